@@ -0,0 +1,197 @@
+#include "AudioAdpcm.h"
+#include <cstring>
+
+static const int IndexTable[16] = {
+    -1, -1, -1, -1, 2, 4, 6, 8,
+    -1, -1, -1, -1, 2, 4, 6, 8
+};
+
+static const int StepTable[89] = {
+    7, 8, 9, 10, 11, 12, 13, 14, 16, 17,
+    19, 21, 23, 25, 28, 31, 34, 37, 41, 45,
+    50, 55, 60, 66, 73, 80, 88, 97, 107, 118,
+    130, 143, 157, 173, 190, 209, 230, 253, 279, 307,
+    337, 371, 408, 449, 494, 544, 598, 658, 724, 796,
+    876, 963, 1060, 1166, 1282, 1411, 1552, 1707, 1878, 2066,
+    2272, 2499, 2749, 3024, 3327, 3660, 4026, 4428, 4871, 5358,
+    5894, 6484, 7132, 7845, 8630, 9493, 10442, 11487, 12635, 13899,
+    15289, 16818, 18500, 20350, 22385, 24623, 27086, 29794, 32767
+};
+
+static int Clamp(int value, int low, int high) {
+    return value < low ? low : (value > high ? high : value);
+}
+
+// Decoder state update for one nibble, shared by both sides so they stay in step
+static void Advance(int nibble, int& predictor, int& stepIndex) {
+    int step = StepTable[stepIndex];
+    int delta = step >> 3;
+    if (nibble & 4) delta += step;
+    if (nibble & 2) delta += step >> 1;
+    if (nibble & 1) delta += step >> 2;
+
+    predictor = Clamp((nibble & 8) ? predictor - delta : predictor + delta, -32768, 32767);
+    stepIndex = Clamp(stepIndex + IndexTable[nibble], 0, 88);
+}
+
+static int EncodeSample(int sample, int& predictor, int& stepIndex) {
+    int diff = sample - predictor;
+    int nibble = 0;
+    if (diff < 0) {
+        nibble = 8;
+        diff = -diff;
+    }
+
+    int step = StepTable[stepIndex];
+    if (diff >= step) {
+        nibble |= 4;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 2;
+        diff -= step;
+    }
+    step >>= 1;
+    if (diff >= step) {
+        nibble |= 1;
+    }
+
+    Advance(nibble, predictor, stepIndex);
+    return nibble;
+}
+
+bool EncodeAdpcm(const float* samples, size_t frames, AdpcmClip& clip) {
+    if (!samples || frames == 0) return false;
+
+    size_t blocks = (frames + AdpcmBlockFrames - 1) / AdpcmBlockFrames;
+    clip.data.assign(blocks * AdpcmBlockHeader + frames, 0);
+    clip.frames = frames;
+
+    int predictor[2] = {};
+    int stepIndex[2] = {};
+    uint8_t* out = clip.data.data();
+
+    for (size_t frame = 0; frame < frames; frame++) {
+        if (frame % AdpcmBlockFrames == 0) {
+            for (int c = 0; c < 2; c++) {
+                int16_t value = static_cast<int16_t>(predictor[c]);
+                memcpy(out + c * 4, &value, sizeof(value));
+                out[c * 4 + 2] = static_cast<uint8_t>(stepIndex[c]);
+            }
+            out += AdpcmBlockHeader;
+        }
+
+        int nibbles[2];
+        for (int c = 0; c < 2; c++) {
+            float value = samples[frame * 2 + c] * 32767.0f;
+            int sample = Clamp(static_cast<int>(value < 0.0f ? value - 0.5f : value + 0.5f), -32768, 32767);
+            nibbles[c] = EncodeSample(sample, predictor[c], stepIndex[c]);
+        }
+        *out++ = static_cast<uint8_t>(nibbles[0] | (nibbles[1] << 4));
+    }
+    return true;
+}
+
+size_t AdpcmReader::Read(float* out, size_t frames) {
+    if (!clip) return 0;
+
+    size_t count = 0;
+    const float scale = 1.0f / 32768.0f;
+    while (count < frames && cursor < clip->frames) {
+        size_t block = cursor / AdpcmBlockFrames;
+        size_t inBlock = cursor % AdpcmBlockFrames;
+        const uint8_t* blockData = clip->data.data() + block * (AdpcmBlockHeader + AdpcmBlockFrames);
+
+        // Every block restarts from its own header
+        if (inBlock == 0) {
+            for (int c = 0; c < 2; c++) {
+                int16_t value;
+                memcpy(&value, blockData + c * 4, sizeof(value));
+                predictor[c] = value;
+                stepIndex[c] = Clamp(blockData[c * 4 + 2], 0, 88);
+            }
+        }
+
+        size_t blockEnd = (block + 1) * AdpcmBlockFrames;
+        if (blockEnd > clip->frames) blockEnd = clip->frames;
+        size_t run = blockEnd - cursor;
+        if (run > frames - count) run = frames - count;
+
+        const uint8_t* bytes = blockData + AdpcmBlockHeader + inBlock;
+        for (size_t k = 0; k < run; k++) {
+            Advance(bytes[k] & 0x0F, predictor[0], stepIndex[0]);
+            Advance(bytes[k] >> 4, predictor[1], stepIndex[1]);
+            out[(count + k) * 2] = predictor[0] * scale;
+            out[(count + k) * 2 + 1] = predictor[1] * scale;
+        }
+        count += run;
+        cursor += run;
+    }
+    return count;
+}
+
+void DecodeAdpcm(const AdpcmClip& clip, std::vector<float>& samples) {
+    samples.resize(clip.frames * 2);
+    AdpcmReader reader(&clip);
+    reader.Read(samples.data(), clip.frames);
+}
+
+void AdpcmCompressor::Start() {
+    if (thread.joinable()) return;
+
+    stopping = false;
+    thread = std::thread(&AdpcmCompressor::Run, this);
+}
+
+void AdpcmCompressor::Stop() {
+    if (!thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    thread.join();
+    results.PopAll();
+}
+
+void AdpcmCompressor::Request(uint64_t tag, const float* samples, size_t frames, std::shared_ptr<void> keepAlive) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) return;
+
+        Job job;
+        job.tag = tag;
+        job.samples = samples;
+        job.frames = frames;
+        job.keepAlive = std::move(keepAlive);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void AdpcmCompressor::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) break;
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        Result result;
+        result.tag = job.tag;
+        result.source = job.samples;
+        auto clip = std::make_shared<AdpcmClip>();
+        if (EncodeAdpcm(job.samples, job.frames, *clip)) {
+            result.clip = std::move(clip);
+        }
+        job.keepAlive.reset();
+        results.Push(std::move(result));
+
+        lock.lock();
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "MpscQueue.h"
+
+// IMA-ADPCM for clips in the engine format (interleaved stereo float), about an eighth of
+// the size of the float PCM at 4 bits a sample. Quality is that of 16-bit IMA-ADPCM: fine
+// for callouts and speech, audibly rougher on quiet, bright material.
+//
+// Layout: blocks of AdpcmBlockFrames frames, the last one possibly shorter. Each block
+// starts with the decoder state of both channels (int16 predictor, uint8 step index, one
+// spare byte), followed by one byte per frame, the left nibble low and the right one high.
+static const size_t AdpcmBlockFrames = 1024;
+static const size_t AdpcmBlockHeader = 8;
+
+struct AdpcmClip {
+    std::vector<uint8_t> data;
+    size_t frames = 0;
+
+    size_t Bytes() const { return data.size(); }
+};
+
+bool EncodeAdpcm(const float* samples, size_t frames, AdpcmClip& clip);
+
+// Sequential decoder, from the start of the clip to its end
+class AdpcmReader {
+public:
+    AdpcmReader() {}
+    explicit AdpcmReader(const AdpcmClip* adpcmClip) : clip(adpcmClip) {}
+
+    // Decodes up to frames frames into out, returns how many there were
+    size_t Read(float* out, size_t frames);
+
+private:
+    const AdpcmClip* clip = nullptr;
+    size_t cursor = 0;
+    int predictor[2] = {};
+    int stepIndex[2] = {};
+};
+
+// The whole clip back to float PCM
+void DecodeAdpcm(const AdpcmClip& clip, std::vector<float>& samples);
+
+// Encodes clips on a worker thread, off the render thread
+class AdpcmCompressor {
+public:
+    struct Result {
+        uint64_t tag = 0;                   // As passed to Request
+        const float* source = nullptr;      // The PCM it was made from
+        std::shared_ptr<AdpcmClip> clip;    // Null if encoding failed
+    };
+
+    AdpcmCompressor() {}
+    ~AdpcmCompressor() { Stop(); }
+    AdpcmCompressor(const AdpcmCompressor&) = delete;
+    AdpcmCompressor& operator=(const AdpcmCompressor&) = delete;
+
+    void Start();
+    void Stop();
+
+    // keepAlive holds the samples until the clip is encoded
+    void Request(uint64_t tag, const float* samples, size_t frames, std::shared_ptr<void> keepAlive);
+
+    // Render thread: clips finished since the last call
+    std::vector<Result> TakeResults() { return results.PopAll(); }
+
+private:
+    struct Job {
+        uint64_t tag = 0;
+        const float* samples = nullptr;
+        size_t frames = 0;
+        std::shared_ptr<void> keepAlive;
+    };
+
+    void Run();
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<Job> jobs;
+    MpscQueue<Result> results;
+};
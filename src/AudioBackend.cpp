@@ -0,0 +1,108 @@
+#include "AudioBackend.h"
+#include <cmath>
+#include <algorithm>
+
+std::string AudioDevice::displayName() const {
+    return WideToUtf8(name) + (isDefault ? " (Default)" : "");
+}
+
+std::string WideToUtf8(const std::wstring& text) {
+    std::string result;
+    result.reserve(text.size());
+
+    for (size_t i = 0; i < text.size(); i++) {
+        uint32_t cp = static_cast<uint32_t>(text[i]);
+
+        // wchar_t is UTF-16 on Windows, join surrogate pairs
+        if (sizeof(wchar_t) == 2 && cp >= 0xD800 && cp <= 0xDBFF && i + 1 < text.size()) {
+            uint32_t low = static_cast<uint32_t>(text[i + 1]);
+            if (low >= 0xDC00 && low <= 0xDFFF) {
+                cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                i++;
+            }
+        }
+
+        if (cp < 0x80) {
+            result += static_cast<char>(cp);
+        }
+        else if (cp < 0x800) {
+            result += static_cast<char>(0xC0 | (cp >> 6));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else if (cp < 0x10000) {
+            result += static_cast<char>(0xE0 | (cp >> 12));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+        else {
+            result += static_cast<char>(0xF0 | (cp >> 18));
+            result += static_cast<char>(0x80 | ((cp >> 12) & 0x3F));
+            result += static_cast<char>(0x80 | ((cp >> 6) & 0x3F));
+            result += static_cast<char>(0x80 | (cp & 0x3F));
+        }
+    }
+
+    return result;
+}
+
+std::wstring Utf8ToWide(const std::string& text) {
+    std::wstring result;
+    result.reserve(text.size());
+
+    for (size_t i = 0; i < text.size();) {
+        unsigned char lead = static_cast<unsigned char>(text[i]);
+        uint32_t cp;
+        size_t extra;
+
+        if (lead < 0x80) { cp = lead; extra = 0; }
+        else if ((lead & 0xE0) == 0xC0) { cp = lead & 0x1F; extra = 1; }
+        else if ((lead & 0xF0) == 0xE0) { cp = lead & 0x0F; extra = 2; }
+        else if ((lead & 0xF8) == 0xF0) { cp = lead & 0x07; extra = 3; }
+        else { cp = 0xFFFD; extra = 0; }
+
+        i++;
+        for (size_t k = 0; k < extra; k++, i++) {
+            if (i >= text.size() || (static_cast<unsigned char>(text[i]) & 0xC0) != 0x80) {
+                cp = 0xFFFD;
+                break;
+            }
+            cp = (cp << 6) | (static_cast<unsigned char>(text[i]) & 0x3F);
+        }
+
+        if (sizeof(wchar_t) == 2 && cp >= 0x10000) {
+            cp -= 0x10000;
+            result += static_cast<wchar_t>(0xD800 + (cp >> 10));
+            result += static_cast<wchar_t>(0xDC00 + (cp & 0x3FF));
+        }
+        else {
+            result += static_cast<wchar_t>(cp);
+        }
+    }
+
+    return result;
+}
+
+void ComputeStereoPanMatrix(uint32_t sourceChannels, float pan, float matrix[4]) {
+    // Clamp pan value between -1 and 1
+    pan = (std::max)(-1.0f, (std::min)(1.0f, pan));
+    std::fill(matrix, matrix + 4, 0.0f);
+
+    if (sourceChannels == 1) {
+        // Mono source, equal-power pan
+        // Left output = cos(angle) * source
+        // Right output = sin(angle) * source
+        float angle = (pan + 1.0f) * 3.14159f / 4.0f; // Convert -1..1 to 0..pi/2
+        matrix[0] = cosf(angle) * 1.5f; // Left
+        matrix[1] = sinf(angle) * 1.5f; // Right
+    }
+    else if (sourceChannels == 2) {
+        // Stereo source, crossfade between channels
+        float leftGain = (1.0f - pan) * 0.5f + 0.5f;
+        float rightGain = (1.0f + pan) * 0.5f + 0.5f;
+
+        matrix[0] = leftGain;
+        matrix[1] = 1.0f - leftGain;
+        matrix[2] = 1.0f - rightGain;
+        matrix[3] = rightGain;
+    }
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+
+// Portable audio output interface. SoundEngine owns the sound cache, the voice
+// pool and the settings plumbing; a backend only turns PCM buffers into sound.
+// Nothing in this header depends on Windows so the miniaudio backend and the
+// playback path can be built anywhere miniaudio runs.
+
+// Sample layout of a PCM buffer
+struct AudioFormat {
+    static const uint16_t PCM = 1;          // Integer samples (WAVE_FORMAT_PCM)
+    static const uint16_t Float = 3;        // IEEE float samples (WAVE_FORMAT_IEEE_FLOAT)
+
+    uint16_t formatTag = PCM;
+    uint16_t channels = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+
+    uint32_t BlockAlign() const { return channels * (bitsPerSample / 8u); }
+    bool IsValid() const {
+        return channels > 0 && sampleRate > 0 &&
+            (formatTag == Float ? bitsPerSample == 32 :
+                formatTag == PCM && (bitsPerSample == 8 || bitsPerSample == 16 || bitsPerSample == 24 || bitsPerSample == 32));
+    }
+
+    bool operator==(const AudioFormat& other) const {
+        return formatTag == other.formatTag && channels == other.channels &&
+            sampleRate == other.sampleRate && bitsPerSample == other.bitsPerSample;
+    }
+    bool operator<(const AudioFormat& other) const {
+        if (formatTag != other.formatTag) return formatTag < other.formatTag;
+        if (channels != other.channels) return channels < other.channels;
+        if (sampleRate != other.sampleRate) return sampleRate < other.sampleRate;
+        return bitsPerSample < other.bitsPerSample;
+    }
+};
+
+// Audio device information structure
+struct AudioDevice {
+    std::wstring id;           // Device ID, only meaningful to the backend that listed it
+    std::wstring name;         // Friendly name of the device
+    bool isDefault = false;    // Is this the default device?
+
+    // Simplified name for display purposes
+    std::string displayName() const;
+};
+
+// UTF-8 <-> wide conversions that don't need the Windows API
+std::string WideToUtf8(const std::wstring& text);
+std::wstring Utf8ToWide(const std::string& text);
+
+// Output gains for a source with 1 or 2 channels mixed to stereo, laid out the way
+// XAudio2's SetOutputMatrix reads them: matrix[destChannel * sourceChannels + sourceChannel].
+void ComputeStereoPanMatrix(uint32_t sourceChannels, float pan, float matrix[4]);
+
+// Trigger-to-start latency, from PlaySound to the first audio of the buffer.
+// Pooled plays reuse an idle voice, created plays had to create one.
+struct PlaybackLatencyStats {
+    std::atomic<uint64_t> pooledCount{ 0 };
+    std::atomic<uint64_t> pooledNanos{ 0 };
+    std::atomic<uint64_t> pooledMaxNanos{ 0 };
+    std::atomic<uint64_t> createdCount{ 0 };
+    std::atomic<uint64_t> createdNanos{ 0 };
+    std::atomic<uint64_t> createdMaxNanos{ 0 };
+
+    void Record(uint64_t nanos, bool pooled) {
+        std::atomic<uint64_t>& count = pooled ? pooledCount : createdCount;
+        std::atomic<uint64_t>& total = pooled ? pooledNanos : createdNanos;
+        std::atomic<uint64_t>& maximum = pooled ? pooledMaxNanos : createdMaxNanos;
+
+        count.fetch_add(1, std::memory_order_relaxed);
+        total.fetch_add(nanos, std::memory_order_relaxed);
+        uint64_t previous = maximum.load(std::memory_order_relaxed);
+        while (nanos > previous && !maximum.compare_exchange_weak(previous, nanos, std::memory_order_relaxed)) {
+        }
+    }
+
+    void Reset() {
+        pooledCount = 0;
+        pooledNanos = 0;
+        pooledMaxNanos = 0;
+        createdCount = 0;
+        createdNanos = 0;
+        createdMaxNanos = 0;
+    }
+};
+
+// One playing (or idle) source. A voice only accepts buffers in the format it was
+// created with, and can be reused after Reset(). Deleting it releases the voice.
+class IAudioVoice {
+public:
+    virtual ~IAudioVoice() {}
+
+    virtual const AudioFormat& GetFormat() const = 0;
+
+    // Queue a buffer. The data must stay valid until the voice has played it, or is reset.
+    // Clips go in as a single end-of-stream buffer; streams queue chunks and call EndStream.
+    virtual bool Submit(const uint8_t* data, uint32_t bytes, bool endOfStream = true) = 0;
+    virtual void EndStream() = 0;
+    virtual uint32_t GetQueuedBuffers() const = 0;
+    virtual bool Start() = 0;
+
+    // Stop and drop queued audio, the voice is ready for another Submit afterwards
+    virtual void Reset() = 0;
+
+    virtual void SetVolume(float volume) = 0;
+    virtual void SetPan(float pan) = 0;
+
+    bool IsFinished() const { return finished.load(std::memory_order_acquire); }
+
+    // Arm the latency measurement and clear the finished flag for the next play
+    void Arm(std::chrono::steady_clock::time_point trigger, bool fromPool, PlaybackLatencyStats* latencyStats) {
+        finished.store(false, std::memory_order_relaxed);
+        pooled = fromPool;
+        stats = latencyStats;
+        // Zero means "not armed", so a trigger exactly at the clock epoch becomes 1 ns
+        int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(trigger.time_since_epoch()).count();
+        triggerNanos.store(nanos != 0 ? nanos : 1, std::memory_order_release);
+    }
+
+protected:
+    // Called by the backend, possibly from its audio thread
+    void NotifyStarted() {
+        int64_t trigger = triggerNanos.exchange(0, std::memory_order_acq_rel);
+        if (trigger != 0 && stats) {
+            int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                std::chrono::steady_clock::now().time_since_epoch()).count();
+            stats->Record(now > trigger ? static_cast<uint64_t>(now - trigger) : 0, pooled);
+        }
+    }
+    void NotifyFinished() { finished.store(true, std::memory_order_release); }
+
+private:
+    std::atomic<bool> finished{ false };
+    std::atomic<int64_t> triggerNanos{ 0 };
+    bool pooled = false;
+    PlaybackLatencyStats* stats = nullptr;
+};
+
+// Fills frameCount frames of interleaved samples, called from the backend's audio thread
+using AudioRenderCallback = std::function<void(float* out, uint32_t frameCount)>;
+
+// Output device plus voice factory
+class IAudioBackend {
+public:
+    virtual ~IAudioBackend() {}
+
+    virtual const char* GetName() const = 0;
+
+    // Open the output. An empty or unknown device id falls back to the default device.
+    virtual bool Initialize(const std::wstring& deviceId) = 0;
+    virtual void Shutdown() = 0;
+
+    // Safe to call from any thread, the device watcher lists devices on its own
+    virtual bool EnumerateDevices(std::vector<AudioDevice>& devices) = 0;
+
+    // Switch outputs. Voices and the render stream move to the new device and keep
+    // playing, nothing has to be recreated.
+    virtual bool SetOutputDevice(const std::wstring& deviceId) = 0;
+
+    // The output died under us, e.g. its device was unplugged. Every voice is dead with it:
+    // delete them all, then SetOutputDevice opens the output again.
+    virtual bool IsOutputLost() const { return false; }
+
+    // Returns nullptr if the format is not supported or the backend isn't initialized
+    virtual IAudioVoice* CreateVoice(const AudioFormat& format) = 0;
+
+    // Continuous float output pulled from render, alongside any voices. There is one
+    // render stream at most; it survives SetOutputDevice, and once StopRenderStream
+    // returns the callback is no longer running.
+    virtual bool StartRenderStream(const AudioFormat& format, AudioRenderCallback render) = 0;
+    virtual void StopRenderStream() = 0;
+};
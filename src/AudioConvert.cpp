@@ -0,0 +1,256 @@
+#include "AudioConvert.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_CONVERT_SSE2 1
+#include <emmintrin.h>
+#endif
+
+AudioFormat GetEngineFormat() {
+    AudioFormat format;
+    format.formatTag = AudioFormat::Float;
+    format.channels = EngineChannels;
+    format.sampleRate = EngineSampleRate;
+    format.bitsPerSample = 32;
+    return format;
+}
+
+bool FindWavChunks(const uint8_t* image, size_t imageSize, const uint8_t*& fmt, uint32_t& fmtSize,
+    const uint8_t*& pcm, uint32_t& pcmSize) {
+    fmt = nullptr;
+    pcm = nullptr;
+    fmtSize = 0;
+    pcmSize = 0;
+    if (imageSize < 12) return false;
+
+    const uint8_t* end = image + imageSize;
+    const uint8_t* pos = image + 12; // Skip RIFF header
+    while (end - pos >= 8) {
+        uint32_t chunkSize;
+        memcpy(&chunkSize, pos + 4, sizeof(chunkSize));
+        const uint8_t* body = pos + 8;
+        size_t available = static_cast<size_t>(end - body);
+
+        if (memcmp(pos, "fmt ", 4) == 0 && chunkSize >= 16 && chunkSize <= available) {
+            fmt = body;
+            fmtSize = chunkSize;
+        }
+        else if (memcmp(pos, "data", 4) == 0) {
+            pcm = body;
+            pcmSize = chunkSize <= available ? chunkSize : static_cast<uint32_t>(available);
+        }
+
+        if (chunkSize >= available) break;
+        pos = body + chunkSize + (chunkSize & 1); // Chunks are word aligned
+    }
+
+    return fmt && pcm && pcmSize > 0;
+}
+
+AudioFormat ParseWavFormat(const uint8_t* fmt, uint32_t fmtSize) {
+    AudioFormat format;
+    if (!fmt || fmtSize < 16) return format;
+
+    // WAVEFORMATEX: tag, channels, rate, byte rate, block align, bits
+    memcpy(&format.formatTag, fmt, 2);
+    memcpy(&format.channels, fmt + 2, 2);
+    memcpy(&format.sampleRate, fmt + 4, 4);
+    memcpy(&format.bitsPerSample, fmt + 14, 2);
+    if (format.formatTag == 0xFFFE) {
+        format.formatTag = format.bitsPerSample == 32 ? AudioFormat::Float : AudioFormat::PCM;
+    }
+    return format;
+}
+
+void ConvertS16ToFloatScalar(const int16_t* in, float* out, size_t samples) {
+    const float scale = 1.0f / 32768.0f;
+    for (size_t i = 0; i < samples; i++) {
+        out[i] = static_cast<float>(in[i]) * scale;
+    }
+}
+
+void ConvertS16ToFloat(const int16_t* in, float* out, size_t samples) {
+    size_t i = 0;
+#ifdef AUDIO_CONVERT_SSE2
+    const __m128 scale = _mm_set1_ps(1.0f / 32768.0f);
+    for (; i + 8 <= samples; i += 8) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(in + i));
+
+        // Widen to 32 bits by putting each sample in the high half and shifting it back down with sign
+        __m128i low = _mm_srai_epi32(_mm_unpacklo_epi16(packed, packed), 16);
+        __m128i high = _mm_srai_epi32(_mm_unpackhi_epi16(packed, packed), 16);
+
+        _mm_storeu_ps(out + i, _mm_mul_ps(_mm_cvtepi32_ps(low), scale));
+        _mm_storeu_ps(out + i + 4, _mm_mul_ps(_mm_cvtepi32_ps(high), scale));
+    }
+#endif
+    ConvertS16ToFloatScalar(in + i, out + i, samples - i);
+}
+
+void DuplicateMonoToStereoScalar(const float* in, float* out, size_t frames) {
+    for (size_t i = 0; i < frames; i++) {
+        out[i * 2] = in[i];
+        out[i * 2 + 1] = in[i];
+    }
+}
+
+void DuplicateMonoToStereo(const float* in, float* out, size_t frames) {
+    size_t i = 0;
+#ifdef AUDIO_CONVERT_SSE2
+    for (; i + 4 <= frames; i += 4) {
+        __m128 mono = _mm_loadu_ps(in + i);
+        _mm_storeu_ps(out + i * 2, _mm_unpacklo_ps(mono, mono));
+        _mm_storeu_ps(out + i * 2 + 4, _mm_unpackhi_ps(mono, mono));
+    }
+#endif
+    DuplicateMonoToStereoScalar(in + i, out + i * 2, frames - i);
+}
+
+size_t ResampledFrameCount(size_t inFrames, uint32_t inRate, uint32_t outRate) {
+    if (inFrames == 0 || inRate == 0 || outRate == 0) return 0;
+    uint64_t frames = static_cast<uint64_t>(inFrames) * outRate / inRate;
+    return frames > 0 ? static_cast<size_t>(frames) : 1;
+}
+
+// Source position of output frame j is j * inRate / outRate, kept as a whole index plus
+// a remainder in 1/outRate steps. Both resamplers step it the same way.
+struct ResamplePosition {
+    size_t index = 0;
+    uint32_t remainder = 0;
+    size_t stepWhole;
+    uint32_t stepRemainder;
+    uint32_t outRate;
+
+    ResamplePosition(uint32_t inRate, uint32_t outputRate)
+        : stepWhole(inRate / outputRate), stepRemainder(inRate % outputRate), outRate(outputRate) {}
+
+    float Fraction() const { return static_cast<float>(remainder) / static_cast<float>(outRate); }
+
+    void Advance() {
+        index += stepWhole;
+        remainder += stepRemainder;
+        if (remainder >= outRate) {
+            remainder -= outRate;
+            index++;
+        }
+    }
+};
+
+static void ResampleStereoFrames(const float* in, size_t inFrames, ResamplePosition& position,
+    float* out, size_t begin, size_t end) {
+    for (size_t j = begin; j < end; j++) {
+        size_t a = position.index;
+        size_t b = a + 1 < inFrames ? a + 1 : inFrames - 1;
+        float t = position.Fraction();
+
+        out[j * 2] = in[a * 2] + (in[b * 2] - in[a * 2]) * t;
+        out[j * 2 + 1] = in[a * 2 + 1] + (in[b * 2 + 1] - in[a * 2 + 1]) * t;
+        position.Advance();
+    }
+}
+
+void ResampleStereoLinearScalar(const float* in, size_t inFrames, uint32_t inRate, float* out, size_t outFrames, uint32_t outRate) {
+    if (inFrames == 0 || outFrames == 0) return;
+    ResamplePosition position(inRate, outRate);
+    ResampleStereoFrames(in, inFrames, position, out, 0, outFrames);
+}
+
+void ResampleStereoLinear(const float* in, size_t inFrames, uint32_t inRate, float* out, size_t outFrames, uint32_t outRate) {
+    if (inFrames == 0 || outFrames == 0) return;
+    ResamplePosition position(inRate, outRate);
+    size_t j = 0;
+#ifdef AUDIO_CONVERT_SSE2
+    // Two output frames per iteration: gather both source pairs, then one lerp over four lanes
+    for (; j + 2 <= outFrames; j += 2) {
+        size_t a0 = position.index;
+        size_t b0 = a0 + 1 < inFrames ? a0 + 1 : inFrames - 1;
+        float t0 = position.Fraction();
+        position.Advance();
+
+        size_t a1 = position.index;
+        size_t b1 = a1 + 1 < inFrames ? a1 + 1 : inFrames - 1;
+        float t1 = position.Fraction();
+        position.Advance();
+
+        __m128 a = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(in + a0 * 2)),
+            reinterpret_cast<const __m64*>(in + a1 * 2));
+        __m128 b = _mm_loadh_pi(_mm_loadl_pi(_mm_setzero_ps(), reinterpret_cast<const __m64*>(in + b0 * 2)),
+            reinterpret_cast<const __m64*>(in + b1 * 2));
+        __m128 t = _mm_set_ps(t1, t1, t0, t0);
+
+        _mm_storeu_ps(out + j * 2, _mm_add_ps(a, _mm_mul_ps(_mm_sub_ps(b, a), t)));
+    }
+#endif
+    ResampleStereoFrames(in, inFrames, position, out, j, outFrames);
+}
+
+// Native samples of any supported layout to float, channel count unchanged
+static void ConvertToFloat(const AudioFormat& format, const uint8_t* data, size_t samples, float* out) {
+    if (format.formatTag == AudioFormat::Float) {
+        memcpy(out, data, samples * sizeof(float));
+        return;
+    }
+
+    switch (format.bitsPerSample) {
+    case 8:
+        // 8-bit WAV is unsigned
+        for (size_t i = 0; i < samples; i++) {
+            out[i] = (static_cast<float>(data[i]) - 128.0f) * (1.0f / 128.0f);
+        }
+        break;
+    case 16:
+        ConvertS16ToFloat(reinterpret_cast<const int16_t*>(data), out, samples);
+        break;
+    case 24:
+        for (size_t i = 0; i < samples; i++) {
+            const uint8_t* p = data + i * 3;
+            int32_t value = static_cast<int32_t>((static_cast<uint32_t>(p[0]) << 8) |
+                (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 24)) >> 8;
+            out[i] = static_cast<float>(value) * (1.0f / 8388608.0f);
+        }
+        break;
+    case 32: {
+        const int32_t* in = reinterpret_cast<const int32_t*>(data);
+        for (size_t i = 0; i < samples; i++) {
+            out[i] = static_cast<float>(in[i]) * (1.0f / 2147483648.0f);
+        }
+        break;
+    }
+    }
+}
+
+bool ConvertToEngineFormat(const AudioFormat& format, const void* data, size_t bytes, std::vector<float>& out) {
+    if (!format.IsValid() || !data) return false;
+
+    size_t frames = bytes / format.BlockAlign();
+    if (frames == 0) return false;
+
+    std::vector<float> native(frames * format.channels);
+    ConvertToFloat(format, static_cast<const uint8_t*>(data), native.size(), native.data());
+
+    std::vector<float> stereo;
+    if (format.channels == 1) {
+        stereo.resize(frames * 2);
+        DuplicateMonoToStereo(native.data(), stereo.data(), frames);
+    }
+    else if (format.channels == 2) {
+        stereo.swap(native);
+    }
+    else {
+        stereo.resize(frames * 2);
+        for (size_t i = 0; i < frames; i++) {
+            stereo[i * 2] = native[i * format.channels];
+            stereo[i * 2 + 1] = native[i * format.channels + 1];
+        }
+    }
+
+    if (format.sampleRate == EngineSampleRate) {
+        out.swap(stereo);
+        return true;
+    }
+
+    size_t outFrames = ResampledFrameCount(frames, format.sampleRate, EngineSampleRate);
+    out.resize(outFrames * 2);
+    ResampleStereoLinear(stereo.data(), frames, format.sampleRate, out.data(), outFrames, EngineSampleRate);
+    return true;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include "AudioBackend.h"
+
+// Load-time conversion to the engine format. Every in-memory sound is stored as
+// 48 kHz stereo float, so all voices share one format and one pool, and buffers
+// can be mixed without per-sound conversion.
+//
+// The kernels use SSE2 where the target guarantees it (every x64 build) and fall back
+// to scalar code elsewhere. Both paths do the same float operations in the same order,
+// so their output is bit for bit identical; the scalar versions are exposed so the
+// two can be compared.
+
+static const uint32_t EngineSampleRate = 48000;
+static const uint16_t EngineChannels = 2;
+
+// 48 kHz stereo 32-bit float
+AudioFormat GetEngineFormat();
+
+// Locate the fmt and data chunks of a RIFF/WAVE image in memory. Chunk sizes are checked
+// against the image, a truncated data chunk is cut to the bytes that are actually there.
+bool FindWavChunks(const uint8_t* image, size_t imageSize, const uint8_t*& fmt, uint32_t& fmtSize,
+    const uint8_t*& pcm, uint32_t& pcmSize);
+
+// Format described by a fmt chunk. WAVE_FORMAT_EXTENSIBLE is read by bit depth.
+AudioFormat ParseWavFormat(const uint8_t* fmt, uint32_t fmtSize);
+
+// Convert interleaved PCM (8/16/24/32-bit integer or 32-bit float, any channel count) to
+// the engine format. Mono is copied to both sides, for more than two channels only the
+// front left and right are kept. Returns false for formats it can't read.
+bool ConvertToEngineFormat(const AudioFormat& format, const void* data, size_t bytes, std::vector<float>& out);
+
+// 16-bit integer samples to float in [-1, 1)
+void ConvertS16ToFloat(const int16_t* in, float* out, size_t samples);
+void ConvertS16ToFloatScalar(const int16_t* in, float* out, size_t samples);
+
+// Mono to interleaved stereo, each sample copied to both channels
+void DuplicateMonoToStereo(const float* in, float* out, size_t frames);
+void DuplicateMonoToStereoScalar(const float* in, float* out, size_t frames);
+
+// Linear interpolation of interleaved stereo from inRate to outRate. Positions are exact
+// integer ratios, so long clips don't drift. ResampledFrameCount gives the size of out.
+size_t ResampledFrameCount(size_t inFrames, uint32_t inRate, uint32_t outRate);
+void ResampleStereoLinear(const float* in, size_t inFrames, uint32_t inRate, float* out, size_t outFrames, uint32_t outRate);
+void ResampleStereoLinearScalar(const float* in, size_t inFrames, uint32_t inRate, float* out, size_t outFrames, uint32_t outRate);
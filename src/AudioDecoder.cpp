@@ -0,0 +1,273 @@
+#include "AudioDecoder.h"
+#include "AudioConvert.h"
+
+// Read an opened stream to the end
+static bool DecodeStream(AudioStream& stream, const std::string& name, DecodedSound& sound, std::string& error) {
+    sound.format = stream.GetFormat();
+    sound.pcm.clear();
+    if (stream.GetLengthInFrames() > 0) {
+        sound.pcm.reserve(static_cast<size_t>(stream.GetLengthInFrames()) * sound.format.BlockAlign());
+    }
+
+    std::vector<uint8_t> chunk;
+    while (stream.ReadChunk(chunk)) {
+        sound.pcm.insert(sound.pcm.end(), chunk.begin(), chunk.end());
+    }
+
+    if (sound.pcm.empty()) {
+        error = "no audio frames in " + name;
+        return false;
+    }
+    return true;
+}
+
+bool DecodeAudioFile(const std::string& path, DecodedSound& sound, std::string& error) {
+    AudioStream stream;
+    if (!stream.Open(path, error)) {
+        return false;
+    }
+    return DecodeStream(stream, path, sound, error);
+}
+
+bool DecodeAudioMemory(const void* data, size_t size, DecodedSound& sound, std::string& error) {
+    AudioStream stream;
+    if (!stream.OpenMemory(data, size, error)) {
+        return false;
+    }
+    return DecodeStream(stream, "in-memory sound", sound, error);
+}
+
+bool AudioStream::Open(const std::string& path, std::string& error) {
+    Close();
+
+    // miniaudio converts and resamples straight to the engine format
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, EngineChannels, EngineSampleRate);
+    if (ma_decoder_init_file(path.c_str(), &config, &decoder) != MA_SUCCESS) {
+        error = "unsupported or unreadable audio file: " + path;
+        return false;
+    }
+    open = true;
+    return ReadFormat(path, error);
+}
+
+bool AudioStream::OpenMemory(const void* data, size_t size, std::string& error) {
+    Close();
+
+    ma_decoder_config config = ma_decoder_config_init(ma_format_f32, EngineChannels, EngineSampleRate);
+    if (ma_decoder_init_memory(data, size, &config, &decoder) != MA_SUCCESS) {
+        error = "unsupported or damaged in-memory sound";
+        return false;
+    }
+    open = true;
+    return ReadFormat("in-memory sound", error);
+}
+
+bool AudioStream::ReadFormat(const std::string& name, std::string& error) {
+    ma_format sampleFormat;
+    ma_uint32 channels = 0;
+    ma_uint32 sampleRate = 0;
+    if (ma_decoder_get_data_format(&decoder, &sampleFormat, &channels, &sampleRate, nullptr, 0) != MA_SUCCESS ||
+        channels == 0 || sampleRate == 0) {
+        Close();
+        error = "could not read the audio format of " + name;
+        return false;
+    }
+    format = GetEngineFormat();
+
+    ma_uint64 length = 0;
+    lengthInFrames = ma_decoder_get_length_in_pcm_frames(&decoder, &length) == MA_SUCCESS ? length : 0;
+    return true;
+}
+
+void AudioStream::Close() {
+    if (open) {
+        ma_decoder_uninit(&decoder);
+        open = false;
+    }
+}
+
+bool AudioStream::ReadChunk(std::vector<uint8_t>& chunk) {
+    if (!open) return false;
+
+    uint32_t blockAlign = format.BlockAlign();
+    chunk.resize(static_cast<size_t>(ChunkFrames) * blockAlign);
+
+    ma_uint64 framesRead = 0;
+    ma_result result = ma_decoder_read_pcm_frames(&decoder, chunk.data(), ChunkFrames, &framesRead);
+    chunk.resize(static_cast<size_t>(framesRead) * blockAlign);
+
+    return (result == MA_SUCCESS || result == MA_AT_END) && framesRead > 0;
+}
+
+AudioDecodeWorker::AudioDecodeWorker() {}
+
+AudioDecodeWorker::~AudioDecodeWorker() {
+    Stop();
+}
+
+void AudioDecodeWorker::Start(size_t threadCount) {
+    if (!threads.empty()) return;
+
+    if (threadCount == 0) {
+        // Leave a core for the game's render thread
+        unsigned int cores = std::thread::hardware_concurrency();
+        threadCount = cores > 1 ? cores - 1 : 1;
+    }
+    if (threadCount > MaxThreads) {
+        threadCount = MaxThreads;
+    }
+
+    stopping = false;
+    for (size_t i = 0; i < threadCount; i++) {
+        threads.emplace_back(&AudioDecodeWorker::Run, this);
+    }
+}
+
+void AudioDecodeWorker::Stop() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        decodeQueue.clear();
+        fillQueue.clear();
+    }
+    wake.notify_all();
+
+    for (auto& thread : threads) {
+        if (thread.joinable()) {
+            thread.join();
+        }
+    }
+    threads.clear();
+}
+
+void AudioDecodeWorker::RequestDecode(const std::string& path) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        DecodeJob job;
+        job.path = path;
+        decodeQueue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void AudioDecodeWorker::RequestDecodeMemory(const std::string& name, const void* data, size_t size,
+    std::shared_ptr<void> keepAlive) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        DecodeJob job;
+        job.path = name;
+        job.data = data;
+        job.size = size;
+        job.keepAlive = std::move(keepAlive);
+        decodeQueue.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void AudioDecodeWorker::RequestFill(const std::shared_ptr<AudioStreamState>& stream) {
+    {
+        std::lock_guard<std::mutex> streamLock(stream->mutex);
+        if (stream->fillQueued || stream->endReached || stream->failed) return;
+        stream->fillQueued = true;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        fillQueue.push_back(stream);
+    }
+    wake.notify_one();
+}
+
+void AudioDecodeWorker::Run() {
+    for (;;) {
+        std::shared_ptr<AudioStreamState> stream;
+        DecodeJob job;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [this]() { return stopping || !fillQueue.empty() || !decodeQueue.empty(); });
+            if (stopping) return;
+
+            // A playing stream running dry is audible, a library scan finishing later isn't
+            if (!fillQueue.empty()) {
+                stream = std::move(fillQueue.front());
+                fillQueue.pop_front();
+            }
+            else {
+                job = std::move(decodeQueue.front());
+                decodeQueue.pop_front();
+            }
+        }
+
+        if (stream) {
+            Fill(*stream);
+        }
+        else {
+            Decode(job);
+        }
+    }
+}
+
+void AudioDecodeWorker::Decode(const DecodeJob& job) {
+    Result result;
+    result.path = job.path;
+
+    if (job.data) {
+        result.ok = DecodeAudioMemory(job.data, job.size, result.sound, result.error);
+        results.Push(std::move(result));
+        return;
+    }
+
+    const std::string& path = job.path;
+    AudioStream probe;
+    if (probe.Open(path, result.error)) {
+        uint64_t streamFrames = static_cast<uint64_t>(probe.GetFormat().sampleRate) * StreamThresholdSeconds;
+        if (probe.GetLengthInFrames() > streamFrames) {
+            result.ok = true;
+            result.streamed = true;
+            result.sound.format = probe.GetFormat();
+        }
+        else {
+            probe.Close();
+            result.ok = DecodeAudioFile(path, result.sound, result.error);
+        }
+    }
+
+    results.Push(std::move(result));
+}
+
+void AudioDecodeWorker::Fill(AudioStreamState& stream) {
+    std::string error;
+    if (!stream.cancelled && !stream.decoder.IsOpen() && !stream.decoder.Open(stream.path, error)) {
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        stream.failed = true;
+        stream.fillQueued = false;
+        return;
+    }
+
+    for (;;) {
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            if (stream.cancelled || stream.ready.size() >= AudioStreamState::ChunksAhead) {
+                stream.fillQueued = false;
+                break;
+            }
+        }
+
+        // Decode without holding the lock, the render thread may be taking chunks
+        std::vector<uint8_t> chunk;
+        bool more = stream.decoder.ReadChunk(chunk);
+
+        std::lock_guard<std::mutex> lock(stream.mutex);
+        if (!chunk.empty()) {
+            stream.ready.push_back(std::move(chunk));
+        }
+        if (!more) {
+            stream.endReached = true;
+            stream.fillQueued = false;
+            break;
+        }
+    }
+
+    if (stream.cancelled || stream.endReached) {
+        stream.decoder.Close();
+    }
+}
@@ -0,0 +1,134 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include "AudioBackend.h"
+#include "MpscQueue.h"
+#include "miniaudio.h"
+
+// Audio file decoding through miniaudio's ma_decoder. Files come out in the engine
+// format (48 kHz stereo float, see AudioConvert.h). Short clips are decoded whole;
+// longer ones are streamed a chunk at a time while they play.
+
+// True when miniaudio.cpp was built with stb_vorbis, so .ogg files can be decoded
+bool IsVorbisDecodingAvailable();
+
+// A fully decoded clip
+struct DecodedSound {
+    AudioFormat format;
+    std::vector<uint8_t> pcm;
+};
+
+bool DecodeAudioFile(const std::string& path, DecodedSound& sound, std::string& error);
+
+// Decode an encoded file image already in memory, such as a sound pack entry
+bool DecodeAudioMemory(const void* data, size_t size, DecodedSound& sound, std::string& error);
+
+// Incremental decoder for a streamed clip
+class AudioStream {
+public:
+    static const uint32_t ChunkFrames = 16384;      // About a third of a second at 48 kHz
+
+    AudioStream() {}
+    ~AudioStream() { Close(); }
+    AudioStream(const AudioStream&) = delete;
+    AudioStream& operator=(const AudioStream&) = delete;
+
+    bool Open(const std::string& path, std::string& error);
+    bool OpenMemory(const void* data, size_t size, std::string& error);    // data must outlive the stream
+    void Close();
+    bool IsOpen() const { return open; }
+
+    const AudioFormat& GetFormat() const { return format; }
+    uint64_t GetLengthInFrames() const { return lengthInFrames; }   // 0 if the decoder can't tell
+
+    // Decode the next chunk. Returns false once the end of the file is reached and nothing was read.
+    bool ReadChunk(std::vector<uint8_t>& chunk);
+
+private:
+    bool ReadFormat(const std::string& name, std::string& error);
+
+    ma_decoder decoder = {};
+    bool open = false;
+    AudioFormat format;
+    uint64_t lengthInFrames = 0;
+};
+
+// Playback state of one streamed voice, shared between the render thread and the decode worker
+struct AudioStreamState {
+    static const size_t ChunksAhead = 3;            // Decoded chunks kept ready per stream
+
+    std::string path;
+    std::atomic<bool> cancelled{ false };
+
+    std::mutex mutex;
+    std::deque<std::vector<uint8_t>> ready;         // Decoded chunks waiting to be submitted
+    bool endReached = false;
+    bool failed = false;
+    bool fillQueued = false;                        // A fill job is already waiting for the worker
+
+    AudioStream decoder;                            // Worker thread only
+};
+
+// Small pool of decode threads. Decode jobs probe a file and either decode it whole
+// or report it as streamed; fill jobs top up streams that are playing and always go first.
+// Finished decodes are handed back through a lock-free queue, so the render thread
+// never waits on a worker to collect them.
+class AudioDecodeWorker {
+public:
+    struct Result {
+        std::string path;
+        bool ok = false;
+        bool streamed = false;
+        DecodedSound sound;         // Whole clip, or just the format when streamed
+        std::string error;
+    };
+
+    // Clips longer than this are streamed rather than decoded into memory
+    static const uint32_t StreamThresholdSeconds = 10;
+    static const size_t MaxThreads = 4;
+
+    AudioDecodeWorker();
+    ~AudioDecodeWorker();
+
+    // threadCount 0 picks one thread per spare core, at most MaxThreads
+    void Start(size_t threadCount = 0);
+    void Stop();
+
+    void RequestDecode(const std::string& path);
+
+    // Decode an in-memory image under the given name, which the result carries as its path.
+    // keepAlive holds the data until the decode is done. Never streamed.
+    void RequestDecodeMemory(const std::string& name, const void* data, size_t size, std::shared_ptr<void> keepAlive);
+    void RequestFill(const std::shared_ptr<AudioStreamState>& stream);
+
+    // Render thread: results finished since the last call
+    std::vector<Result> TakeResults() { return results.PopAll(); }
+
+private:
+    struct DecodeJob {
+        std::string path;
+        const void* data = nullptr;     // In-memory image, or null to read path
+        size_t size = 0;
+        std::shared_ptr<void> keepAlive;
+    };
+
+    void Run();
+    void Decode(const DecodeJob& job);
+    void Fill(AudioStreamState& stream);
+
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+
+    std::deque<DecodeJob> decodeQueue;
+    std::deque<std::shared_ptr<AudioStreamState>> fillQueue;
+    MpscQueue<Result> results;
+};
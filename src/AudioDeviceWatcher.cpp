@@ -0,0 +1,150 @@
+#include "AudioDeviceWatcher.h"
+#include "shared.h"
+
+// Unplugging a headset sends several notifications in a row, wait this long for them to settle
+static const DWORD SettleDelayMs = 200;
+
+AudioDeviceWatcher::AudioDeviceWatcher() {}
+
+AudioDeviceWatcher::~AudioDeviceWatcher() {
+    Stop();
+}
+
+bool AudioDeviceWatcher::Start(IAudioBackend* audioBackend) {
+    if (running) return true;
+    if (!audioBackend) return false;
+
+    backend = audioBackend;
+    stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    changeEvent = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+    if (!stopEvent || !changeEvent) {
+        if (stopEvent) CloseHandle(stopEvent);
+        if (changeEvent) CloseHandle(changeEvent);
+        stopEvent = nullptr;
+        changeEvent = nullptr;
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create audio device watcher events");
+        }
+        return false;
+    }
+
+    running = true;
+    watchThread = std::thread(&AudioDeviceWatcher::WatchLoop, this);
+    return true;
+}
+
+void AudioDeviceWatcher::Stop() {
+    if (!running) return;
+
+    running = false;
+    SetEvent(stopEvent);
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+
+    CloseHandle(stopEvent);
+    CloseHandle(changeEvent);
+    stopEvent = nullptr;
+    changeEvent = nullptr;
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.reset();
+    hasPending = false;
+}
+
+void AudioDeviceWatcher::WatchLoop() {
+    // The notification client is registered from this thread, so COM is set up here and the
+    // render thread's apartment is left alone
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool needsUninitialize = SUCCEEDED(hr);
+
+    IMMDeviceEnumerator* pEnumerator = nullptr;
+    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
+    if (SUCCEEDED(hr)) {
+        hr = pEnumerator->RegisterEndpointNotificationCallback(this);
+    }
+
+    if (FAILED(hr)) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Audio device watcher unavailable, device changes need a manual refresh");
+        }
+    }
+    else {
+        while (running) {
+            HANDLE handles[2] = { stopEvent, changeEvent };
+            if (WaitForMultipleObjects(2, handles, FALSE, INFINITE) != WAIT_OBJECT_0 + 1) {
+                break;
+            }
+
+            // Notifications that arrive while settling are folded into this listing
+            if (WaitForSingleObject(stopEvent, SettleDelayMs) == WAIT_OBJECT_0) {
+                break;
+            }
+            ResetEvent(changeEvent);
+
+            auto devices = std::make_unique<std::vector<AudioDevice>>();
+            backend->EnumerateDevices(*devices);
+
+            // A newer list replaces one the render thread hasn't picked up yet
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pending = std::move(devices);
+            hasPending = true;
+        }
+
+        pEnumerator->UnregisterEndpointNotificationCallback(this);
+    }
+
+    if (pEnumerator) {
+        pEnumerator->Release();
+    }
+    if (needsUninitialize) {
+        CoUninitialize();
+    }
+}
+
+bool AudioDeviceWatcher::TakeDevices(std::vector<AudioDevice>& devices) {
+    // Checked without the lock, this runs every frame
+    if (!hasPending) return false;
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    if (!pending) return false;
+
+    devices = std::move(*pending);
+    pending.reset();
+    hasPending = false;
+    return true;
+}
+
+HRESULT AudioDeviceWatcher::QueryInterface(REFIID riid, void** ppvObject) {
+    if (!ppvObject) return E_POINTER;
+    if (riid == __uuidof(IUnknown) || riid == __uuidof(IMMNotificationClient)) {
+        *ppvObject = static_cast<IMMNotificationClient*>(this);
+        return S_OK;
+    }
+    *ppvObject = nullptr;
+    return E_NOINTERFACE;
+}
+
+HRESULT AudioDeviceWatcher::OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId) {
+    // Only the default playback device the game's own output follows matters
+    if (flow == eRender && role == eConsole) {
+        SetEvent(changeEvent);
+    }
+    return S_OK;
+}
+
+HRESULT AudioDeviceWatcher::OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState) {
+    SetEvent(changeEvent);
+    return S_OK;
+}
+
+HRESULT AudioDeviceWatcher::OnDeviceAdded(LPCWSTR pwstrDeviceId) {
+    SetEvent(changeEvent);
+    return S_OK;
+}
+
+HRESULT AudioDeviceWatcher::OnDeviceRemoved(LPCWSTR pwstrDeviceId) {
+    SetEvent(changeEvent);
+    return S_OK;
+}
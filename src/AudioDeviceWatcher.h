@@ -0,0 +1,54 @@
+#pragma once
+
+#include <Windows.h>
+#include <mmdeviceapi.h>
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+#include "AudioBackend.h"
+
+// Watches output devices through IMMNotificationClient: the default device changing and
+// devices being plugged in, enabled or removed. Windows calls the notifications on its own
+// threads; they only wake the watch thread, which lets a burst of them settle, lists the
+// devices through the backend and leaves the list for the render thread to pick up.
+class AudioDeviceWatcher : private IMMNotificationClient {
+private:
+    IAudioBackend* backend = nullptr;
+
+    std::thread watchThread;
+    HANDLE stopEvent = nullptr;
+    HANDLE changeEvent = nullptr;       // Auto-reset, set by the notifications
+    std::atomic<bool> running{ false };
+
+    std::mutex pendingMutex;
+    std::unique_ptr<std::vector<AudioDevice>> pending;
+    std::atomic<bool> hasPending{ false };
+
+    void WatchLoop();
+
+    // IUnknown. The watcher owns its lifetime, COM only borrows it between register and unregister.
+    HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** ppvObject) override;
+    ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+    ULONG STDMETHODCALLTYPE Release() override { return 1; }
+
+    HRESULT STDMETHODCALLTYPE OnDefaultDeviceChanged(EDataFlow flow, ERole role, LPCWSTR pwstrDefaultDeviceId) override;
+    HRESULT STDMETHODCALLTYPE OnDeviceStateChanged(LPCWSTR pwstrDeviceId, DWORD dwNewState) override;
+    HRESULT STDMETHODCALLTYPE OnDeviceAdded(LPCWSTR pwstrDeviceId) override;
+    HRESULT STDMETHODCALLTYPE OnDeviceRemoved(LPCWSTR pwstrDeviceId) override;
+    HRESULT STDMETHODCALLTYPE OnPropertyValueChanged(LPCWSTR pwstrDeviceId, const PROPERTYKEY key) override { return S_OK; }
+
+public:
+    AudioDeviceWatcher();
+    ~AudioDeviceWatcher();
+
+    // The backend lists the devices, so ids match what it opens. It must outlive the watcher.
+    bool Start(IAudioBackend* audioBackend);
+    void Stop();
+
+    // Call once per frame from the render thread. True with the newest device list if the
+    // devices changed since the last call.
+    bool TakeDevices(std::vector<AudioDevice>& devices);
+};
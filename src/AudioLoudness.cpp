@@ -0,0 +1,337 @@
+#include "AudioLoudness.h"
+#include <cmath>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+float LoudnessInfo::NormalizationGain() const {
+    if (integratedLufs <= -70.0f) return 1.0f;
+
+    float gainDb = LoudnessTargetLufs - integratedLufs;
+    gainDb = (std::max)(-12.0f, (std::min)(12.0f, gainDb));
+    gainDb = (std::min)(gainDb, -1.0f - truePeakDb);
+    return std::pow(10.0f, gainDb / 20.0f);
+}
+
+// Biquad in direct form I, state per channel
+struct Biquad {
+    double b0, b1, b2, a1, a2;
+    double x1 = 0.0, x2 = 0.0, y1 = 0.0, y2 = 0.0;
+
+    double Process(double x) {
+        double y = b0 * x + b1 * x1 + b2 * x2 - a1 * y1 - a2 * y2;
+        x2 = x1;
+        x1 = x;
+        y2 = y1;
+        y1 = y;
+        return y;
+    }
+};
+
+// K-weighting: the BS.1770 shelf and high-pass, designed for any rate from their analog
+// prototypes (at 48 kHz this gives the coefficients printed in the standard)
+static void MakeKWeighting(uint32_t sampleRate, Biquad& shelf, Biquad& highPass) {
+    const double pi = 3.14159265358979323846;
+    double rate = static_cast<double>(sampleRate);
+
+    {
+        const double f0 = 1681.974450955533, gainDb = 3.999843853973347, q = 0.7071752369554196;
+        double k = std::tan(pi * f0 / rate);
+        double vh = std::pow(10.0, gainDb / 20.0);
+        double vb = std::pow(vh, 0.4996667741545416);
+        double a0 = 1.0 + k / q + k * k;
+        shelf.b0 = (vh + vb * k / q + k * k) / a0;
+        shelf.b1 = 2.0 * (k * k - vh) / a0;
+        shelf.b2 = (vh - vb * k / q + k * k) / a0;
+        shelf.a1 = 2.0 * (k * k - 1.0) / a0;
+        shelf.a2 = (1.0 - k / q + k * k) / a0;
+    }
+    {
+        const double f0 = 38.13547087602444, q = 0.5003270373238773;
+        double k = std::tan(pi * f0 / rate);
+        double a0 = 1.0 + k / q + k * k;
+        highPass.b0 = 1.0;
+        highPass.b1 = -2.0;
+        highPass.b2 = 1.0;
+        highPass.a1 = 2.0 * (k * k - 1.0) / a0;
+        highPass.a2 = (1.0 - k / q + k * k) / a0;
+    }
+}
+
+static double BlockLoudness(double meanSquare) {
+    return meanSquare > 0.0 ? -0.691 + 10.0 * std::log10(meanSquare) : -1000.0;
+}
+
+// Peak of the signal reconstructed at 4x, with a 16-tap Hann-windowed sinc per phase
+static float MeasureTruePeak(const float* samples, size_t frames) {
+    const int Taps = 16;
+    const int Phases = 4;
+    const double pi = 3.14159265358979323846;
+
+    double kernel[Phases][Taps];
+    for (int p = 0; p < Phases; p++) {
+        double sum = 0.0;
+        for (int t = 0; t < Taps; t++) {
+            double x = static_cast<double>(t - Taps / 2 + 1) - static_cast<double>(p) / Phases;
+            double sinc = x == 0.0 ? 1.0 : std::sin(pi * x) / (pi * x);
+            double window = 0.5 + 0.5 * std::cos(pi * x / (Taps / 2));
+            kernel[p][t] = sinc * window;
+            sum += kernel[p][t];
+        }
+        for (int t = 0; t < Taps; t++) {
+            kernel[p][t] /= sum;
+        }
+    }
+
+    double peak = 0.0;
+    for (int channel = 0; channel < 2; channel++) {
+        for (size_t i = 0; i < frames; i++) {
+            peak = (std::max)(peak, static_cast<double>(std::fabs(samples[i * 2 + channel])));
+
+            // Points between sample i and i + 1
+            for (int p = 1; p < Phases; p++) {
+                double value = 0.0;
+                for (int t = 0; t < Taps; t++) {
+                    int64_t index = static_cast<int64_t>(i) + (Taps / 2 - t);
+                    if (index < 0 || index >= static_cast<int64_t>(frames)) continue;
+                    value += kernel[p][t] * samples[index * 2 + channel];
+                }
+                peak = (std::max)(peak, std::fabs(value));
+            }
+        }
+    }
+    return peak > 0.0 ? static_cast<float>(20.0 * std::log10(peak)) : -100.0f;
+}
+
+bool MeasureLoudness(const float* samples, size_t frames, uint32_t sampleRate, LoudnessInfo& info) {
+    if (!samples || frames == 0 || sampleRate == 0) return false;
+
+    // K-weighted power per 100 ms step, blocks are four steps
+    Biquad shelf[2], highPass[2];
+    for (int c = 0; c < 2; c++) {
+        MakeKWeighting(sampleRate, shelf[c], highPass[c]);
+    }
+
+    size_t stepFrames = sampleRate / 10;
+    std::vector<double> stepPower;
+    double stepSum = 0.0;
+    size_t stepCount = 0;
+    for (size_t i = 0; i < frames; i++) {
+        for (int c = 0; c < 2; c++) {
+            double y = highPass[c].Process(shelf[c].Process(samples[i * 2 + c]));
+            stepSum += y * y;
+        }
+        if (++stepCount == stepFrames) {
+            stepPower.push_back(stepSum);
+            stepSum = 0.0;
+            stepCount = 0;
+        }
+    }
+
+    std::vector<double> blockPower;
+    if (stepPower.size() >= 4) {
+        for (size_t i = 0; i + 4 <= stepPower.size(); i++) {
+            double sum = stepPower[i] + stepPower[i + 1] + stepPower[i + 2] + stepPower[i + 3];
+            blockPower.push_back(sum / (4.0 * stepFrames));
+        }
+    }
+    else {
+        // Shorter than one block: the whole clip is the block
+        double sum = stepSum;
+        for (double power : stepPower) {
+            sum += power;
+        }
+        blockPower.push_back(sum / static_cast<double>(frames));
+    }
+
+    // Absolute gate at -70 LUFS, then a relative gate 10 LU under what passed it
+    double absoluteSum = 0.0;
+    size_t absoluteCount = 0;
+    for (double power : blockPower) {
+        if (BlockLoudness(power) > -70.0) {
+            absoluteSum += power;
+            absoluteCount++;
+        }
+    }
+
+    info.integratedLufs = -100.0f;
+    if (absoluteCount > 0) {
+        double relativeGate = BlockLoudness(absoluteSum / absoluteCount) - 10.0;
+        double gatedSum = 0.0;
+        size_t gatedCount = 0;
+        for (double power : blockPower) {
+            double loudness = BlockLoudness(power);
+            if (loudness > -70.0 && loudness > relativeGate) {
+                gatedSum += power;
+                gatedCount++;
+            }
+        }
+        if (gatedCount > 0) {
+            info.integratedLufs = static_cast<float>((std::max)(-100.0, BlockLoudness(gatedSum / gatedCount)));
+        }
+    }
+
+    info.truePeakDb = MeasureTruePeak(samples, frames);
+    return true;
+}
+
+// Size and modification time identify the version of a file the cache entry is for
+static bool StatFile(const std::string& path, uint64_t& size, int64_t& modified) {
+    std::error_code error;
+    std::filesystem::path filePath = std::filesystem::u8path(path);
+    size = static_cast<uint64_t>(std::filesystem::file_size(filePath, error));
+    if (error) return false;
+    auto time = std::filesystem::last_write_time(filePath, error);
+    if (error) return false;
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+void LoudnessAnalyzer::Start(const std::string& cacheFile) {
+    if (thread.joinable()) return;
+
+    cachePath = cacheFile;
+    LoadCache();
+    stopping = false;
+    thread = std::thread(&LoudnessAnalyzer::Run, this);
+}
+
+void LoudnessAnalyzer::Stop() {
+    if (!thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+        queued.clear();
+    }
+    wake.notify_all();
+    thread.join();
+    SaveCache();
+}
+
+bool LoudnessAnalyzer::Lookup(const std::string& path, LoudnessInfo& info) {
+    uint64_t size = 0;
+    int64_t modified = 0;
+    if (!StatFile(path, size, modified)) return false;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    auto it = cache.find(path);
+    if (it == cache.end() || it->second.size != size || it->second.modified != modified) return false;
+    info = it->second.info;
+    return true;
+}
+
+void LoudnessAnalyzer::Request(const std::string& path, const float* samples, size_t frames, uint32_t sampleRate,
+    std::shared_ptr<void> keepAlive) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable() || !queued.insert(path).second) return;
+
+        Job job;
+        job.path = path;
+        job.samples = samples;
+        job.frames = frames;
+        job.sampleRate = sampleRate;
+        job.keepAlive = std::move(keepAlive);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void LoudnessAnalyzer::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+        if (stopping) break;
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        Result result;
+        result.path = job.path;
+        result.ok = MeasureLoudness(job.samples, job.frames, job.sampleRate, result.info);
+        job.keepAlive.reset();
+
+        Entry entry;
+        bool stat = result.ok && StatFile(job.path, entry.size, entry.modified);
+        entry.info = result.info;
+
+        lock.lock();
+        queued.erase(job.path);
+        if (stat) {
+            cache[job.path] = entry;
+            cacheDirty = true;
+        }
+        bool idle = jobs.empty();
+        lock.unlock();
+
+        results.Push(std::move(result));
+
+        // Write once a batch of loads has been measured rather than after every file
+        if (idle) {
+            SaveCache();
+        }
+        lock.lock();
+    }
+}
+
+void LoudnessAnalyzer::LoadCache() {
+    if (cachePath.empty()) return;
+
+    std::ifstream file(std::filesystem::u8path(cachePath));
+    if (!file.is_open()) return;
+
+    json data = json::parse(file, nullptr, false);
+    if (data.is_discarded() || !data.is_object() || data.value("version", 0) != 1 ||
+        !data.contains("files") || !data["files"].is_object()) {
+        return;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    for (const auto& [path, value] : data["files"].items()) {
+        if (!value.is_object()) continue;
+
+        Entry entry;
+        entry.size = value.value("size", static_cast<uint64_t>(0));
+        entry.modified = value.value("modified", static_cast<int64_t>(0));
+        entry.info.integratedLufs = value.value("lufs", -100.0f);
+        entry.info.truePeakDb = value.value("peak", -100.0f);
+        cache[path] = entry;
+    }
+}
+
+void LoudnessAnalyzer::SaveCache() {
+    json files = json::object();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!cacheDirty || cachePath.empty()) return;
+        cacheDirty = false;
+
+        for (const auto& [path, entry] : cache) {
+            files[path] = {
+                { "size", entry.size },
+                { "modified", entry.modified },
+                { "lufs", entry.info.integratedLufs },
+                { "peak", entry.info.truePeakDb }
+            };
+        }
+    }
+
+    json data = { { "version", 1 }, { "files", std::move(files) } };
+
+    // Write beside the old file and swap, a crash mid-write leaves the old cache intact
+    std::string tempPath = cachePath + ".tmp";
+    {
+        std::ofstream file(std::filesystem::u8path(tempPath), std::ios::trunc);
+        if (!file.is_open()) return;
+        file << data.dump();
+        if (!file.good()) return;
+    }
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::u8path(tempPath), std::filesystem::u8path(cachePath), error);
+}
@@ -0,0 +1,94 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include "MpscQueue.h"
+
+// Loudness of a clip per EBU R128 / ITU-R BS.1770: integrated loudness over K-weighted,
+// gated 400 ms blocks, and the true peak from 4x oversampling.
+struct LoudnessInfo {
+    float integratedLufs = -100.0f;     // -100 for silence
+    float truePeakDb = -100.0f;         // dBTP
+
+    // Gain that brings the clip to the target loudness without pushing the true peak past
+    // -1 dBTP, limited to +-12 dB. Silent clips are left alone.
+    float NormalizationGain() const;
+};
+
+// Loudness custom sounds are brought to
+static const float LoudnessTargetLufs = -18.0f;
+
+// Measure interleaved stereo float at 48 kHz. Clips shorter than one 400 ms block are
+// measured as a single block, so short chimes still get a value.
+bool MeasureLoudness(const float* samples, size_t frames, uint32_t sampleRate, LoudnessInfo& info);
+
+// Background loudness measurement with an on-disk cache keyed by path, size and
+// modification time, so each file is analysed once rather than on every load.
+class LoudnessAnalyzer {
+public:
+    struct Result {
+        std::string path;
+        bool ok = false;
+        LoudnessInfo info;
+    };
+
+    LoudnessAnalyzer() {}
+    ~LoudnessAnalyzer() { Stop(); }
+    LoudnessAnalyzer(const LoudnessAnalyzer&) = delete;
+    LoudnessAnalyzer& operator=(const LoudnessAnalyzer&) = delete;
+
+    // Loads the cache file and starts the worker; an empty path keeps the cache in memory
+    void Start(const std::string& cacheFile);
+    void Stop();
+
+    // Cached result for the file as it is on disk now
+    bool Lookup(const std::string& path, LoudnessInfo& info);
+
+    // Measure PCM in the engine format. keepAlive holds the samples until the job is done.
+    void Request(const std::string& path, const float* samples, size_t frames, uint32_t sampleRate,
+        std::shared_ptr<void> keepAlive);
+
+    // Render thread: measurements finished since the last call
+    std::vector<Result> TakeResults() { return results.PopAll(); }
+
+private:
+    struct Job {
+        std::string path;
+        const float* samples = nullptr;
+        size_t frames = 0;
+        uint32_t sampleRate = 0;
+        std::shared_ptr<void> keepAlive;
+    };
+
+    struct Entry {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        LoudnessInfo info;
+    };
+
+    void Run();
+    void LoadCache();
+    void SaveCache();
+
+    std::string cachePath;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<Job> jobs;
+    std::set<std::string> queued;               // Paths in jobs, so repeated loads queue once
+
+    std::map<std::string, Entry> cache;         // Guarded by mutex
+    bool cacheDirty = false;
+
+    MpscQueue<Result> results;
+};
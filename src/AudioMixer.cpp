@@ -0,0 +1,359 @@
+#include "AudioMixer.h"
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_MIXER_SSE2 1
+#include <emmintrin.h>
+#endif
+
+static void MixStereoRampFrom(const float* in, float* out, size_t begin, size_t end,
+    const float from[4], const float step[4]) {
+    for (size_t k = begin; k < end; k++) {
+        float frame = static_cast<float>(k);
+        float m0 = from[0] + step[0] * frame;
+        float m1 = from[1] + step[1] * frame;
+        float m2 = from[2] + step[2] * frame;
+        float m3 = from[3] + step[3] * frame;
+        float left = in[k * 2];
+        float right = in[k * 2 + 1];
+        out[k * 2] += left * m0 + right * m1;
+        out[k * 2 + 1] += left * m2 + right * m3;
+    }
+}
+
+void MixStereoRampScalar(const float* in, float* out, size_t frames, const float from[4], const float to[4]) {
+    if (frames == 0) return;
+    float step[4];
+    for (int c = 0; c < 4; c++) {
+        step[c] = (to[c] - from[c]) / static_cast<float>(frames);
+    }
+    MixStereoRampFrom(in, out, 0, frames, from, step);
+}
+
+void MixStereoRamp(const float* in, float* out, size_t frames, const float from[4], const float to[4]) {
+    if (frames == 0) return;
+    float step[4];
+    for (int c = 0; c < 4; c++) {
+        step[c] = (to[c] - from[c]) / static_cast<float>(frames);
+    }
+
+    size_t k = 0;
+#ifdef AUDIO_MIXER_SSE2
+    // Two frames per iteration. With x = [L0 R0 L1 R1] and its pairs swapped, [R0 L0 R1 L1],
+    // the output is x * [m0 m3 m0 m3] + swapped * [m1 m2 m1 m2] with each frame's own ramped gains.
+    // Gains are from + step * frame as in the scalar loop, rather than accumulated, so both agree exactly.
+    const __m128 directFrom = _mm_set_ps(from[3], from[0], from[3], from[0]);
+    const __m128 crossFrom = _mm_set_ps(from[2], from[1], from[2], from[1]);
+    const __m128 directStep = _mm_set_ps(step[3], step[0], step[3], step[0]);
+    const __m128 crossStep = _mm_set_ps(step[2], step[1], step[2], step[1]);
+    const __m128 two = _mm_set1_ps(2.0f);
+    __m128 frame = _mm_set_ps(1.0f, 1.0f, 0.0f, 0.0f);
+
+    for (; k + 2 <= frames; k += 2) {
+        __m128 direct = _mm_add_ps(directFrom, _mm_mul_ps(directStep, frame));
+        __m128 cross = _mm_add_ps(crossFrom, _mm_mul_ps(crossStep, frame));
+
+        __m128 x = _mm_loadu_ps(in + k * 2);
+        __m128 swapped = _mm_shuffle_ps(x, x, _MM_SHUFFLE(2, 3, 0, 1));
+        __m128 mixed = _mm_add_ps(_mm_mul_ps(x, direct), _mm_mul_ps(swapped, cross));
+        _mm_storeu_ps(out + k * 2, _mm_add_ps(_mm_loadu_ps(out + k * 2), mixed));
+
+        frame = _mm_add_ps(frame, two);
+    }
+#endif
+    MixStereoRampFrom(in, out, k, frames, from, step);
+}
+
+AudioMixer::AudioMixer(uint32_t sampleRate) : sampleRate(sampleRate) {
+    clips.reserve(MaxClips);
+    finished.resize(FinishedCapacity);
+    scratch.resize(ScratchFrames * 2);
+}
+
+AudioMixer::~AudioMixer() {}
+
+uint64_t AudioMixer::Queue(Clip clip) {
+    Command command;
+    command.type = Command::PlayClip;
+    command.clipId = nextClipId.fetch_add(1, std::memory_order_relaxed);
+    command.clip = std::move(clip);
+    command.clip.id = command.clipId;
+
+    uint64_t clipId = command.clipId;
+    commands.Push(std::move(command));
+    return clipId;
+}
+
+uint64_t AudioMixer::Play(const float* samples, size_t frames, std::shared_ptr<void> keepAlive, float gain, float pan,
+    std::chrono::steady_clock::time_point trigger, PlaybackLatencyStats* latencyStats) {
+    Clip clip;
+    clip.samples = samples;
+    clip.frames = frames;
+    clip.keepAlive = std::move(keepAlive);
+    clip.gain = gain;
+    clip.pan = pan;
+    clip.trigger = trigger;
+    clip.latencyStats = latencyStats;
+    return Queue(std::move(clip));
+}
+
+uint64_t AudioMixer::PlayAt(const float* samples, size_t frames, std::shared_ptr<void> keepAlive, float gain, float pan,
+    std::chrono::steady_clock::time_point startTime) {
+    Clip clip;
+    clip.samples = samples;
+    clip.frames = frames;
+    clip.keepAlive = std::move(keepAlive);
+    clip.gain = gain;
+    clip.pan = pan;
+    clip.scheduled = true;
+    clip.startTime = startTime;
+    clip.trigger = startTime;
+    return Queue(std::move(clip));
+}
+
+uint64_t AudioMixer::Play(const AdpcmClip* adpcm, std::shared_ptr<void> keepAlive, float gain, float pan,
+    std::chrono::steady_clock::time_point trigger, PlaybackLatencyStats* latencyStats) {
+    Clip clip;
+    clip.adpcm = adpcm;
+    clip.reader = AdpcmReader(adpcm);
+    clip.frames = adpcm->frames;
+    clip.keepAlive = std::move(keepAlive);
+    clip.gain = gain;
+    clip.pan = pan;
+    clip.trigger = trigger;
+    clip.latencyStats = latencyStats;
+    return Queue(std::move(clip));
+}
+
+uint64_t AudioMixer::PlayAt(const AdpcmClip* adpcm, std::shared_ptr<void> keepAlive, float gain, float pan,
+    std::chrono::steady_clock::time_point startTime) {
+    Clip clip;
+    clip.adpcm = adpcm;
+    clip.reader = AdpcmReader(adpcm);
+    clip.frames = adpcm->frames;
+    clip.keepAlive = std::move(keepAlive);
+    clip.gain = gain;
+    clip.pan = pan;
+    clip.scheduled = true;
+    clip.startTime = startTime;
+    clip.trigger = startTime;
+    return Queue(std::move(clip));
+}
+
+void AudioMixer::SetClipGain(uint64_t clipId, float gain) {
+    Command command;
+    command.type = Command::Gain;
+    command.clipId = clipId;
+    command.value = gain;
+    commands.Push(std::move(command));
+}
+
+void AudioMixer::SetClipPan(uint64_t clipId, float pan) {
+    Command command;
+    command.type = Command::Pan;
+    command.clipId = clipId;
+    command.value = pan;
+    commands.Push(std::move(command));
+}
+
+void AudioMixer::SetMasterGain(float gain) {
+    Command command;
+    command.type = Command::Master;
+    command.value = gain;
+    commands.Push(std::move(command));
+}
+
+void AudioMixer::Stop(uint64_t clipId) {
+    Command command;
+    command.type = Command::StopClip;
+    command.clipId = clipId;
+    commands.Push(std::move(command));
+}
+
+void AudioMixer::StopAll() {
+    Command command;
+    command.type = Command::StopEverything;
+    commands.Push(std::move(command));
+}
+
+std::vector<AudioMixer::FinishedClip> AudioMixer::TakeFinished() {
+    std::vector<FinishedClip> taken;
+    size_t read = finishedRead.load(std::memory_order_relaxed);
+    size_t write = finishedWrite.load(std::memory_order_acquire);
+    taken.reserve(write - read);
+    for (; read != write; read++) {
+        taken.push_back(std::move(finished[read % FinishedCapacity]));
+    }
+    finishedRead.store(read, std::memory_order_release);
+    return taken;
+}
+
+bool AudioMixer::PushFinished(uint64_t clipId, std::shared_ptr<void>& keepAlive) {
+    size_t write = finishedWrite.load(std::memory_order_relaxed);
+    if (write - finishedRead.load(std::memory_order_acquire) >= FinishedCapacity) return false;
+
+    // The slot was moved out by TakeFinished, so assigning it frees nothing
+    FinishedClip& slot = finished[write % FinishedCapacity];
+    slot.id = clipId;
+    slot.keepAlive = std::move(keepAlive);
+    finishedWrite.store(write + 1, std::memory_order_release);
+    return true;
+}
+
+// False when the ring is full: the clip stays, silent, and is retried next block
+bool AudioMixer::Finish(size_t index) {
+    if (!PushFinished(clips[index].id, clips[index].keepAlive)) {
+        clips[index].stopped = true;
+        return false;
+    }
+
+    if (index + 1 != clips.size()) {
+        clips[index] = std::move(clips.back());
+    }
+    clips.pop_back();
+    return true;
+}
+
+void AudioMixer::ApplyCommands() {
+    if (commands.Empty()) return;
+
+    commands.Drain([this](Command& command) {
+        switch (command.type) {
+        case Command::PlayClip:
+            if (clips.size() >= MaxClips) {
+                // No room: handed straight back unplayed. With the ring full too, the queue node
+                // keeps it until the game thread frees the node.
+                PushFinished(command.clip.id, command.clip.keepAlive);
+                break;
+            }
+            // Unscheduled clips start at the top of this block
+            command.clip.startFrame = command.clip.scheduled ? FrameAt(command.clip.startTime) : renderedFrames;
+            clips.push_back(std::move(command.clip));
+            break;
+        case Command::Master:
+            masterGain = command.value;
+            break;
+        case Command::StopEverything:
+            for (size_t i = clips.size(); i-- > 0;) {
+                Finish(i);
+            }
+            break;
+        default:
+            for (size_t i = 0; i < clips.size(); i++) {
+                if (clips[i].id != command.clipId) continue;
+                if (command.type == Command::Gain) {
+                    clips[i].gain = command.value;
+                }
+                else if (command.type == Command::Pan) {
+                    clips[i].pan = command.value;
+                }
+                else {
+                    Finish(i);
+                }
+                break;
+            }
+            break;
+        }
+    });
+}
+
+void AudioMixer::UpdateClock(std::chrono::steady_clock::time_point now) {
+    double expected = anchorFrame + std::chrono::duration<double>(now - anchorTime).count() * sampleRate;
+    double error = static_cast<double>(renderedFrames) - expected;
+
+    // A first call, or a stall or device change that broke the clock by more than 100 ms,
+    // re-anchors outright; otherwise follow the device clock by 1% of the error per block
+    if (!anchored || error > sampleRate / 10.0 || error < -(sampleRate / 10.0)) {
+        anchorTime = now;
+        anchorFrame = static_cast<double>(renderedFrames);
+        anchored = true;
+        return;
+    }
+    anchorFrame += error * 0.01;
+}
+
+uint64_t AudioMixer::FrameAt(std::chrono::steady_clock::time_point time) const {
+    double frame = anchorFrame + std::chrono::duration<double>(time - anchorTime).count() * sampleRate;
+    if (frame <= static_cast<double>(renderedFrames)) return renderedFrames;
+    return static_cast<uint64_t>(frame + 0.5);
+}
+
+void AudioMixer::Render(float* out, uint32_t frames) {
+    UpdateClock(std::chrono::steady_clock::now());
+    ApplyCommands();
+    memset(out, 0, static_cast<size_t>(frames) * 2 * sizeof(float));
+
+    uint64_t blockStart = renderedFrames;
+    uint64_t blockEnd = renderedFrames + frames;
+
+    for (size_t i = 0; i < clips.size();) {
+        Clip& clip = clips[i];
+        if (clip.stopped) {
+            if (!Finish(i)) i++;
+            continue;
+        }
+
+        // Scheduled clips wait for their block, then start partway into it
+        if (clip.startFrame >= blockEnd) {
+            i++;
+            continue;
+        }
+        size_t offset = clip.cursor == 0 && clip.startFrame > blockStart ? static_cast<size_t>(clip.startFrame - blockStart) : 0;
+
+        float target[4];
+        ComputeStereoPanMatrix(2, clip.pan, target);
+        float gain = clip.gain * masterGain;
+        for (int c = 0; c < 4; c++) {
+            target[c] *= gain;
+        }
+
+        // A new clip starts at its gain rather than fading in
+        if (!clip.started) {
+            memcpy(clip.matrix, target, sizeof(target));
+            clip.started = true;
+
+            // Measured to the block the clip is first mixed into
+            if (clip.latencyStats) {
+                auto elapsed = std::chrono::steady_clock::now() - clip.trigger;
+                int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+                clip.latencyStats->Record(nanos > 0 ? static_cast<uint64_t>(nanos) : 0, true);
+            }
+        }
+
+        size_t remaining = clip.frames - clip.cursor;
+        size_t space = frames - offset;
+        size_t count = remaining < space ? remaining : space;
+        if (clip.adpcm) {
+            // Decoded into the scratch buffer a piece at a time, the ramp carries on across the pieces
+            for (size_t done = 0; done < count;) {
+                size_t piece = count - done < ScratchFrames ? count - done : ScratchFrames;
+                piece = clip.reader.Read(scratch.data(), piece);
+                if (piece == 0) break;
+
+                float from[4];
+                float to[4];
+                for (int c = 0; c < 4; c++) {
+                    float step = (target[c] - clip.matrix[c]) / static_cast<float>(count);
+                    from[c] = clip.matrix[c] + step * static_cast<float>(done);
+                    to[c] = clip.matrix[c] + step * static_cast<float>(done + piece);
+                }
+                MixStereoRamp(scratch.data(), out + (offset + done) * 2, piece, from, to);
+                done += piece;
+            }
+        }
+        else {
+            MixStereoRamp(clip.samples + clip.cursor * 2, out + offset * 2, count, clip.matrix, target);
+        }
+        memcpy(clip.matrix, target, sizeof(target));
+        clip.cursor += count;
+
+        if (clip.cursor >= clip.frames) {
+            if (!Finish(i)) i++;
+            continue;
+        }
+        i++;
+    }
+
+    renderedFrames = blockEnd;
+    playingCount.store(clips.size(), std::memory_order_relaxed);
+}
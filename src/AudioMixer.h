@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+#include <chrono>
+#include <atomic>
+#include "AudioBackend.h"
+#include "AudioAdpcm.h"
+#include "MpscQueue.h"
+
+// Mix kernel: add frames of interleaved stereo in to out through a 2x2 gain matrix
+// (laid out like ComputeStereoPanMatrix) that ramps linearly from `from` to `to` over
+// the block, so gain and pan changes never click. SSE2 where the target has it; the
+// scalar version gives bit for bit the same result.
+void MixStereoRamp(const float* in, float* out, size_t frames, const float from[4], const float to[4]);
+void MixStereoRampScalar(const float* in, float* out, size_t frames, const float from[4], const float to[4]);
+
+// Software mixer for in-memory clips in the engine format (interleaved stereo float).
+// The game thread queues commands, the backend's audio thread renders; the two only
+// meet in lock-free queues. Gain, pan and master changes take effect on the next
+// rendered block and are ramped across it.
+//
+// The count of rendered frames is the mixer's clock. It is tied to steady_clock by an
+// anchor that follows the render calls slowly, so callback jitter doesn't move it, and
+// a clip given a start time begins at that exact frame, wherever it falls in a block.
+//
+// Render never allocates or frees: clips live in storage reserved up front, commands are
+// drained straight from their queue nodes, and stopped clips are handed back through a
+// fixed ring so their memory is released on the game thread.
+class AudioMixer {
+public:
+    static const size_t MaxClips = 256;             // Playing at once; more are returned unplayed
+    static const size_t FinishedCapacity = 1024;    // Stopped clips waiting for TakeFinished
+
+    // A clip that stopped, handed back so its memory is released off the audio thread
+    struct FinishedClip {
+        uint64_t id = 0;
+        std::shared_ptr<void> keepAlive;
+    };
+
+    explicit AudioMixer(uint32_t sampleRate);
+    ~AudioMixer();
+    AudioMixer(const AudioMixer&) = delete;
+    AudioMixer& operator=(const AudioMixer&) = delete;
+
+    // Game thread. `samples` must stay valid while keepAlive is held; the mixer holds it
+    // until the clip is returned by TakeFinished. Returns the clip id.
+    uint64_t Play(const float* samples, size_t frames, std::shared_ptr<void> keepAlive, float gain, float pan,
+        std::chrono::steady_clock::time_point trigger, PlaybackLatencyStats* latencyStats);
+
+    // As Play, but the clip starts at the frame that renders at startTime. A time already
+    // past starts on the next block. Stop cancels it before it starts.
+    uint64_t PlayAt(const float* samples, size_t frames, std::shared_ptr<void> keepAlive, float gain, float pan,
+        std::chrono::steady_clock::time_point startTime);
+
+    // The same for a compressed clip, decoded a piece at a time into a scratch buffer as it
+    // plays. keepAlive holds the clip.
+    uint64_t Play(const AdpcmClip* adpcm, std::shared_ptr<void> keepAlive, float gain, float pan,
+        std::chrono::steady_clock::time_point trigger, PlaybackLatencyStats* latencyStats);
+    uint64_t PlayAt(const AdpcmClip* adpcm, std::shared_ptr<void> keepAlive, float gain, float pan,
+        std::chrono::steady_clock::time_point startTime);
+    void SetClipGain(uint64_t clipId, float gain);
+    void SetClipPan(uint64_t clipId, float pan);
+    void SetMasterGain(float gain);
+    void Stop(uint64_t clipId);
+    void StopAll();
+
+    std::vector<FinishedClip> TakeFinished();
+    size_t GetPlayingCount() const { return playingCount.load(std::memory_order_relaxed); }
+
+    // Audio thread: overwrite out with frames of interleaved stereo
+    void Render(float* out, uint32_t frames);
+
+private:
+    struct Clip {
+        uint64_t id = 0;
+        const float* samples = nullptr;
+        const AdpcmClip* adpcm = nullptr;   // Instead of samples for a compressed clip
+        AdpcmReader reader;
+        size_t frames = 0;
+        size_t cursor = 0;
+        std::shared_ptr<void> keepAlive;
+        float gain = 1.0f;
+        float pan = 0.0f;
+        float matrix[4] = {};           // Applied at the end of the last block, ramps from here
+        bool started = false;
+        bool stopped = false;           // Done, waiting for room in the finished ring
+        bool scheduled = false;         // Has a start time rather than starting on the next block
+        std::chrono::steady_clock::time_point startTime;
+        uint64_t startFrame = 0;        // Mixer clock frame the clip starts at
+        std::chrono::steady_clock::time_point trigger;
+        PlaybackLatencyStats* latencyStats = nullptr;
+    };
+
+    struct Command {
+        enum Type { PlayClip, Gain, Pan, Master, StopClip, StopEverything };
+        Type type = PlayClip;
+        uint64_t clipId = 0;
+        float value = 0.0f;
+        Clip clip;                      // PlayClip only
+    };
+
+    uint64_t Queue(Clip clip);
+    void ApplyCommands();
+    bool PushFinished(uint64_t clipId, std::shared_ptr<void>& keepAlive);
+    bool Finish(size_t index);
+    void UpdateClock(std::chrono::steady_clock::time_point now);
+    uint64_t FrameAt(std::chrono::steady_clock::time_point time) const;
+
+    MpscQueue<Command> commands;
+    std::atomic<uint64_t> nextClipId{ 1 };
+
+    // Single-producer ring from the audio thread to TakeFinished
+    std::vector<FinishedClip> finished;
+    std::atomic<size_t> finishedWrite{ 0 };
+    std::atomic<size_t> finishedRead{ 0 };
+    std::atomic<size_t> playingCount{ 0 };
+
+    // Audio thread only
+    static const size_t ScratchFrames = 256;
+    std::vector<Clip> clips;
+    std::vector<float> scratch;                 // Decoded frames of the compressed clip being mixed
+    float masterGain = 1.0f;
+    uint32_t sampleRate;
+    uint64_t renderedFrames = 0;
+    bool anchored = false;
+    std::chrono::steady_clock::time_point anchorTime;
+    double anchorFrame = 0.0;                   // Fractional, it is nudged a little each block
+};
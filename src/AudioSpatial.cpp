@@ -0,0 +1,118 @@
+#include "AudioSpatial.h"
+#include <cmath>
+
+#if defined(_M_X64) || defined(__SSE2__) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define AUDIO_SPATIAL_SSE2 1
+#include <emmintrin.h>
+#endif
+
+// Below this distance the direction is meaningless, the sound plays centred
+static const float SpatialMinDistance = 0.01f;
+
+// Listener's right-hand axis. Left-handed with Y up, so top x front.
+static void RightAxis(const SpatialListener& listener, float right[3]) {
+    const float* t = listener.top;
+    const float* f = listener.front;
+    right[0] = t[1] * f[2] - t[2] * f[1];
+    right[1] = t[2] * f[0] - t[0] * f[2];
+    right[2] = t[0] * f[1] - t[1] * f[0];
+
+    float length = std::sqrt(right[0] * right[0] + right[1] * right[1] + right[2] * right[2]);
+    if (length < 1e-6f) {
+        right[0] = 1.0f;
+        right[1] = 0.0f;
+        right[2] = 0.0f;
+        return;
+    }
+    for (int c = 0; c < 3; c++) {
+        right[c] /= length;
+    }
+}
+
+static void SpatializeFrom(const SpatialListener& listener, const float right[3], const float* x, const float* y,
+    const float* z, size_t begin, size_t end, float* pans, float* gains) {
+    const float* p = listener.position;
+    const float* f = listener.front;
+    for (size_t i = begin; i < end; i++) {
+        float dx = x[i] - p[0];
+        float dy = y[i] - p[1];
+        float dz = z[i] - p[2];
+        float distance = std::sqrt(dx * dx + dy * dy + dz * dz);
+        if (distance < SpatialMinDistance) {
+            pans[i] = 0.0f;
+            gains[i] = 1.0f;
+            continue;
+        }
+
+        // Sine of the angle to the right, and how far behind the sound is
+        float inverse = 1.0f / distance;
+        float side = (dx * right[0] + dy * right[1] + dz * right[2]) * inverse;
+        float ahead = (dx * f[0] + dy * f[1] + dz * f[2]) * inverse;
+        float behind = ahead < 0.0f ? -ahead : 0.0f;
+
+        float falloff = SpatialNearDistance * inverse;
+        falloff = falloff < 1.0f ? falloff : 1.0f;
+        falloff = falloff > SpatialMinGain ? falloff : SpatialMinGain;
+
+        pans[i] = side < -1.0f ? -1.0f : (side > 1.0f ? 1.0f : side);
+        gains[i] = falloff * (1.0f - (1.0f - SpatialRearGain) * behind);
+    }
+}
+
+void SpatializeBatchScalar(const SpatialListener& listener, const float* x, const float* y, const float* z,
+    size_t count, float* pans, float* gains) {
+    float right[3];
+    RightAxis(listener, right);
+    SpatializeFrom(listener, right, x, y, z, 0, count, pans, gains);
+}
+
+void SpatializeBatch(const SpatialListener& listener, const float* x, const float* y, const float* z,
+    size_t count, float* pans, float* gains) {
+    float right[3];
+    RightAxis(listener, right);
+
+    size_t i = 0;
+#ifdef AUDIO_SPATIAL_SSE2
+    const __m128 px = _mm_set1_ps(listener.position[0]);
+    const __m128 py = _mm_set1_ps(listener.position[1]);
+    const __m128 pz = _mm_set1_ps(listener.position[2]);
+    const __m128 rx = _mm_set1_ps(right[0]);
+    const __m128 ry = _mm_set1_ps(right[1]);
+    const __m128 rz = _mm_set1_ps(right[2]);
+    const __m128 fx = _mm_set1_ps(listener.front[0]);
+    const __m128 fy = _mm_set1_ps(listener.front[1]);
+    const __m128 fz = _mm_set1_ps(listener.front[2]);
+    const __m128 zero = _mm_setzero_ps();
+    const __m128 one = _mm_set1_ps(1.0f);
+    const __m128 minusOne = _mm_set1_ps(-1.0f);
+    const __m128 nearDistance = _mm_set1_ps(SpatialNearDistance);
+    const __m128 minGain = _mm_set1_ps(SpatialMinGain);
+    const __m128 rearLoss = _mm_set1_ps(1.0f - SpatialRearGain);
+    const __m128 minDistance = _mm_set1_ps(SpatialMinDistance);
+
+    for (; i + 4 <= count; i += 4) {
+        __m128 dx = _mm_sub_ps(_mm_loadu_ps(x + i), px);
+        __m128 dy = _mm_sub_ps(_mm_loadu_ps(y + i), py);
+        __m128 dz = _mm_sub_ps(_mm_loadu_ps(z + i), pz);
+        __m128 distance = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+        __m128 inverse = _mm_div_ps(one, distance);
+
+        __m128 side = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, rx), _mm_mul_ps(dy, ry)), _mm_mul_ps(dz, rz)), inverse);
+        __m128 ahead = _mm_mul_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, fx), _mm_mul_ps(dy, fy)), _mm_mul_ps(dz, fz)), inverse);
+        __m128 behind = _mm_max_ps(_mm_sub_ps(zero, ahead), zero);
+
+        __m128 falloff = _mm_max_ps(_mm_min_ps(_mm_mul_ps(nearDistance, inverse), one), minGain);
+        __m128 pan = _mm_max_ps(_mm_min_ps(side, one), minusOne);
+        __m128 gain = _mm_mul_ps(falloff, _mm_sub_ps(one, _mm_mul_ps(rearLoss, behind)));
+
+        // Too close for a direction: centred at full gain
+        __m128 close = _mm_cmplt_ps(distance, minDistance);
+        pan = _mm_andnot_ps(close, pan);
+        gain = _mm_or_ps(_mm_and_ps(close, one), _mm_andnot_ps(close, gain));
+
+        _mm_storeu_ps(pans + i, pan);
+        _mm_storeu_ps(gains + i, gain);
+    }
+#endif
+    SpatializeFrom(listener, right, x, y, z, i, count, pans, gains);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+// Positional alerts without HRTFs: a sound at a world position is panned by its angle
+// to the listener's right and attenuated with distance, and a little when behind.
+// Coordinates are MumbleLink's: metres, left-handed, Y up.
+
+// Where a sound comes from
+enum class SpatialMode : int {
+    Off = 0,            // Plays as set up, with its own pan
+    Position = 1,       // A point in the world
+    Direction = 2,      // A compass direction, the same wherever the player is
+};
+
+struct SoundEmitter {
+    SpatialMode mode = SpatialMode::Off;
+    float position[3] = {};         // World position, or a unit direction vector
+    uint32_t mapId = 0;             // Map a position belongs to, 0 for any
+
+    bool IsSpatial() const { return mode != SpatialMode::Off; }
+};
+
+struct SpatialListener {
+    float position[3] = {};
+    float front[3] = { 0.0f, 0.0f, 1.0f };
+    float top[3] = { 0.0f, 1.0f, 0.0f };
+};
+
+// Full gain inside this distance, falling off as 1/distance beyond it
+static const float SpatialNearDistance = 10.0f;
+// Distant alerts still have to be heard
+static const float SpatialMinGain = 0.3f;
+// Gain for a sound straight behind, blended in from the side
+static const float SpatialRearGain = 0.7f;
+
+// Pan and gain for count emitters given as separate x, y and z arrays. The SSE2 path does four
+// emitters a step in the same operation order as the scalar one, so both agree exactly.
+void SpatializeBatch(const SpatialListener& listener, const float* x, const float* y, const float* z,
+    size_t count, float* pans, float* gains);
+void SpatializeBatchScalar(const SpatialListener& listener, const float* x, const float* y, const float* z,
+    size_t count, float* pans, float* gains);
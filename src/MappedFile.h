@@ -0,0 +1,79 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <memory>
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only view of a whole file. The view keeps the file open after the handles are closed.
+// On Windows the file can still be renamed or deleted meanwhile, just not written; elsewhere
+// nothing stops a writer, which is why files that get mapped are replaced by renaming.
+class MappedFile {
+public:
+    static std::shared_ptr<MappedFile> Open(const std::string& path) {
+#ifdef _WIN32
+        HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE,
+            nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE) return nullptr;
+
+        // Empty files can't be mapped, and a WAV can't describe more than 4 GB anyway
+        LARGE_INTEGER size = {};
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 || size.QuadPart > MAXDWORD) {
+            CloseHandle(file);
+            return nullptr;
+        }
+
+        HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        CloseHandle(file);
+        if (!mapping) return nullptr;
+
+        void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        CloseHandle(mapping);
+        if (!view) return nullptr;
+
+        return std::shared_ptr<MappedFile>(new MappedFile(static_cast<const uint8_t*>(view), static_cast<size_t>(size.QuadPart)));
+#else
+        int file = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        if (file < 0) return nullptr;
+
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size <= 0 || static_cast<uint64_t>(info.st_size) > 0xFFFFFFFFull) {
+            close(file);
+            return nullptr;
+        }
+
+        void* view = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+        close(file);
+        if (view == MAP_FAILED) return nullptr;
+
+        return std::shared_ptr<MappedFile>(new MappedFile(static_cast<const uint8_t*>(view), static_cast<size_t>(info.st_size)));
+#endif
+    }
+
+    ~MappedFile() {
+#ifdef _WIN32
+        UnmapViewOfFile(data);
+#else
+        munmap(const_cast<uint8_t*>(data), size);
+#endif
+    }
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const uint8_t* Data() const { return data; }
+    size_t Size() const { return size; }
+
+private:
+    MappedFile(const uint8_t* view, size_t viewSize) : data(view), size(viewSize) {}
+
+    const uint8_t* data;
+    size_t size;
+};
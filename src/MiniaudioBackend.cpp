@@ -0,0 +1,406 @@
+#include "MiniaudioBackend.h"
+#include <algorithm>
+#include <cstring>
+#include <deque>
+
+// Source voice mixed by MiniaudioBackend. Each submitted buffer is converted once to float
+// at the output rate, keeping the source channel count so the pan matrix applies as-is.
+// Buffers are resampled independently, so streamed chunks at a foreign rate can click
+// slightly at the seams; alert clips are a single buffer and unaffected.
+class MiniaudioVoice : public IAudioVoice {
+public:
+    MiniaudioVoice(MiniaudioBackend* backend, const AudioFormat& voiceFormat)
+        : owner(backend), format(voiceFormat) {
+        ComputeStereoPanMatrix(format.channels, 0.0f, matrix);
+
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        owner->voices.push_back(this);
+    }
+
+    ~MiniaudioVoice() override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        owner->voices.erase(std::remove(owner->voices.begin(), owner->voices.end(), this), owner->voices.end());
+    }
+
+    const AudioFormat& GetFormat() const override { return format; }
+
+    bool Submit(const uint8_t* data, uint32_t bytes, bool endOfStream) override {
+        ma_format sourceFormat = ToMaFormat(format);
+        uint32_t blockAlign = format.BlockAlign();
+        if (sourceFormat == ma_format_unknown || blockAlign == 0) return false;
+
+        // Convert outside the lock, the mixer may be running
+        ma_uint64 framesIn = bytes / blockAlign;
+        ma_uint64 framesOut = ma_convert_frames(nullptr, 0, ma_format_f32, format.channels, MiniaudioBackend::OutputSampleRate,
+            data, framesIn, sourceFormat, format.channels, format.sampleRate);
+
+        std::vector<float> converted(static_cast<size_t>(framesOut) * format.channels);
+        if (framesOut > 0) {
+            framesOut = ma_convert_frames(converted.data(), framesOut, ma_format_f32, format.channels, MiniaudioBackend::OutputSampleRate,
+                data, framesIn, sourceFormat, format.channels, format.sampleRate);
+            converted.resize(static_cast<size_t>(framesOut) * format.channels);
+        }
+
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        queue.push_back(std::move(converted));
+        endQueued = endOfStream;
+        return true;
+    }
+
+    void EndStream() override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        endQueued = true;
+        if (queue.empty() && playing) {
+            playing = false;
+            NotifyFinished();
+        }
+    }
+
+    uint32_t GetQueuedBuffers() const override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        return static_cast<uint32_t>(queue.size());
+    }
+
+    bool Start() override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        playing = true;
+        return true;
+    }
+
+    void Reset() override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        playing = false;
+        started = false;
+        endQueued = false;
+        queue.clear();
+        cursor = 0;
+    }
+
+    void SetVolume(float newVolume) override {
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        volume = newVolume;
+    }
+
+    void SetPan(float pan) override {
+        float newMatrix[4];
+        ComputeStereoPanMatrix(format.channels, pan, newMatrix);
+
+        std::lock_guard<std::mutex> lock(owner->mixMutex);
+        std::copy(newMatrix, newMatrix + 4, matrix);
+    }
+
+    // Mixer thread, called with mixMutex held
+    void MixInto(float* out, uint32_t frameCount) {
+        if (!playing) return;
+
+        if (!started && !queue.empty()) {
+            started = true;
+            NotifyStarted();
+        }
+
+        size_t channels = format.channels;
+        size_t mixed = 0;
+        while (mixed < frameCount && !queue.empty()) {
+            const std::vector<float>& samples = queue.front();
+            size_t totalFrames = samples.size() / channels;
+            size_t frames = (std::min)(static_cast<size_t>(frameCount) - mixed, totalFrames - cursor);
+            MixFrames(out + mixed * 2, samples.data() + cursor * channels, frames);
+
+            mixed += frames;
+            cursor += frames;
+            if (cursor >= totalFrames) {
+                queue.pop_front();
+                cursor = 0;
+            }
+        }
+
+        // A stream that is still being decoded just underruns until the next chunk arrives
+        if (queue.empty() && endQueued) {
+            playing = false;
+            NotifyFinished();
+        }
+    }
+
+private:
+    void MixFrames(float* out, const float* src, size_t frames) {
+        size_t channels = format.channels;
+
+        // matrix[dest * channels + source], see ComputeStereoPanMatrix
+        if (channels == 1) {
+            float left = matrix[0] * volume;
+            float right = matrix[1] * volume;
+            for (size_t i = 0; i < frames; i++) {
+                out[i * 2] += src[i] * left;
+                out[i * 2 + 1] += src[i] * right;
+            }
+        }
+        else if (channels == 2) {
+            float ll = matrix[0] * volume, lr = matrix[1] * volume;
+            float rl = matrix[2] * volume, rr = matrix[3] * volume;
+            for (size_t i = 0; i < frames; i++) {
+                float l = src[i * 2];
+                float r = src[i * 2 + 1];
+                out[i * 2] += l * ll + r * lr;
+                out[i * 2 + 1] += l * rl + r * rr;
+            }
+        }
+        else {
+            // More than two channels: fold the first two into stereo, like XAudio2's default downmix would
+            for (size_t i = 0; i < frames; i++) {
+                out[i * 2] += src[i * channels] * volume;
+                out[i * 2 + 1] += src[i * channels + 1] * volume;
+            }
+        }
+    }
+
+    static ma_format ToMaFormat(const AudioFormat& format) {
+        if (format.formatTag == AudioFormat::Float && format.bitsPerSample == 32) return ma_format_f32;
+        if (format.formatTag != AudioFormat::PCM) return ma_format_unknown;
+        switch (format.bitsPerSample) {
+        case 8: return ma_format_u8;
+        case 16: return ma_format_s16;
+        case 24: return ma_format_s24;
+        case 32: return ma_format_s32;
+        default: return ma_format_unknown;
+        }
+    }
+
+    MiniaudioBackend* owner;
+    AudioFormat format;
+
+    // Playback state, guarded by owner->mixMutex
+    std::deque<std::vector<float>> queue;   // Converted buffers, front is playing
+    size_t cursor = 0;                      // Frame position in queue.front()
+    bool playing = false;
+    bool started = false;
+    bool endQueued = false;
+    float volume = 1.0f;
+    float matrix[4];
+};
+
+MiniaudioBackend::MiniaudioBackend(Output outputType, const std::string& path)
+    : output(outputType), wavPath(path) {}
+
+MiniaudioBackend::~MiniaudioBackend() {
+    Shutdown();
+}
+
+void MiniaudioBackend::DataCallback(ma_device* pDevice, void* pOutput, const void* /*pInput*/, ma_uint32 frameCount) {
+    static_cast<MiniaudioBackend*>(pDevice->pUserData)->Mix(static_cast<float*>(pOutput), frameCount);
+}
+
+bool MiniaudioBackend::Initialize(const std::wstring& deviceId) {
+    if (initialized) return true;
+
+    if (output == Output::WavFile) {
+        ma_encoder_config config = ma_encoder_config_init(ma_encoding_format_wav, ma_format_f32, OutputChannels, OutputSampleRate);
+        if (wavPath.empty() || ma_encoder_init_file(wavPath.c_str(), &config, &encoder) != MA_SUCCESS) {
+            return false;
+        }
+        encoderReady = true;
+        framesRendered = 0;
+        initialized = true;
+        return true;
+    }
+
+    if (!contextReady) {
+        ma_backend nullBackend[] = { ma_backend_null };
+        ma_result result = output == Output::Null
+            ? ma_context_init(nullBackend, 1, nullptr, &context)
+            : ma_context_init(nullptr, 0, nullptr, &context);
+        if (result != MA_SUCCESS) {
+            return false;
+        }
+        contextReady = true;
+    }
+
+    if (!StartDevice(deviceId)) {
+        ma_context_uninit(&context);
+        contextReady = false;
+        return false;
+    }
+
+    initialized = true;
+    return true;
+}
+
+void MiniaudioBackend::Shutdown() {
+    StopDevice();
+    StopRenderStream();
+
+    if (encoderReady) {
+        ma_encoder_uninit(&encoder);
+        encoderReady = false;
+    }
+
+    if (contextReady) {
+        ma_context_uninit(&context);
+        contextReady = false;
+    }
+
+    initialized = false;
+}
+
+bool MiniaudioBackend::StartDevice(const std::wstring& deviceId) {
+    // Device ids from EnumerateDevices are names, map them back to miniaudio's ids
+    ma_device_id selectedId;
+    bool hasSelectedId = false;
+    if (!deviceId.empty() && output == Output::Device) {
+        ma_device_info* playbackInfos = nullptr;
+        ma_uint32 playbackCount = 0;
+        if (ma_context_get_devices(&context, &playbackInfos, &playbackCount, nullptr, nullptr) == MA_SUCCESS) {
+            std::string name = WideToUtf8(deviceId);
+            for (ma_uint32 i = 0; i < playbackCount; i++) {
+                if (name == playbackInfos[i].name) {
+                    selectedId = playbackInfos[i].id;
+                    hasSelectedId = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    ma_device_config config = ma_device_config_init(ma_device_type_playback);
+    config.playback.pDeviceID = hasSelectedId ? &selectedId : nullptr;
+    config.playback.format = ma_format_f32;
+    config.playback.channels = OutputChannels;
+    config.sampleRate = OutputSampleRate;
+    config.dataCallback = DataCallback;
+    config.pUserData = this;
+
+    ma_result result = ma_device_init(&context, &config, &device);
+    if (result != MA_SUCCESS && hasSelectedId) {
+        // If the specific device fails, try the default
+        config.playback.pDeviceID = nullptr;
+        result = ma_device_init(&context, &config, &device);
+    }
+    if (result != MA_SUCCESS) {
+        return false;
+    }
+    deviceReady = true;
+
+    if (ma_device_start(&device) != MA_SUCCESS) {
+        StopDevice();
+        return false;
+    }
+    return true;
+}
+
+void MiniaudioBackend::StopDevice() {
+    if (deviceReady) {
+        ma_device_uninit(&device);
+        deviceReady = false;
+    }
+}
+
+bool MiniaudioBackend::EnumerateDevices(std::vector<AudioDevice>& devices) {
+    devices.clear();
+
+    if (output == Output::Null) {
+        AudioDevice device;
+        device.name = L"Null Output";
+        device.isDefault = true;
+        devices.push_back(device);
+        return true;
+    }
+
+    if (output == Output::WavFile) {
+        AudioDevice device;
+        device.name = L"WAV File: " + Utf8ToWide(wavPath);
+        device.isDefault = true;
+        devices.push_back(device);
+        return true;
+    }
+
+    // Listing works before Initialize, open a temporary context if we have none yet
+    ma_context tempContext;
+    ma_context* pContext = &context;
+    if (!contextReady) {
+        if (ma_context_init(nullptr, 0, nullptr, &tempContext) != MA_SUCCESS) {
+            return false;
+        }
+        pContext = &tempContext;
+    }
+
+    ma_device_info* playbackInfos = nullptr;
+    ma_uint32 playbackCount = 0;
+    if (ma_context_get_devices(pContext, &playbackInfos, &playbackCount, nullptr, nullptr) == MA_SUCCESS) {
+        for (ma_uint32 i = 0; i < playbackCount; i++) {
+            AudioDevice device;
+            device.name = Utf8ToWide(playbackInfos[i].name);
+            device.id = device.name;
+            device.isDefault = playbackInfos[i].isDefault != MA_FALSE;
+            devices.push_back(device);
+        }
+    }
+
+    if (pContext == &tempContext) {
+        ma_context_uninit(&tempContext);
+    }
+
+    return !devices.empty();
+}
+
+bool MiniaudioBackend::SetOutputDevice(const std::wstring& deviceId) {
+    if (!initialized) return false;
+    if (output != Output::Device) return true;
+
+    StopDevice();
+    return StartDevice(deviceId);
+}
+
+IAudioVoice* MiniaudioBackend::CreateVoice(const AudioFormat& format) {
+    if (!initialized || !format.IsValid()) return nullptr;
+    return new MiniaudioVoice(this, format);
+}
+
+bool MiniaudioBackend::StartRenderStream(const AudioFormat& format, AudioRenderCallback render) {
+    if (!initialized || !render) return false;
+    if (format.formatTag != AudioFormat::Float || format.bitsPerSample != 32 ||
+        format.channels != OutputChannels || format.sampleRate != OutputSampleRate) {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mixMutex);
+    renderStream = std::move(render);
+    return true;
+}
+
+void MiniaudioBackend::StopRenderStream() {
+    std::lock_guard<std::mutex> lock(mixMutex);
+    renderStream = nullptr;
+}
+
+void MiniaudioBackend::Mix(float* out, uint32_t frameCount) {
+    size_t samples = static_cast<size_t>(frameCount) * OutputChannels;
+    std::fill(out, out + samples, 0.0f);
+
+    std::lock_guard<std::mutex> lock(mixMutex);
+    if (renderStream) {
+        if (streamBuffer.size() < samples) {
+            streamBuffer.resize(samples);
+        }
+        renderStream(streamBuffer.data(), frameCount);
+        for (size_t i = 0; i < samples; i++) {
+            out[i] += streamBuffer[i];
+        }
+    }
+
+    for (MiniaudioVoice* voice : voices) {
+        voice->MixInto(out, frameCount);
+    }
+}
+
+bool MiniaudioBackend::Render(uint32_t frameCount) {
+    if (!encoderReady) return false;
+
+    renderBuffer.resize(static_cast<size_t>(frameCount) * OutputChannels);
+    Mix(renderBuffer.data(), frameCount);
+
+    ma_uint64 written = 0;
+    if (ma_encoder_write_pcm_frames(&encoder, renderBuffer.data(), frameCount, &written) != MA_SUCCESS) {
+        return false;
+    }
+    framesRendered += written;
+    return written == frameCount;
+}
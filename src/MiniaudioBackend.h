@@ -0,0 +1,77 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include "AudioBackend.h"
+#include "miniaudio.h"
+
+class MiniaudioVoice;
+
+// IAudioBackend on miniaudio. Voices and the render stream are mixed in software to
+// 48 kHz stereo float using the same pan matrix as the XAudio2 backend, then sent to one of:
+//   Device  - a real playback device through miniaudio's platform backends
+//   Null    - miniaudio's null device, which pulls audio in real time and discards it
+//   WavFile - nothing pulls; Render() mixes a fixed number of frames into a WAV file
+// The WavFile output makes playback deterministic, so a run can be compared sample
+// for sample against an expected waveform.
+class MiniaudioBackend : public IAudioBackend {
+public:
+    enum class Output {
+        Device,
+        Null,
+        WavFile
+    };
+
+    static const uint32_t OutputChannels = 2;
+    static const uint32_t OutputSampleRate = 48000;
+
+    explicit MiniaudioBackend(Output output = Output::Device, const std::string& wavPath = "");
+    ~MiniaudioBackend() override;
+
+    const char* GetName() const override { return "miniaudio"; }
+
+    bool Initialize(const std::wstring& deviceId) override;
+    void Shutdown() override;
+
+    bool EnumerateDevices(std::vector<AudioDevice>& devices) override;
+    bool SetOutputDevice(const std::wstring& deviceId) override;
+
+    IAudioVoice* CreateVoice(const AudioFormat& format) override;
+
+    // Only the output format (48 kHz stereo float) is accepted
+    bool StartRenderStream(const AudioFormat& format, AudioRenderCallback render) override;
+    void StopRenderStream() override;
+
+    // Mix every started voice into frameCount interleaved stereo frames, overwriting out
+    void Mix(float* out, uint32_t frameCount);
+
+    // WavFile output only: mix frameCount frames and append them to the file
+    bool Render(uint32_t frameCount);
+    uint64_t GetFramesRendered() const { return framesRendered; }
+
+private:
+    friend class MiniaudioVoice;
+
+    static void DataCallback(ma_device* pDevice, void* pOutput, const void* pInput, ma_uint32 frameCount);
+    bool StartDevice(const std::wstring& deviceId);
+    void StopDevice();
+
+    Output output;
+    std::string wavPath;
+    bool initialized = false;
+
+    ma_context context = {};
+    bool contextReady = false;
+    ma_device device = {};
+    bool deviceReady = false;
+    ma_encoder encoder = {};
+    bool encoderReady = false;
+
+    mutable std::mutex mixMutex;            // Guards voices and their playback state
+    std::vector<MiniaudioVoice*> voices;    // Every live voice, playing or idle
+    AudioRenderCallback renderStream;       // Guarded by mixMutex too
+    std::vector<float> streamBuffer;        // Scratch for the render stream
+    std::vector<float> renderBuffer;        // Scratch for Render()
+    uint64_t framesRendered = 0;
+};
@@ -0,0 +1,100 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+
+// Lock-free multi-producer, single-consumer queue. Producers push from any thread;
+// the single consumer takes everything pushed so far in one exchange, in push order.
+// Taking the whole list at once means the consumer never races a pop, so there is
+// no ABA problem to guard against.
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        T value;
+        Node* next;
+    };
+
+    std::atomic<Node*> head{ nullptr };     // Most recently pushed node
+    std::atomic<Node*> retired{ nullptr };  // Nodes Drain is done with, freed by the next Push
+
+    static void FreeList(Node* node) {
+        while (node) {
+            Node* next = node->next;
+            delete node;
+            node = next;
+        }
+    }
+
+public:
+    MpscQueue() {}
+    ~MpscQueue() {
+        FreeList(head.exchange(nullptr));
+        FreeList(retired.exchange(nullptr));
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void Push(T value) {
+        // Each producer takes a whole retired chain, so concurrent pushes never share one
+        FreeList(retired.exchange(nullptr, std::memory_order_acquire));
+
+        Node* node = new Node{ std::move(value), head.load(std::memory_order_relaxed) };
+        while (!head.compare_exchange_weak(node->next, node, std::memory_order_release, std::memory_order_relaxed)) {
+        }
+    }
+
+    // Consumer only
+    std::vector<T> PopAll() {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+
+        // The list is newest-first, reverse it to hand items back in push order
+        Node* reversed = nullptr;
+        size_t count = 0;
+        while (node) {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+            count++;
+        }
+
+        std::vector<T> items;
+        items.reserve(count);
+        while (reversed) {
+            Node* next = reversed->next;
+            items.push_back(std::move(reversed->value));
+            delete reversed;
+            reversed = next;
+        }
+        return items;
+    }
+
+    // Consumer only. Hands each item to consume in push order without allocating or freeing
+    // anything: the nodes go back to the producer side and the next Push frees them, so a
+    // real-time consumer never touches the heap. consume may move out of the item.
+    template <typename F>
+    void Drain(F&& consume) {
+        Node* node = head.exchange(nullptr, std::memory_order_acquire);
+        if (!node) return;
+
+        Node* reversed = nullptr;
+        Node* last = node;
+        while (node) {
+            Node* next = node->next;
+            node->next = reversed;
+            reversed = node;
+            node = next;
+        }
+        for (Node* item = reversed; item; item = item->next) {
+            consume(item->value);
+        }
+
+        Node* old = retired.load(std::memory_order_relaxed);
+        do {
+            last->next = old;
+        } while (!retired.compare_exchange_weak(old, reversed, std::memory_order_release, std::memory_order_relaxed));
+    }
+
+    bool Empty() const { return head.load(std::memory_order_acquire) == nullptr; }
+};
@@ -0,0 +1,403 @@
+#include "PcmCache.h"
+#include "AudioConvert.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <vector>
+#include <set>
+#include "nlohmann/json.hpp"
+
+using json = nlohmann::json;
+
+// Blob layout: this header, then frames of interleaved engine-format samples
+struct PcmBlobHeader {
+    char magic[4];                  // "SPCM"
+    uint32_t version;
+    uint32_t sampleRate;
+    uint32_t channels;
+    uint64_t frames;
+    uint64_t reserved;              // Pads the samples to a 32 byte offset
+};
+
+static const uint32_t PcmBlobVersion = 1;
+static const uint64_t FnvOffset = 14695981039346656037ull;
+static const uint64_t FnvPrime = 1099511628211ull;
+
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FnvOffset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FnvPrime;
+    }
+    return hash;
+}
+
+static std::string BlobName(uint64_t hash) {
+    char name[24];
+    snprintf(name, sizeof(name), "%016llx.pcm", static_cast<unsigned long long>(hash));
+    return name;
+}
+
+static bool StatFile(const std::string& path, uint64_t& size, int64_t& modified) {
+    std::error_code error;
+    std::filesystem::path filePath = std::filesystem::u8path(path);
+    size = static_cast<uint64_t>(std::filesystem::file_size(filePath, error));
+    if (error) return false;
+    auto time = std::filesystem::last_write_time(filePath, error);
+    if (error) return false;
+    modified = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+// Hash of the source file's bytes, so identical files map to one blob
+static bool HashFile(const std::string& path, uint64_t& hash) {
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file.is_open()) return false;
+
+    std::vector<char> chunk(64 * 1024);
+    hash = FnvOffset;
+    while (file) {
+        file.read(chunk.data(), chunk.size());
+        hash = HashBytes(chunk.data(), static_cast<size_t>(file.gcount()), hash);
+    }
+    return file.eof();
+}
+
+bool PcmCache::Start(const std::string& cacheDirectory) {
+    if (thread.joinable() || cacheDirectory.empty()) return false;
+
+    std::error_code error;
+    std::filesystem::create_directories(std::filesystem::u8path(cacheDirectory), error);
+    if (error) return false;
+
+    directory = cacheDirectory;
+    LoadIndex();
+    stopping = false;
+    thread = std::thread(&PcmCache::Run, this);
+    return true;
+}
+
+void PcmCache::Stop() {
+    if (!thread.joinable()) return;
+
+    // Writes still queued are dropped, those sounds are decoded again next time
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        jobs.clear();
+    }
+    wake.notify_all();
+    thread.join();
+    SaveIndex();
+}
+
+bool PcmCache::LookupFile(const std::string& path, Blob& blob) {
+    uint64_t size = 0;
+    int64_t modified = 0;
+    std::string blobName;
+    if (StatFile(path, size, modified)) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = files.find(path);
+        if (it != files.end() && it->second.size == size && it->second.modified == modified) {
+            blobName = it->second.blob;
+        }
+    }
+
+    if (blobName.empty() || !MapBlob(blobName, blob)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+bool PcmCache::LookupKey(const std::string& key, Blob& blob) {
+    std::string blobName;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto it = keys.find(key);
+        if (it != keys.end()) {
+            blobName = it->second;
+        }
+    }
+
+    if (blobName.empty() || !MapBlob(blobName, blob)) {
+        misses++;
+        return false;
+    }
+    hits++;
+    return true;
+}
+
+void PcmCache::StoreFile(const std::string& path, const float* samples, size_t frames, std::shared_ptr<void> keepAlive) {
+    if (!samples || frames == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) return;
+
+        Job job;
+        job.name = path;
+        job.isFile = true;
+        job.samples = samples;
+        job.frames = frames;
+        job.keepAlive = std::move(keepAlive);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void PcmCache::StoreKey(const std::string& key, const float* samples, size_t frames, std::shared_ptr<void> keepAlive) {
+    if (!samples || frames == 0) return;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!thread.joinable()) return;
+
+        Job job;
+        job.name = key;
+        job.samples = samples;
+        job.frames = frames;
+        job.keepAlive = std::move(keepAlive);
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+}
+
+void PcmCache::RetainKeys(std::set<std::string> liveKeys) {
+    if (!thread.joinable()) return;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        retainedKeys = std::move(liveKeys);
+        keySweepRequested = true;
+    }
+    wake.notify_one();
+}
+
+PcmCache::Stats PcmCache::GetStats() const {
+    Stats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.writes = writes.load();
+    return stats;
+}
+
+void PcmCache::Run() {
+    // Which keys are still wanted is only known once the saved TTS sounds are loaded,
+    // RetainKeys sweeps those later
+    RemoveOrphans(nullptr);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    while (true) {
+        wake.wait(lock, [this] { return stopping || keySweepRequested || !jobs.empty(); });
+        if (stopping) break;
+
+        if (keySweepRequested) {
+            std::set<std::string> liveKeys = std::move(retainedKeys);
+            retainedKeys.clear();
+            keySweepRequested = false;
+            lock.unlock();
+
+            RemoveOrphans(&liveKeys);
+            SaveIndex();
+
+            lock.lock();
+            continue;
+        }
+
+        Job job = std::move(jobs.front());
+        jobs.pop_front();
+        lock.unlock();
+
+        Write(job);
+        job.keepAlive.reset();
+
+        lock.lock();
+        bool idle = jobs.empty();
+        lock.unlock();
+
+        // Write the index once a batch of loads is stored rather than after every sound
+        if (idle) {
+            SaveIndex();
+        }
+        lock.lock();
+    }
+}
+
+void PcmCache::Write(const Job& job) {
+    FileEntry entry;
+    uint64_t hash = 0;
+    if (job.isFile) {
+        if (!StatFile(job.name, entry.size, entry.modified) || !HashFile(job.name, hash)) return;
+    }
+    else {
+        hash = HashBytes(job.name.data(), job.name.size(), HashBytes("key:", 4));
+    }
+    entry.blob = BlobName(hash);
+
+    // A blob already on disk came from identical content
+    std::error_code error;
+    if (!std::filesystem::exists(std::filesystem::u8path(BlobPath(entry.blob)), error)) {
+        if (!WriteBlob(entry.blob, job.samples, job.frames)) return;
+        writes++;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (job.isFile) {
+        files[job.name] = entry;
+    }
+    else {
+        keys[job.name] = entry.blob;
+    }
+    indexDirty = true;
+}
+
+bool PcmCache::MapBlob(const std::string& blobName, Blob& blob) {
+    std::shared_ptr<MappedFile> mapped = MappedFile::Open(BlobPath(blobName));
+    if (!mapped || mapped->Size() < sizeof(PcmBlobHeader)) return false;
+
+    PcmBlobHeader header;
+    memcpy(&header, mapped->Data(), sizeof(header));
+    uint64_t frameBytes = static_cast<uint64_t>(EngineChannels) * sizeof(float);
+    if (memcmp(header.magic, "SPCM", 4) != 0 || header.version != PcmBlobVersion ||
+        header.sampleRate != EngineSampleRate || header.channels != EngineChannels || header.frames == 0 ||
+        mapped->Size() != sizeof(PcmBlobHeader) + header.frames * frameBytes) {
+        return false;
+    }
+
+    blob.samples = reinterpret_cast<const float*>(mapped->Data() + sizeof(PcmBlobHeader));
+    blob.frames = static_cast<size_t>(header.frames);
+    blob.backing = std::move(mapped);
+    return true;
+}
+
+bool PcmCache::WriteBlob(const std::string& blobName, const float* samples, size_t frames) {
+    PcmBlobHeader header = {};
+    memcpy(header.magic, "SPCM", 4);
+    header.version = PcmBlobVersion;
+    header.sampleRate = EngineSampleRate;
+    header.channels = EngineChannels;
+    header.frames = frames;
+
+    // Written beside the blob and renamed, a partial blob never has the real name
+    std::string path = BlobPath(blobName);
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(std::filesystem::u8path(tempPath), std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) return false;
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        file.write(reinterpret_cast<const char*>(samples), static_cast<std::streamsize>(frames * EngineChannels * sizeof(float)));
+        if (!file.good()) {
+            file.close();
+            std::error_code error;
+            std::filesystem::remove(std::filesystem::u8path(tempPath), error);
+            return false;
+        }
+    }
+
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::u8path(tempPath), std::filesystem::u8path(path), error);
+    return !error;
+}
+
+void PcmCache::RemoveOrphans(const std::set<std::string>* liveKeys) {
+    // Files that are gone and keys no longer live leave the index, then blobs of changed
+    // or deleted sources and writes cut short are no longer referenced
+    std::set<std::string> referenced;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto it = files.begin(); it != files.end();) {
+            std::error_code error;
+            if (!std::filesystem::exists(std::filesystem::u8path(it->first), error)) {
+                it = files.erase(it);
+                indexDirty = true;
+                continue;
+            }
+            referenced.insert(it->second.blob);
+            ++it;
+        }
+        for (auto it = keys.begin(); it != keys.end();) {
+            if (liveKeys && liveKeys->find(it->first) == liveKeys->end()) {
+                it = keys.erase(it);
+                indexDirty = true;
+                continue;
+            }
+            referenced.insert(it->second);
+            ++it;
+        }
+    }
+
+    std::error_code error;
+    for (const auto& entry : std::filesystem::directory_iterator(std::filesystem::u8path(directory), error)) {
+        std::string name = entry.path().filename().u8string();
+        std::string extension = entry.path().extension().u8string();
+        if ((extension == ".pcm" && referenced.find(name) == referenced.end()) || extension == ".tmp") {
+            std::error_code removeError;
+            std::filesystem::remove(entry.path(), removeError);
+        }
+    }
+}
+
+void PcmCache::LoadIndex() {
+    std::ifstream file(std::filesystem::u8path(directory + "/index.json"));
+    if (!file.is_open()) return;
+
+    json data = json::parse(file, nullptr, false);
+    if (data.is_discarded() || !data.is_object() || data.value("version", 0) != 1) return;
+
+    std::lock_guard<std::mutex> lock(mutex);
+    if (data.contains("files") && data["files"].is_object()) {
+        for (const auto& [path, value] : data["files"].items()) {
+            if (!value.is_object()) continue;
+
+            FileEntry entry;
+            entry.size = value.value("size", static_cast<uint64_t>(0));
+            entry.modified = value.value("modified", static_cast<int64_t>(0));
+            entry.blob = value.value("blob", std::string());
+            if (!entry.blob.empty()) {
+                files[path] = entry;
+            }
+        }
+    }
+    if (data.contains("keys") && data["keys"].is_object()) {
+        for (const auto& [key, value] : data["keys"].items()) {
+            if (value.is_string()) {
+                keys[key] = value.get<std::string>();
+            }
+        }
+    }
+}
+
+void PcmCache::SaveIndex() {
+    json fileList = json::object();
+    json keyList = json::object();
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!indexDirty) return;
+        indexDirty = false;
+
+        for (const auto& [path, entry] : files) {
+            fileList[path] = { { "size", entry.size }, { "modified", entry.modified }, { "blob", entry.blob } };
+        }
+        for (const auto& [key, blobName] : keys) {
+            keyList[key] = blobName;
+        }
+    }
+
+    json data = { { "version", 1 }, { "files", std::move(fileList) }, { "keys", std::move(keyList) } };
+
+    std::string path = directory + "/index.json";
+    std::string tempPath = path + ".tmp";
+    {
+        std::ofstream file(std::filesystem::u8path(tempPath), std::ios::trunc);
+        if (!file.is_open()) return;
+        file << data.dump();
+        if (!file.good()) return;
+    }
+    std::error_code error;
+    std::filesystem::rename(std::filesystem::u8path(tempPath), std::filesystem::u8path(path), error);
+}
+
+std::string PcmCache::BlobPath(const std::string& blobName) const {
+    return directory + "/" + blobName;
+}
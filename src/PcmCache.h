@@ -0,0 +1,101 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <deque>
+#include <map>
+#include <set>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+
+// On-disk cache of decoded sounds in the engine format (48 kHz stereo float), so a warm
+// start maps PCM from disk instead of decoding files or synthesizing speech again.
+//
+// Blobs are content addressed: a file's blob is named by a hash of the source file, so
+// copies and renames share one, and keyed sounds (TTS voice and text) by a hash of the key.
+// A compact index maps paths, checked by size and modification time, and keys to blobs.
+// Writes, hashing and the index file are handled on a worker thread.
+class PcmCache {
+public:
+    // Mapped PCM; backing keeps the mapping alive
+    struct Blob {
+        const float* samples = nullptr;
+        size_t frames = 0;
+        std::shared_ptr<void> backing;
+    };
+
+    struct Stats {
+        uint64_t hits = 0;          // Sounds mapped from the cache
+        uint64_t misses = 0;        // Lookups that found nothing usable
+        uint64_t writes = 0;        // Blobs written
+    };
+
+    PcmCache() {}
+    ~PcmCache() { Stop(); }
+    PcmCache(const PcmCache&) = delete;
+    PcmCache& operator=(const PcmCache&) = delete;
+
+    // Loads the index from the directory, creating it if needed, and starts the worker
+    bool Start(const std::string& cacheDirectory);
+    void Stop();
+
+    // PCM for the file as it is on disk now, or for a key
+    bool LookupFile(const std::string& path, Blob& blob);
+    bool LookupKey(const std::string& key, Blob& blob);
+
+    // Write PCM in the engine format. keepAlive holds the samples until it is written.
+    void StoreFile(const std::string& path, const float* samples, size_t frames, std::shared_ptr<void> keepAlive);
+    void StoreKey(const std::string& key, const float* samples, size_t frames, std::shared_ptr<void> keepAlive);
+
+    // Forget keyed sounds that are not in liveKeys, such as deleted saved TTS sounds, and
+    // remove their blobs. The sweep runs on the worker.
+    void RetainKeys(std::set<std::string> liveKeys);
+
+    Stats GetStats() const;
+
+private:
+    struct Job {
+        std::string name;           // Path or key
+        bool isFile = false;
+        const float* samples = nullptr;
+        size_t frames = 0;
+        std::shared_ptr<void> keepAlive;
+    };
+
+    struct FileEntry {
+        uint64_t size = 0;
+        int64_t modified = 0;
+        std::string blob;
+    };
+
+    void Run();
+    void Write(const Job& job);
+    bool MapBlob(const std::string& blobName, Blob& blob);
+    bool WriteBlob(const std::string& blobName, const float* samples, size_t frames);
+    void RemoveOrphans(const std::set<std::string>* liveKeys);
+    void LoadIndex();
+    void SaveIndex();
+    std::string BlobPath(const std::string& blobName) const;
+
+    std::string directory;
+    std::thread thread;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<Job> jobs;
+
+    // Guarded by mutex
+    std::map<std::string, FileEntry> files;
+    std::map<std::string, std::string> keys;
+    bool indexDirty = false;
+    bool keySweepRequested = false;
+    std::set<std::string> retainedKeys;     // For the requested sweep
+
+    std::atomic<uint64_t> hits{ 0 };
+    std::atomic<uint64_t> misses{ 0 };
+    std::atomic<uint64_t> writes{ 0 };
+};
@@ -0,0 +1,65 @@
+#include "RecentSounds.h"
+#include "settings.h"
+
+void RecentSoundLog::Start() {
+    if (thread.joinable()) return;
+
+    stopping = false;
+    running = true;
+    thread = std::thread(&RecentSoundLog::Run, this);
+}
+
+void RecentSoundLog::Stop() {
+    if (!thread.joinable()) return;
+
+    running = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    thread.join();
+    Flush(true);
+}
+
+void RecentSoundLog::Run() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopping) {
+        // The list only feeds the UI and the saved file, a couple of seconds late is fine
+        wake.wait_for(lock, std::chrono::seconds(2), [this] { return stopping; });
+
+        lock.unlock();
+        Flush(false);
+        lock.lock();
+    }
+}
+
+void RecentSoundLog::Flush(bool final) {
+    std::vector<SoundID> played = events.PopAll();
+    if (played.empty()) return;
+
+    std::vector<std::string> ids;
+    ids.reserve(played.size());
+    for (const auto& soundId : played) {
+        // Back-to-back repeats of one sound move nothing in the list
+        std::string id = soundId.ToString();
+        if (ids.empty() || ids.back() != id) {
+            ids.push_back(std::move(id));
+        }
+    }
+
+    try {
+        if (Settings::AddRecentSounds(ids) && !SettingsPath.empty()) {
+            // The debounced save runs on a detached thread, which can't outlive an unload
+            if (final) {
+                Settings::Save(SettingsPath);
+            }
+            else {
+                Settings::ScheduleSave(SettingsPath);
+            }
+        }
+    }
+    catch (...) {
+        // Losing a recent-sound update is harmless
+    }
+}
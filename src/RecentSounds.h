@@ -0,0 +1,42 @@
+#pragma once
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include "Sounds.h"
+#include "MpscQueue.h"
+
+// Recent-sound bookkeeping kept off the playback path. Plays are pushed onto a lock-free
+// queue; a background thread folds them into the settings' recent list every few
+// seconds and schedules a save only when the list actually changed.
+class RecentSoundLog {
+public:
+    RecentSoundLog() {}
+    ~RecentSoundLog() { Stop(); }
+    RecentSoundLog(const RecentSoundLog&) = delete;
+    RecentSoundLog& operator=(const RecentSoundLog&) = delete;
+
+    void Start();
+    void Stop();    // Folds in whatever is still queued
+
+    // Any thread; dropped while the log isn't running
+    void Record(const SoundID& soundId) {
+        if (running.load(std::memory_order_relaxed)) {
+            events.Push(soundId);
+        }
+    }
+
+private:
+    void Run();
+    void Flush(bool final);
+
+    MpscQueue<SoundID> events;
+    std::atomic<bool> running{ false };
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+};
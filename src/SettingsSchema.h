@@ -0,0 +1,223 @@
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include "nlohmann/json.hpp"
+
+// Compile-time field tables for settings structs.
+//
+// Each serializable struct specializes Schema::Of<T> with a constexpr tuple of
+// fields. JSON reading, JSON writing, defaulting, validation and the compact
+// binary encoding are all generated from that single table, so adding a field
+// means adding one line instead of touching toJson/fromJson/Load/Save.
+namespace Schema {
+
+    using json = nlohmann::json;
+
+    // Default marker for fields that keep their current value when the key is missing
+    struct KeepValue {};
+
+    constexpr size_t KeyLength(const char* key) {
+        size_t length = 0;
+        while (key[length] != '\0') {
+            ++length;
+        }
+        return length;
+    }
+
+    template <typename Owner, typename T, typename Default>
+    struct Field {
+        const char* key;
+        size_t keyLength;
+        T Owner::* member;
+        Default defaultValue;
+        bool (*validate)(const T&);     // Optional; a value failing validation falls back to the default
+    };
+
+    template <typename T>
+    struct Identity { using type = T; };
+
+    // The validator is non-deduced so captureless lambdas convert in place
+    template <typename Owner, typename T, typename Default>
+    constexpr Field<Owner, T, Default> MakeField(const char* key, T Owner::* member, Default defaultValue,
+        typename Identity<bool (*)(const T&)>::type validate = nullptr) {
+        return Field<Owner, T, Default>{ key, KeyLength(key), member, defaultValue, validate };
+    }
+
+    // Specialize with `static constexpr auto fields = std::make_tuple(MakeField(...), ...);`
+    template <typename T>
+    struct Of;
+
+    template <typename T, typename = void>
+    struct HasSchema : std::false_type {};
+
+    template <typename T>
+    struct HasSchema<T, std::void_t<decltype(Of<T>::fields)>> : std::true_type {};
+
+    // Binary helpers (little-endian, matches every platform the addon runs on)
+    template <typename T>
+    inline void AppendRaw(std::string& out, const T& value) {
+        out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+
+    template <typename T>
+    inline bool ReadRaw(const char*& p, const char* end, T& value) {
+        if (static_cast<size_t>(end - p) < sizeof(T)) return false;
+        std::memcpy(&value, p, sizeof(T));
+        p += sizeof(T);
+        return true;
+    }
+
+    // Per-type codecs. Read returns false on a type mismatch so the field keeps its default.
+    template <typename T, typename Enable = void>
+    struct Codec;
+
+    template <>
+    struct Codec<bool> {
+        static bool Read(const json& j, bool& out) {
+            if (!j.is_boolean()) return false;
+            out = j.get<bool>();
+            return true;
+        }
+        static void Write(json& j, const bool& value) { j = value; }
+        static void WriteBinary(std::string& out, const bool& value) { out.push_back(value ? 1 : 0); }
+        static bool ReadBinary(const char*& p, const char* end, bool& value) {
+            uint8_t raw = 0;
+            if (!ReadRaw(p, end, raw)) return false;
+            value = raw != 0;
+            return true;
+        }
+    };
+
+    template <typename T>
+    struct Codec<T, std::enable_if_t<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>>> {
+        static bool Read(const json& j, T& out) {
+            if (!j.is_number()) return false;
+            out = j.get<T>();
+            return true;
+        }
+        static void Write(json& j, const T& value) { j = value; }
+        static void WriteBinary(std::string& out, const T& value) { AppendRaw(out, value); }
+        static bool ReadBinary(const char*& p, const char* end, T& value) { return ReadRaw(p, end, value); }
+    };
+
+    template <>
+    struct Codec<std::string> {
+        static bool Read(const json& j, std::string& out) {
+            if (!j.is_string()) return false;
+            out = j.get_ref<const std::string&>();
+            return true;
+        }
+        static void Write(json& j, const std::string& value) { j = value; }
+        static void WriteBinary(std::string& out, const std::string& value) {
+            AppendRaw(out, static_cast<uint32_t>(value.size()));
+            out.append(value);
+        }
+        static bool ReadBinary(const char*& p, const char* end, std::string& value) {
+            uint32_t length = 0;
+            if (!ReadRaw(p, end, length)) return false;
+            if (static_cast<size_t>(end - p) < length) return false;
+            value.assign(p, length);
+            p += length;
+            return true;
+        }
+    };
+
+    template <typename T>
+    void FromJson(const json& j, T& obj);
+    template <typename T>
+    void MergeJson(const json& j, T& obj);
+    template <typename T>
+    json ToJson(const T& obj);
+    template <typename T>
+    void WriteBinary(std::string& out, const T& obj);
+    template <typename T>
+    bool ReadBinary(const char*& p, const char* end, T& obj);
+
+    // Nested structs with their own schema
+    template <typename T>
+    struct Codec<T, std::enable_if_t<HasSchema<T>::value>> {
+        static bool Read(const json& j, T& out) {
+            if (!j.is_object()) return false;
+            FromJson(j, out);
+            return true;
+        }
+        static void Write(json& j, const T& value) { j = ToJson(value); }
+        static void WriteBinary(std::string& out, const T& value) { Schema::WriteBinary(out, value); }
+        static bool ReadBinary(const char*& p, const char* end, T& value) { return Schema::ReadBinary(p, end, value); }
+    };
+
+    namespace Detail {
+        template <typename Owner, typename T, typename Default>
+        void ApplyDefault(const Field<Owner, T, Default>& field, Owner& obj) {
+            if constexpr (!std::is_same_v<Default, KeepValue>) {
+                obj.*field.member = T(field.defaultValue);
+            }
+        }
+
+        template <typename Owner, typename T, typename Default>
+        bool ReadIfKey(const Field<Owner, T, Default>& field, const std::string& key, const json& value, Owner& obj) {
+            if (key.size() != field.keyLength || std::memcmp(key.data(), field.key, field.keyLength) != 0) {
+                return false;
+            }
+
+            T parsed = obj.*field.member;
+            if (Codec<T>::Read(value, parsed) && (!field.validate || field.validate(parsed))) {
+                obj.*field.member = std::move(parsed);
+            }
+            return true;    // Key consumed, stop looking at the remaining fields
+        }
+
+        template <typename Owner, typename T, typename Default>
+        void WriteField(const Field<Owner, T, Default>& field, json& j, const Owner& obj) {
+            Codec<T>::Write(j[field.key], obj.*field.member);
+        }
+    }
+
+    // Reads every key of `j` once and dispatches it to the matching field.
+    // Fields missing from the document get their declared default.
+    template <typename T>
+    void FromJson(const json& j, T& obj) {
+        std::apply([&](const auto&... field) { (Detail::ApplyDefault(field, obj), ...); }, Of<T>::fields);
+        MergeJson(j, obj);
+    }
+
+    // As FromJson, but fields missing from the document keep their current value
+    template <typename T>
+    void MergeJson(const json& j, T& obj) {
+        const auto& fields = Of<T>::fields;
+        if (!j.is_object()) return;
+
+        for (auto it = j.begin(); it != j.end(); ++it) {
+            const std::string& key = it.key();
+            const json& value = it.value();
+            std::apply([&](const auto&... field) { (Detail::ReadIfKey(field, key, value, obj) || ...); }, fields);
+        }
+    }
+
+    template <typename T>
+    json ToJson(const T& obj) {
+        json j = json::object();
+        std::apply([&](const auto&... field) { (Detail::WriteField(field, j, obj), ...); }, Of<T>::fields);
+        return j;
+    }
+
+    // Writes fields back to back in declaration order, no keys
+    template <typename T>
+    void WriteBinary(std::string& out, const T& obj) {
+        std::apply([&](const auto&... field) {
+            (Codec<std::decay_t<decltype(obj.*field.member)>>::WriteBinary(out, obj.*field.member), ...);
+            }, Of<T>::fields);
+    }
+
+    template <typename T>
+    bool ReadBinary(const char*& p, const char* end, T& obj) {
+        return std::apply([&](const auto&... field) {
+            return (Codec<std::decay_t<decltype(obj.*field.member)>>::ReadBinary(p, end, obj.*field.member) && ...);
+            }, Of<T>::fields);
+    }
+}
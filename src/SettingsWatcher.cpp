@@ -0,0 +1,371 @@
+#define NOMINMAX
+#include "SettingsWatcher.h"
+#include "settings.h"
+#include "shared.h"
+#include "Sounds.h"
+#include "TextToSpeech.h"
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+// Global settings watcher instance
+SettingsWatcher* g_SettingsWatcher = nullptr;
+
+// Editors usually save in several writes, wait this long for the file to settle
+static const int SettleDelayMs = 250;
+
+SettingsWatcher::SettingsWatcher() {}
+
+SettingsWatcher::~SettingsWatcher() {
+    Stop();
+}
+
+bool SettingsWatcher::Start(const std::string& path) {
+    if (running) return true;
+
+    std::filesystem::path filePath = std::filesystem::absolute(std::filesystem::u8path(path));
+    directory = filePath.parent_path().native();
+    fileName = filePath.filename().native();
+    settingsPath = path;
+
+#ifdef _WIN32
+    stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stopEvent) {
+#else
+    if (pipe2(stopPipe, O_CLOEXEC) != 0) {
+#endif
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create settings watcher stop event");
+        }
+        return false;
+    }
+
+    running = true;
+    watchThread = std::thread(&SettingsWatcher::WatchLoop, this);
+    return true;
+}
+
+void SettingsWatcher::Stop() {
+    if (!running) return;
+
+    running = false;
+#ifdef _WIN32
+    SetEvent(stopEvent);
+#else
+    // One byte wakes the poll; if the write fails the pipe is already readable
+    char wake = 0;
+    ssize_t written = write(stopPipe[1], &wake, 1);
+    (void)written;
+#endif
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+
+#ifdef _WIN32
+    CloseHandle(stopEvent);
+    stopEvent = nullptr;
+#else
+    close(stopPipe[0]);
+    close(stopPipe[1]);
+    stopPipe[0] = stopPipe[1] = -1;
+#endif
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.reset();
+}
+
+#ifdef _WIN32
+void SettingsWatcher::WatchLoop() {
+    HANDLE hDirectory = CreateFileW(directory.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (hDirectory == INVALID_HANDLE_VALUE) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Settings watcher could not open the addon directory");
+        }
+        return;
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    alignas(DWORD) BYTE buffer[4096];
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+
+    while (running && overlapped.hEvent) {
+        ResetEvent(overlapped.hEvent);
+        if (!ReadDirectoryChangesW(hDirectory, buffer, sizeof(buffer), FALSE, filter, nullptr, &overlapped, nullptr)) {
+            if (APIDefs) {
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Settings watcher stopped: ReadDirectoryChangesW failed");
+            }
+            break;
+        }
+
+        HANDLE handles[2] = { stopEvent, overlapped.hEvent };
+        DWORD waitResult = WaitForMultipleObjects(2, handles, FALSE, INFINITE);
+        if (waitResult != WAIT_OBJECT_0 + 1) {
+            // Stop requested, cancel the outstanding read before the buffer goes away
+            CancelIo(hDirectory);
+            DWORD ignored = 0;
+            GetOverlappedResult(hDirectory, &overlapped, &ignored, TRUE);
+            break;
+        }
+
+        DWORD bytesReturned = 0;
+        if (!GetOverlappedResult(hDirectory, &overlapped, &bytesReturned, FALSE)) {
+            continue;
+        }
+
+        // Zero bytes means the notification buffer overflowed, assume our file was touched
+        bool settingsTouched = bytesReturned == 0;
+        for (BYTE* p = buffer; !settingsTouched && bytesReturned > 0;) {
+            FILE_NOTIFY_INFORMATION* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(p);
+            size_t nameLength = info->FileNameLength / sizeof(WCHAR);
+            if (nameLength == fileName.size() &&
+                _wcsnicmp(info->FileName, fileName.c_str(), nameLength) == 0) {
+                settingsTouched = true;
+            }
+
+            if (info->NextEntryOffset == 0) break;
+            p += info->NextEntryOffset;
+        }
+
+        if (!settingsTouched) continue;
+
+        if (WaitForSingleObject(stopEvent, SettleDelayMs) == WAIT_OBJECT_0) {
+            break;
+        }
+
+        ReadSettingsFile();
+    }
+
+    if (overlapped.hEvent) {
+        CloseHandle(overlapped.hEvent);
+    }
+    CloseHandle(hDirectory);
+}
+#else
+void SettingsWatcher::WatchLoop() {
+    int inotifyFd = inotify_init1(IN_CLOEXEC);
+    // Editors that save through a temporary file rename it over ours, hence IN_MOVED_TO
+    if (inotifyFd < 0 || inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Settings watcher could not open the addon directory");
+        }
+        if (inotifyFd >= 0) {
+            close(inotifyFd);
+        }
+        return;
+    }
+
+    alignas(inotify_event) char buffer[4096];
+    while (running) {
+        pollfd fds[2] = { { stopPipe[0], POLLIN, 0 }, { inotifyFd, POLLIN, 0 } };
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR) continue;
+            if (APIDefs) {
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Settings watcher stopped: poll failed");
+            }
+            break;
+        }
+        if (fds[0].revents != 0) break;
+
+        ssize_t bytesRead = read(inotifyFd, buffer, sizeof(buffer));
+        if (bytesRead <= 0) continue;
+
+        // An overflowed queue may have dropped our file's event, assume it was touched
+        bool settingsTouched = false;
+        for (char* p = buffer; !settingsTouched && p < buffer + bytesRead;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(p);
+            if ((event->mask & IN_Q_OVERFLOW) || (event->len > 0 && fileName == event->name)) {
+                settingsTouched = true;
+            }
+            p += sizeof(inotify_event) + event->len;
+        }
+
+        if (!settingsTouched) continue;
+
+        pollfd stop = { stopPipe[0], POLLIN, 0 };
+        if (poll(&stop, 1, SettleDelayMs) > 0) {
+            break;
+        }
+
+        ReadSettingsFile();
+    }
+
+    close(inotifyFd);
+}
+#endif
+
+void SettingsWatcher::ReadSettingsFile() {
+    std::string content;
+    {
+        std::ifstream file(settingsPath);
+        if (!file.is_open()) return;
+
+        std::stringstream ss;
+        ss << file.rdbuf();
+        content = ss.str();
+    }
+
+    // Skip our own saves and content we already applied
+    size_t hash = std::hash<std::string>{}(content);
+    if (hash == lastSeenHash || hash == Settings::GetLastSavedHash()) {
+        lastSeenHash = hash;
+        return;
+    }
+
+    // A half-written file fails to parse; the next write notification retries it
+    json data = json::parse(content, nullptr, false);
+    if (data.is_discarded() || !data.is_object()) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, "Settings file changed but could not be parsed yet");
+        }
+        return;
+    }
+    lastSeenHash = hash;
+
+    auto reload = std::make_unique<SettingsReload>();
+
+    try {
+        if (data.contains("timers") && data["timers"].is_array()) {
+            for (const auto& timerJson : data["timers"]) {
+                TimerData timer = TimerData::fromJson(timerJson);
+                if (timer.isRoomTimer) continue;
+
+                if (!timerJson.contains("id") || !timerJson["id"].is_string()) {
+                    reload->needsSave = true;
+                }
+                reload->timers.push_back(std::move(timer));
+            }
+        }
+
+        if (data.contains("sounds") && data["sounds"].is_object()) {
+            const auto& soundsJson = data["sounds"];
+            reload->hasSounds = true;
+
+            // Start from the live values, so keys or sections the file leaves out are kept rather than reset
+            auto current = Settings::GetSoundState();
+            SoundSettings& sounds = reload->sounds;
+            sounds.masterVolume = current->masterVolume;
+            sounds.audioDeviceIndex = current->audioDeviceIndex;
+            sounds.soundCacheBudgetMB = current->soundCacheBudgetMB;
+            sounds.alertCoalesceMs = current->alertCoalesceMs;
+            sounds.maxConcurrentSounds = current->maxConcurrentSounds;
+            sounds.alertDuckVolume = current->alertDuckVolume;
+            sounds.normalizeLoudness = current->normalizeLoudness;
+            sounds.compressIdleSounds = current->compressIdleSounds;
+            sounds.ttsCacheBudgetMB = current->ttsCacheBudgetMB;
+            sounds.customSoundsDirectory = current->customSoundsDirectory;
+            sounds.soundVolumes = current->soundVolumes;
+            sounds.soundPans = current->soundPans;
+            Schema::MergeJson(soundsJson, sounds);
+
+            // A section that is present replaces the live one
+            if (soundsJson.contains("soundVolumes") && soundsJson["soundVolumes"].is_object()) {
+                reload->sounds.soundVolumes.clear();
+                for (auto it = soundsJson["soundVolumes"].begin(); it != soundsJson["soundVolumes"].end(); ++it) {
+                    if (it.value().is_number()) {
+                        reload->sounds.soundVolumes[it.key()] = it.value().get<float>();
+                    }
+                }
+            }
+
+            if (soundsJson.contains("soundPans") && soundsJson["soundPans"].is_object()) {
+                reload->sounds.soundPans.clear();
+                for (auto it = soundsJson["soundPans"].begin(); it != soundsJson["soundPans"].end(); ++it) {
+                    if (it.value().is_number()) {
+                        reload->sounds.soundPans[it.key()] = it.value().get<float>();
+                    }
+                }
+            }
+        }
+    }
+    catch (const std::exception& e) {
+        if (APIDefs) {
+            char errorMsg[256];
+            sprintf_s(errorMsg, "Error reading changed settings file: %s", e.what());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+        }
+        return;
+    }
+
+    // A newer parse replaces one the render thread hasn't picked up yet
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending = std::move(reload);
+}
+
+void SettingsWatcher::ApplyPending() {
+    std::unique_ptr<SettingsReload> reload;
+    {
+        std::lock_guard<std::mutex> lock(pendingMutex);
+        reload = std::move(pending);
+    }
+    if (!reload) return;
+
+    SettingsReloadResult result = Settings::ApplyReload(*reload);
+
+    // Removed timers lose their keybind and active state
+    for (const auto& timerId : result.removedTimers) {
+        auto it = std::find_if(activeTimers.begin(), activeTimers.end(),
+            [&timerId](const ActiveTimer& active) { return active.id == timerId && !active.isRoomTimer(); });
+        if (it != activeTimers.end()) {
+            UnregisterTimerKeybind(it->id);
+            activeTimers.erase(it);
+        }
+    }
+
+    // New timers start paused, addOrUpdateActiveTimer registers the keybind
+    for (const auto& change : result.addedTimers) {
+        addOrUpdateActiveTimer(ActiveTimer(change.id, change.newDuration, true));
+    }
+
+    // Running timers keep counting; an untouched paused timer picks up the new duration
+    for (const auto& change : result.changedTimers) {
+        for (auto& active : activeTimers) {
+            if (active.id == change.id && !active.isRoomTimer()) {
+                if (active.isPaused && active.remainingTime == change.oldDuration) {
+                    active.remainingTime = change.newDuration;
+                }
+                break;
+            }
+        }
+    }
+
+    // Budgets, coalescing and voice limits reach their subsystems the way their setters
+    // do, without writing back to the settings they came from
+    if (g_TextToSpeech && result.soundsChanged) {
+        g_TextToSpeech->SyncFromSettings();
+    }
+    if (g_SoundEngine && result.soundsChanged) {
+        g_SoundEngine->SyncFromSettings();
+
+        if (result.soundsDirectoryChanged) {
+            std::string customSoundsDir = Settings::GetCustomSoundsDirectory();
+            if (!customSoundsDir.empty() && std::filesystem::exists(customSoundsDir)) {
+                g_SoundEngine->ScanSoundDirectory(customSoundsDir);
+            }
+        }
+    }
+
+    // Persist ids generated for timers that were added without one
+    if (reload->needsSave && !settingsPath.empty()) {
+        Settings::ScheduleSave(settingsPath);
+    }
+
+    if (APIDefs && !result.empty()) {
+        char logMsg[256];
+        sprintf_s(logMsg, "Reloaded settings: %zu timers added, %zu changed, %zu removed%s",
+            result.addedTimers.size(), result.changedTimers.size(), result.removedTimers.size(),
+            result.soundsChanged ? ", sound settings updated" : "");
+        APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
+    }
+}
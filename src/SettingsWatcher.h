@@ -0,0 +1,51 @@
+#pragma once
+
+#ifdef _WIN32
+#include <Windows.h>
+#endif
+#include <filesystem>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <memory>
+
+struct SettingsReload;
+
+// Watches settings.json for external edits, with ReadDirectoryChangesW on Windows and
+// inotify elsewhere. The file is parsed on a background thread; the result is diffed and
+// applied on the render thread by ApplyPending.
+class SettingsWatcher {
+private:
+    std::filesystem::path::string_type directory;   // Folder containing the settings file
+    std::filesystem::path::string_type fileName;    // Settings file name, case-insensitive on Windows
+    std::string settingsPath;
+
+    std::thread watchThread;
+#ifdef _WIN32
+    HANDLE stopEvent = nullptr;
+#else
+    int stopPipe[2] = { -1, -1 };       // Written to wake the watch thread for Stop
+#endif
+    std::atomic<bool> running{ false };
+
+    size_t lastSeenHash = 0;            // Last content we parsed, watcher thread only
+
+    std::mutex pendingMutex;
+    std::unique_ptr<SettingsReload> pending;
+
+    void WatchLoop();
+    void ReadSettingsFile();
+
+public:
+    SettingsWatcher();
+    ~SettingsWatcher();
+
+    bool Start(const std::string& path);
+    void Stop();
+
+    // Call once per frame from the render thread
+    void ApplyPending();
+};
+
+extern SettingsWatcher* g_SettingsWatcher;
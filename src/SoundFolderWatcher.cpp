@@ -0,0 +1,188 @@
+#include "SoundFolderWatcher.h"
+#include "shared.h"
+#include <algorithm>
+
+// A file is reported once it has gone this long without a change notification
+static const int SettleDelayMs = 500;
+
+SoundFolderWatcher::SoundFolderWatcher() {}
+
+SoundFolderWatcher::~SoundFolderWatcher() {
+    Stop();
+}
+
+bool SoundFolderWatcher::Start(const std::string& path) {
+    if (running) return true;
+
+    // Same narrow path handling as ScanSoundDirectory, so the paths built from it match
+    directory = path;
+    watchedPath = std::filesystem::path(path).wstring();
+
+    stopEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+    if (!stopEvent) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create sound folder watcher stop event");
+        }
+        return false;
+    }
+
+    running = true;
+    watchThread = std::thread(&SoundFolderWatcher::WatchLoop, this);
+    return true;
+}
+
+void SoundFolderWatcher::Stop() {
+    if (!running) return;
+
+    running = false;
+    SetEvent(stopEvent);
+    if (watchThread.joinable()) {
+        watchThread.join();
+    }
+
+    CloseHandle(stopEvent);
+    stopEvent = nullptr;
+    settling.clear();
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.clear();
+    pendingRescan = false;
+    hasPending = false;
+}
+
+void SoundFolderWatcher::WatchLoop() {
+    HANDLE hDirectory = CreateFileW(watchedPath.c_str(), FILE_LIST_DIRECTORY,
+        FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING,
+        FILE_FLAG_BACKUP_SEMANTICS | FILE_FLAG_OVERLAPPED, nullptr);
+    if (hDirectory == INVALID_HANDLE_VALUE) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Sound folder watcher could not open the custom sounds directory");
+        }
+        return;
+    }
+
+    OVERLAPPED overlapped = {};
+    overlapped.hEvent = CreateEventW(nullptr, TRUE, FALSE, nullptr);
+
+    alignas(DWORD) BYTE buffer[16384];
+    const DWORD filter = FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME | FILE_NOTIFY_CHANGE_SIZE;
+    bool readPending = false;
+
+    while (running && overlapped.hEvent) {
+        if (!readPending) {
+            ResetEvent(overlapped.hEvent);
+            if (!ReadDirectoryChangesW(hDirectory, buffer, sizeof(buffer), FALSE, filter, nullptr, &overlapped, nullptr)) {
+                if (APIDefs) {
+                    APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Sound folder watcher stopped: ReadDirectoryChangesW failed");
+                }
+                break;
+            }
+            readPending = true;
+        }
+
+        // Sleep until the next notification, or until the oldest settling file is due
+        DWORD timeout = INFINITE;
+        if (!settling.empty()) {
+            auto due = std::chrono::steady_clock::time_point::max();
+            for (const auto& [name, touched] : settling) {
+                due = (std::min)(due, touched + std::chrono::milliseconds(SettleDelayMs));
+            }
+            auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(due - std::chrono::steady_clock::now()).count();
+            timeout = wait > 0 ? static_cast<DWORD>(wait) : 0;
+        }
+
+        HANDLE handles[2] = { stopEvent, overlapped.hEvent };
+        DWORD waitResult = WaitForMultipleObjects(2, handles, FALSE, timeout);
+        if (waitResult == WAIT_TIMEOUT) {
+            ReportSettled();
+            continue;
+        }
+        if (waitResult != WAIT_OBJECT_0 + 1) {
+            break;
+        }
+
+        readPending = false;
+        DWORD bytesReturned = 0;
+        if (!GetOverlappedResult(hDirectory, &overlapped, &bytesReturned, FALSE)) {
+            continue;
+        }
+
+        // Zero bytes means the notification buffer overflowed and changes were missed
+        if (bytesReturned == 0) {
+            settling.clear();
+            std::lock_guard<std::mutex> lock(pendingMutex);
+            pendingRescan = true;
+            hasPending = true;
+            continue;
+        }
+
+        auto now = std::chrono::steady_clock::now();
+        for (BYTE* p = buffer;;) {
+            FILE_NOTIFY_INFORMATION* info = reinterpret_cast<FILE_NOTIFY_INFORMATION*>(p);
+            settling[std::wstring(info->FileName, info->FileNameLength / sizeof(WCHAR))] = now;
+
+            if (info->NextEntryOffset == 0) break;
+            p += info->NextEntryOffset;
+        }
+    }
+
+    // Cancel the outstanding read before the buffer goes away
+    if (readPending) {
+        CancelIo(hDirectory);
+        DWORD ignored = 0;
+        GetOverlappedResult(hDirectory, &overlapped, &ignored, TRUE);
+    }
+
+    if (overlapped.hEvent) {
+        CloseHandle(overlapped.hEvent);
+    }
+    CloseHandle(hDirectory);
+}
+
+void SoundFolderWatcher::ReportSettled() {
+    auto now = std::chrono::steady_clock::now();
+    std::vector<std::wstring> settled;
+
+    for (auto it = settling.begin(); it != settling.end();) {
+        if (now - it->second < std::chrono::milliseconds(SettleDelayMs)) {
+            ++it;
+            continue;
+        }
+
+        // A copy can stall longer than the delay; while the writer still holds the file,
+        // opening it without write sharing fails and it is checked again later
+        std::wstring path = watchedPath + L"\\" + it->first;
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, 0, nullptr);
+        if (file == INVALID_HANDLE_VALUE && GetLastError() == ERROR_SHARING_VIOLATION) {
+            it->second = now;
+            ++it;
+            continue;
+        }
+        if (file != INVALID_HANDLE_VALUE) {
+            CloseHandle(file);
+        }
+
+        // Deleted files are reported too, the engine sees they are gone
+        settled.push_back(it->first);
+        it = settling.erase(it);
+    }
+
+    if (settled.empty()) return;
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    pending.insert(settled.begin(), settled.end());
+    hasPending = true;
+}
+
+bool SoundFolderWatcher::TakeChanges(std::vector<std::filesystem::path>& fileNames, bool& rescan) {
+    // Checked without the lock, this runs every frame
+    if (!hasPending) return false;
+
+    std::lock_guard<std::mutex> lock(pendingMutex);
+    fileNames.assign(pending.begin(), pending.end());
+    rescan = pendingRescan;
+    pending.clear();
+    pendingRescan = false;
+    hasPending = false;
+    return !fileNames.empty() || rescan;
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <Windows.h>
+#include <string>
+#include <vector>
+#include <map>
+#include <set>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+
+// Watches the custom sounds folder so files dropped in, replaced or deleted show up
+// without a rescan. Changes are collected per file on a background thread; a file is
+// reported once it has been quiet for a moment and no one has it open for writing, so
+// one still being copied in is never read half-written. SoundEngine::Update applies them.
+class SoundFolderWatcher {
+private:
+    std::string directory;              // As passed to Start, sound ids are built from it
+    std::wstring watchedPath;
+
+    std::thread watchThread;
+    HANDLE stopEvent = nullptr;
+    std::atomic<bool> running{ false };
+
+    // Watcher thread only: files with recent changes and when they were last touched
+    std::map<std::wstring, std::chrono::steady_clock::time_point> settling;
+
+    std::mutex pendingMutex;
+    std::set<std::wstring> pending;     // Settled file names
+    bool pendingRescan = false;         // Notifications were lost, the folder has to be listed again
+    std::atomic<bool> hasPending{ false };
+
+    void WatchLoop();
+    void ReportSettled();
+
+public:
+    SoundFolderWatcher();
+    ~SoundFolderWatcher();
+
+    bool Start(const std::string& path);
+    void Stop();
+    const std::string& GetDirectory() const { return directory; }
+
+    // Call once per frame from the render thread. Names of the files that changed, were added
+    // or were removed since the last call; the caller checks which by looking at the folder.
+    bool TakeChanges(std::vector<std::filesystem::path>& fileNames, bool& rescan);
+};
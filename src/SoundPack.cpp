@@ -0,0 +1,288 @@
+#include "SoundPack.h"
+#include "AudioConvert.h"
+#include "MappedFile.h"
+#include <cstring>
+#include <algorithm>
+#include <filesystem>
+#include <fstream>
+
+// On-disk structures, read and written with memcpy so alignment never matters
+struct SoundPackHeader {
+    char magic[4];                  // "STSP"
+    uint32_t version;
+    uint32_t entryCount;
+    uint32_t entrySize;             // sizeof(SoundPackEntry) when written
+    uint64_t stringsOffset;
+    uint64_t stringsSize;
+};
+
+struct SoundPackEntry {
+    uint32_t nameOffset;            // Into the string table
+    uint32_t nameLength;
+    uint32_t categoryOffset;
+    uint32_t categoryLength;
+    uint32_t encoding;              // SoundPackPcm or SoundPackEncoded
+    uint16_t formatTag;             // PCM entries only
+    uint16_t channels;
+    uint32_t sampleRate;
+    uint16_t bitsPerSample;
+    uint16_t reserved;
+    uint64_t dataOffset;            // From the start of the file
+    uint64_t dataLength;
+};
+
+static_assert(sizeof(SoundPackHeader) == 32, "sound pack header layout");
+static_assert(sizeof(SoundPackEntry) == 48, "sound pack entry layout");
+
+static const uint32_t SoundPackVersion = 1;
+static const uint32_t SoundPackPcm = 0;
+static const uint32_t SoundPackEncoded = 1;
+static const uint64_t SoundPackAlignment = 64;
+
+static std::string LowerExtension(const std::filesystem::path& path) {
+    std::string ext = path.extension().u8string();
+    if (!ext.empty() && ext[0] == '.') ext.erase(0, 1);
+    std::transform(ext.begin(), ext.end(), ext.begin(), [](unsigned char c) { return static_cast<char>(::tolower(c)); });
+    return ext;
+}
+
+std::string MakeSoundPackPath(const std::string& packPath, const std::string& name) {
+    return packPath + SoundPackSeparator + name;
+}
+
+bool SplitSoundPackPath(const std::string& soundPath, std::string& packPath, std::string& name) {
+    size_t separator = soundPath.find(SoundPackSeparator);
+    if (separator == std::string::npos) return false;
+
+    packPath = soundPath.substr(0, separator);
+    name = soundPath.substr(separator + 1);
+    return !packPath.empty() && !name.empty();
+}
+
+bool IsSoundPackFile(const std::string& path) {
+    return LowerExtension(std::filesystem::u8path(path)) == SoundPackExtension;
+}
+
+std::shared_ptr<SoundPack> SoundPack::Open(const std::string& path, std::string& error) {
+    std::shared_ptr<MappedFile> mapped = MappedFile::Open(path);
+    if (!mapped) {
+        error = "could not open sound pack " + path;
+        return nullptr;
+    }
+
+    const uint8_t* image = mapped->Data();
+    uint64_t imageSize = mapped->Size();
+
+    SoundPackHeader header;
+    if (imageSize < sizeof(header)) {
+        error = "sound pack is truncated: " + path;
+        return nullptr;
+    }
+    memcpy(&header, image, sizeof(header));
+    if (memcmp(header.magic, "STSP", 4) != 0 || header.version != SoundPackVersion) {
+        error = "not a sound pack, or made by a newer version: " + path;
+        return nullptr;
+    }
+
+    // Everything the header points at has to lie inside the file
+    uint64_t indexEnd = sizeof(header) + static_cast<uint64_t>(header.entryCount) * header.entrySize;
+    if (header.entrySize < sizeof(SoundPackEntry) || indexEnd > imageSize ||
+        header.stringsOffset > imageSize || header.stringsSize > imageSize - header.stringsOffset) {
+        error = "sound pack index is damaged: " + path;
+        return nullptr;
+    }
+    const char* strings = reinterpret_cast<const char*>(image + header.stringsOffset);
+
+    std::shared_ptr<SoundPack> pack(new SoundPack());
+    pack->path = path;
+    pack->sounds.reserve(header.entryCount);
+
+    for (uint32_t i = 0; i < header.entryCount; i++) {
+        SoundPackEntry entry;
+        memcpy(&entry, image + sizeof(header) + static_cast<uint64_t>(i) * header.entrySize, sizeof(entry));
+
+        if (static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > header.stringsSize ||
+            static_cast<uint64_t>(entry.categoryOffset) + entry.categoryLength > header.stringsSize ||
+            entry.nameLength == 0 || entry.dataLength == 0 ||
+            entry.dataOffset > imageSize || entry.dataLength > imageSize - entry.dataOffset) {
+            error = "sound pack entry " + std::to_string(i) + " is damaged: " + path;
+            return nullptr;
+        }
+
+        Sound sound;
+        sound.name.assign(strings + entry.nameOffset, entry.nameLength);
+        sound.category.assign(strings + entry.categoryOffset, entry.categoryLength);
+        sound.encoded = entry.encoding == SoundPackEncoded;
+        sound.data = image + entry.dataOffset;
+        sound.size = static_cast<size_t>(entry.dataLength);
+
+        if (!sound.encoded) {
+            sound.format.formatTag = entry.formatTag;
+            sound.format.channels = entry.channels;
+            sound.format.sampleRate = entry.sampleRate;
+            sound.format.bitsPerSample = entry.bitsPerSample;
+            if (entry.encoding != SoundPackPcm || !sound.format.IsValid() || sound.size % sound.format.BlockAlign() != 0) {
+                error = "sound pack entry " + sound.name + " has an unsupported format: " + path;
+                return nullptr;
+            }
+        }
+
+        // A repeated name would be unreachable, the first one wins
+        if (pack->byName.emplace(sound.name, pack->sounds.size()).second) {
+            pack->sounds.push_back(std::move(sound));
+        }
+    }
+
+    pack->mapped = std::move(mapped);
+    return pack;
+}
+
+const SoundPack::Sound* SoundPack::Find(const std::string& name) const {
+    auto it = byName.find(name);
+    return it != byName.end() ? &sounds[it->second] : nullptr;
+}
+
+bool WriteSoundPack(const std::string& sourceDirectory, const std::string& outputPath, size_t& soundCount, std::string& error) {
+    namespace fs = std::filesystem;
+    soundCount = 0;
+
+    struct PackedSound {
+        std::string name;
+        std::string category;
+        SoundPackEntry entry = {};
+        std::vector<uint8_t> bytes;         // The whole source file
+        size_t dataStart = 0;               // Part of bytes that is stored
+        size_t dataLength = 0;
+    };
+    std::vector<PackedSound> packed;
+
+    // Sorted by name so the same folder always gives the same pack
+    fs::path root = fs::u8path(sourceDirectory);
+    std::vector<fs::path> files;
+    std::error_code listError;
+    for (fs::recursive_directory_iterator it(root, listError), end; !listError && it != end; it.increment(listError)) {
+        if (!it->is_regular_file()) continue;
+        std::string ext = LowerExtension(it->path());
+        if (ext == "wav" || ext == "mp3" || ext == "flac" || ext == "ogg") {
+            files.push_back(it->path());
+        }
+    }
+    if (listError) {
+        error = "could not list " + sourceDirectory + ": " + listError.message();
+        return false;
+    }
+    std::sort(files.begin(), files.end());
+
+    for (const auto& file : files) {
+        PackedSound sound;
+        fs::path relative = file.lexically_relative(root);
+        sound.name = (relative.parent_path() / file.stem()).generic_u8string();
+        sound.category = relative.parent_path().generic_u8string();
+
+        std::ifstream input(file, std::ios::binary);
+        if (!input.is_open()) {
+            error = "could not read " + file.u8string();
+            return false;
+        }
+        sound.bytes.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+        if (sound.bytes.empty()) continue;
+
+        // WAVs the converter reads are stored as raw PCM, everything else as its file image
+        const uint8_t* fmt = nullptr;
+        const uint8_t* pcm = nullptr;
+        uint32_t fmtSize = 0;
+        uint32_t pcmSize = 0;
+        AudioFormat format;
+        if (LowerExtension(file) == "wav" && sound.bytes.size() >= 12 && memcmp(sound.bytes.data(), "RIFF", 4) == 0 &&
+            FindWavChunks(sound.bytes.data(), sound.bytes.size(), fmt, fmtSize, pcm, pcmSize)) {
+            format = ParseWavFormat(fmt, fmtSize);
+        }
+        if (format.IsValid() && pcmSize >= format.BlockAlign()) {
+            sound.entry.encoding = SoundPackPcm;
+            sound.entry.formatTag = format.formatTag;
+            sound.entry.channels = format.channels;
+            sound.entry.sampleRate = format.sampleRate;
+            sound.entry.bitsPerSample = format.bitsPerSample;
+            sound.dataStart = static_cast<size_t>(pcm - sound.bytes.data());
+            sound.dataLength = pcmSize - pcmSize % format.BlockAlign();
+        }
+        else {
+            sound.entry.encoding = SoundPackEncoded;
+            sound.dataLength = sound.bytes.size();
+        }
+        packed.push_back(std::move(sound));
+    }
+
+    if (packed.empty()) {
+        error = "no audio files in " + sourceDirectory;
+        return false;
+    }
+
+    // Lay out the string table, then the data after it
+    std::string strings;
+    for (auto& sound : packed) {
+        sound.entry.nameOffset = static_cast<uint32_t>(strings.size());
+        sound.entry.nameLength = static_cast<uint32_t>(sound.name.size());
+        strings += sound.name;
+        sound.entry.categoryOffset = static_cast<uint32_t>(strings.size());
+        sound.entry.categoryLength = static_cast<uint32_t>(sound.category.size());
+        strings += sound.category;
+    }
+
+    SoundPackHeader header = {};
+    memcpy(header.magic, "STSP", 4);
+    header.version = SoundPackVersion;
+    header.entryCount = static_cast<uint32_t>(packed.size());
+    header.entrySize = sizeof(SoundPackEntry);
+    header.stringsOffset = sizeof(SoundPackHeader) + packed.size() * sizeof(SoundPackEntry);
+    header.stringsSize = strings.size();
+
+    auto align = [](uint64_t offset) { return (offset + SoundPackAlignment - 1) / SoundPackAlignment * SoundPackAlignment; };
+    uint64_t offset = align(header.stringsOffset + header.stringsSize);
+    for (auto& sound : packed) {
+        sound.entry.dataOffset = offset;
+        sound.entry.dataLength = sound.dataLength;
+        offset = align(offset + sound.dataLength);
+    }
+
+    std::string tempPath = outputPath + ".tmp";
+    {
+        std::ofstream output(fs::u8path(tempPath), std::ios::binary | std::ios::trunc);
+        if (!output.is_open()) {
+            error = "could not create " + tempPath;
+            return false;
+        }
+
+        output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        for (const auto& sound : packed) {
+            output.write(reinterpret_cast<const char*>(&sound.entry), sizeof(sound.entry));
+        }
+        output.write(strings.data(), static_cast<std::streamsize>(strings.size()));
+
+        static const char padding[SoundPackAlignment] = {};
+        uint64_t written = header.stringsOffset + header.stringsSize;
+        for (const auto& sound : packed) {
+            output.write(padding, static_cast<std::streamsize>(sound.entry.dataOffset - written));
+            output.write(reinterpret_cast<const char*>(sound.bytes.data() + sound.dataStart), static_cast<std::streamsize>(sound.dataLength));
+            written = sound.entry.dataOffset + sound.dataLength;
+        }
+
+        if (!output.good()) {
+            output.close();
+            std::error_code removeError;
+            fs::remove(fs::u8path(tempPath), removeError);
+            error = "could not write " + tempPath;
+            return false;
+        }
+    }
+
+    std::error_code renameError;
+    fs::rename(fs::u8path(tempPath), fs::u8path(outputPath), renameError);
+    if (renameError) {
+        error = "could not replace " + outputPath + ": " + renameError.message();
+        return false;
+    }
+
+    soundCount = packed.size();
+    return true;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include "AudioBackend.h"
+
+class MappedFile;
+
+// Single-file sound packs, so a callout pack of hundreds of clips is one file open
+// rather than hundreds.
+//
+// Layout, little-endian: a header, a fixed-size index entry per sound, a string table
+// with the names and categories, then each sound's data at a 64 byte aligned offset.
+// WAV sources are stored as their raw PCM and play straight from the mapped pack;
+// anything else keeps its encoded bytes and is decoded from memory when first used.
+// The whole file is memory-mapped, the index is read in place.
+
+// Pack files are recognised by this extension
+static const char* const SoundPackExtension = "soundpack";
+
+// Sounds in a pack are identified as "<pack path>|<name>"; '|' can't appear in a Windows path
+static const char SoundPackSeparator = '|';
+
+std::string MakeSoundPackPath(const std::string& packPath, const std::string& name);
+bool SplitSoundPackPath(const std::string& soundPath, std::string& packPath, std::string& name);
+bool IsSoundPackFile(const std::string& path);
+
+class SoundPack {
+public:
+    struct Sound {
+        std::string name;           // Path within the packed folder, without extension
+        std::string category;       // Subfolder it came from, empty at the top level
+        bool encoded = false;       // Compressed file image rather than raw PCM
+        AudioFormat format;         // PCM only
+        const uint8_t* data = nullptr;
+        size_t size = 0;
+    };
+
+    // Maps and validates the pack. The pack must stay alive while any of its data is used.
+    static std::shared_ptr<SoundPack> Open(const std::string& path, std::string& error);
+
+    const std::string& GetPath() const { return path; }
+    const std::vector<Sound>& GetSounds() const { return sounds; }
+    const Sound* Find(const std::string& name) const;
+
+private:
+    SoundPack() {}
+
+    std::string path;
+    std::shared_ptr<MappedFile> mapped;
+    std::vector<Sound> sounds;
+    std::map<std::string, size_t> byName;
+};
+
+// Packer: every supported audio file under sourceDirectory, subfolders included, into one
+// pack at outputPath. Written to a temporary file first, so a failed run leaves nothing behind.
+bool WriteSoundPack(const std::string& sourceDirectory, const std::string& outputPath, size_t& soundCount, std::string& error);
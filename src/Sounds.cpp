@@ -2,8 +2,18 @@
 #include "settings.h"
 #include "shared.h"
 #include "TextToSpeech.h"
+#include "XAudio2Backend.h"
+#include "AudioDecoder.h"
+#include "AudioConvert.h"
+#include "RecentSounds.h"
+#include "AudioLoudness.h"
+#include "MappedFile.h"
+#include "PcmCache.h"
+#include "SoundPack.h"
+#include "AudioDeviceWatcher.h"
+#include "SoundFolderWatcher.h"
 #include <algorithm>
-#include <Functiondiscoverykeys_devpkey.h>
+#include <cmath>
 
 
 // Global sound engine instance
@@ -17,101 +27,44 @@ std::string GetFileExtension(const std::string& filePath) {
     return filePath.substr(pos + 1);
 }
 
+// Backends take a portable format. Only the WAVEFORMATEX part of an extensible header
+// is kept, so WAVE_FORMAT_EXTENSIBLE is read by bit depth.
+static AudioFormat ToAudioFormat(const WAVEFORMATEX& wfx) {
+    AudioFormat format;
+    format.formatTag = wfx.wFormatTag;
+    if (wfx.wFormatTag == WAVE_FORMAT_EXTENSIBLE) {
+        format.formatTag = wfx.wBitsPerSample == 32 ? AudioFormat::Float : AudioFormat::PCM;
+    }
+    format.channels = wfx.nChannels;
+    format.sampleRate = wfx.nSamplesPerSec;
+    format.bitsPerSample = wfx.wBitsPerSample;
+    return format;
+}
+
+static WAVEFORMATEX ToWaveFormat(const AudioFormat& format) {
+    WAVEFORMATEX wfx = {};
+    wfx.wFormatTag = format.formatTag == AudioFormat::Float ? WAVE_FORMAT_IEEE_FLOAT : WAVE_FORMAT_PCM;
+    wfx.nChannels = format.channels;
+    wfx.nSamplesPerSec = format.sampleRate;
+    wfx.wBitsPerSample = format.bitsPerSample;
+    wfx.nBlockAlign = static_cast<WORD>(format.BlockAlign());
+    wfx.nAvgBytesPerSec = format.sampleRate * format.BlockAlign();
+    return wfx;
+}
+
 bool SoundEngine::EnumerateAudioDevices() {
     // Clear the existing device list
     audioDevices.clear();
     currentDeviceIndex = 0;
 
-    // Initialize COM if needed
-    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
-    bool needsUninitialize = SUCCEEDED(hr);
-
-    // Create device enumerator
-    IMMDeviceEnumerator* pEnumerator = nullptr;
-    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
-        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
-
-    if (SUCCEEDED(hr)) {
-        // Get the default device ID
-        IMMDevice* pDefaultDevice = nullptr;
-        std::wstring defaultDeviceId;
-
-        hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDefaultDevice);
-        if (SUCCEEDED(hr)) {
-            LPWSTR deviceId = nullptr;
-            hr = pDefaultDevice->GetId(&deviceId);
-            if (SUCCEEDED(hr)) {
-                defaultDeviceId = deviceId;
-                CoTaskMemFree(deviceId);
-            }
-            pDefaultDevice->Release();
-        }
-
-        // Enumerate all devices
-        IMMDeviceCollection* pDevices = nullptr;
-        hr = pEnumerator->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &pDevices);
-
-        if (SUCCEEDED(hr)) {
-            UINT count;
-            hr = pDevices->GetCount(&count);
-
-            if (SUCCEEDED(hr)) {
-                for (UINT i = 0; i < count; i++) {
-                    IMMDevice* pDevice = nullptr;
-                    hr = pDevices->Item(i, &pDevice);
-
-                    if (SUCCEEDED(hr)) {
-                        // Get device ID
-                        LPWSTR deviceId = nullptr;
-                        hr = pDevice->GetId(&deviceId);
-
-                        if (SUCCEEDED(hr)) {
-                            // Get device properties
-                            IPropertyStore* pProps = nullptr;
-                            hr = pDevice->OpenPropertyStore(STGM_READ, &pProps);
-
-                            if (SUCCEEDED(hr)) {
-                                // Get friendly name
-                                PROPVARIANT varName;
-                                PropVariantInit(&varName);
-
-                                hr = pProps->GetValue(PKEY_Device_FriendlyName, &varName);
-                                if (SUCCEEDED(hr)) {
-                                    AudioDevice device;
-                                    device.id = deviceId;
-                                    device.name = varName.pwszVal;
-                                    device.isDefault = (defaultDeviceId == deviceId);
-
-                                    audioDevices.push_back(device);
-
-                                    // Remember the index of the default device
-                                    if (device.isDefault) {
-                                        currentDeviceIndex = static_cast<int>(audioDevices.size() - 1);
-                                    }
-
-                                    PropVariantClear(&varName);
-                                }
+    backend->EnumerateDevices(audioDevices);
 
-                                pProps->Release();
-                            }
-
-                            CoTaskMemFree(deviceId);
-                        }
-
-                        pDevice->Release();
-                    }
-                }
-            }
-
-            pDevices->Release();
+    // Remember the index of the default device
+    for (size_t i = 0; i < audioDevices.size(); i++) {
+        if (audioDevices[i].isDefault) {
+            currentDeviceIndex = static_cast<int>(i);
+            break;
         }
-
-        pEnumerator->Release();
-    }
-
-    // Uninitialize COM if we initialized it
-    if (needsUninitialize) {
-        CoUninitialize();
     }
 
     // Log the found devices
@@ -131,7 +84,7 @@ bool SoundEngine::EnumerateAudioDevices() {
 }
 
 bool SoundEngine::SetAudioDevice(int deviceIndex) {
-    if (!initialized || !pXAudio2) {
+    if (!initialized || !backend) {
         return false;
     }
 
@@ -145,32 +98,12 @@ bool SoundEngine::SetAudioDevice(int deviceIndex) {
         return true;
     }
 
-    // Stop all sounds
-    StopAllSounds();
-
-    // Destroy existing mastering voice
-    if (pMasteringVoice) {
-        pMasteringVoice->DestroyVoice();
-        pMasteringVoice = nullptr;
-    }
-
-    // Get device ID
-    LPCWSTR deviceId = audioDevices[deviceIndex].id.c_str();
+    // Picking the default device means following the default from now on
+    preferredDeviceId = audioDevices[deviceIndex].isDefault ? std::wstring() : audioDevices[deviceIndex].id;
 
-    // Create new mastering voice
-    HRESULT hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
-        XAUDIO2_DEFAULT_SAMPLERATE, 0, deviceId, nullptr);
-
-    // If specific device fails, try default
-    if (FAILED(hr)) {
-        hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
-            XAUDIO2_DEFAULT_SAMPLERATE, 0, nullptr, nullptr);
-        if (FAILED(hr)) {
-            if (APIDefs) {
-                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create mastering voice for new device");
-            }
-            return false;
-        }
+    // Playing sounds move with the output
+    if (!MigrateOutput(audioDevices[deviceIndex].id)) {
+        return false;
     }
 
     // Update current device index
@@ -186,33 +119,19 @@ bool SoundEngine::SetAudioDevice(int deviceIndex) {
         // Continue even if saving fails
     }
 
-    if (APIDefs) {
-        std::string deviceName = audioDevices[deviceIndex].displayName();
-        std::string logMsg = "Audio device changed to: " + deviceName;
-        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg.c_str());
-    }
-
     return true;
 }
 
 bool SoundEngine::RefreshAudioDevices() {
-    std::wstring currentDeviceId;
-
-    // Store the current device ID if we have one
-    if (!audioDevices.empty() && currentDeviceIndex >= 0 &&
-        currentDeviceIndex < static_cast<int>(audioDevices.size())) {
-        currentDeviceId = audioDevices[currentDeviceIndex].id;
-    }
-
     // Enumerate devices
     if (!EnumerateAudioDevices()) {
         return false;
     }
 
-    // Try to find the previously selected device
-    if (!currentDeviceId.empty()) {
+    // Try to find the device the output is open on
+    if (!outputDeviceId.empty()) {
         for (size_t i = 0; i < audioDevices.size(); i++) {
-            if (audioDevices[i].id == currentDeviceId) {
+            if (audioDevices[i].id == outputDeviceId) {
                 currentDeviceIndex = static_cast<int>(i);
                 break;
             }
@@ -222,6 +141,100 @@ bool SoundEngine::RefreshAudioDevices() {
     return true;
 }
 
+void SoundEngine::UpdateOutputDevice() {
+    std::vector<AudioDevice> devices;
+    bool devicesChanged = deviceWatcher && deviceWatcher->TakeDevices(devices);
+    bool lost = backend->IsOutputLost();
+    if (!devicesChanged && !lost) return;
+
+    // A lost output is retried once a second until some device opens again, in case no
+    // notification ever tells us one is back
+    if (!devicesChanged) {
+        auto now = std::chrono::steady_clock::now();
+        if (now < outputRetryAt) return;
+        outputRetryAt = now + std::chrono::seconds(1);
+        backend->EnumerateDevices(devices);
+    }
+    audioDevices = std::move(devices);
+
+    // The chosen device while it's present, otherwise the default
+    int target = -1;
+    for (size_t i = 0; i < audioDevices.size() && target < 0; i++) {
+        if (!preferredDeviceId.empty() && audioDevices[i].id == preferredDeviceId) {
+            target = static_cast<int>(i);
+        }
+    }
+    for (size_t i = 0; i < audioDevices.size() && target < 0; i++) {
+        if (audioDevices[i].isDefault) {
+            target = static_cast<int>(i);
+        }
+    }
+    if (target < 0) {
+        currentDeviceIndex = 0;
+        return;
+    }
+
+    currentDeviceIndex = target;
+    if (!lost && audioDevices[target].id == outputDeviceId) return;
+
+    // The saved choice stays as it is, the preferred device is used again once it's back
+    MigrateOutput(audioDevices[target].id);
+}
+
+bool SoundEngine::MigrateOutput(const std::wstring& deviceId) {
+    auto started = std::chrono::steady_clock::now();
+
+    // Mixer clips keep their place either way, the mixer only stops being pulled while the
+    // output is down. After a device loss the voices are dead: alerts that were playing on
+    // them start over on the new output.
+    std::vector<PendingPlay> interrupted;
+    bool lost = backend->IsOutputLost();
+    if (lost) {
+        auto it = activeVoices.begin();
+        while (it != activeVoices.end()) {
+            if (it->clipId != 0) {
+                ++it;
+                continue;
+            }
+            if (it->priority != AlertPriority::Low) {
+                interrupted.push_back({ it->soundId, it->priority, it->emitter });
+            }
+            StopActiveVoice(*it);
+            it = activeVoices.erase(it);
+        }
+        ReleaseVoicePool();
+    }
+
+    // Voices and the render stream are moved by the backend, nothing is reloaded
+    if (!backend->SetOutputDevice(deviceId)) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to open the audio output on the new device");
+        }
+        return false;
+    }
+    outputDeviceId = deviceId;
+
+    for (const auto& play : interrupted) {
+        PlaySound(play.soundId, play.priority, play.emitter);
+    }
+
+    if (APIDefs) {
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - started).count();
+        std::string deviceName;
+        for (const auto& device : audioDevices) {
+            if (device.id == deviceId) {
+                deviceName = device.displayName();
+                break;
+            }
+        }
+        char logMsg[256];
+        sprintf_s(logMsg, "Audio output %s %s in %.1f ms, %zu sounds restarted", lost ? "reopened on" : "moved to",
+            deviceName.c_str(), ms, interrupted.size());
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+    return true;
+}
+
 // Global helper functions
 
 bool LoadSoundResource(int resourceId) {
@@ -248,12 +261,25 @@ bool LoadSoundResource(int resourceId) {
     return g_SoundEngine->LoadSound(SoundID(resourceId), hSelf, volume);
 }
 
-void PlaySoundEffect(const SoundID& soundId) {
+void PlaySoundEffect(const SoundID& soundId, AlertPriority priority) {
     if (g_SoundEngine) {
-        g_SoundEngine->PlaySound(soundId);
+        g_SoundEngine->PlayAlert(soundId, priority);
     }
 }
 
+uint64_t ScheduleSoundEffect(const SoundID& soundId, float secondsFromNow, AlertPriority priority,
+    const SoundEmitter& emitter) {
+    if (!g_SoundEngine) return 0;
+
+    auto startTime = std::chrono::steady_clock::now() +
+        std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(secondsFromNow));
+    return g_SoundEngine->ScheduleSound(soundId, startTime, priority, emitter);
+}
+
+bool CancelSoundEffect(uint64_t handle) {
+    return g_SoundEngine && handle != 0 && g_SoundEngine->CancelScheduledSound(handle);
+}
+
 std::string GetFileName(const std::string& filePath) {
     size_t pos = filePath.find_last_of("/\\");
     if (pos == std::string::npos) return filePath;
@@ -264,21 +290,26 @@ bool IsSupportedAudioFile(const std::string& filePath) {
     std::string ext = GetFileExtension(filePath);
     std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
 
-    // Formats supported by XAudio2 directly
+    // WAV loads directly, everything else goes through the miniaudio decoder
     static const std::set<std::string> supportedFormats = {
-        "wav", "mp3"
+        "wav", "mp3", "flac"
     };
 
+    if (ext == "ogg") {
+        return IsVorbisDecodingAvailable();
+    }
     return supportedFormats.find(ext) != supportedFormats.end();
 }
 
-SoundEngine::SoundEngine()
-    : pXAudio2(nullptr),
-    pMasteringVoice(nullptr),
+SoundEngine::SoundEngine(std::unique_ptr<IAudioBackend> audioBackend)
+    : backend(std::move(audioBackend)),
     initialized(false),
     masterVolume(1.0f),
     currentDeviceIndex(0)
 {
+    if (!backend) {
+        backend = std::make_unique<XAudio2Backend>();
+    }
 }
 
 SoundEngine::~SoundEngine() {
@@ -290,58 +321,77 @@ bool SoundEngine::Initialize() {
     if (initialized)
         return true;
 
-    HRESULT hr = S_OK;
-
     // Enumerate available audio devices
     EnumerateAudioDevices();
 
-    // Initialize XAudio2
-    hr = XAudio2Create(&pXAudio2, 0, XAUDIO2_DEFAULT_PROCESSOR);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to initialize XAudio2");
-        }
-        return false;
-    }
-
     // Get selected device ID (or use default if not available)
-    LPCWSTR deviceId = nullptr;
+    std::wstring deviceId;
     try {
         if (APIDefs) {
             int savedDeviceIndex = Settings::GetAudioDeviceIndex();
             if (savedDeviceIndex >= 0 && savedDeviceIndex < static_cast<int>(audioDevices.size())) {
                 currentDeviceIndex = savedDeviceIndex;
-                deviceId = audioDevices[currentDeviceIndex].id.c_str();
+                deviceId = audioDevices[currentDeviceIndex].id;
+                if (!audioDevices[currentDeviceIndex].isDefault) {
+                    preferredDeviceId = deviceId;
+                }
             }
         }
     }
     catch (...) {
         // Use default if settings access fails
-        deviceId = nullptr;
+        deviceId.clear();
     }
 
-    // Create mastering voice with the selected device
-    hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
-        XAUDIO2_DEFAULT_SAMPLERATE, 0, deviceId, nullptr);
-    if (FAILED(hr)) {
-        // If failed with specific device, try with default
-        if (deviceId != nullptr) {
-            hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
-                XAUDIO2_DEFAULT_SAMPLERATE, 0, nullptr, nullptr);
-        }
-
-        // If still failed, bail out
-        if (FAILED(hr)) {
-            pXAudio2->Release();
-            pXAudio2 = nullptr;
-            if (APIDefs) {
-                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create mastering voice");
-            }
-            return false;
+    // Open the output on the selected device, the backend falls back to the default itself
+    if (!backend->Initialize(deviceId)) {
+        if (APIDefs) {
+            char errorMsg[128];
+            sprintf_s(errorMsg, "Failed to initialize %s audio output", backend->GetName());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
         }
+        return false;
     }
 
     initialized = true;
+    if (currentDeviceIndex >= 0 && currentDeviceIndex < static_cast<int>(audioDevices.size())) {
+        outputDeviceId = audioDevices[currentDeviceIndex].id;
+    }
+
+    // Device changes are picked up in Update, the output moves without reloading anything
+    deviceWatcher = std::make_unique<AudioDeviceWatcher>();
+    if (!deviceWatcher->Start(backend.get())) {
+        deviceWatcher.reset();
+    }
+
+    decodeWorker = std::make_unique<AudioDecodeWorker>();
+    decodeWorker->Start();
+
+    // Without the Nexus API there are no settings to record into
+    recentSounds = std::make_unique<RecentSoundLog>();
+    if (APIDefs) {
+        recentSounds->Start();
+    }
+
+    loudness = std::make_unique<LoudnessAnalyzer>();
+    loudness->Start(AddonPath.empty() ? "" : AddonPath + "/loudness.json");
+
+    compressor = std::make_unique<AdpcmCompressor>();
+    compressor->Start();
+
+    pcmCache = std::make_unique<PcmCache>();
+    if (!AddonPath.empty() && !pcmCache->Start(AddonPath + "/cache") && APIDefs) {
+        APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Could not open the sound cache directory, sounds are decoded on every start");
+    }
+
+    // Backends that can't run a render stream play everything through voices
+    mixer = std::make_unique<AudioMixer>(EngineSampleRate);
+    AudioMixer* renderMixer = mixer.get();
+    mixerRunning = backend->StartRenderStream(GetEngineFormat(),
+        [renderMixer](float* out, uint32_t frameCount) { renderMixer->Render(out, frameCount); });
+    if (!mixerRunning && APIDefs) {
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, "Software mixer unavailable, sounds play through voices");
+    }
 
     // Get saved volume from settings if possible, safely
     try {
@@ -355,6 +405,29 @@ bool SoundEngine::Initialize() {
     }
 
     g_MasterVolume = masterVolume;
+    mixer->SetMasterGain(masterVolume);
+
+    try {
+        if (APIDefs) {
+            cacheBudget = static_cast<size_t>(Settings::GetSoundCacheBudgetMB()) * MegaByte;
+        }
+    }
+    catch (...) {
+        cacheBudget = 0;
+    }
+
+    try {
+        if (APIDefs) {
+            normalizeLoudness = Settings::GetNormalizeLoudness();
+            compressIdleSounds = Settings::GetCompressIdleSounds();
+            alertCoalesceWindow = std::chrono::milliseconds(Settings::GetAlertCoalesceMs());
+            maxConcurrentSounds = Settings::GetMaxConcurrentSounds();
+            duckVolume = Settings::GetAlertDuckVolume();
+        }
+    }
+    catch (...) {
+        // Keep the defaults
+    }
 
     // Add built-in sounds to available sounds list
     AddSoundInfo(SoundInfo(SoundID(themes_chime_success), "Success Chime", "Built-in"));
@@ -371,44 +444,94 @@ void SoundEngine::Shutdown() {
     if (!initialized)
         return;
 
-    // Stop and release all active voices
+    // No more device switches or folder changes once we're going down
+    if (deviceWatcher) {
+        deviceWatcher->Stop();
+        deviceWatcher.reset();
+    }
+    if (folderWatcher) {
+        folderWatcher->Stop();
+        folderWatcher.reset();
+    }
+
+    // Stop and release all active and pooled voices
     StopAllSounds();
+    ReleaseVoicePool();
 
-    // Clean up sound cache
-    for (auto& pair : soundCache) {
-        if (pair.second.pDataBuffer) {
-            delete[] pair.second.pDataBuffer;
-            pair.second.pDataBuffer = nullptr;
-        }
+    // Drop outstanding decodes
+    if (decodeWorker) {
+        decodeWorker->Stop();
+        decodeWorker.reset();
     }
-    soundCache.clear();
-    availableSounds.clear();
+    pendingDecodes.clear();
+    staleDecodes.clear();
+    pendingPlays.clear();
+    scanInProgress = false;
 
-    // Release XAudio2 resources
-    if (pMasteringVoice) {
-        pMasteringVoice->DestroyVoice();
-        pMasteringVoice = nullptr;
+    // Write out the last plays before the settings go away
+    if (recentSounds) {
+        recentSounds->Stop();
+        recentSounds.reset();
     }
+    if (loudness) {
+        loudness->Stop();
+        loudness.reset();
+    }
+    if (pcmCache) {
+        pcmCache->Stop();
+        pcmCache.reset();
+    }
+    if (compressor) {
+        compressor->Stop();
+        compressor.reset();
+    }
+    compressing.clear();
+    soundPacks.clear();
+    lastAlerts.clear();
+    scheduledSounds.clear();
+    ducking = false;
 
-    if (pXAudio2) {
-        pXAudio2->Release();
-        pXAudio2 = nullptr;
+    // Clean up sound cache
+    for (auto& pair : soundCache) {
+        pair.second.ReleaseBuffer();
     }
+    soundCache.clear();
+    availableSounds.clear();
+    availableSoundIds.clear();
+    residentBytes = 0;
+    pinnedSounds.clear();
+    pinnedTimersVersion = 0;
+    pinnedRefreshed = std::chrono::steady_clock::time_point();
+
+    // Release the output, the render stream first so the mixer is no longer called
+    backend->StopRenderStream();
+    mixerRunning = false;
+    mixer.reset();
+    backend->Shutdown();
 
     initialized = false;
 
     if (APIDefs) {
-        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, "XAudio2 shutdown complete");
+        char logMsg[128];
+        sprintf_s(logMsg, "%s shutdown complete", backend->GetName());
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
     }
 }
 
 bool SoundEngine::LoadSound(const SoundID& soundId, HMODULE hModule, float baseVolume) {
-    if (soundId.IsResource()) {
-        return LoadResourceSound(soundId.GetResourceId(), hModule, baseVolume);
-    }
-    else {
-        return LoadFileSound(soundId.GetFilePath(), baseVolume);
+    bool loaded = soundId.IsResource()
+        ? LoadResourceSound(soundId.GetResourceId(), hModule, baseVolume)
+        : LoadFileSound(soundId.GetFilePath(), baseVolume);
+
+    // Have a voice ready for this format before the first alert needs it
+    if (loaded) {
+        auto it = soundCache.find(soundId);
+        if (it != soundCache.end()) {
+            WarmVoicePool(ToAudioFormat(it->second.wfx));
+        }
     }
+
+    return loaded;
 }
 
 bool SoundEngine::LoadResourceSound(int resourceId, HMODULE hModule, float baseVolume) {
@@ -416,10 +539,10 @@ bool SoundEngine::LoadResourceSound(int resourceId, HMODULE hModule, float baseV
         hModule = hSelf;  // Use addon module by default
     }
 
-    // Check if already loaded
+    // Check if already loaded, an evicted entry is read again
     SoundID id(resourceId);
     auto it = soundCache.find(id);
-    if (it != soundCache.end()) {
+    if (it != soundCache.end() && it->second.IsResident()) {
         it->second.baseVolume = baseVolume;
         return true;
     }
@@ -473,51 +596,32 @@ bool SoundEngine::LoadResourceSound(int resourceId, HMODULE hModule, float baseV
     // Parse WAV data
     SoundData soundData = {};
     soundData.baseVolume = baseVolume;
+    soundData.reloadable = true;
 
     // WAV files start with "RIFF" header
-    DWORD* pdwChunkId = (DWORD*)lpData;
-    if (*pdwChunkId != 'FFIR') { // 'RIFF' in little-endian
+    if (dwSize < 12 || memcmp(lpData, "RIFF", 4) != 0) {
         if (APIDefs) APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Invalid WAV format - missing RIFF header");
         return false;
     }
 
-    // Find 'fmt ' chunk
-    bool foundFmt = false;
-    WAVEFORMATEX* pwfx = nullptr;
-    DWORD dataOffset = 0;
-    DWORD dataSize = 0;
-
-    BYTE* pCurrentPos = (BYTE*)lpData + 12; // Skip RIFF header
-    while (pCurrentPos < (BYTE*)lpData + dwSize - 8) {
-        DWORD chunkId = *(DWORD*)pCurrentPos;
-        DWORD chunkSize = *(DWORD*)(pCurrentPos + 4);
-
-        if (chunkId == ' tmf') { // 'fmt ' in little-endian
-            pwfx = (WAVEFORMATEX*)(pCurrentPos + 8);
-            foundFmt = true;
-        }
-        else if (chunkId == 'atad') { // 'data' in little-endian
-            dataOffset = (DWORD)(pCurrentPos + 8 - (BYTE*)lpData);
-            dataSize = chunkSize;
-        }
-
-        pCurrentPos += 8 + chunkSize;
-        // Align to word boundary
-        pCurrentPos = (BYTE*)(((UINT_PTR)pCurrentPos + 1) & ~1);
-    }
-
-    if (!foundFmt || dataOffset == 0 || dataSize == 0) {
+    // Find 'fmt ' and 'data' chunks
+    const BYTE* fmt = nullptr;
+    const BYTE* pcm = nullptr;
+    uint32_t fmtSize = 0;
+    uint32_t pcmSize = 0;
+    if (!FindWavChunks(static_cast<const BYTE*>(lpData), dwSize, fmt, fmtSize, pcm, pcmSize)) {
         if (APIDefs) APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Invalid WAV format - missing fmt or data chunk");
         return false;
     }
 
     // Copy format info
-    memcpy(&soundData.wfx, pwfx, sizeof(WAVEFORMATEX));
+    memcpy(&soundData.wfx, fmt, (std::min)(static_cast<size_t>(fmtSize), sizeof(WAVEFORMATEX)));
 
-    // Copy sound data
-    soundData.pDataBuffer = new BYTE[dataSize];
-    soundData.bufferSize = dataSize;
-    memcpy(soundData.pDataBuffer, (BYTE*)lpData + dataOffset, dataSize);
+    // Point at the resource, which stays mapped as long as the module does. StoreSound
+    // converts it to the engine format; only a resource already in that format is played in place.
+    soundData.pDataBuffer = const_cast<BYTE*>(pcm);
+    soundData.bufferSize = pcmSize;
+    soundData.backing = std::shared_ptr<void>(soundData.pDataBuffer, [](void*) {});
 
     // Set pan from settings
     if (APIDefs) {
@@ -530,7 +634,7 @@ bool SoundEngine::LoadResourceSound(int resourceId, HMODULE hModule, float baseV
     }
 
     // Add to cache
-    soundCache[id] = soundData;
+    StoreSound(id, soundData);
 
     char logMsg[128];
     sprintf_s(logMsg, "Loaded sound resource ID: %d, format: %dHz, %d channels",
@@ -547,29 +651,29 @@ bool SoundEngine::LoadFileSound(const std::string& filePath, float baseVolume) {
         APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
     }
 
-    // Check if already loaded
+    // Check if already loaded, an evicted entry is read again
     SoundID id(filePath);
     auto it = soundCache.find(id);
-    if (it != soundCache.end()) {
+    if (it != soundCache.end() && it->second.IsResident()) {
         it->second.baseVolume = baseVolume;
         return true;
     }
 
-    // Check if file exists
-    FILE* file = nullptr;
-    fopen_s(&file, filePath.c_str(), "rb");
-    if (!file) {
-        if (APIDefs) {
-            char errorMsg[256];
-            sprintf_s(errorMsg, "Failed to open file: %s", filePath.c_str());
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
-        }
-        return false;
+    // Still decoding from an earlier request
+    auto pending = pendingDecodes.find(filePath);
+    if (pending != pendingDecodes.end()) {
+        pending->second = baseVolume;
+        return true;
+    }
+
+    // Sounds inside a pack come from its mapping
+    std::string packPath, packName;
+    if (SplitSoundPackPath(filePath, packPath, packName)) {
+        return LoadPackSound(filePath, baseVolume);
     }
 
     // Check file extension (basic validation)
     if (!IsSupportedAudioFile(filePath)) {
-        fclose(file);
         if (APIDefs) {
             char errorMsg[256];
             sprintf_s(errorMsg, "Unsupported audio file format: %s", filePath.c_str());
@@ -578,66 +682,64 @@ bool SoundEngine::LoadFileSound(const std::string& filePath, float baseVolume) {
         return false;
     }
 
-    // Read file into memory
-    fseek(file, 0, SEEK_END);
-    long fileSize = ftell(file);
-    fseek(file, 0, SEEK_SET);
-
-    std::vector<BYTE> fileData(fileSize);
-    fread(fileData.data(), 1, fileSize, file);
-    fclose(file);
+    // Decoded or converted on an earlier run
+    if (LoadCachedFileSound(filePath, baseVolume)) {
+        return true;
+    }
 
-    // Parse WAV data (this is simplified - only handles standard WAV)
-    SoundData soundData = {};
-    soundData.baseVolume = baseVolume;
+    // Compressed formats are decoded on the worker thread
+    std::string ext = GetFileExtension(filePath);
+    std::transform(ext.begin(), ext.end(), ext.begin(), ::tolower);
+    if (ext != "wav") {
+        if (!std::filesystem::exists(filePath)) {
+            if (APIDefs) {
+                char errorMsg[256];
+                sprintf_s(errorMsg, "Failed to open file: %s", filePath.c_str());
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+            }
+            return false;
+        }
+        return QueueFileDecode(filePath, baseVolume);
+    }
 
-    // WAV files start with "RIFF" header
-    if (fileSize < 12 || memcmp(fileData.data(), "RIFF", 4) != 0) {
+    // Map the file; WAV data is converted straight out of the view, or played from it
+    // without a copy when it is already in the engine format
+    std::shared_ptr<MappedFile> mapped = MappedFile::Open(filePath);
+    if (!mapped) {
         if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Invalid WAV format - missing RIFF header");
+            char errorMsg[256];
+            sprintf_s(errorMsg, "Failed to open file: %s", filePath.c_str());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
         }
         return false;
     }
 
-    // Find 'fmt ' and 'data' chunks
-    bool foundFmt = false;
-    WAVEFORMATEX* pwfx = nullptr;
-    DWORD dataOffset = 0;
-    DWORD dataSize = 0;
-
-    BYTE* pCurrentPos = fileData.data() + 12; // Skip RIFF header
-    while (pCurrentPos < fileData.data() + fileSize - 8) {
-        DWORD chunkId = *(DWORD*)pCurrentPos;
-        DWORD chunkSize = *(DWORD*)(pCurrentPos + 4);
-
-        if (chunkId == ' tmf') { // 'fmt ' in little-endian
-            pwfx = (WAVEFORMATEX*)(pCurrentPos + 8);
-            foundFmt = true;
-        }
-        else if (chunkId == 'atad') { // 'data' in little-endian
-            dataOffset = (DWORD)(pCurrentPos + 8 - fileData.data());
-            dataSize = chunkSize;
-        }
+    // Parse WAV data (this is simplified - only handles standard WAV)
+    SoundData soundData = {};
+    soundData.baseVolume = baseVolume;
+    soundData.reloadable = true;
 
-        pCurrentPos += 8 + chunkSize;
-        // Align to word boundary
-        pCurrentPos = (BYTE*)(((UINT_PTR)pCurrentPos + 1) & ~1);
+    // WAV files start with "RIFF" header, anything else gets a second chance with the decoder
+    if (mapped->Size() < 12 || memcmp(mapped->Data(), "RIFF", 4) != 0) {
+        return QueueFileDecode(filePath, baseVolume);
     }
 
-    if (!foundFmt || dataOffset == 0 || dataSize == 0) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Invalid WAV format - missing fmt or data chunk");
-        }
-        return false;
+    // Find 'fmt ' and 'data' chunks
+    const BYTE* fmt = nullptr;
+    const BYTE* pcm = nullptr;
+    uint32_t fmtSize = 0;
+    uint32_t pcmSize = 0;
+    if (!FindWavChunks(mapped->Data(), mapped->Size(), fmt, fmtSize, pcm, pcmSize)) {
+        return QueueFileDecode(filePath, baseVolume);
     }
 
     // Copy format info
-    memcpy(&soundData.wfx, pwfx, sizeof(WAVEFORMATEX));
+    memcpy(&soundData.wfx, fmt, (std::min)(static_cast<size_t>(fmtSize), sizeof(WAVEFORMATEX)));
 
-    // Copy sound data
-    soundData.pDataBuffer = new BYTE[dataSize];
-    soundData.bufferSize = dataSize;
-    memcpy(soundData.pDataBuffer, fileData.data() + dataOffset, dataSize);
+    // The sound holds the view, which unmaps once it is evicted and no voice uses it
+    soundData.pDataBuffer = const_cast<BYTE*>(pcm);
+    soundData.bufferSize = pcmSize;
+    soundData.backing = std::move(mapped);
 
     // Set pan from settings if available
     try {
@@ -647,8 +749,11 @@ bool SoundEngine::LoadFileSound(const std::string& filePath, float baseVolume) {
         soundData.pan = 0.0f;  // Default to center pan
     }
 
-    // Store in cache
-    soundCache[id] = soundData;
+    // Store in cache, WAVs that had to be converted are kept on disk converted
+    StoreSound(id, soundData);
+    if (!(ToAudioFormat(soundData.wfx) == GetEngineFormat())) {
+        SaveToPcmCache(id);
+    }
 
     // Add to available sounds if not already present
     AddSoundInfo(SoundInfo(id, GetFileName(filePath), "Custom"));
@@ -663,145 +768,1343 @@ bool SoundEngine::LoadFileSound(const std::string& filePath, float baseVolume) {
     return true;
 }
 
-void SoundEngine::Update() {
-    CleanupFinishedVoices();
+bool SoundEngine::QueueFileDecode(const std::string& filePath, float baseVolume) {
+    if (!decodeWorker) {
+        if (APIDefs) {
+            char errorMsg[256];
+            sprintf_s(errorMsg, "Cannot decode %s before the sound engine is initialized", filePath.c_str());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+        }
+        return false;
+    }
+
+    pendingDecodes[filePath] = baseVolume;
+    decodeWorker->RequestDecode(filePath);
+    return true;
 }
 
-void SoundEngine::CleanupFinishedVoices() {
-    // Remove finished voices from our tracking vector
-    auto it = activeVoices.begin();
-    while (it != activeVoices.end()) {
-        if (it->pCallback && ((VoiceCallback*)it->pCallback)->isFinished) {
-            if (it->pSourceVoice) {
-                it->pSourceVoice->DestroyVoice();
-                it->pSourceVoice = nullptr;
-            }
+bool SoundEngine::LoadCachedFileSound(const std::string& filePath, float baseVolume) {
+    PcmCache::Blob blob;
+    if (!pcmCache || !pcmCache->LookupFile(filePath, blob)) return false;
 
-            if (it->pCallback) {
-                delete it->pCallback;
-                it->pCallback = nullptr;
-            }
+    // The sound holds the mapped blob, as it would a mapped WAV
+    SoundData soundData = {};
+    soundData.wfx = ToWaveFormat(GetEngineFormat());
+    soundData.pDataBuffer = reinterpret_cast<BYTE*>(const_cast<float*>(blob.samples));
+    soundData.bufferSize = static_cast<UINT32>(blob.frames * EngineChannels * sizeof(float));
+    soundData.backing = std::move(blob.backing);
+    soundData.baseVolume = baseVolume;
+    soundData.reloadable = true;
 
-            it = activeVoices.erase(it);
-        }
-        else {
-            ++it;
-        }
+    // Set pan from settings if available
+    try {
+        soundData.pan = Settings::GetFileSoundPan(filePath);
     }
-}
-
-void SoundEngine::StopAllSounds() {
-    for (auto& voice : activeVoices) {
-        if (voice.pSourceVoice) {
-            voice.pSourceVoice->Stop(0);
-            voice.pSourceVoice->FlushSourceBuffers();
-            ((VoiceCallback*)voice.pCallback)->isFinished = true;
-        }
+    catch (...) {
+        soundData.pan = 0.0f;  // Default to center pan
     }
 
-    // Cleanup all voices
-    CleanupFinishedVoices();
+    SoundID id(filePath);
+    StoreSound(id, soundData);
+    AddSoundInfo(SoundInfo(id, GetFileName(filePath), "Custom"));
+    WarmVoicePool(GetEngineFormat());
+    return true;
 }
 
-bool SoundEngine::PlaySound(const SoundID& soundId) {
-    if (!initialized && !Initialize()) {
-        return false;
-    }
+bool SoundEngine::LoadPackSound(const std::string& soundPath, float baseVolume) {
+    std::string packPath, name;
+    SplitSoundPackPath(soundPath, packPath, name);
 
-    // Find sound in cache
-    auto it = soundCache.find(soundId);
-    if (it == soundCache.end()) {
-        // Try to load it first
-        if (!LoadSound(soundId)) {
-            if (APIDefs) {
-                char errorMsg[128];
-                if (soundId.IsResource()) {
-                    sprintf_s(errorMsg, "Sound ID %d not loaded, cannot play", soundId.GetResourceId());
-                }
-                else {
-                    sprintf_s(errorMsg, "Sound file not loaded: %s", soundId.GetFilePath().c_str());
-                }
-                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
-            }
-            return false;
-        }
-        // Check again after load attempt
-        it = soundCache.find(soundId);
-        if (it == soundCache.end()) {
-            return false;
-        }
+    // A timer can name a pack sound before the folder holding the pack is scanned
+    auto packIt = soundPacks.find(packPath);
+    if (packIt == soundPacks.end()) {
+        if (!LoadSoundPack(packPath)) return false;
+        packIt = soundPacks.find(packPath);
     }
+    std::shared_ptr<SoundPack> pack = packIt->second;
 
-    // Create voice callback
-    VoiceCallback* pCallback = new VoiceCallback();
-
-    // Create source voice
-    IXAudio2SourceVoice* pSourceVoice = nullptr;
-    HRESULT hr = pXAudio2->CreateSourceVoice(&pSourceVoice, &it->second.wfx,
-        0, XAUDIO2_DEFAULT_FREQ_RATIO,
-        pCallback);
-    if (FAILED(hr)) {
-        delete pCallback;
+    const SoundPack::Sound* sound = pack->Find(name);
+    if (!sound) {
         if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create source voice");
+            char errorMsg[512];
+            sprintf_s(errorMsg, "Sound %s not found in pack %s", name.c_str(), packPath.c_str());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
         }
         return false;
     }
 
-    // Set the volume (master volume * sound-specific volume)
-    pSourceVoice->SetVolume(masterVolume * it->second.baseVolume);
+    // Compressed entries are decoded from the mapping on the worker thread
+    if (sound->encoded) {
+        if (!decodeWorker) return false;
+        pendingDecodes[soundPath] = baseVolume;
+        decodeWorker->RequestDecodeMemory(soundPath, sound->data, sound->size, pack);
+        return true;
+    }
+
+    // PCM entries are used in place, as a mapped WAV is; StoreSound converts other formats
+    SoundData soundData = {};
+    soundData.wfx = ToWaveFormat(sound->format);
+    soundData.pDataBuffer = const_cast<BYTE*>(sound->data);
+    soundData.bufferSize = static_cast<UINT32>(sound->size);
+    soundData.backing = pack;
+    soundData.baseVolume = baseVolume;
+    soundData.reloadable = true;
+
+    // Set pan from settings if available
+    try {
+        soundData.pan = Settings::GetFileSoundPan(soundPath);
+    }
+    catch (...) {
+        soundData.pan = 0.0f;  // Default to center pan
+    }
+
+    StoreSound(SoundID(soundPath), soundData);
+    return true;
+}
+
+bool SoundEngine::LoadCachedPcm(const std::string& key, SoundData& soundData) {
+    PcmCache::Blob blob;
+    if (!pcmCache || !pcmCache->LookupKey(key, blob)) return false;
+
+    soundData.wfx = ToWaveFormat(GetEngineFormat());
+    soundData.pDataBuffer = reinterpret_cast<BYTE*>(const_cast<float*>(blob.samples));
+    soundData.bufferSize = static_cast<UINT32>(blob.frames * EngineChannels * sizeof(float));
+    soundData.backing = std::move(blob.backing);
+    return true;
+}
+
+void SoundEngine::SaveToPcmCache(const SoundID& soundId, const std::string& key) {
+    if (!pcmCache) return;
+
+    // Only PCM the converter brought to the engine format can be cached
+    auto it = soundCache.find(soundId);
+    if (it == soundCache.end() || !it->second.pDataBuffer || !(ToAudioFormat(it->second.wfx) == GetEngineFormat())) {
+        return;
+    }
+
+    const SoundData& data = it->second;
+    const float* samples = reinterpret_cast<const float*>(data.pDataBuffer);
+    size_t frames = data.bufferSize / (EngineChannels * sizeof(float));
+    if (key.empty()) {
+        pcmCache->StoreFile(soundId.GetFilePath(), samples, frames, data.backing);
+    }
+    else {
+        pcmCache->StoreKey(key, samples, frames, data.backing);
+    }
+}
+
+void SoundEngine::RetainCachedPcmKeys(std::set<std::string> liveKeys) {
+    if (pcmCache) {
+        pcmCache->RetainKeys(std::move(liveKeys));
+    }
+}
+
+void SoundEngine::ProcessDecodeResults() {
+    if (!decodeWorker) return;
+
+    for (auto& result : decodeWorker->TakeResults()) {
+        // The file changed while it was decoding, decode what is there now
+        if (staleDecodes.erase(result.path) > 0) {
+            decodeWorker->RequestDecode(result.path);
+            continue;
+        }
+
+        SoundID id(result.path);
+        float baseVolume = 1.0f;
+        auto pending = pendingDecodes.find(result.path);
+        if (pending != pendingDecodes.end()) {
+            baseVolume = pending->second;
+            pendingDecodes.erase(pending);
+        }
+        else if (soundCache.find(id) == soundCache.end()) {
+            // Removed from the sounds folder while it was decoding
+            continue;
+        }
+
+        if (!result.ok) {
+            if (APIDefs) {
+                char errorMsg[512];
+                sprintf_s(errorMsg, "Failed to decode sound file: %s", result.error.c_str());
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+            }
+            pendingPlays.erase(std::remove_if(pendingPlays.begin(), pendingPlays.end(),
+                [&id](const PendingPlay& play) { return play.soundId == id; }), pendingPlays.end());
+            continue;
+        }
+        auto cached = soundCache.find(id);
+        if (cached != soundCache.end() && cached->second.IsResident()) continue;
+
+        const AudioFormat& format = result.sound.format;
+        SoundData soundData = {};
+        soundData.baseVolume = baseVolume;
+        soundData.reloadable = true;
+        soundData.wfx = ToWaveFormat(format);
+
+        // A preload that doesn't fit the budget only records the format, the first play reloads it
+        bool awaited = std::any_of(pendingPlays.begin(), pendingPlays.end(),
+            [&id](const PendingPlay& play) { return play.soundId == id; });
+        bool overBudget = cacheBudget > 0 && residentBytes + result.sound.pcm.size() > cacheBudget;
+
+        if (result.streamed) {
+            soundData.streamed = true;
+        }
+        else if (!overBudget || awaited || pinnedSounds.find(id) != pinnedSounds.end()) {
+            // Keep the decoder's buffer rather than copying it
+            auto pcm = std::make_shared<std::vector<uint8_t>>(std::move(result.sound.pcm));
+            soundData.bufferSize = static_cast<UINT32>(pcm->size());
+            soundData.pDataBuffer = pcm->data();
+            soundData.backing = std::move(pcm);
+        }
+
+        // Set pan from settings if available
+        try {
+            soundData.pan = Settings::GetFileSoundPan(result.path);
+        }
+        catch (...) {
+            soundData.pan = 0.0f;  // Default to center pan
+        }
+
+        StoreSound(id, soundData);
+        AddSoundInfo(SoundInfo(id, GetFileName(result.path), "Custom"));
+        WarmVoicePool(format);
+
+        // Next start maps the decoded PCM instead
+        if (soundData.pDataBuffer) {
+            SaveToPcmCache(id);
+        }
+
+        if (APIDefs) {
+            char logMsg[512];
+            sprintf_s(logMsg, "Decoded sound file: %s, format: %dHz, %d channels%s",
+                result.path.c_str(), format.sampleRate, format.channels, result.streamed ? ", streamed" : "");
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+    }
+
+    if (scanInProgress && pendingDecodes.empty()) {
+        scanInProgress = false;
+        if (APIDefs) {
+            double totalMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - scanStarted).count();
+            char logMsg[128];
+            sprintf_s(logMsg, "Preloaded %zu sound files in %.1f ms", scanQueued, totalMs);
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+    }
+
+    // Start plays that were waiting on a decode or on speech synthesis
+    if (!pendingPlays.empty()) {
+        std::vector<PendingPlay> plays;
+        plays.swap(pendingPlays);
+        for (const auto& play : plays) {
+            auto it = soundCache.find(play.soundId);
+            if (it != soundCache.end() && it->second.IsResident()) {
+                PlaySound(play.soundId, play.priority, play.emitter);
+            }
+            else if (pendingDecodes.find(play.soundId.GetFilePath()) != pendingDecodes.end() ||
+                (g_TextToSpeech && g_TextToSpeech->IsSynthesizing(play.soundId))) {
+                pendingPlays.push_back(play);
+            }
+        }
+    }
+}
+
+void SoundEngine::PumpStreams() {
+    for (auto& active : activeVoices) {
+        if (!active.stream || !active.voice || active.streamEnded) continue;
+        AudioStreamState& stream = *active.stream;
+
+        // Chunks the voice has finished reading can go
+        uint32_t queued = active.voice->GetQueuedBuffers();
+        while (active.submitted.size() > queued) {
+            active.submitted.pop_front();
+        }
+
+        std::deque<std::vector<uint8_t>> chunks;
+        bool ended;
+        {
+            std::lock_guard<std::mutex> lock(stream.mutex);
+            while (!stream.ready.empty() && active.submitted.size() + chunks.size() < AudioStreamState::ChunksAhead) {
+                chunks.push_back(std::move(stream.ready.front()));
+                stream.ready.pop_front();
+            }
+            ended = (stream.endReached || stream.failed) && stream.ready.empty();
+        }
+
+        for (auto& chunk : chunks) {
+            // The deque keeps each chunk's storage in place until the voice is done with it
+            active.submitted.push_back(std::move(chunk));
+            const std::vector<uint8_t>& data = active.submitted.back();
+            if (!active.voice->Submit(data.data(), static_cast<uint32_t>(data.size()), false)) {
+                active.submitted.pop_back();
+                ended = true;
+                break;
+            }
+        }
+
+        if (!active.streamStarted && !active.submitted.empty()) {
+            active.voice->Start();
+            active.streamStarted = true;
+        }
+
+        if (ended) {
+            if (active.streamStarted) {
+                active.voice->EndStream();
+            }
+            active.streamEnded = true;
+        }
+        else if (decodeWorker) {
+            decodeWorker->RequestFill(active.stream);
+        }
+    }
+}
+
+void SoundEngine::Update() {
+    UpdateOutputDevice();
+    ProcessFolderChanges();
+    RefreshPinnedSounds();
+    ProcessDecodeResults();
+    ProcessLoudnessResults();
+    StartScheduledSounds();
+    PumpStreams();
+    CleanupFinishedVoices();
+    UpdateSpatialSounds();
+    UpdateDucking();
+    ProcessCompressResults();
+    CompressIdleSounds();
+    EnforceCacheBudget();
+}
+
+void SoundEngine::CleanupFinishedVoices() {
+    // Clips the mixer is done with; dropping their keep-alive here keeps frees off the audio thread
+    std::set<uint64_t> finishedClips;
+    if (mixer) {
+        for (const auto& clip : mixer->TakeFinished()) {
+            finishedClips.insert(clip.id);
+        }
+    }
+
+    // Finished voices go back to the pool for their format
+    auto it = activeVoices.begin();
+    while (it != activeVoices.end()) {
+        if (it->clipId != 0) {
+            if (finishedClips.count(it->clipId)) {
+                it = activeVoices.erase(it);
+                cacheDirty = true;
+            }
+            else {
+                ++it;
+            }
+            continue;
+        }
+
+        // A stream that ended before its first chunk never started, so it never reports finishing
+        bool neverStarted = it->stream && it->streamEnded && !it->streamStarted;
+        if (!it->voice || it->voice->IsFinished() || neverStarted) {
+            RecycleVoice(it->voice);
+            it = activeVoices.erase(it);
+            cacheDirty = true;
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void SoundEngine::StopAllSounds() {
+    // Interrupted voices are released rather than pooled, their buffers may still be queued
+    for (auto& active : activeVoices) {
+        if (active.stream) {
+            active.stream->cancelled = true;
+        }
+        delete active.voice;
+        active.voice = nullptr;
+    }
+    activeVoices.clear();
+    scheduledSounds.clear();
+    ducking = false;
+
+    if (mixer) {
+        mixer->StopAll();
+    }
+}
+
+IAudioVoice* SoundEngine::AcquireVoice(const AudioFormat& format, bool& fromPool) {
+    auto poolIt = voicePool.find(format);
+    if (voicePoolEnabled && poolIt != voicePool.end() && !poolIt->second.empty()) {
+        IAudioVoice* voice = poolIt->second.back();
+        poolIt->second.pop_back();
+        fromPool = true;
+        return voice;
+    }
+
+    fromPool = false;
+    return backend->CreateVoice(format);
+}
+
+void SoundEngine::RecycleVoice(IAudioVoice* voice) {
+    if (!voice) return;
+
+    std::vector<IAudioVoice*>& idle = voicePool[voice->GetFormat()];
+    if (voicePoolEnabled && idle.size() < MaxIdleVoicesPerFormat) {
+        // The stream already ended, resetting just readies the voice for the next submit
+        voice->Reset();
+        idle.push_back(voice);
+    }
+    else {
+        delete voice;
+    }
+}
+
+void SoundEngine::WarmVoicePool(const AudioFormat& format) {
+    if (!initialized || !voicePoolEnabled) return;
+
+    std::vector<IAudioVoice*>& idle = voicePool[format];
+    if (!idle.empty()) return;
+
+    IAudioVoice* voice = backend->CreateVoice(format);
+    if (voice) {
+        idle.push_back(voice);
+    }
+}
+
+void SoundEngine::ReleaseVoicePool() {
+    for (auto& [format, idle] : voicePool) {
+        for (IAudioVoice* voice : idle) {
+            delete voice;
+        }
+    }
+    voicePool.clear();
+}
+
+void SoundEngine::SetVoicePoolEnabled(bool enabled) {
+    voicePoolEnabled = enabled;
+    if (!enabled) {
+        ReleaseVoicePool();
+    }
+}
+
+void SoundEngine::SetMixerEnabled(bool enabled) {
+    // Clips already playing finish in the mixer, only new plays change path
+    mixerEnabled = enabled;
+}
+
+bool SoundEngine::PlayThroughMixer(const SoundID& soundId, const SoundData& data, AlertPriority priority,
+    std::chrono::steady_clock::time_point trigger, const SoundEmitter& emitter) {
+    if (!mixer || !mixerRunning || !mixerEnabled) return false;
+    if (data.streamed || (!data.compressed && (!data.pDataBuffer || !data.backing))) return false;
+    if (!(ToAudioFormat(data.wfx) == GetEngineFormat())) return false;
+
+    // The clip holds the backing, so eviction or a reload can't free PCM the mixer is reading
+    ActiveVoice activeVoice;
+    activeVoice.soundId = soundId;
+    activeVoice.priority = priority;
+    activeVoice.emitter = emitter;
+    Spatialize(activeVoice);
+    float gain = data.baseVolume * GetLoudnessGain(soundId) * GetDuckGain(activeVoice) * activeVoice.spatialGain;
+    float pan = emitter.IsSpatial() ? activeVoice.spatialPan : data.pan;
+    activeVoice.clipId = data.compressed
+        ? mixer->Play(data.compressed.get(), data.compressed, gain, pan, trigger, &latencyStats)
+        : mixer->Play(reinterpret_cast<const float*>(data.pDataBuffer), data.bufferSize / (EngineChannels * sizeof(float)),
+            data.backing, gain, pan, trigger, &latencyStats);
+    activeVoices.push_back(std::move(activeVoice));
+    return true;
+}
+
+void SoundEngine::GetPlaybackLatency(bool pooled, uint64_t& count, double& averageMs, double& maxMs) const {
+    count = (pooled ? latencyStats.pooledCount : latencyStats.createdCount).load(std::memory_order_relaxed);
+    uint64_t total = (pooled ? latencyStats.pooledNanos : latencyStats.createdNanos).load(std::memory_order_relaxed);
+    uint64_t maximum = (pooled ? latencyStats.pooledMaxNanos : latencyStats.createdMaxNanos).load(std::memory_order_relaxed);
+
+    averageMs = count > 0 ? (static_cast<double>(total) / static_cast<double>(count)) / 1.0e6 : 0.0;
+    maxMs = static_cast<double>(maximum) / 1.0e6;
+}
+
+void SoundEngine::ResetPlaybackLatency() {
+    latencyStats.Reset();
+}
+
+void SoundEngine::StoreSound(const SoundID& soundId, const SoundData& soundData) {
+    SoundData converted = soundData;
+
+    // Everything in memory is kept in the engine format so all plays share one voice format.
+    // A source that's already there (decoded files, float 48 kHz WAVs) is kept as is.
+    AudioFormat engineFormat = GetEngineFormat();
+    AudioFormat format = ToAudioFormat(soundData.wfx);
+    if (soundData.pDataBuffer && !(format == engineFormat)) {
+        auto pcm = std::make_shared<std::vector<float>>();
+        if (ConvertToEngineFormat(format, soundData.pDataBuffer, soundData.bufferSize, *pcm)) {
+            converted.ReleaseBuffer();
+            converted.pDataBuffer = reinterpret_cast<BYTE*>(pcm->data());
+            converted.bufferSize = static_cast<UINT32>(pcm->size() * sizeof(float));
+            converted.backing = std::move(pcm);
+            converted.wfx = ToWaveFormat(engineFormat);
+        }
+        else if (APIDefs) {
+            // Formats the converter can't read still play through a voice of their own
+            char logMsg[128];
+            sprintf_s(logMsg, "Keeping sound in its own format (tag %u, %u bits)", soundData.wfx.wFormatTag, soundData.wfx.wBitsPerSample);
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+    }
+    if (converted.pDataBuffer && !converted.backing) {
+        // Buffers from new[] get shared ownership too, so mixer clips can keep them alive
+        converted.backing = std::shared_ptr<BYTE>(converted.pDataBuffer, std::default_delete<BYTE[]>());
+    }
+
+    auto it = soundCache.find(soundId);
+    if (it != soundCache.end() && (it->second.pDataBuffer || it->second.compressed)) {
+        // Replacing the PCM, voices still reading the old copy have to go first
+        StopVoicesFor(soundId);
+        residentBytes -= it->second.ResidentBytes();
+        it->second.ReleaseBuffer();
+    }
+
+    SoundData& stored = soundCache[soundId];
+    stored = converted;
+    MarkUsed(stored);
+
+    // Custom files get a loudness gain, from the cache or measured in the background
+    if (loudness && !soundId.IsResource() && !soundId.IsTts()) {
+        LoudnessInfo info;
+        if (loudness->Lookup(soundId.GetFilePath(), info)) {
+            stored.loudnessGain = info.NormalizationGain();
+        }
+        else if (stored.pDataBuffer && ToAudioFormat(stored.wfx) == GetEngineFormat()) {
+            loudness->Request(soundId.GetFilePath(), reinterpret_cast<const float*>(stored.pDataBuffer),
+                stored.bufferSize / (EngineChannels * sizeof(float)), EngineSampleRate, stored.backing);
+        }
+    }
+    if (stored.pDataBuffer) {
+        residentBytes += stored.bufferSize;
+        cacheDirty = true;
+    }
+}
+
+void SoundEngine::StopActiveVoice(ActiveVoice& active) {
+    // Interrupted voices are released rather than pooled, their buffers may still be queued
+    if (active.stream) {
+        active.stream->cancelled = true;
+    }
+    if (active.clipId != 0 && mixer) {
+        mixer->Stop(active.clipId);
+    }
+    delete active.voice;
+    active.voice = nullptr;
+}
+
+void SoundEngine::StopVoicesFor(const SoundID& soundId) {
+    auto it = activeVoices.begin();
+    while (it != activeVoices.end()) {
+        if (it->soundId == soundId) {
+            StopActiveVoice(*it);
+            it = activeVoices.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+}
+
+void SoundEngine::RefreshPinnedSounds() {
+    if (!initialized) return;
+
+    // Timer sounds are edited in place without bumping the timers version, so recheck every few seconds too
+    auto now = std::chrono::steady_clock::now();
+    uint64_t timersVersion = Settings::GetTimersVersion();
+    if (timersVersion == pinnedTimersVersion && now - pinnedRefreshed < std::chrono::seconds(2)) {
+        return;
+    }
+    pinnedTimersVersion = timersVersion;
+    pinnedRefreshed = now;
+
+    std::set<SoundID> pinned;
+    {
+        std::lock_guard<std::mutex> lock(Settings::Mutex);
+        for (const auto& timer : Settings::timers) {
+            pinned.insert(timer.endSound);
+            if (timer.useWarning) {
+                pinned.insert(timer.warningSound);
+            }
+        }
+    }
+    if (pinned != pinnedSounds) {
+        pinnedSounds.swap(pinned);
+        cacheDirty = true;
+    }
+
+    // Pinned sounds stay resident; one that was evicted before it was pinned is read back now.
+    // Sounds that never loaded are left to the first play, so a missing file isn't retried forever.
+    for (const auto& soundId : pinnedSounds) {
+        auto it = soundCache.find(soundId);
+        if (it == soundCache.end() || it->second.IsResident() || !it->second.reloadable) continue;
+
+        // The same path as a first load: disk cache, mapped WAVs, pack sounds, background decodes
+        LoadSound(soundId, nullptr, it->second.baseVolume);
+    }
+}
+
+void SoundEngine::EnforceCacheBudget() {
+    if (!cacheDirty) return;
+    cacheDirty = false;
+
+    if (cacheBudget == 0 || residentBytes <= cacheBudget) return;
+
+    std::set<SoundID> playing;
+    for (const auto& active : activeVoices) {
+        playing.insert(active.soundId);
+    }
+
+    // Anything that can be read back or thrown away, least recently used first
+    std::vector<std::pair<uint64_t, SoundID>> candidates;
+    for (const auto& [soundId, data] : soundCache) {
+        if ((!data.pDataBuffer && !data.compressed) || !(data.reloadable || data.temporary)) continue;
+        if (pinnedSounds.find(soundId) != pinnedSounds.end() || playing.find(soundId) != playing.end()) continue;
+        candidates.emplace_back(data.lastUsed, soundId);
+    }
+    std::sort(candidates.begin(), candidates.end(),
+        [](const auto& a, const auto& b) { return a.first < b.first; });
+
+    size_t evicted = 0;
+    for (const auto& candidate : candidates) {
+        if (residentBytes <= cacheBudget) break;
+
+        auto it = soundCache.find(candidate.second);
+        SoundData& data = it->second;
+        residentBytes -= data.ResidentBytes();
+        data.ReleaseBuffer();
+        if (data.temporary) {
+            soundCache.erase(it);
+        }
+        evicted++;
+    }
+    cacheEvictions += evicted;
+
+    if (APIDefs && evicted > 0) {
+        char logMsg[128];
+        sprintf_s(logMsg, "Evicted %zu sounds from the cache, %.1f MB resident", evicted,
+            static_cast<double>(residentBytes) / MegaByte);
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+}
+
+void SoundEngine::SetCacheBudgetMB(int megabytes) {
+    megabytes = (std::max)(0, megabytes);
+    cacheBudget = static_cast<size_t>(megabytes) * MegaByte;
+    cacheDirty = true;
+    EnforceCacheBudget();
+
+    if (APIDefs) {
+        try {
+            Settings::SetSoundCacheBudgetMB(megabytes);
+        }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+SoundCacheStats SoundEngine::GetCacheStats() const {
+    SoundCacheStats stats;
+    stats.budgetBytes = cacheBudget;
+    stats.residentBytes = residentBytes;
+    stats.hits = cacheHits;
+    stats.misses = cacheMisses;
+    stats.evictions = cacheEvictions;
+    if (pcmCache) {
+        PcmCache::Stats disk = pcmCache->GetStats();
+        stats.diskHits = disk.hits;
+        stats.diskMisses = disk.misses;
+        stats.diskWrites = disk.writes;
+    }
+
+    stats.expansions = expansions;
+    stats.expansionMs = expansionMs;
+
+    for (const auto& [soundId, data] : soundCache) {
+        if (!data.pDataBuffer && !data.compressed) continue;
+        stats.residentSounds++;
+        if (pinnedSounds.find(soundId) != pinnedSounds.end()) {
+            stats.pinnedBytes += data.ResidentBytes();
+        }
+        if (data.compressed) {
+            stats.compressedSounds++;
+            stats.compressedBytes += data.compressed->Bytes();
+            stats.compressionSavedBytes += data.compressed->frames * EngineChannels * sizeof(float) - data.compressed->Bytes();
+        }
+    }
+    return stats;
+}
+
+void SoundEngine::ResetCacheStats() {
+    cacheHits = 0;
+    cacheMisses = 0;
+    cacheEvictions = 0;
+    expansions = 0;
+    expansionMs = 0.0;
+}
+
+void SoundEngine::MarkUsed(SoundData& data) {
+    data.lastUsed = ++cacheTick;
+    data.lastUsedTime = std::chrono::steady_clock::now();
+}
+
+void SoundEngine::CompressIdleSounds() {
+    // Only while the mixer plays engine-format sounds, otherwise every play would pay for an expansion
+    if (!compressIdleSounds || !compressor || !mixer || !mixerRunning || !mixerEnabled) return;
+
+    auto now = std::chrono::steady_clock::now();
+    if (now < compressScanAt) return;
+    compressScanAt = now + std::chrono::seconds(2);
+
+    std::set<SoundID> queued;
+    for (const auto& [tag, soundId] : compressing) {
+        queued.insert(soundId);
+    }
+
+    for (const auto& [soundId, data] : soundCache) {
+        if (!data.pDataBuffer || !data.backing || data.streamed || !(ToAudioFormat(data.wfx) == GetEngineFormat())) continue;
+        if (now - data.lastUsedTime < std::chrono::seconds(CompressIdleSeconds) || queued.count(soundId)) continue;
+
+        size_t frames = data.bufferSize / (EngineChannels * sizeof(float));
+        if (frames < CompressMinFrames) continue;
+
+        uint64_t tag = nextCompressTag++;
+        compressing[tag] = soundId;
+        compressor->Request(tag, reinterpret_cast<const float*>(data.pDataBuffer), frames, data.backing);
+    }
+}
+
+void SoundEngine::ProcessCompressResults() {
+    if (!compressor) return;
+
+    auto now = std::chrono::steady_clock::now();
+    size_t swapped = 0;
+    for (auto& result : compressor->TakeResults()) {
+        auto job = compressing.find(result.tag);
+        if (job == compressing.end()) continue;
+        SoundID soundId = job->second;
+        compressing.erase(job);
+
+        // Replaced, evicted or played since it was queued: it stays PCM
+        auto it = soundCache.find(soundId);
+        if (!result.clip || !compressIdleSounds || it == soundCache.end() ||
+            it->second.pDataBuffer != reinterpret_cast<const BYTE*>(result.source) ||
+            now - it->second.lastUsedTime < std::chrono::seconds(CompressIdleSeconds)) {
+            continue;
+        }
+
+        // Voices read the PCM without holding it; mixer clips keep their copy alive themselves
+        bool onVoice = std::any_of(activeVoices.begin(), activeVoices.end(),
+            [&soundId](const ActiveVoice& active) { return active.voice && active.soundId == soundId; });
+        if (onVoice) continue;
+
+        residentBytes -= it->second.ResidentBytes();
+        it->second.ReleaseBuffer();
+        it->second.compressed = std::move(result.clip);
+        residentBytes += it->second.ResidentBytes();
+        swapped++;
+    }
+
+    if (APIDefs && swapped > 0) {
+        char logMsg[128];
+        sprintf_s(logMsg, "Compressed %zu idle sounds, %.1f MB resident", swapped,
+            static_cast<double>(residentBytes) / MegaByte);
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+}
+
+void SoundEngine::ExpandSound(SoundData& data) {
+    if (!data.compressed) return;
+
+    auto pcm = std::make_shared<std::vector<float>>();
+    DecodeAdpcm(*data.compressed, *pcm);
+
+    residentBytes -= data.ResidentBytes();
+    data.compressed.reset();
+    data.pDataBuffer = reinterpret_cast<BYTE*>(pcm->data());
+    data.bufferSize = static_cast<UINT32>(pcm->size() * sizeof(float));
+    data.backing = std::move(pcm);
+    residentBytes += data.bufferSize;
+    cacheDirty = true;
+}
+
+void SoundEngine::SetIdleCompressionEnabled(bool enabled) {
+    compressIdleSounds = enabled;
+
+    // Turned off, everything goes back to full quality PCM
+    if (!enabled) {
+        for (auto& [soundId, data] : soundCache) {
+            ExpandSound(data);
+        }
+        compressing.clear();
+    }
+
+    if (APIDefs) {
+        try {
+            Settings::SetCompressIdleSounds(enabled);
+        }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+bool SoundEngine::PlayAlert(const SoundID& soundId, AlertPriority priority, const SoundEmitter& emitter) {
+    alertStats.requested++;
+
+    // A burst of timers ending together asks for the same sound many times in one frame;
+    // the first play stands for the rest. A scheduled play leaves a start time in the future,
+    // so the gap is taken either way round as in ScheduleSound
+    auto now = std::chrono::steady_clock::now();
+    auto lastIt = lastAlerts.find(soundId);
+    if (lastIt != lastAlerts.end()) {
+        auto apart = now > lastIt->second ? now - lastIt->second : lastIt->second - now;
+        if (apart < alertCoalesceWindow) {
+            alertStats.merged++;
+            return true;
+        }
+    }
+
+    if (!MakeRoomFor(priority)) {
+        alertStats.dropped++;
+        if (APIDefs) {
+            char logMsg[128];
+            sprintf_s(logMsg, "Alert dropped, %zu sounds already playing", activeVoices.size());
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+        return false;
+    }
+
+    if (!PlaySound(soundId, priority, emitter)) {
+        return false;
+    }
+    lastAlerts[soundId] = now;
+    alertStats.played++;
+
+    if (priority == AlertPriority::High && !ducking && duckVolume < 1.0f && activeVoices.size() > 1) {
+        alertStats.ducked++;
+    }
+    UpdateDucking();
+    return true;
+}
+
+uint64_t SoundEngine::ScheduleSound(const SoundID& soundId, std::chrono::steady_clock::time_point startTime,
+    AlertPriority priority, const SoundEmitter& emitter) {
+    if (!initialized && !Initialize()) {
+        return 0;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    if (startTime <= now) {
+        PlayAlert(soundId, priority, emitter);
+        return 0;
+    }
+
+    // Coalesce on the time the sound will play, not the time it was asked for
+    alertStats.requested++;
+    auto lastIt = lastAlerts.find(soundId);
+    if (lastIt != lastAlerts.end()) {
+        auto apart = startTime > lastIt->second ? startTime - lastIt->second : lastIt->second - startTime;
+        if (apart < alertCoalesceWindow) {
+            alertStats.merged++;
+            return 0;
+        }
+    }
+
+    // Pre-roll: have the PCM resident now so nothing loads at the deadline
+    auto it = soundCache.find(soundId);
+    if (it == soundCache.end() || !it->second.IsResident()) {
+        float baseVolume = it != soundCache.end() ? it->second.baseVolume : 1.0f;
+        LoadSound(soundId, nullptr, baseVolume);
+        it = soundCache.find(soundId);
+    }
+
+    ScheduledSound scheduled;
+    scheduled.handle = nextScheduleHandle++;
+    scheduled.soundId = soundId;
+    scheduled.priority = priority;
+    scheduled.startTime = startTime;
+    scheduled.emitter = emitter;
+
+    // Through the mixer the clip is queued now and starts on its frame
+    const bool mixable = mixer && mixerRunning && mixerEnabled && it != soundCache.end() && !it->second.streamed &&
+        (it->second.compressed || (it->second.pDataBuffer && it->second.backing)) &&
+        ToAudioFormat(it->second.wfx) == GetEngineFormat();
+    if (mixable) {
+        if (!MakeRoomFor(priority)) {
+            alertStats.dropped++;
+            return 0;
+        }
+
+        const SoundData& data = it->second;
+        ActiveVoice activeVoice;
+        activeVoice.soundId = soundId;
+        activeVoice.priority = priority;
+        activeVoice.startsAt = startTime;
+        activeVoice.emitter = emitter;
+        Spatialize(activeVoice);
+        float gain = data.baseVolume * GetLoudnessGain(soundId) * GetDuckGain(activeVoice) * activeVoice.spatialGain;
+        float pan = emitter.IsSpatial() ? activeVoice.spatialPan : data.pan;
+        scheduled.clipId = data.compressed
+            ? mixer->PlayAt(data.compressed.get(), data.compressed, gain, pan, startTime)
+            : mixer->PlayAt(reinterpret_cast<const float*>(data.pDataBuffer), data.bufferSize / (EngineChannels * sizeof(float)),
+                data.backing, gain, pan, startTime);
+        activeVoice.clipId = scheduled.clipId;
+        activeVoices.push_back(std::move(activeVoice));
+
+        MarkUsed(it->second);
+        recentSounds->Record(soundId);
+        alertStats.played++;
+    }
+
+    lastAlerts[soundId] = startTime;
+    scheduledSounds.push_back(std::move(scheduled));
+    return scheduledSounds.back().handle;
+}
+
+bool SoundEngine::CancelScheduledSound(uint64_t handle) {
+    auto it = std::find_if(scheduledSounds.begin(), scheduledSounds.end(),
+        [handle](const ScheduledSound& scheduled) { return scheduled.handle == handle; });
+    if (it == scheduledSounds.end() || it->startTime <= std::chrono::steady_clock::now()) {
+        return false;
+    }
+
+    if (it->clipId != 0) {
+        auto active = std::find_if(activeVoices.begin(), activeVoices.end(),
+            [&it](const ActiveVoice& voice) { return voice.clipId == it->clipId; });
+        if (active != activeVoices.end()) {
+            StopActiveVoice(*active);
+            activeVoices.erase(active);
+        }
+    }
+
+    auto lastIt = lastAlerts.find(it->soundId);
+    if (lastIt != lastAlerts.end() && lastIt->second == it->startTime) {
+        lastAlerts.erase(lastIt);
+    }
+    scheduledSounds.erase(it);
+    return true;
+}
+
+void SoundEngine::StartScheduledSounds() {
+    if (scheduledSounds.empty()) return;
+
+    auto now = std::chrono::steady_clock::now();
+    std::vector<ScheduledSound> due;
+    auto it = scheduledSounds.begin();
+    while (it != scheduledSounds.end()) {
+        if (it->startTime <= now) {
+            due.push_back(std::move(*it));
+            it = scheduledSounds.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    // Mixer clips are already playing; the rest start now, on frame time. They were
+    // counted and coalesced when scheduled.
+    for (const auto& scheduled : due) {
+        if (scheduled.clipId != 0) continue;
+
+        if (!MakeRoomFor(scheduled.priority)) {
+            alertStats.dropped++;
+            continue;
+        }
+        if (PlaySound(scheduled.soundId, scheduled.priority, scheduled.emitter)) {
+            alertStats.played++;
+        }
+    }
+}
+
+bool SoundEngine::MakeRoomFor(AlertPriority priority) {
+    if (maxConcurrentSounds <= 0 || activeVoices.size() < static_cast<size_t>(maxConcurrentSounds)) {
+        return true;
+    }
+
+    // Steal the lowest priority sound, the oldest of those; activeVoices is in start order
+    auto victim = activeVoices.end();
+    for (auto it = activeVoices.begin(); it != activeVoices.end(); ++it) {
+        if (victim == activeVoices.end() || it->priority < victim->priority) {
+            victim = it;
+        }
+    }
+    if (victim == activeVoices.end() || victim->priority > priority) {
+        return false;
+    }
+
+    StopActiveVoice(*victim);
+    activeVoices.erase(victim);
+    cacheDirty = true;
+    alertStats.stolen++;
+    return true;
+}
+
+float SoundEngine::GetDuckGain(const ActiveVoice& active) const {
+    return ducking && active.priority != AlertPriority::High ? duckVolume : 1.0f;
+}
+
+float SoundEngine::GetLoudnessGain(const SoundID& soundId) const {
+    if (!normalizeLoudness) return 1.0f;
+    auto it = soundCache.find(soundId);
+    return it != soundCache.end() ? it->second.loudnessGain : 1.0f;
+}
+
+void SoundEngine::ProcessLoudnessResults() {
+    if (!loudness) return;
+
+    for (const auto& result : loudness->TakeResults()) {
+        if (!result.ok) continue;
+
+        SoundID soundId(result.path);
+        auto it = soundCache.find(soundId);
+        if (it == soundCache.end()) continue;
+        it->second.loudnessGain = result.info.NormalizationGain();
+
+        // A sound measured while it plays changes level on the spot
+        for (const auto& active : activeVoices) {
+            if (active.soundId == soundId) {
+                ApplyVolume(active, it->second.baseVolume);
+            }
+        }
+
+        if (APIDefs) {
+            char logMsg[512];
+            sprintf_s(logMsg, "Loudness %.1f LUFS, true peak %.1f dBTP, gain %.1f dB: %s",
+                result.info.integratedLufs, result.info.truePeakDb,
+                20.0f * std::log10(it->second.loudnessGain), GetFileName(result.path).c_str());
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+    }
+}
+
+void SoundEngine::SetLoudnessNormalized(bool enabled) {
+    normalizeLoudness = enabled;
+
+    for (const auto& active : activeVoices) {
+        auto it = soundCache.find(active.soundId);
+        ApplyVolume(active, it != soundCache.end() ? it->second.baseVolume : 1.0f);
+    }
+
+    if (APIDefs) {
+        try {
+            Settings::SetNormalizeLoudness(enabled);
+        }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+void SoundEngine::ApplyVolume(const ActiveVoice& active, float baseVolume) {
+    float gain = baseVolume * GetLoudnessGain(active.soundId) * GetDuckGain(active) * active.spatialGain;
+    if (active.voice) {
+        active.voice->SetVolume(masterVolume * gain);
+    }
+    else if (active.clipId != 0 && mixer) {
+        // The mixer applies the master gain itself
+        mixer->SetClipGain(active.clipId, gain);
+    }
+}
 
-    // Apply panning
-    ApplyPanning(pSourceVoice, it->second.pan);
+void SoundEngine::ApplyPan(const ActiveVoice& active, float pan) {
+    if (active.voice) {
+        active.voice->SetPan(pan);
+    }
+    else if (active.clipId != 0 && mixer) {
+        mixer->SetClipPan(active.clipId, pan);
+    }
+}
 
-    // Submit buffer
-    XAUDIO2_BUFFER buffer = { 0 };
-    buffer.pAudioData = it->second.pDataBuffer;
-    buffer.AudioBytes = it->second.bufferSize;
-    buffer.Flags = XAUDIO2_END_OF_STREAM;
+// Point to spatialize an emitter from. One that can't be placed, with no live link or on
+// another map, sits on the listener and so plays centred at full gain.
+static void EmitterPoint(const SoundEmitter& emitter, const SpatialListener& listener, bool listenerValid,
+    uint32_t listenerMapId, float point[3]) {
+    for (int c = 0; c < 3; c++) {
+        point[c] = listener.position[c];
+    }
+    if (!listenerValid) return;
 
-    hr = pSourceVoice->SubmitSourceBuffer(&buffer);
-    if (FAILED(hr)) {
-        pSourceVoice->DestroyVoice();
-        delete pCallback;
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to submit buffer");
+    if (emitter.mode == SpatialMode::Position && (emitter.mapId == 0 || emitter.mapId == listenerMapId)) {
+        for (int c = 0; c < 3; c++) {
+            point[c] = emitter.position[c];
+        }
+    }
+    else if (emitter.mode == SpatialMode::Direction) {
+        // Inside the near distance, so only the direction counts
+        for (int c = 0; c < 3; c++) {
+            point[c] += emitter.position[c] * SpatialNearDistance;
+        }
+    }
+}
+
+bool SoundEngine::ReadListener() {
+    if (!MumbleLink || MumbleLink->UITick == 0) {
+        listenerValid = false;
+        return false;
+    }
+
+    // Heard from the character, facing where the camera looks
+    const Mumble::Data& link = *MumbleLink;
+    listener.position[0] = link.AvatarPosition.X;
+    listener.position[1] = link.AvatarPosition.Y;
+    listener.position[2] = link.AvatarPosition.Z;
+    listener.front[0] = link.CameraFront.X;
+    listener.front[1] = link.CameraFront.Y;
+    listener.front[2] = link.CameraFront.Z;
+    listener.top[0] = link.CameraTop.X;
+    listener.top[1] = link.CameraTop.Y;
+    listener.top[2] = link.CameraTop.Z;
+    listenerMapId = link.Context.MapID;
+    listenerValid = true;
+    return true;
+}
+
+void SoundEngine::Spatialize(ActiveVoice& active) {
+    active.spatialPan = 0.0f;
+    active.spatialGain = 1.0f;
+    if (!active.emitter.IsSpatial()) return;
+
+    ReadListener();
+    float point[3];
+    EmitterPoint(active.emitter, listener, listenerValid, listenerMapId, point);
+    SpatializeBatch(listener, &point[0], &point[1], &point[2], 1, &active.spatialPan, &active.spatialGain);
+}
+
+void SoundEngine::UpdateSpatialSounds() {
+    spatialVoices.clear();
+    for (size_t i = 0; i < activeVoices.size(); i++) {
+        if (activeVoices[i].emitter.IsSpatial()) {
+            spatialVoices.push_back(i);
+        }
+    }
+    if (spatialVoices.empty()) return;
+
+    ReadListener();
+    size_t count = spatialVoices.size();
+    spatialX.resize(count);
+    spatialY.resize(count);
+    spatialZ.resize(count);
+    spatialPans.resize(count);
+    spatialGains.resize(count);
+    for (size_t k = 0; k < count; k++) {
+        float point[3];
+        EmitterPoint(activeVoices[spatialVoices[k]].emitter, listener, listenerValid, listenerMapId, point);
+        spatialX[k] = point[0];
+        spatialY[k] = point[1];
+        spatialZ[k] = point[2];
+    }
+    SpatializeBatch(listener, spatialX.data(), spatialY.data(), spatialZ.data(), count, spatialPans.data(), spatialGains.data());
+
+    // Only changes worth hearing are sent; the mixer ramps them across a block
+    const float threshold = 0.002f;
+    for (size_t k = 0; k < count; k++) {
+        ActiveVoice& active = activeVoices[spatialVoices[k]];
+        if (std::fabs(spatialPans[k] - active.spatialPan) > threshold) {
+            active.spatialPan = spatialPans[k];
+            ApplyPan(active, active.spatialPan);
+        }
+        if (std::fabs(spatialGains[k] - active.spatialGain) > threshold) {
+            active.spatialGain = spatialGains[k];
+            auto it = soundCache.find(active.soundId);
+            ApplyVolume(active, it != soundCache.end() ? it->second.baseVolume : 1.0f);
+        }
+    }
+}
+
+void SoundEngine::UpdateDucking(bool reapply) {
+    // Drop coalescing entries once their window has passed
+    auto now = std::chrono::steady_clock::now();
+    for (auto it = lastAlerts.begin(); it != lastAlerts.end();) {
+        if (now - it->second >= alertCoalesceWindow) {
+            it = lastAlerts.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    bool duck = false;
+    if (duckVolume < 1.0f) {
+        for (const auto& active : activeVoices) {
+            if (active.priority == AlertPriority::High && active.startsAt <= now) {
+                duck = true;
+                break;
+            }
+        }
+    }
+    if (duck == ducking && !reapply) return;
+    ducking = duck;
+
+    for (const auto& active : activeVoices) {
+        if (active.priority == AlertPriority::High) continue;
+        auto it = soundCache.find(active.soundId);
+        ApplyVolume(active, it != soundCache.end() ? it->second.baseVolume : 1.0f);
+    }
+}
+
+void SoundEngine::SetAlertCoalesceMs(int milliseconds) {
+    milliseconds = (std::max)(0, (std::min)(2000, milliseconds));
+    alertCoalesceWindow = std::chrono::milliseconds(milliseconds);
+
+    if (APIDefs) {
+        try {
+            Settings::SetAlertCoalesceMs(milliseconds);
+        }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+void SoundEngine::SetMaxConcurrentSounds(int count) {
+    maxConcurrentSounds = (std::max)(0, count);
+
+    if (APIDefs) {
+        try {
+            Settings::SetMaxConcurrentSounds(maxConcurrentSounds);
         }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+void SoundEngine::SetAlertDuckVolume(float volume) {
+    duckVolume = (std::max)(0.0f, (std::min)(1.0f, volume));
+
+    // Re-apply to anything currently ducked
+    UpdateDucking(true);
+
+    if (APIDefs) {
+        try {
+            Settings::SetAlertDuckVolume(duckVolume);
+        }
+        catch (...) {
+            // Continue even if settings update fails
+        }
+    }
+}
+
+bool SoundEngine::PlaySound(const SoundID& soundId, AlertPriority priority, const SoundEmitter& emitter) {
+    if (!initialized && !Initialize()) {
         return false;
     }
 
-    // Start playing
-    hr = pSourceVoice->Start(0);
-    if (FAILED(hr)) {
-        pSourceVoice->DestroyVoice();
-        delete pCallback;
+    // Find sound in cache
+    auto it = soundCache.find(soundId);
+    if (it != soundCache.end() && it->second.IsResident()) {
+        cacheHits++;
+    }
+    else {
+        cacheMisses++;
+
+        // Speech still being synthesized plays once it lands
+        if (!soundId.IsResource() && g_TextToSpeech && g_TextToSpeech->IsSynthesizing(soundId)) {
+            pendingPlays.push_back({ soundId, priority, emitter });
+            return true;
+        }
+
+        // Try to load it first, an evicted entry keeps its volume
+        float baseVolume = it != soundCache.end() ? it->second.baseVolume : 1.0f;
+        if (!LoadSound(soundId, nullptr, baseVolume)) {
+            if (APIDefs) {
+                char errorMsg[128];
+                if (soundId.IsResource()) {
+                    sprintf_s(errorMsg, "Sound ID %d not loaded, cannot play", soundId.GetResourceId());
+                }
+                else {
+                    sprintf_s(errorMsg, "Sound file not loaded: %s", soundId.GetFilePath().c_str());
+                }
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+            }
+            return false;
+        }
+        // Check again after load attempt
+        it = soundCache.find(soundId);
+        if (it == soundCache.end() || !it->second.IsResident()) {
+            // Compressed files decode in the background, play once they're ready
+            if (!soundId.IsResource() && pendingDecodes.find(soundId.GetFilePath()) != pendingDecodes.end()) {
+                pendingPlays.push_back({ soundId, priority, emitter });
+                return true;
+            }
+            return false;
+        }
+    }
+
+    // Latency is measured from here, so a pool miss pays for creating the voice in the numbers
+    auto trigger = std::chrono::steady_clock::now();
+
+    if (PlayThroughMixer(soundId, it->second, priority, trigger, emitter)) {
+        MarkUsed(it->second);
+        recentSounds->Record(soundId);
+        return true;
+    }
+
+    // A voice needs PCM, a compressed sound is expanded first and that time adds to its start
+    if (it->second.compressed) {
+        auto expandStart = std::chrono::steady_clock::now();
+        ExpandSound(it->second);
+        expansions++;
+        expansionMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - expandStart).count();
+    }
+
+    // Take an idle voice for this format, or create one
+    bool fromPool = false;
+    IAudioVoice* voice = AcquireVoice(ToAudioFormat(it->second.wfx), fromPool);
+    if (!voice) {
         if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to start playback");
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create source voice");
         }
         return false;
     }
+    voice->Arm(trigger, fromPool, &latencyStats);
 
-    // Track the voice for cleanup
     ActiveVoice activeVoice;
-    activeVoice.pSourceVoice = pSourceVoice;
-    activeVoice.pCallback = pCallback;
+    activeVoice.voice = voice;
     activeVoice.soundId = soundId;
-    activeVoices.push_back(activeVoice);
+    activeVoice.priority = priority;
+    activeVoice.emitter = emitter;
+    Spatialize(activeVoice);
 
-    // Add to recent sounds in settings
-    try {
-        if (APIDefs) {
-            if (soundId.IsResource()) {
-                Settings::AddRecentSound(soundId.ToString());
+    // Set the volume (master volume * sound-specific volume, ducked under a warning)
+    ApplyVolume(activeVoice, it->second.baseVolume);
+
+    // Apply panning, a positional sound's comes from where it is
+    ApplyPan(activeVoice, emitter.IsSpatial() ? activeVoice.spatialPan : it->second.pan);
+
+    if (it->second.streamed) {
+        // PumpStreams submits chunks and starts the voice once the worker has decoded some
+        activeVoice.stream = std::make_shared<AudioStreamState>();
+        activeVoice.stream->path = soundId.GetFilePath();
+        decodeWorker->RequestFill(activeVoice.stream);
+    }
+    else {
+        // Submit buffer
+        if (!voice->Submit(it->second.pDataBuffer, it->second.bufferSize)) {
+            delete voice;
+            if (APIDefs) {
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to submit buffer");
             }
-            else {
-                Settings::AddRecentSound(soundId.ToString());
+            return false;
+        }
+
+        // Start playing
+        if (!voice->Start()) {
+            delete voice;
+            if (APIDefs) {
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to start playback");
             }
+            return false;
         }
     }
-    catch (...) {
-        // Continue even if this fails
-    }
+
+    // Track the voice for cleanup
+    activeVoices.push_back(std::move(activeVoice));
+    MarkUsed(it->second);
+
+    // Recent sounds are folded into the settings in the background, no lock or save here
+    recentSounds->Record(soundId);
 
     return true;
 }
@@ -810,34 +2113,28 @@ void SoundEngine::SetMasterVolume(float volume) {
     // Clamp volume to valid range
     masterVolume = (std::max)(0.0f, (std::min)(1.0f, volume));
     g_MasterVolume = masterVolume;
+    if (mixer) {
+        mixer->SetMasterGain(masterVolume);
+    }
 
-    // Update all active voices
-    for (auto& voice : activeVoices) {
-        if (voice.pSourceVoice) {
+    // Update all active voices, mixer clips already follow the master gain
+    for (auto& active : activeVoices) {
+        if (active.voice) {
             // Apply both master volume and sound-specific volume
             float soundVolume = 1.0f; // Default
-            auto it = soundCache.find(voice.soundId);
+            auto it = soundCache.find(active.soundId);
             if (it != soundCache.end()) {
                 soundVolume = it->second.baseVolume;
             }
-            voice.pSourceVoice->SetVolume(masterVolume * soundVolume);
+            ApplyVolume(active, soundVolume);
         }
     }
 
     // Only save settings if APIDefs is valid to avoid crash
     if (APIDefs) {
         try {
-            // We need to update the settings value but AVOID circular calls
-            // Use a direct approach to update and save
-            {
-                std::lock_guard<std::mutex> lock(Settings::Mutex);
-                Settings::sounds.masterVolume = masterVolume;
-
-                // Save directly if possible
-                if (!SettingsPath.empty()) {
-                    Settings::ScheduleSave(SettingsPath);
-                }
-            }
+            // Settings only stores and publishes the value, it doesn't call back into the engine
+            Settings::SetMasterVolume(masterVolume);
         }
         catch (const std::exception& e) {
             // Log specific exception details
@@ -894,9 +2191,9 @@ void SoundEngine::SetSoundVolume(const SoundID& soundId, float volume) {
         it->second.baseVolume = volume;
 
         // Update any active voices playing this sound
-        for (auto& voice : activeVoices) {
-            if (voice.soundId == soundId && voice.pSourceVoice) {
-                voice.pSourceVoice->SetVolume(masterVolume * volume);
+        for (auto& active : activeVoices) {
+            if (active.soundId == soundId) {
+                ApplyVolume(active, volume);
             }
         }
 
@@ -917,6 +2214,59 @@ void SoundEngine::SetSoundVolume(const SoundID& soundId, float volume) {
     }
 }
 
+void SoundEngine::SyncFromSettings() {
+    auto state = Settings::GetSoundState();
+
+    masterVolume = (std::max)(0.0f, (std::min)(1.0f, state->masterVolume));
+    g_MasterVolume = masterVolume;
+    if (mixer) {
+        mixer->SetMasterGain(masterVolume);
+    }
+    cacheBudget = static_cast<size_t>((std::max)(0, state->soundCacheBudgetMB)) * MegaByte;
+    cacheDirty = true;
+    normalizeLoudness = state->normalizeLoudness;
+    if (compressIdleSounds != state->compressIdleSounds) {
+        compressIdleSounds = state->compressIdleSounds;
+        if (!compressIdleSounds) {
+            for (auto& [soundId, data] : soundCache) {
+                ExpandSound(data);
+            }
+            compressing.clear();
+        }
+    }
+    alertCoalesceWindow = std::chrono::milliseconds((std::max)(0, (std::min)(2000, state->alertCoalesceMs)));
+    maxConcurrentSounds = (std::max)(0, state->maxConcurrentSounds);
+    duckVolume = (std::max)(0.0f, (std::min)(1.0f, state->alertDuckVolume));
+
+    for (auto& [soundId, data] : soundCache) {
+        const std::string key = soundId.ToString();
+
+        auto volumeIt = state->soundVolumes.find(key);
+        if (volumeIt != state->soundVolumes.end()) {
+            data.baseVolume = (std::max)(0.0f, (std::min)(1.0f, volumeIt->second));
+        }
+
+        auto panIt = state->soundPans.find(key);
+        if (panIt != state->soundPans.end()) {
+            data.pan = (std::max)(-1.0f, (std::min)(1.0f, panIt->second));
+        }
+    }
+
+    // Voices already playing pick up the new values too
+    for (auto& active : activeVoices) {
+        auto it = soundCache.find(active.soundId);
+        if (it == soundCache.end()) continue;
+
+        ApplyVolume(active, it->second.baseVolume);
+        if (!active.emitter.IsSpatial()) {
+            ApplyPan(active, it->second.pan);
+        }
+    }
+
+    // A smaller budget evicts now, as SetCacheBudgetMB does
+    EnforceCacheBudget();
+}
+
 float SoundEngine::GetSoundVolume(const SoundID& soundId) const {
     auto it = soundCache.find(soundId);
     if (it != soundCache.end()) {
@@ -941,50 +2291,6 @@ float SoundEngine::GetSoundVolume(const SoundID& soundId) const {
     return 1.0f; // Default volume
 }
 
-void SoundEngine::ApplyPanning(IXAudio2SourceVoice* pVoice, float pan) {
-    if (!pVoice) return;
-
-    // Clamp pan value between -1 and 1
-    pan = (std::max)(-1.0f, (std::min)(1.0f, pan));
-
-    // Get channel count from the voice
-    XAUDIO2_VOICE_DETAILS details;
-    pVoice->GetVoiceDetails(&details);
-
-    // Create output matrix
-    float matrix[8] = {}; // Maximum 8 channels for safety
-
-    if (details.InputChannels == 1) {
-        // Mono source
-        // Left output = cos(angle) * source
-        // Right output = sin(angle) * source
-        float angle = (pan + 1.0f) * 3.14159f / 4.0f; // Convert -1..1 to 0..pi/2
-        matrix[0] = cosf(angle) * 1.5f; // Left
-        matrix[1] = sinf(angle) * 1.5f; // Right
-    }
-    else if (details.InputChannels == 2) {
-        // Stereo source
-        // For stereo, we'll crossfade between channels
-        float leftGain = (1.0f - pan) * 0.5f + 0.5f;
-        float rightGain = (1.0f + pan) * 0.5f + 0.5f;
-
-        // Left source -> Left output
-        matrix[0] = leftGain;
-        // Left source -> Right output
-        matrix[1] = 1.0f - leftGain;
-        // Right source -> Left output
-        matrix[2] = 1.0f - rightGain;
-        // Right source -> Right output
-        matrix[3] = rightGain;
-    }
-
-    // Apply the output matrix
-    HRESULT hr = pVoice->SetOutputMatrix(nullptr, details.InputChannels, 2, matrix);
-    if (FAILED(hr) && APIDefs) {
-        APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to set output matrix for panning");
-    }
-}
-
 void SoundEngine::SetSoundPan(const SoundID& soundId, float pan) {
     // Clamp pan value between -1 and 1
     pan = (std::max)(-1.0f, (std::min)(1.0f, pan));
@@ -1023,10 +2329,9 @@ void SoundEngine::SetSoundPan(const SoundID& soundId, float pan) {
         it->second.pan = pan;
 
         // Apply panning to any active voices playing this sound
-        for (auto& voice : activeVoices) {
-            if (voice.soundId == soundId && voice.pSourceVoice) {
-                ApplyPanning(voice.pSourceVoice, pan);
-            }
+        for (auto& active : activeVoices) {
+            if (active.soundId != soundId || active.emitter.IsSpatial()) continue;
+            ApplyPan(active, pan);
         }
 
         // Save to settings
@@ -1085,10 +2390,8 @@ float SoundEngine::GetSoundPan(const SoundID& soundId) const {
 
 void SoundEngine::AddSoundInfo(const SoundInfo& info) {
     // Check if this sound is already in our list
-    for (const auto& existing : availableSounds) {
-        if (existing.id == info.id) {
-            return; // Already exists
-        }
+    if (!availableSoundIds.insert(info.id).second) {
+        return; // Already exists
     }
 
     // Add to the list
@@ -1104,42 +2407,38 @@ void SoundEngine::ScanSoundDirectory(const std::string& directory) {
         return;
     }
 
-    if (APIDefs) {
-        char logMsg[256];
-        sprintf_s(logMsg, "Scanning sound directory: %s", directory.c_str());
-        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
-    }
+    // Only list the files here so the UI has them straight away; reading and decoding
+    // happens on the decode pool and lands in soundCache from Update()
+    auto listStart = std::chrono::steady_clock::now();
+    size_t found = 0;
+    size_t cached = 0;
+    size_t queued = 0;
 
     try {
         for (const auto& entry : std::filesystem::directory_iterator(directory)) {
-            if (entry.is_regular_file()) {
-                std::string filepath = entry.path().string();
-
-                // Check if this is a supported audio file
-                if (IsSupportedAudioFile(filepath)) {
-                    // Create a SoundID for this file
-                    SoundID id(filepath);
-
-                    // Add to available sounds list
-                    std::string filename = GetFileName(filepath);
-                    AddSoundInfo(SoundInfo(id, filename, "Custom"));
-
-                    // Preload the sound into the cache with default volume
-                    // This ensures it's in the cache for volume/pan adjustments
-                    if (!LoadSound(id)) {
-                        if (APIDefs) {
-                            char errorMsg[256];
-                            sprintf_s(errorMsg, "Failed to preload sound file: %s", filename.c_str());
-                            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
-                        }
-                    }
+            if (!entry.is_regular_file()) continue;
 
-                    if (APIDefs) {
-                        char logMsg[256];
-                        sprintf_s(logMsg, "Found sound file: %s", filename.c_str());
-                        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
-                    }
-                }
+            std::string filepath = entry.path().string();
+            if (IsSoundPackFile(filepath)) {
+                LoadSoundPack(filepath);
+                continue;
+            }
+            if (!IsSupportedAudioFile(filepath)) continue;
+
+            SoundID id(filepath);
+            AddSoundInfo(SoundInfo(id, GetFileName(filepath), "Custom"));
+            found++;
+
+            if (soundCache.find(id) != soundCache.end() || pendingDecodes.find(filepath) != pendingDecodes.end()) {
+                continue;
+            }
+
+            // Files decoded on an earlier run are mapped from the PCM cache right here
+            if (LoadCachedFileSound(filepath, 1.0f)) {
+                cached++;
+            }
+            else if (QueueFileDecode(filepath, 1.0f)) {
+                queued++;
             }
         }
     }
@@ -1150,11 +2449,234 @@ void SoundEngine::ScanSoundDirectory(const std::string& directory) {
             APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
         }
     }
+
+    if (queued > 0) {
+        scanInProgress = true;
+        scanQueued = queued;
+        scanStarted = listStart;
+    }
+
+    if (APIDefs) {
+        double listMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - listStart).count();
+        char logMsg[512];
+        sprintf_s(logMsg, "Listed %zu sound files in %.1f ms, %zu mapped from the cache, %zu queued for decoding: %s",
+            found, listMs, cached, queued, directory.c_str());
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+
+    // From here on changes to the folder are picked up as they happen
+    if (!folderWatcher || folderWatcher->GetDirectory() != directory) {
+        folderWatcher = std::make_unique<SoundFolderWatcher>();
+        if (!folderWatcher->Start(directory)) {
+            folderWatcher.reset();
+        }
+    }
+}
+
+void SoundEngine::ProcessFolderChanges() {
+    std::vector<std::filesystem::path> fileNames;
+    bool rescan = false;
+    if (!folderWatcher || !folderWatcher->TakeChanges(fileNames, rescan)) return;
+
+    std::string directory = folderWatcher->GetDirectory();
+    size_t added = 0;
+    size_t changed = 0;
+    size_t removed = 0;
+
+    // Notifications were lost: drop what's gone, the scan below picks up the rest
+    if (rescan) {
+        std::vector<SoundID> missing;
+        for (const auto& info : availableSounds) {
+            if (info.id.IsResource() || info.id.IsTts()) continue;
+
+            std::string path = info.id.GetFilePath();
+            std::string packPath;
+            std::string name;
+            if (SplitSoundPackPath(path, packPath, name)) continue;
+
+            std::error_code error;
+            std::filesystem::path file(path);
+            if (file.parent_path() == std::filesystem::path(directory) && !std::filesystem::exists(file, error)) {
+                missing.push_back(info.id);
+            }
+        }
+        for (const auto& id : missing) {
+            ForgetSound(id);
+            removed++;
+        }
+        ScanSoundDirectory(directory);
+    }
+
+    for (const auto& fileName : fileNames) {
+        std::filesystem::path file = std::filesystem::path(directory) / fileName;
+        std::string filepath = file.string();
+        std::error_code error;
+        bool exists = std::filesystem::is_regular_file(file, error);
+
+        // A pack is replaced as a whole
+        if (IsSoundPackFile(filepath)) {
+            bool loaded = soundPacks.find(filepath) != soundPacks.end();
+            UnloadSoundPack(filepath);
+            if (exists && LoadSoundPack(filepath)) {
+                if (loaded) {
+                    changed++;
+                }
+                else {
+                    added++;
+                }
+            }
+            else if (loaded) {
+                removed++;
+            }
+            continue;
+        }
+        if (!IsSupportedAudioFile(filepath)) continue;
+
+        SoundID id(filepath);
+        if (!exists) {
+            if (availableSoundIds.count(id)) {
+                ForgetSound(id);
+                removed++;
+            }
+            continue;
+        }
+
+        // Still decoding the old contents; that result is thrown away and the file decoded again
+        if (pendingDecodes.find(filepath) != pendingDecodes.end()) {
+            staleDecodes.insert(filepath);
+            changed++;
+            continue;
+        }
+
+        // Replaced: the old PCM goes, volume and pan carry over
+        float baseVolume = 1.0f;
+        auto cached = soundCache.find(id);
+        if (cached != soundCache.end()) {
+            baseVolume = cached->second.baseVolume;
+            StopVoicesFor(id);
+            residentBytes -= cached->second.ResidentBytes();
+            cached->second.ReleaseBuffer();
+            soundCache.erase(cached);
+            changed++;
+        }
+        else if (availableSoundIds.count(id)) {
+            changed++;
+        }
+        else {
+            added++;
+        }
+
+        AddSoundInfo(SoundInfo(id, GetFileName(filepath), "Custom"));
+        if (!LoadCachedFileSound(filepath, baseVolume)) {
+            QueueFileDecode(filepath, baseVolume);
+        }
+    }
+
+    if (APIDefs && (added > 0 || changed > 0 || removed > 0)) {
+        char logMsg[512];
+        sprintf_s(logMsg, "Sounds folder changed: %zu added, %zu replaced, %zu removed", added, changed, removed);
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+}
+
+void SoundEngine::ForgetSound(const SoundID& soundId) {
+    StopVoicesFor(soundId);
+    pendingPlays.erase(std::remove_if(pendingPlays.begin(), pendingPlays.end(),
+        [&soundId](const PendingPlay& play) { return play.soundId == soundId; }), pendingPlays.end());
+
+    std::string path = soundId.GetFilePath();
+    pendingDecodes.erase(path);
+    staleDecodes.erase(path);
+
+    auto cached = soundCache.find(soundId);
+    if (cached != soundCache.end()) {
+        residentBytes -= cached->second.ResidentBytes();
+        cached->second.ReleaseBuffer();
+        soundCache.erase(cached);
+    }
+
+    // Timers still naming the sound keep it in their settings and fall silent until it's back
+    if (availableSoundIds.erase(soundId) > 0) {
+        availableSounds.erase(std::remove_if(availableSounds.begin(), availableSounds.end(),
+            [&soundId](const SoundInfo& info) { return info.id == soundId; }), availableSounds.end());
+    }
+}
+
+void SoundEngine::UnloadSoundPack(const std::string& packPath) {
+    auto pack = soundPacks.find(packPath);
+    if (pack == soundPacks.end()) return;
+
+    // Clips still playing hold the mapping through their backing
+    for (const auto& sound : pack->second->GetSounds()) {
+        ForgetSound(SoundID(MakeSoundPackPath(packPath, sound.name)));
+    }
+    soundPacks.erase(pack);
+}
+
+bool SoundEngine::LoadSoundPack(const std::string& packPath) {
+    if (soundPacks.find(packPath) != soundPacks.end()) return true;
+
+    auto start = std::chrono::steady_clock::now();
+    std::string error;
+    std::shared_ptr<SoundPack> pack = SoundPack::Open(packPath, error);
+    if (!pack) {
+        if (APIDefs) {
+            char errorMsg[512];
+            sprintf_s(errorMsg, "Failed to load sound pack: %s", error.c_str());
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, errorMsg);
+        }
+        return false;
+    }
+
+    // One pass over the index. Pack sounds are listed with the custom sounds, named by
+    // their path inside the pack so subfolders stay apart.
+    for (const auto& sound : pack->GetSounds()) {
+        AddSoundInfo(SoundInfo(SoundID(MakeSoundPackPath(packPath, sound.name)), sound.name, "Custom"));
+    }
+    soundPacks[packPath] = pack;
+
+    if (APIDefs) {
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        char logMsg[512];
+        sprintf_s(logMsg, "Loaded sound pack with %zu sounds in %.1f ms: %s", pack->GetSounds().size(), loadMs, packPath.c_str());
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+    return true;
+}
+
+bool SoundEngine::IsSoundResident(const SoundID& soundId) const {
+    auto it = soundCache.find(soundId);
+    return it != soundCache.end() && it->second.IsResident();
+}
+
+size_t SoundEngine::GetResidentBytes(const SoundID& soundId) const {
+    auto it = soundCache.find(soundId);
+    return it != soundCache.end() ? it->second.ResidentBytes() : 0;
+}
+
+void SoundEngine::ReleaseTempSound(const SoundID& soundId) {
+    auto it = soundCache.find(soundId);
+    if (it == soundCache.end() || !it->second.temporary) return;
+
+    // Mixer clips keep the PCM alive through its backing, a voice reads the buffer itself
+    for (const auto& active : activeVoices) {
+        if (active.soundId == soundId && active.clipId == 0) return;
+    }
+
+    pendingPlays.erase(std::remove_if(pendingPlays.begin(), pendingPlays.end(),
+        [&soundId](const PendingPlay& play) { return play.soundId == soundId; }), pendingPlays.end());
+    residentBytes -= it->second.ResidentBytes();
+    it->second.ReleaseBuffer();
+    soundCache.erase(it);
 }
 
 void SoundEngine::AddTempSound(const SoundID& soundId, const SoundData& soundData) {
-    // Add to our cache without adding to the available sounds list
-    soundCache[soundId] = soundData;
+    // Add to our cache without adding to the available sounds list; nothing can reload it,
+    // so it is dropped once evicted
+    SoundData temporary = soundData;
+    temporary.temporary = true;
+    StoreSound(soundId, temporary);
+    WarmVoicePool(ToAudioFormat(soundData.wfx));
 
     if (APIDefs) {
         APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, "Added temporary sound to cache");
@@ -1163,8 +2685,9 @@ void SoundEngine::AddTempSound(const SoundID& soundId, const SoundData& soundDat
 
 void SoundEngine::AddPermanentSound(const SoundID& soundId, const SoundData& soundData,
     const std::string& displayName, const std::string& category) {
-    // Add to our cache
-    soundCache[soundId] = soundData;
+    // Add to our cache, it can't be reloaded so it is never evicted
+    StoreSound(soundId, soundData);
+    WarmVoicePool(ToAudioFormat(soundData.wfx));
 
     // Add to the available sounds list
     std::string actualCategory = category.empty() ? "Custom" : category;
@@ -1182,8 +2705,9 @@ void SoundEngine::AddTtsSound(const TtsSoundID& soundId, const SoundData& soundD
     // Convert to regular SoundID for the sound cache (it's already a SoundID subclass)
     const SoundID& baseId = soundId;
 
-    // Add to our cache
-    soundCache[baseId] = soundData;
+    // Add to our cache, it can't be reloaded so it is never evicted
+    StoreSound(baseId, soundData);
+    WarmVoicePool(ToAudioFormat(soundData.wfx));
 
     // Add to the available sounds list
     std::string name = displayName.empty() ?
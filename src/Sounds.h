@@ -6,14 +6,26 @@
 #include <set>
 #include <memory>
 #include <filesystem>
-#include <xaudio2.h>
-#include <mmdeviceapi.h>
+#include <deque>
+#include <Windows.h>
+#include <mmreg.h>
+#include "AudioBackend.h"
+#include "AudioMixer.h"
+#include "AudioSpatial.h"
 #include "resource.h"
 
 // Forward declarations
 class SoundEngine;
 class TextToSpeech;
 class TtsSoundID;
+class AudioDecodeWorker;
+class RecentSoundLog;
+class LoudnessAnalyzer;
+class PcmCache;
+class AudioDeviceWatcher;
+class SoundFolderWatcher;
+class SoundPack;
+struct AudioStreamState;
 extern SoundEngine* g_SoundEngine;
 extern float g_MasterVolume;
 
@@ -119,101 +131,320 @@ struct SoundInfo {
     SoundInfo() {}
 };
 
-// Audio device information structure
-struct AudioDevice {
-    std::wstring id;           // Device ID
-    std::wstring name;         // Friendly name of the device
-    bool isDefault;            // Is this the default device?
-
-    // Simplified name for display purposes
-    std::string displayName() const {
-        // Convert wide string to string for display
-        int size_needed = WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, NULL, 0, NULL, NULL);
-        std::string result(size_needed, 0);
-        WideCharToMultiByte(CP_UTF8, 0, name.c_str(), -1, &result[0], size_needed, NULL, NULL);
-        // Remove null terminator from the end
-        if (!result.empty() && result.back() == 0) {
-            result.pop_back();
+// Internal sound data structure
+struct SoundData {
+    BYTE* pDataBuffer = nullptr;    // Sound data buffer, read-only
+    UINT32 bufferSize = 0;          // Buffer size in bytes
+    std::shared_ptr<void> backing;  // Owner of the memory pDataBuffer points into (a mapped file,
+                                    // decoded PCM, a module resource); null means new[] from the caller
+    WAVEFORMATEX wfx = {};          // Wave format info
+    float baseVolume = 1.0f;        // Base volume (0.0f to 1.0f)
+    float pan = 0.0f;               // Pan position (-1.0f = left, 0.0f = center, 1.0f = right)
+    bool streamed = false;          // Long compressed file, decoded while it plays; no buffer is held
+    float loudnessGain = 1.0f;      // Brings a custom file to the common loudness, applied with baseVolume
+    std::shared_ptr<AdpcmClip> compressed;  // Held instead of the PCM once the sound has gone unplayed for a while
+
+    // Cache bookkeeping, managed by SoundEngine
+    uint64_t lastUsed = 0;          // Cache tick of the last load or play, the oldest is evicted first
+    std::chrono::steady_clock::time_point lastUsedTime;
+    bool reloadable = false;        // PCM can be read again from its resource or file after eviction
+    bool temporary = false;         // Dropped from the cache entirely when evicted
+
+    // Evicted entries keep their format, volume and pan but hold no PCM
+    bool IsResident() const { return pDataBuffer != nullptr || streamed || compressed; }
+    size_t ResidentBytes() const { return pDataBuffer ? bufferSize : (compressed ? compressed->Bytes() : 0); }
+
+    void ReleaseBuffer() {
+        if (!backing) {
+            delete[] pDataBuffer;
         }
-        return result + (isDefault ? " (Default)" : "");
+        backing.reset();
+        compressed.reset();
+        pDataBuffer = nullptr;
+        bufferSize = 0;
     }
 };
 
-// XAudio2 Voice callback implementation
-class VoiceCallback : public IXAudio2VoiceCallback {
-public:
-    VoiceCallback() : isFinished(false) {}
-
-    // Voice events we care about
-    void STDMETHODCALLTYPE OnStreamEnd() override { isFinished = true; }
-
-    // Required but unused callbacks
-    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
-    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 SamplesRequired) override {}
-    void STDMETHODCALLTYPE OnBufferEnd(void* pBufferContext) override {}
-    void STDMETHODCALLTYPE OnBufferStart(void* pBufferContext) override {}
-    void STDMETHODCALLTYPE OnLoopEnd(void* pBufferContext) override {}
-    void STDMETHODCALLTYPE OnVoiceError(void* pBufferContext, HRESULT Error) override {}
+// Sound cache usage, see SoundEngine::GetCacheStats
+struct SoundCacheStats {
+    size_t budgetBytes = 0;         // 0 when there is no limit
+    size_t residentBytes = 0;
+    size_t residentSounds = 0;
+    size_t pinnedBytes = 0;         // Part of residentBytes held by timer sounds
+    uint64_t hits = 0;              // Plays that found their PCM in memory
+    uint64_t misses = 0;            // Plays that had to load or reload first
+    uint64_t evictions = 0;
+    uint64_t diskHits = 0;          // Loads mapped from the on-disk PCM cache, since startup
+    uint64_t diskMisses = 0;
+    uint64_t diskWrites = 0;
+    size_t compressedSounds = 0;    // Held as ADPCM, part of residentSounds
+    size_t compressedBytes = 0;
+    size_t compressionSavedBytes = 0;   // PCM those sounds would take on top of compressedBytes
+    uint64_t expansions = 0;        // Compressed sounds decoded back to PCM to play through a voice
+    double expansionMs = 0.0;       // Time those took, added to the start of each of them
+
+    double HitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+};
 
-    bool isFinished;
+// Alert priority, decides which alert gives way when too many play at once
+enum class AlertPriority {
+    Low,        // Previews and other UI feedback
+    Normal,     // Timer end sounds
+    High        // Timer warnings, duck everything else while they play
 };
 
-// Internal sound data structure
-struct SoundData {
-    BYTE* pDataBuffer = nullptr;    // Sound data buffer
-    UINT32 bufferSize = 0;          // Buffer size in bytes
-    WAVEFORMATEX wfx = {};          // Wave format info
-    float baseVolume = 1.0f;        // Base volume (0.0f to 1.0f)
-    float pan = 0.0f;               // Pan position (-1.0f = left, 0.0f = center, 1.0f = right)
+// What the alert arbitration did, see SoundEngine::PlayAlert
+struct AlertStats {
+    uint64_t requested = 0;
+    uint64_t played = 0;
+    uint64_t merged = 0;            // Same sound again inside the coalescing window, folded into the first
+    uint64_t dropped = 0;           // Over the voice limit with nothing of lower priority to stop
+    uint64_t stolen = 0;            // Playing sounds stopped to make room for a higher priority alert
+    uint64_t ducked = 0;            // High priority alerts that ducked other audio
 };
 
 // Voice tracking structure
 struct ActiveVoice {
-    IXAudio2SourceVoice* pSourceVoice = nullptr;
-    VoiceCallback* pCallback = nullptr;
-    bool isFinished = false;
+    IAudioVoice* voice = nullptr;       // Null for clips played by the mixer
+    uint64_t clipId = 0;                // Mixer clip, 0 when playing through a voice
     SoundID soundId;                    // Which sound is playing
+    AlertPriority priority = AlertPriority::Normal;
+    std::chrono::steady_clock::time_point startsAt;     // Later than now for a clip scheduled ahead
+
+    // Positional sounds follow the listener every frame; pan and gain as last applied
+    SoundEmitter emitter;
+    float spatialPan = 0.0f;
+    float spatialGain = 1.0f;
+
+    // Streamed sounds only
+    std::shared_ptr<AudioStreamState> stream;
+    std::deque<std::vector<uint8_t>> submitted;     // Chunks the voice may still be reading
+    bool streamStarted = false;
+    bool streamEnded = false;
+};
+
+// A sound queued by SoundEngine::ScheduleSound
+struct ScheduledSound {
+    uint64_t handle = 0;
+    SoundID soundId;
+    AlertPriority priority = AlertPriority::Normal;
+    std::chrono::steady_clock::time_point startTime;
+    SoundEmitter emitter;
+    uint64_t clipId = 0;                // Already handed to the mixer; 0 means Update plays it on time
+};
+
+// A play waiting on its sound's decode
+struct PendingPlay {
+    SoundID soundId;
+    AlertPriority priority = AlertPriority::Normal;
+    SoundEmitter emitter;
 };
 
+// How far ahead timers schedule their sounds. Enough to cover a slow frame or two.
+const float ScheduledSoundLeadSeconds = 0.25f;
+
 // Forward declare TtsSoundID to avoid circular dependency
 class TtsSoundID;
 
 // Main sound engine class
 class SoundEngine {
 private:
-    IXAudio2* pXAudio2 = nullptr;                   // XAudio2 engine
-    IXAudio2MasteringVoice* pMasteringVoice = nullptr; // Mastering voice
+    std::unique_ptr<IAudioBackend> backend;         // Output backend, XAudio2 unless one was passed in
     std::map<SoundID, SoundData> soundCache;        // Cache of loaded sounds
     std::vector<ActiveVoice> activeVoices;          // Currently playing voices
     std::vector<SoundInfo> availableSounds;         // Sounds available for UI selection
+    std::set<SoundID> availableSoundIds;            // Same ids, for duplicate checks
     std::vector<AudioDevice> audioDevices;          // Available audio devices
     int currentDeviceIndex = 0;                     // Index of the current audio device
 
+    // Output device. A device the user picked is used while it is present, otherwise the
+    // output follows the Windows default; changes are reported by the watcher
+    std::unique_ptr<AudioDeviceWatcher> deviceWatcher;
+    std::wstring preferredDeviceId;                 // Empty to follow the default device
+    std::wstring outputDeviceId;                    // Device the output is open on
+    std::chrono::steady_clock::time_point outputRetryAt;
+    std::map<AudioFormat, std::vector<IAudioVoice*>> voicePool;  // Idle voices per format, almost always just the engine format
+    bool voicePoolEnabled = true;
+    PlaybackLatencyStats latencyStats;
+
+    // In-memory sounds in the engine format are mixed in software into one output stream;
+    // streamed sounds and other formats keep their own voices
+    std::unique_ptr<AudioMixer> mixer;
+    bool mixerEnabled = true;
+    bool mixerRunning = false;                      // The backend accepted the render stream
+
+    // Compressed files decode on a worker; plays requested meanwhile start when it lands
+    std::unique_ptr<AudioDecodeWorker> decodeWorker;
+    std::map<std::string, float> pendingDecodes;    // File path -> requested base volume
+    std::set<std::string> staleDecodes;             // Changed on disk while decoding, decoded again when the result lands
+    std::vector<PendingPlay> pendingPlays;
+
+    // Decoded files and synthesized speech kept on disk in the engine format for warm starts
+    std::unique_ptr<PcmCache> pcmCache;
+
+    // Mounted sound packs by path; their sounds point into the mapping
+    std::map<std::string, std::shared_ptr<SoundPack>> soundPacks;
+
+    // The last scanned sounds folder is watched, files added, replaced or deleted there are
+    // applied one by one
+    std::unique_ptr<SoundFolderWatcher> folderWatcher;
+
+    // Sounds left unplayed for a while are held as ADPCM, an eighth of the PCM. The mixer decodes
+    // them as they play at no extra latency; a voice needs them expanded to PCM first.
+    static const int CompressIdleSeconds = 60;
+    static const size_t CompressMinFrames = 48000;  // A second in the engine format, shorter clips aren't worth the quality
+    std::unique_ptr<AdpcmCompressor> compressor;
+    bool compressIdleSounds = false;
+    std::map<uint64_t, SoundID> compressing;        // Request tag -> sound
+    uint64_t nextCompressTag = 1;
+    std::chrono::steady_clock::time_point compressScanAt;
+    uint64_t expansions = 0;
+    double expansionMs = 0.0;
+
+    // Custom files are measured once in the background and played at a common loudness
+    std::unique_ptr<LoudnessAnalyzer> loudness;
+    bool normalizeLoudness = true;
+
+    // Listener for positional sounds, from MumbleLink's avatar position and camera orientation.
+    // Without a live link they play centred at full gain.
+    SpatialListener listener;
+    bool listenerValid = false;
+    uint32_t listenerMapId = 0;
+    std::vector<float> spatialX, spatialY, spatialZ;    // Emitters of the playing positional sounds,
+    std::vector<float> spatialPans, spatialGains;       // batched each frame
+    std::vector<size_t> spatialVoices;
+
+    // Sounds waiting for their start time
+    std::vector<ScheduledSound> scheduledSounds;
+    uint64_t nextScheduleHandle = 1;
+
+    // Plays are recorded here and folded into the settings' recent list in the background
+    std::unique_ptr<RecentSoundLog> recentSounds;
+
+    // Sound cache. PCM beyond the budget is evicted least recently used first; sounds used
+    // by timers are pinned and reloaded if they aren't resident
+    size_t cacheBudget = 0;                         // Bytes, 0 for no limit
+    size_t residentBytes = 0;
+    uint64_t cacheTick = 0;
+    uint64_t cacheHits = 0;
+    uint64_t cacheMisses = 0;
+    uint64_t cacheEvictions = 0;
+    bool cacheDirty = false;                        // Something changed that may let the cache shrink
+    std::set<SoundID> pinnedSounds;
+    uint64_t pinnedTimersVersion = 0;
+    std::chrono::steady_clock::time_point pinnedRefreshed;
+
+    // Alert arbitration. Repeats of a sound inside the window are merged, past the voice limit
+    // the lowest priority, oldest sound is stopped, and High alerts duck the rest
+    std::chrono::milliseconds alertCoalesceWindow{ 150 };
+    int maxConcurrentSounds = 8;                    // 0 for no limit
+    float duckVolume = 0.4f;                        // Gain for other sounds while a High alert plays
+    bool ducking = false;
+    std::map<SoundID, std::chrono::steady_clock::time_point> lastAlerts;
+    AlertStats alertStats;
+
+    // Directory scan timing, reported once every queued file has decoded
+    bool scanInProgress = false;
+    size_t scanQueued = 0;
+    std::chrono::steady_clock::time_point scanStarted;
+
     bool initialized = false;
     float masterVolume = 1.0f;                      // Master volume (0.0f to 1.0f)
 
     // Private helper methods
     bool EnumerateAudioDevices();
-    void ApplyPanning(IXAudio2SourceVoice* pVoice, float pan);
+    void UpdateOutputDevice();
+    bool MigrateOutput(const std::wstring& deviceId);
     bool LoadResourceSound(int resourceId, HMODULE hModule, float baseVolume = 1.0f);
     bool LoadFileSound(const std::string& filePath, float baseVolume = 1.0f);
 
+    // Voice pool. Sounds are stored in the engine format, so in practice every play
+    // shares the one pool; other formats only appear for sources the converter can't read.
+    static const size_t MaxIdleVoicesPerFormat = 8;
+    IAudioVoice* AcquireVoice(const AudioFormat& format, bool& fromPool);
+    void RecycleVoice(IAudioVoice* voice);
+    void WarmVoicePool(const AudioFormat& format);
+    void ReleaseVoicePool();
+    bool PlayThroughMixer(const SoundID& soundId, const SoundData& data, AlertPriority priority,
+        std::chrono::steady_clock::time_point trigger, const SoundEmitter& emitter);
+    void StartScheduledSounds();
+
+    // Decoding and streaming
+    bool QueueFileDecode(const std::string& filePath, float baseVolume);
+    bool LoadCachedFileSound(const std::string& filePath, float baseVolume);
+    bool LoadPackSound(const std::string& soundPath, float baseVolume);
+    void ProcessDecodeResults();
+    void PumpStreams();
+
+    // Sounds folder changes
+    void ProcessFolderChanges();
+    void ForgetSound(const SoundID& soundId);
+    void UnloadSoundPack(const std::string& packPath);
+
+    // Sound cache
+    static const size_t MegaByte = 1024 * 1024;
+    void StoreSound(const SoundID& soundId, const SoundData& soundData);
+    void MarkUsed(SoundData& data);
+    void CompressIdleSounds();
+    void ProcessCompressResults();
+    void ExpandSound(SoundData& data);
+    void StopVoicesFor(const SoundID& soundId);
+    void RefreshPinnedSounds();
+    void EnforceCacheBudget();
+
+    // Alert arbitration
+    void StopActiveVoice(ActiveVoice& active);
+    bool MakeRoomFor(AlertPriority priority);
+    void UpdateDucking(bool reapply = false);
+    float GetDuckGain(const ActiveVoice& active) const;
+    float GetLoudnessGain(const SoundID& soundId) const;
+    void ProcessLoudnessResults();
+    void ApplyVolume(const ActiveVoice& active, float baseVolume);
+
+    // Positional sounds
+    bool ReadListener();
+    void Spatialize(ActiveVoice& active);
+    void UpdateSpatialSounds();
+    void ApplyPan(const ActiveVoice& active, float pan);
+
 public:
-    SoundEngine();
+    // Pass a backend to play through something other than XAudio2
+    explicit SoundEngine(std::unique_ptr<IAudioBackend> audioBackend = nullptr);
     ~SoundEngine();
 
     bool Initialize();
     void Shutdown();
-    void Update();  // Call this every frame to clean up finished voices
+    void Update();  // Call this every frame to feed streams and clean up finished voices
 
     // Unified sound loading method
     bool LoadSound(const SoundID& soundId, HMODULE hModule = nullptr, float baseVolume = 1.0f);
 
+    // Loaded with its PCM in memory, plays without a load
+    bool IsSoundResident(const SoundID& soundId) const;
+    size_t GetResidentBytes(const SoundID& soundId) const;
+
+    // Drop a temporary sound its owner no longer needs; one a voice is still reading is
+    // left for the cache budget
+    void ReleaseTempSound(const SoundID& soundId);
+
     // TTS support - add a TTS sound to the cache
     void AddTtsSound(const TtsSoundID& soundId, const SoundData& soundData, const std::string& displayName = "");
 
     // Unified playback method
-    bool PlaySound(const SoundID& soundId);
+    // An emitter places the sound in the world, it is panned and attenuated from the listener
+    bool PlaySound(const SoundID& soundId, AlertPriority priority = AlertPriority::Normal,
+        const SoundEmitter& emitter = SoundEmitter());
+
+    // Play through the alert arbitration: merged, limited and ducked as configured
+    bool PlayAlert(const SoundID& soundId, AlertPriority priority = AlertPriority::Normal,
+        const SoundEmitter& emitter = SoundEmitter());
+
+    // Play an alert at a set time. Through the mixer it starts on the exact sample for that
+    // time whatever the frame rate; otherwise Update starts it on the first frame after.
+    // Returns a handle for CancelScheduledSound, 0 if it played right away or not at all.
+    uint64_t ScheduleSound(const SoundID& soundId, std::chrono::steady_clock::time_point startTime,
+        AlertPriority priority = AlertPriority::Normal, const SoundEmitter& emitter = SoundEmitter());
+    bool CancelScheduledSound(uint64_t handle);     // False once it has started
     void StopAllSounds();
     void CleanupFinishedVoices();
 
@@ -227,12 +458,52 @@ public:
     void SetSoundPan(const SoundID& soundId, float pan);
     float GetSoundPan(const SoundID& soundId) const;
 
+    // Re-read volumes, pans, cache budget and alert limits from Settings without writing back
+    void SyncFromSettings();
+
     // Sound library management
     void ScanSoundDirectory(const std::string& directory);
+
+    // Map a sound pack and list its sounds; their PCM is read from the mapping when used
+    bool LoadSoundPack(const std::string& packPath);
     const std::vector<SoundInfo>& GetAvailableSounds() const { return availableSounds; }
     void AddSoundInfo(const SoundInfo& info);
 
+    // Voice pool and trigger-to-start latency
+    bool IsVoicePoolEnabled() const { return voicePoolEnabled; }
+    void SetVoicePoolEnabled(bool enabled);
+    bool IsMixerEnabled() const { return mixerEnabled; }
+    void SetMixerEnabled(bool enabled);
+    size_t GetMixedClipCount() const { return mixer ? mixer->GetPlayingCount() : 0; }
+    void GetPlaybackLatency(bool pooled, uint64_t& count, double& averageMs, double& maxMs) const;
+    void ResetPlaybackLatency();
+
+    // Sound cache budget and statistics
+    int GetCacheBudgetMB() const { return static_cast<int>(cacheBudget / MegaByte); }
+    void SetCacheBudgetMB(int megabytes);
+    SoundCacheStats GetCacheStats() const;
+    void ResetCacheStats();
+
+    // Alert arbitration settings and counters
+    int GetAlertCoalesceMs() const { return static_cast<int>(alertCoalesceWindow.count()); }
+    void SetAlertCoalesceMs(int milliseconds);
+    int GetMaxConcurrentSounds() const { return maxConcurrentSounds; }
+    void SetMaxConcurrentSounds(int count);
+    float GetAlertDuckVolume() const { return duckVolume; }
+    void SetAlertDuckVolume(float volume);
+    const AlertStats& GetAlertStats() const { return alertStats; }
+    void ResetAlertStats() { alertStats = AlertStats(); }
+
+    // Loudness normalization of custom sound files
+    bool IsLoudnessNormalized() const { return normalizeLoudness; }
+    void SetLoudnessNormalized(bool enabled);
+
+    // Compressed residency for sounds that go unplayed
+    bool IsIdleCompressionEnabled() const { return compressIdleSounds; }
+    void SetIdleCompressionEnabled(bool enabled);
+
     // Audio device selection
+    const char* GetBackendName() const { return backend ? backend->GetName() : ""; }
     const std::vector<AudioDevice>& GetAudioDevices() const { return audioDevices; }
     int GetCurrentDeviceIndex() const { return currentDeviceIndex; }
     bool SetAudioDevice(int deviceIndex);
@@ -242,6 +513,12 @@ public:
     void AddTempSound(const SoundID& soundId, const SoundData& soundData);
     void AddPermanentSound(const SoundID& soundId, const SoundData& soundData,
         const std::string& displayName, const std::string& category = "");
+
+    // On-disk PCM cache. Files are keyed by their content; other sounds, such as speech,
+    // by a key naming what produced them. Saving takes the sound as it is in soundCache.
+    bool LoadCachedPcm(const std::string& key, SoundData& soundData);
+    void SaveToPcmCache(const SoundID& soundId, const std::string& key = "");
+    void RetainCachedPcmKeys(std::set<std::string> liveKeys);   // Drops other keyed sounds from the disk cache
 };
 
 // Helper functions for sound management
@@ -252,5 +529,10 @@ bool IsSupportedAudioFile(const std::string& filePath);
 // Function to load a resource sound with default settings
 bool LoadSoundResource(int resourceId);
 
-// Function to play a sound by ID
-void PlaySoundEffect(const SoundID& soundId);
\ No newline at end of file
+// Function to play a sound by ID, through the alert arbitration
+void PlaySoundEffect(const SoundID& soundId, AlertPriority priority = AlertPriority::Normal);
+
+// Schedule a sound secondsFromNow ahead, see SoundEngine::ScheduleSound
+uint64_t ScheduleSoundEffect(const SoundID& soundId, float secondsFromNow, AlertPriority priority = AlertPriority::Normal,
+    const SoundEmitter& emitter = SoundEmitter());
+bool CancelSoundEffect(uint64_t handle);
\ No newline at end of file
@@ -8,13 +8,154 @@
 // Global TTS engine instance
 TextToSpeech* g_TextToSpeech = nullptr;
 
+bool TtsWorker::Start() {
+    if (thread.joinable()) return false;
+
+    stopping = false;
+    thread = std::thread(&TtsWorker::Run, this);
+    return true;
+}
+
+void TtsWorker::Stop() {
+    if (!thread.joinable()) return;
+
+    std::deque<std::shared_ptr<Job>> abandoned;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+        abandoned.swap(jobs);
+    }
+    wake.notify_all();
+    thread.join();
+
+    // Nobody waits forever on a phrase that will never be spoken
+    for (auto& job : abandoned) {
+        job->promise.set_value(std::make_shared<TtsClip>());
+    }
+}
+
+TtsFuture TtsWorker::Request(const std::wstring& voiceId, const std::string& text, bool urgent) {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto it = jobs.begin(); it != jobs.end(); ++it) {
+        if ((*it)->voiceId != voiceId || (*it)->text != text) continue;
+
+        TtsFuture future = (*it)->future;
+        if (urgent && it != jobs.begin()) {
+            std::shared_ptr<Job> job = *it;
+            jobs.erase(it);
+            jobs.push_front(std::move(job));
+        }
+        return future;
+    }
+
+    auto job = std::make_shared<Job>();
+    job->voiceId = voiceId;
+    job->text = text;
+    job->future = job->promise.get_future().share();
+    TtsFuture future = job->future;
+
+    if (!thread.joinable() || stopping) {
+        job->promise.set_value(std::make_shared<TtsClip>());
+        return future;
+    }
+    if (urgent) {
+        jobs.push_front(std::move(job));
+    }
+    else {
+        jobs.push_back(std::move(job));
+    }
+    wake.notify_one();
+    return future;
+}
+
+void TtsWorker::Run() {
+    // The voice and its streams are created, used and released on this thread only
+    HRESULT hr = CoInitializeEx(NULL, COINIT_APARTMENTTHREADED);
+    bool comInitialized = SUCCEEDED(hr);
+    {
+        CComPtr<ISpVoice> voice;
+        if (comInitialized) {
+            voice.CoCreateInstance(CLSID_SpVoice);
+        }
+
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [this] { return stopping || !jobs.empty(); });
+            if (stopping) break;
+
+            std::shared_ptr<Job> job = std::move(jobs.front());
+            jobs.pop_front();
+            lock.unlock();
+
+            auto clip = std::make_shared<TtsClip>();
+            if (voice) {
+                Synthesize(voice, *job, *clip);
+            }
+            job->promise.set_value(std::move(clip));
+
+            lock.lock();
+        }
+    }
+    if (comInitialized) {
+        CoUninitialize();
+    }
+}
+
+void TtsWorker::Synthesize(ISpVoice* voice, const Job& job, TtsClip& clip) {
+    auto start = std::chrono::steady_clock::now();
+
+    // The job's voice, or the system default
+    CComPtr<ISpObjectToken> token;
+    HRESULT hr = job.voiceId.empty()
+        ? SpGetDefaultTokenFromCategoryId(SPCAT_VOICES, &token)
+        : SpGetTokenFromId(job.voiceId.c_str(), &token);
+    if (FAILED(hr) || FAILED(voice->SetVoice(token))) return;
+
+    // PCM 16-bit, 22kHz, mono into a memory stream
+    CComPtr<IStream> memStream;
+    if (FAILED(CreateStreamOnHGlobal(NULL, TRUE, &memStream))) return;
+
+    WAVEFORMATEX format = { 0 };
+    format.wFormatTag = WAVE_FORMAT_PCM;
+    format.nChannels = 1;
+    format.nSamplesPerSec = 22050;
+    format.wBitsPerSample = 16;
+    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+    format.cbSize = 0;
+
+    CComPtr<ISpStream> stream;
+    if (FAILED(stream.CoCreateInstance(CLSID_SpStream)) ||
+        FAILED(stream->SetBaseStream(memStream, SPDFID_WaveFormatEx, &format)) ||
+        FAILED(voice->SetOutput(stream, TRUE))) {
+        return;
+    }
+
+    hr = voice->Speak(TextToSpeech::StringToWString(job.text).c_str(), SPF_IS_NOT_XML | SPF_PURGEBEFORESPEAK, NULL);
+    voice->SetOutput(NULL, FALSE);
+    if (FAILED(hr)) return;
+
+    // Only what was written, the HGLOBAL itself may be larger; copied out once
+    STATSTG stat = {};
+    HGLOBAL hGlobal = NULL;
+    if (FAILED(memStream->Stat(&stat, STATFLAG_NONAME)) || FAILED(GetHGlobalFromStream(memStream, &hGlobal))) return;
+    size_t size = static_cast<size_t>(stat.cbSize.QuadPart);
+    size -= size % format.nBlockAlign;
+    if (size == 0) return;
+
+    const BYTE* data = static_cast<const BYTE*>(GlobalLock(hGlobal));
+    if (!data) return;
+    clip.pcm.assign(data, data + size);
+    GlobalUnlock(hGlobal);
+
+    clip.format = format;
+    clip.synthesisMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    clip.ok = true;
+}
+
 TextToSpeech::TextToSpeech()
     : initialized(false),
-    pVoice(nullptr),
-    pStream(nullptr),
-    pMemStream(nullptr),
-    pSpeechData(nullptr),
-    speechDataSize(0)
+    pVoice(nullptr)
 {
 }
 
@@ -53,6 +194,17 @@ bool TextToSpeech::Initialize() {
         return false;
     }
 
+    // Speech is synthesized off the render thread
+    worker = std::make_unique<TtsWorker>();
+    if (!worker->Start()) {
+        if (APIDefs) {
+            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to start the TTS worker");
+        }
+        worker.reset();
+        pVoice.Release();
+        return false;
+    }
+
     initialized = true;
 
     if (APIDefs) {
@@ -65,16 +217,16 @@ void TextToSpeech::Shutdown() {
     if (!initialized)
         return;
 
-    // Clean up any speech data
-    if (pSpeechData) {
-        delete[] pSpeechData;
-        pSpeechData = nullptr;
-        speechDataSize = 0;
+    // Phrases still queued are dropped
+    if (worker) {
+        worker->Stop();
+        worker.reset();
     }
+    pending.clear();
+    clipCache.Clear();
+    cacheBudgetMB = -1;
 
     // Release SAPI objects
-    pStream.Release();
-    pMemStream.Release();
     pVoice.Release();
 
     initialized = false;
@@ -194,44 +346,8 @@ bool TextToSpeech::SetVoice(int voiceIndex) {
         return false;
     }
 
-    // Create voice token category
-    CComPtr<ISpObjectTokenCategory> pCategory;
-    HRESULT hr = SpGetCategoryFromId(SPCAT_VOICES, &pCategory);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to get voice category");
-        }
-        return false;
-    }
-
-    // Enumerate voice tokens
-    CComPtr<IEnumSpObjectTokens> pTokenEnum;
-    hr = pCategory->EnumTokens(NULL, NULL, &pTokenEnum);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to enumerate voice tokens");
-        }
-        return false;
-    }
-
-    // Get the selected voice token
-    CComPtr<ISpObjectToken> pVoiceToken;
-    hr = pTokenEnum->Item(voiceIndex, &pVoiceToken);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to get selected voice token");
-        }
-        return false;
-    }
-
-    // Set the voice
-    hr = pVoice->SetVoice(pVoiceToken);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to set voice");
-        }
-        return false;
-    }
+    // The worker picks the voice per phrase, by its token ID
+    currentVoiceId = availableVoices[voiceIndex].id;
 
     // Success
     if (APIDefs) {
@@ -242,131 +358,190 @@ bool TextToSpeech::SetVoice(int voiceIndex) {
     return true;
 }
 
-bool TextToSpeech::TextToWav(const std::wstring& text, BYTE** ppData, ULONG* pDataSize, WAVEFORMATEX* pWaveFormat) {
-    if (!initialized || !pVoice) {
-        return false;
-    }
-
-    // Clean up previous data if any
-    if (pSpeechData) {
-        delete[] pSpeechData;
-        pSpeechData = nullptr;
-        speechDataSize = 0;
+std::wstring TextToSpeech::VoiceIdFor(int voiceIndex) const {
+    if (voiceIndex < 0 || voiceIndex >= static_cast<int>(availableVoices.size())) {
+        return L"";
     }
+    return availableVoices[voiceIndex].id;
+}
 
-    // Release previous streams
-    pStream.Release();
-    pMemStream.Release();
+void TextToSpeech::SetCacheBudgetMB(int megabytes) {
+    megabytes = (std::max)(0, megabytes);
+    cacheBudgetMB = megabytes;
+    clipCache.SetBudget(static_cast<size_t>(megabytes) * 1024 * 1024);
+    ReleasePhrases(clipCache.Evict());
 
-    // Create a new memory stream
-    HRESULT hr = CreateStreamOnHGlobal(NULL, TRUE, &pMemStream);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create memory stream for TTS");
+    if (APIDefs) {
+        try {
+            Settings::SetTtsCacheBudgetMB(megabytes);
+        }
+        catch (...) {
+            // Continue even if settings update fails
         }
-        return false;
     }
+}
 
-    // Define the output format as PCM 16-bit, 22kHz, mono
-    WAVEFORMATEX format = { 0 };
-    format.wFormatTag = WAVE_FORMAT_PCM;
-    format.nChannels = 1;
-    format.nSamplesPerSec = 22050;
-    format.wBitsPerSample = 16;
-    format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
-    format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
-    format.cbSize = 0;
+SoundData TextToSpeech::ClipSoundData(const std::shared_ptr<TtsClip>& clip, float volume, float pan) {
+    // The engine converts straight from the clip, which its backing keeps alive
+    SoundData soundData = {};
+    soundData.pDataBuffer = clip->pcm.data();
+    soundData.bufferSize = static_cast<UINT32>(clip->pcm.size());
+    soundData.backing = std::shared_ptr<void>(clip, clip->pcm.data());
+    memcpy(&soundData.wfx, &clip->format, sizeof(WAVEFORMATEX));
+    soundData.baseVolume = volume;
+    soundData.pan = pan;
+    return soundData;
+}
 
-    // Copy format info if requested
-    if (pWaveFormat) {
-        memcpy(pWaveFormat, &format, sizeof(WAVEFORMATEX));
+void TextToSpeech::ReleasePhrases(const std::vector<uint64_t>& keys) {
+    // Saved TTS sounds are permanent, only spoken phrases have a sound to drop
+    if (!g_SoundEngine) return;
+    for (uint64_t key : keys) {
+        g_SoundEngine->ReleaseTempSound(SoundID(TtsPhrasePath(key)));
     }
+}
 
-    // Create a stream that will write to our memory stream
-    hr = CoCreateInstance(CLSID_SpStream, NULL, CLSCTX_ALL, __uuidof(ISpStream), (void**)&pStream);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to create SpStream for TTS");
+bool TextToSpeech::ParseTtsPath(const std::string& path, int& voiceIndex, std::string& text) {
+    size_t secondColon = path.find(':', 4);
+    if (path.compare(0, 4, "tts:") != 0 || secondColon == std::string::npos) return false;
+
+    std::string voiceStr = path.substr(4, secondColon - 4);
+    text = path.substr(secondColon + 1);
+    voiceIndex = -1;
+    if (voiceStr != "default") {
+        try {
+            voiceIndex = std::stoi(voiceStr);
+        }
+        catch (...) {
+            // Use default voice
         }
-        pMemStream.Release();
-        return false;
     }
+    return true;
+}
 
-    // Initialize the stream
-    hr = pStream->SetBaseStream(pMemStream, SPDFID_WaveFormatEx, &format);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to initialize TTS stream");
-        }
-        pStream.Release();
-        pMemStream.Release();
-        return false;
+void TextToSpeech::RefreshPinnedPhrases() {
+    // Timer sounds are edited in place without bumping the timers version, so recheck every few seconds too
+    auto now = std::chrono::steady_clock::now();
+    uint64_t timersVersion = Settings::GetTimersVersion();
+    if (timersVersion == pinnedTimersVersion && now - pinnedRefreshed < std::chrono::seconds(2)) {
+        return;
     }
+    pinnedTimersVersion = timersVersion;
+    pinnedRefreshed = now;
 
-    // Set output to audio stream
-    hr = pVoice->SetOutput(pStream, TRUE);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to set TTS output to stream");
+    std::unordered_set<uint64_t> keys;
+    auto pin = [this, &keys](const SoundID& soundId) {
+        int voiceIndex = -1;
+        std::string text;
+        if (!soundId.IsResource() && ParseTtsPath(soundId.GetFilePath(), voiceIndex, text)) {
+            keys.insert(TtsPhraseKey(VoiceIdFor(voiceIndex), text));
+        }
+    };
+    {
+        std::lock_guard<std::mutex> lock(Settings::Mutex);
+        for (const auto& timer : Settings::timers) {
+            pin(timer.endSound);
+            if (timer.useWarning) {
+                pin(timer.warningSound);
+            }
         }
-        pStream.Release();
-        pMemStream.Release();
-        return false;
     }
+    if (keys != clipCache.GetPinned()) {
+        ReleasePhrases(clipCache.SetPinned(std::move(keys)));
+    }
+}
 
-    // Speak the text to the stream
-    hr = pVoice->Speak(text.c_str(), SPF_IS_NOT_XML | SPF_PURGEBEFORESPEAK, NULL);
-    if (FAILED(hr)) {
-        if (APIDefs) {
-            APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to speak text to stream");
-        }
-        pVoice->SetOutput(NULL, FALSE);
-        pStream.Release();
-        pMemStream.Release();
-        return false;
+void TextToSpeech::SyncFromSettings() {
+    int budgetMB = (std::max)(0, Settings::GetSoundState()->ttsCacheBudgetMB);
+    if (budgetMB != cacheBudgetMB) {
+        cacheBudgetMB = budgetMB;
+        clipCache.SetBudget(static_cast<size_t>(budgetMB) * 1024 * 1024);
+        ReleasePhrases(clipCache.Evict());
     }
+}
 
-    // Make sure the stream is done
-    pVoice->WaitUntilDone(INFINITE);
+void TextToSpeech::Update() {
+    if (!initialized) return;
 
-    // Reset voice output
-    pVoice->SetOutput(NULL, FALSE);
+    SyncFromSettings();
+    RefreshPinnedPhrases();
 
-    // Get the data from the memory stream
-    HGLOBAL hGlobal = NULL;
-    hr = GetHGlobalFromStream(pMemStream, &hGlobal);
-    if (SUCCEEDED(hr) && hGlobal) {
-        // Lock the memory
-        LPVOID ptr = GlobalLock(hGlobal);
-        if (ptr) {
-            // Get the size
-            speechDataSize = (ULONG)GlobalSize(hGlobal);
+    for (size_t i = 0; i < pending.size();) {
+        if (pending[i].clip.wait_for(std::chrono::seconds(0)) != std::future_status::ready) {
+            i++;
+            continue;
+        }
+        PendingSpeech speech = std::move(pending[i]);
+        pending.erase(pending.begin() + i);
 
-            // Copy the data
-            pSpeechData = new BYTE[speechDataSize];
-            memcpy(pSpeechData, ptr, speechDataSize);
+        std::shared_ptr<TtsClip> clip = speech.clip.get();
+        if (!clip->ok || !g_SoundEngine) {
+            if (APIDefs) {
+                char logMsg[256];
+                sprintf_s(logMsg, "Failed to synthesize TTS audio%s%s", speech.name.empty() ? "" : " for ", speech.name.c_str());
+                APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, logMsg);
+            }
+            continue;
+        }
 
-            // Return the data to the caller
-            *ppData = pSpeechData;
-            *pDataSize = speechDataSize;
+        clipCache.RecordSynthesis(clip->synthesisMs);
+        SoundData soundData = ClipSoundData(clip, speech.volume, speech.pan);
 
-            // Unlock the memory
-            GlobalUnlock(hGlobal);
+        // A saved sound's engine copy is permanent, a spoken phrase's goes with its clip
+        SoundID soundId(speech.soundPath);
+        size_t bytes = clip->pcm.size();
+        if (speech.permanent) {
+            g_SoundEngine->AddPermanentSound(soundId, soundData, speech.name, "Text-to-Speech");
+            g_SoundEngine->SaveToPcmCache(soundId, speech.pcmKey);
+        }
+        else {
+            g_SoundEngine->AddTempSound(soundId, soundData);
+            bytes += g_SoundEngine->GetResidentBytes(soundId);
+        }
+        ReleasePhrases(clipCache.Insert(speech.key, clip, bytes));
 
-            if (APIDefs) {
-                char logMsg[128];
-                sprintf_s(logMsg, "Generated TTS audio (%d bytes)", speechDataSize);
-                APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
-            }
+        if (APIDefs) {
+            char logMsg[256];
+            sprintf_s(logMsg, "Synthesized TTS audio in %.1f ms (%zu bytes)%s%s", clip->synthesisMs, clip->pcm.size(),
+                speech.name.empty() ? "" : ": ", speech.name.c_str());
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
 
-            return true;
+        if (speech.play) {
+            g_SoundEngine->PlaySound(soundId);
         }
     }
+}
 
-    if (APIDefs) {
-        APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to get TTS data from stream");
+bool TextToSpeech::IsSynthesizing(const SoundID& soundId) const {
+    if (soundId.IsResource()) return false;
+    return std::any_of(pending.begin(), pending.end(),
+        [&soundId](const PendingSpeech& speech) { return speech.soundPath == soundId.GetFilePath(); });
+}
+
+void TextToSpeech::Prewarm(const SoundID& soundId) {
+    if (!initialized || !worker || !g_SoundEngine || soundId.IsResource()) return;
+
+    const std::string& path = soundId.GetFilePath();
+    int voiceIndex = -1;
+    std::string text;
+    if (!ParseTtsPath(path, voiceIndex, text) || g_SoundEngine->IsSoundResident(soundId)) return;
+
+    // Already queued: asking again with urgency moves it to the front
+    if (IsSynthesizing(soundId)) {
+        worker->Request(VoiceIdFor(voiceIndex), text, true);
+        return;
+    }
+
+    // Not loaded at all, such as after a failed synthesis: made again under its saved name,
+    // which is already in settings
+    std::vector<SoundSettings::TtsSoundInfo> saved = Settings::GetTtsSounds();
+    for (const auto& info : saved) {
+        if (info.id == path) {
+            LoadTtsSound(text, info.name, voiceIndex, info.volume, info.pan, true);
+            return;
+        }
     }
-    return false;
 }
 
 std::wstring TextToSpeech::StringToWString(const std::string& text) {
@@ -423,15 +598,6 @@ bool TextToSpeech::SpeakText(const std::string& text, float volume, float pan) {
         return false;
     }
 
-    // Generate the TTS data
-    BYTE* pData = nullptr;
-    ULONG dataSize = 0;
-    WAVEFORMATEX format = { 0 };
-
-    if (!TextToWav(StringToWString(text), &pData, &dataSize, &format)) {
-        return false;
-    }
-
     // Check if we have a sound engine
     if (!g_SoundEngine) {
         if (APIDefs) {
@@ -440,27 +606,96 @@ bool TextToSpeech::SpeakText(const std::string& text, float volume, float pan) {
         return false;
     }
 
-    // Create a unique sound ID for this text
-    std::string idStr = "tts:" + text;
+    // Phrases are keyed by voice and text, the same words in another voice are another phrase
+    uint64_t key = TtsPhraseKey(currentVoiceId, text);
+    std::string idStr = TtsPhrasePath(key);
     SoundID cacheId(idStr);
 
-    // Create a sound data struct
-    SoundData soundData = { 0 };
-    soundData.pDataBuffer = new BYTE[dataSize];
-    soundData.bufferSize = dataSize;
-    memcpy(soundData.pDataBuffer, pData, dataSize);
-    memcpy(&soundData.wfx, &format, sizeof(WAVEFORMATEX));
-    soundData.baseVolume = volume;
-    soundData.pan = pan;
+    // Spoken before and still loaded: play it now
+    if (g_SoundEngine->IsSoundResident(cacheId)) {
+        clipCache.Find(key);
+        return g_SoundEngine->PlaySound(cacheId);
+    }
+
+    // Clip still cached but the engine let its copy go
+    if (std::shared_ptr<TtsClip> clip = clipCache.Find(key)) {
+        g_SoundEngine->AddTempSound(cacheId, ClipSoundData(clip, volume, pan));
+        ReleasePhrases(clipCache.Insert(key, clip, clip->pcm.size() + g_SoundEngine->GetResidentBytes(cacheId)));
+        return g_SoundEngine->PlaySound(cacheId);
+    }
 
-    // Add to the sound engine's cache as a temporary sound
-    // We don't need the AddTtsSound method; we can use the normal sound system
-    g_SoundEngine->AddTempSound(cacheId, soundData);
+    // Already on its way: it plays once, when ready
+    for (auto& speech : pending) {
+        if (speech.soundPath == idStr) {
+            speech.play = true;
+            return true;
+        }
+    }
 
-    // Play the sound
-    bool result = g_SoundEngine->PlaySound(cacheId);
+    // Synthesized in the background, Update adds it as a temporary sound and plays it
+    PendingSpeech speech;
+    speech.clip = worker->Request(currentVoiceId, text, true);
+    speech.key = key;
+    speech.soundPath = idStr;
+    speech.play = true;
+    speech.volume = volume;
+    speech.pan = pan;
+    pending.push_back(std::move(speech));
+    return true;
+}
 
-    return result;
+std::string TextToSpeech::PcmKeyFor(int voiceIndex, const std::string& text) const {
+    // Voice indices change when voices are installed or removed, their IDs don't
+    std::wstring voiceId = VoiceIdFor(voiceIndex);
+    return "tts:" + (!voiceId.empty() ? WStringToString(voiceId) : std::string("default")) + ":" + text;
+}
+
+std::string TextToSpeech::LoadTtsSound(const std::string& text, const std::string& name,
+    int voiceIndex, float volume, float pan, bool urgent) {
+    // Create a unique sound ID for this text and voice combo
+    std::string voiceStr = (voiceIndex >= 0) ? std::to_string(voiceIndex) : "default";
+    std::string idStr = "tts:" + voiceStr + ":" + text;
+    SoundID cacheId(idStr);
+
+    std::string pcmKey = PcmKeyFor(voiceIndex, text);
+    std::wstring voiceId = VoiceIdFor(voiceIndex);
+    uint64_t key = TtsPhraseKey(voiceId, text);
+
+    // From the disk cache or a clip already spoken right away, or synthesized in the background and added by Update
+    SoundData soundData = { 0 };
+    std::shared_ptr<TtsClip> clip;
+    bool fromDisk = g_SoundEngine->LoadCachedPcm(pcmKey, soundData);
+    if (!fromDisk && (clip = clipCache.Find(key))) {
+        soundData = ClipSoundData(clip, volume, pan);
+    }
+    if (fromDisk || clip) {
+        soundData.baseVolume = volume;
+        soundData.pan = pan;
+        g_SoundEngine->AddPermanentSound(cacheId, soundData, name, "Text-to-Speech");
+        if (clip) {
+            g_SoundEngine->SaveToPcmCache(cacheId, pcmKey);
+        }
+
+        if (APIDefs) {
+            char logMsg[256];
+            sprintf_s(logMsg, "Created TTS sound: %s", name.c_str());
+            APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+        }
+    }
+    else if (!IsSynthesizing(cacheId)) {
+        PendingSpeech speech;
+        speech.clip = worker->Request(voiceId, text, urgent);
+        speech.key = key;
+        speech.soundPath = idStr;
+        speech.pcmKey = pcmKey;
+        speech.name = name;
+        speech.permanent = true;
+        speech.volume = volume;
+        speech.pan = pan;
+        pending.push_back(std::move(speech));
+    }
+
+    return idStr;
 }
 
 bool TextToSpeech::CreateTtsSound(const std::string& text, const std::string& name,
@@ -474,20 +709,6 @@ bool TextToSpeech::CreateTtsSound(const std::string& text, const std::string& na
         return false;
     }
 
-    // Set voice if specified
-    if (voiceIndex >= 0 && voiceIndex < static_cast<int>(availableVoices.size())) {
-        SetVoice(voiceIndex);
-    }
-
-    // Generate the TTS data
-    BYTE* pData = nullptr;
-    ULONG dataSize = 0;
-    WAVEFORMATEX format = { 0 };
-
-    if (!TextToWav(StringToWString(text), &pData, &dataSize, &format)) {
-        return false;
-    }
-
     // Check if we have a sound engine
     if (!g_SoundEngine) {
         if (APIDefs) {
@@ -496,29 +717,7 @@ bool TextToSpeech::CreateTtsSound(const std::string& text, const std::string& na
         return false;
     }
 
-    // Create a unique sound ID for this text and voice combo
-    std::string voiceStr = (voiceIndex >= 0) ? std::to_string(voiceIndex) : "default";
-    std::string idStr = "tts:" + voiceStr + ":" + text;
-    SoundID cacheId(idStr);
-
-    // Create a sound data struct
-    SoundData soundData = { 0 };
-    soundData.pDataBuffer = new BYTE[dataSize];
-    soundData.bufferSize = dataSize;
-    memcpy(soundData.pDataBuffer, pData, dataSize);
-    memcpy(&soundData.wfx, &format, sizeof(WAVEFORMATEX));
-    soundData.baseVolume = volume;
-    soundData.pan = pan;
-
-    // Add to the sound engine's cache as a permanent sound
-    g_SoundEngine->AddPermanentSound(cacheId, soundData, name, "Text-to-Speech");
-
-    // Log success before attempting to save to settings
-    if (APIDefs) {
-        char logMsg[256];
-        sprintf_s(logMsg, "Created TTS sound: %s", name.c_str());
-        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
-    }
+    std::string idStr = LoadTtsSound(text, name, voiceIndex, volume, pan, false);
 
     // Save the TTS sound to settings in a separate step
     // This way, even if settings save fails, the sound is still usable in the current session
@@ -559,4 +758,13 @@ bool PlayTtsNotification(const std::string& text, float volume, float pan) {
     }
 
     return g_TextToSpeech->SpeakText(text, volume, pan);
-}
\ No newline at end of file
+}
+
+void PrewarmTimerSpeech(const TimerData& timer) {
+    if (!g_TextToSpeech || !g_TextToSpeech->IsInitialized()) return;
+
+    g_TextToSpeech->Prewarm(timer.endSound);
+    if (timer.useWarning) {
+        g_TextToSpeech->Prewarm(timer.warningSound);
+    }
+}
@@ -3,16 +3,25 @@
 
 #include <string>
 #include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <future>
+#include <condition_variable>
+#include <chrono>
 #include <sapi.h>           // Speech API
 #include <sphelper.h>       // Speech API helpers
 #include <atlbase.h>        // For CComPtr
 #include "Sounds.h"         // Include this for SoundID class
+#include "TtsCache.h"
 
 #pragma comment(lib, "sapi.lib")
 
 // Forward declarations
 class SoundEngine;
 struct SoundData;
+struct TimerData;
 
 // Simplified voice information structure
 struct VoiceInfo {
@@ -78,23 +87,95 @@ public:
     }
 };
 
+// A synthesized phrase, PCM in the format SAPI was asked for
+struct TtsClip {
+    bool ok = false;
+    WAVEFORMATEX format = {};
+    std::vector<BYTE> pcm;
+    double synthesisMs = 0.0;
+};
+
+using TtsFuture = std::shared_future<std::shared_ptr<TtsClip>>;
+
+// Synthesizes speech on its own thread, in its own COM apartment with its own SAPI voice,
+// so Speak never runs on the game's thread. Requesting a phrase that is already queued
+// returns the same future; an urgent request moves it to the front.
+class TtsWorker {
+public:
+    TtsWorker() {}
+    ~TtsWorker() { Stop(); }
+    TtsWorker(const TtsWorker&) = delete;
+    TtsWorker& operator=(const TtsWorker&) = delete;
+
+    bool Start();
+    void Stop();        // Queued phrases resolve as failed
+
+    // voiceId is a SAPI voice token ID, empty for the system default
+    TtsFuture Request(const std::wstring& voiceId, const std::string& text, bool urgent);
+
+private:
+    struct Job {
+        std::wstring voiceId;
+        std::string text;
+        std::promise<std::shared_ptr<TtsClip>> promise;
+        TtsFuture future;
+    };
+
+    void Run();
+    void Synthesize(ISpVoice* voice, const Job& job, TtsClip& clip);
+
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable wake;
+    bool stopping = false;
+    std::deque<std::shared_ptr<Job>> jobs;
+};
+
 // Class to handle text-to-speech operations
 class TextToSpeech {
 private:
     bool initialized;
-    CComPtr<ISpVoice> pVoice;                  // SAPI voice
+    CComPtr<ISpVoice> pVoice;                  // SAPI voice, used to list the installed voices
     std::vector<VoiceInfo> availableVoices;    // Available voices
-
-    // Memory stream for audio data
-    CComPtr<ISpStream> pStream;
-    CComPtr<IStream> pMemStream;
-
-    // Last generated speech data
-    BYTE* pSpeechData;
-    ULONG speechDataSize;
+    std::wstring currentVoiceId;               // Voice for SpeakText, empty for the default
+
+    // Phrases being synthesized; Update hands each to the sound engine once it lands
+    struct PendingSpeech {
+        TtsFuture clip;
+        uint64_t key = 0;           // TtsPhraseKey of the voice and text
+        std::string soundPath;      // SoundID path, "tts:..." or a phrase path
+        std::string pcmKey;         // Disk cache key, permanent sounds only
+        std::string name;           // Display name, permanent sounds only
+        bool permanent = false;
+        bool play = false;          // Play as soon as it is ready
+        float volume = 1.0f;
+        float pan = 0.0f;
+    };
+    std::unique_ptr<TtsWorker> worker;
+    std::vector<PendingSpeech> pending;
+
+    // Every synthesized clip, so a phrase is synthesized once while it is in use. Spoken
+    // phrases are temporary engine sounds that go when their clip is evicted; phrases
+    // the timers use are pinned.
+    TtsClipCache clipCache;
+    int cacheBudgetMB = -1;
+    uint64_t pinnedTimersVersion = 0;
+    std::chrono::steady_clock::time_point pinnedRefreshed;
 
     // Helper methods
     bool EnumerateVoices();
+    std::wstring VoiceIdFor(int voiceIndex) const;
+    void RefreshPinnedPhrases();
+    void ReleasePhrases(const std::vector<uint64_t>& keys);
+    static SoundData ClipSoundData(const std::shared_ptr<TtsClip>& clip, float volume, float pan);
+
+    // Puts a TTS sound in the sound engine from the disk or clip cache, or queues its
+    // synthesis, without touching settings. Returns the sound's path.
+    std::string LoadTtsSound(const std::string& text, const std::string& name,
+        int voiceIndex, float volume, float pan, bool urgent);
+
+    // Saved TTS sounds are "tts:<voice index or default>:<text>"
+    static bool ParseTtsPath(const std::string& path, int& voiceIndex, std::string& text);
 
 public:
     TextToSpeech();
@@ -108,23 +189,47 @@ public:
     const std::vector<VoiceInfo>& GetAvailableVoices() const { return availableVoices; }
     bool SetVoice(int voiceIndex);
 
-    // Speech generation
-    bool TextToWav(const std::wstring& text, BYTE** ppData, ULONG* pDataSize, WAVEFORMATEX* pWaveFormat);
+    // Render thread: hand finished phrases to the sound engine
+    void Update();
+
+    // Clip cache budget, 0 for no limit, and statistics
+    int GetCacheBudgetMB() const { return cacheBudgetMB; }
+    void SetCacheBudgetMB(int megabytes);
+
+    // Picks up the budget from the settings snapshot, e.g. after a reload
+    void SyncFromSettings();
+    TtsCacheStats GetCacheStats() const { return clipCache.GetStats(); }
+    void ResetCacheStats() { clipCache.ResetStats(); }
+
+    // A saved TTS sound still being synthesized; plays of it wait for it
+    bool IsSynthesizing(const SoundID& soundId) const;
+
+    // Have a TTS sound a timer uses ready before the timer needs it: one still queued moves
+    // to the front, one that isn't loaded is synthesized again
+    void Prewarm(const SoundID& soundId);
 
     // Helper for converting between string types
     static std::wstring StringToWString(const std::string& text);
     static std::string WStringToString(const std::wstring& text);
 
-    // Play text directly (convenience method that uses SoundEngine)
+    // Play text directly (convenience method that uses SoundEngine). Synthesized in the
+    // background, it plays when ready.
     bool SpeakText(const std::string& text, float volume = 1.0f, float pan = 0.0f);
 
-    // Add TTS sound to the sound engine (for selecting in UI)
+    // Add TTS sound to the sound engine (for selecting in UI). Served from the disk cache
+    // when it can be, otherwise it joins the sound list once synthesized.
     bool CreateTtsSound(const std::string& text, const std::string& name,
         int voiceIndex = -1, float volume = 1.0f, float pan = 0.0f);
+
+    // Disk cache key of a saved TTS sound, by the voice's own ID rather than its index
+    std::string PcmKeyFor(int voiceIndex, const std::string& text) const;
 };
 
 // Global TTS engine
 extern TextToSpeech* g_TextToSpeech;
 
 // Helper function to speak text
-bool PlayTtsNotification(const std::string& text, float volume = 1.0f, float pan = 0.0f);
\ No newline at end of file
+bool PlayTtsNotification(const std::string& text, float volume = 1.0f, float pan = 0.0f);
+
+// Prewarm the TTS sounds a timer plays, when it is saved or loaded
+void PrewarmTimerSpeech(const TimerData& timer);
\ No newline at end of file
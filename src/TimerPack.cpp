@@ -0,0 +1,364 @@
+#define NOMINMAX
+#include "TimerPack.h"
+#include "settings.h"
+#include "shared.h"
+#include <fstream>
+#include <filesystem>
+#include <algorithm>
+
+// Global timer pack transfer instance
+TimerPackTransfer* g_TimerPack = nullptr;
+
+static const char* const PackFormat = "simple-timers-pack";
+static const int PackVersion = 1;
+
+TimerPackTransfer::TimerPackTransfer() {}
+
+TimerPackTransfer::~TimerPackTransfer() {
+    Cancel();
+}
+
+void TimerPackTransfer::JoinWorker() {
+    if (worker.joinable()) {
+        worker.join();
+    }
+}
+
+void TimerPackTransfer::Fail(const std::string& message) {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        statusMessage = message;
+    }
+    state = State::Failed;
+
+    if (APIDefs) {
+        char logMsg[512];
+        sprintf_s(logMsg, "Timer pack: %s", message.c_str());
+        APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, logMsg);
+    }
+}
+
+bool TimerPackTransfer::StartImport(const std::string& path) {
+    if (IsBusy()) return false;
+    JoinWorker();
+
+    bytesTotal = 0;
+    bytesProcessed = 0;
+    timersProcessed = 0;
+    linesSkipped = 0;
+    timersInserted = 0;
+    cancelRequested = false;
+    workerDone = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readyBatches.clear();
+        statusMessage.clear();
+    }
+
+    lastWasImport = true;
+    state = State::Importing;
+    worker = std::thread(&TimerPackTransfer::ImportWorker, this, path);
+    return true;
+}
+
+bool TimerPackTransfer::StartExport(const std::string& path) {
+    if (IsBusy()) return false;
+    JoinWorker();
+
+    // Snapshot local timers; room timers belong to their room
+    std::vector<TimerData> snapshot;
+    {
+        std::lock_guard<std::mutex> lock(Settings::Mutex);
+        snapshot.reserve(Settings::timers.size());
+        for (const auto& timer : Settings::timers) {
+            if (!timer.isRoomTimer) {
+                snapshot.push_back(timer);
+            }
+        }
+    }
+
+    bytesTotal = snapshot.size();
+    bytesProcessed = 0;
+    timersProcessed = 0;
+    linesSkipped = 0;
+    cancelRequested = false;
+    workerDone = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        statusMessage.clear();
+    }
+
+    lastWasImport = false;
+    state = State::Exporting;
+    worker = std::thread(&TimerPackTransfer::ExportWorker, this, path, std::move(snapshot));
+    return true;
+}
+
+// Timers an import already put into Settings stay: registered and saved like a finished import
+void TimerPackTransfer::KeepInserted() {
+    while (!pendingRegistrations.empty()) {
+        RegisterTimerKeybind(pendingRegistrations.front());
+        pendingRegistrations.pop_front();
+    }
+    if (timersInserted > 0 && !SettingsPath.empty()) {
+        Settings::ScheduleSave(SettingsPath);
+    }
+    timersInserted = 0;
+}
+
+void TimerPackTransfer::Cancel() {
+    cancelRequested = true;
+    JoinWorker();
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        readyBatches.clear();
+    }
+    State current = state.load();
+    if (current == State::Importing || current == State::Failed) {
+        KeepInserted();
+    }
+    if (IsBusy()) {
+        state = State::Idle;
+    }
+}
+
+void TimerPackTransfer::ImportWorker(std::string path) {
+    std::ifstream file(std::filesystem::u8path(path), std::ios::binary);
+    if (!file.is_open()) {
+        Fail("could not open " + path);
+        workerDone = true;
+        return;
+    }
+
+    file.seekg(0, std::ios::end);
+    bytesTotal = static_cast<uint64_t>(std::max<std::streamoff>(0, file.tellg()));
+    file.seekg(0, std::ios::beg);
+
+    std::vector<TimerData> batch;
+    batch.reserve(BatchSize);
+
+    auto flush = [this, &batch]() {
+        if (batch.empty()) return;
+        std::lock_guard<std::mutex> lock(mutex);
+        readyBatches.push_back(std::move(batch));
+        batch = std::vector<TimerData>();
+        batch.reserve(BatchSize);
+    };
+
+    std::string line;
+    while (!cancelRequested && std::getline(file, line)) {
+        bytesProcessed += line.size() + 1;
+
+        if (!line.empty() && line.back() == '\r') {
+            line.pop_back();
+        }
+        if (line.find_first_not_of(" \t") == std::string::npos) {
+            continue;
+        }
+
+        json j = json::parse(line, nullptr, false);
+        if (j.is_discarded() || !j.is_object()) {
+            linesSkipped++;
+            continue;
+        }
+
+        if (j.contains("format")) {
+            if (j["format"] != PackFormat) {
+                Fail("not a timer pack: " + path);
+                workerDone = true;
+                return;
+            }
+            continue;
+        }
+
+        TimerData timer = TimerData::fromJson(j);
+
+        // Packs are shared between players, never reuse the ids they carry
+        timer.id = TimerData::generateUniqueId("timer_");
+        timer.isRoomTimer = false;
+        timer.roomId.clear();
+
+        batch.push_back(std::move(timer));
+        timersProcessed++;
+
+        if (batch.size() >= BatchSize) {
+            flush();
+        }
+    }
+
+    flush();
+    workerDone = true;
+}
+
+void TimerPackTransfer::ExportWorker(std::string path, std::vector<TimerData> snapshot) {
+    // Write next to the target and swap it in, so a cancelled export never leaves half a pack
+    std::filesystem::path target = std::filesystem::u8path(path);
+    std::filesystem::path temp = target;
+    temp += ".tmp";
+
+    {
+        std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            Fail("could not write " + path);
+            workerDone = true;
+            return;
+        }
+
+        json header = json::object();
+        header["format"] = PackFormat;
+        header["version"] = PackVersion;
+        header["count"] = snapshot.size();
+        file << header.dump() << '\n';
+
+        for (const auto& timer : snapshot) {
+            if (cancelRequested) break;
+
+            file << timer.toJson().dump() << '\n';
+            timersProcessed++;
+            bytesProcessed++;
+        }
+
+        if (!file.good()) {
+            file.close();
+            std::error_code ec;
+            std::filesystem::remove(temp, ec);
+            Fail("write error while exporting " + path);
+            workerDone = true;
+            return;
+        }
+    }
+
+    std::error_code ec;
+    if (cancelRequested) {
+        std::filesystem::remove(temp, ec);
+    }
+    else {
+        std::filesystem::rename(temp, target, ec);
+        if (ec) {
+            std::filesystem::remove(temp, ec);
+            Fail("could not replace " + path);
+        }
+    }
+
+    workerDone = true;
+}
+
+void TimerPackTransfer::Update() {
+    State current = state.load();
+
+    // An import that failed part way keeps what it already added, batches not yet added are dropped
+    if (current == State::Failed && lastWasImport && workerDone && (timersInserted > 0 || !pendingRegistrations.empty())) {
+        JoinWorker();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            readyBatches.clear();
+        }
+        KeepInserted();
+        return;
+    }
+    if (current != State::Importing && current != State::Exporting) return;
+
+    if (current == State::Importing) {
+        // Everything parsed since last frame goes into Settings under a single lock
+        std::deque<std::vector<TimerData>> batches;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            batches.swap(readyBatches);
+        }
+
+        if (!batches.empty()) {
+            size_t count = 0;
+            for (const auto& batch : batches) {
+                count += batch.size();
+            }
+
+            std::vector<TimerData> merged;
+            merged.reserve(count);
+            activeTimers.reserve(activeTimers.size() + count);
+            for (auto& batch : batches) {
+                for (auto& timer : batch) {
+                    // Ids are fresh, so skip addOrUpdateActiveTimer's linear search
+                    activeTimers.push_back(ActiveTimer(timer.id, timer.duration, true));
+                    pendingRegistrations.push_back(timer.id);
+                    merged.push_back(std::move(timer));
+                }
+            }
+
+            Settings::AddTimers(std::move(merged));
+            timersInserted += count;
+        }
+
+        // Keybind registration goes through Nexus, spread it over frames
+        for (size_t i = 0; i < KeybindsPerFrame && !pendingRegistrations.empty(); i++) {
+            RegisterTimerKeybind(pendingRegistrations.front());
+            pendingRegistrations.pop_front();
+        }
+    }
+
+    if (!workerDone) return;
+
+    bool drained;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        drained = readyBatches.empty();
+    }
+    if (!drained || !pendingRegistrations.empty()) return;
+
+    JoinWorker();
+    if (state.load() == State::Failed) {
+        KeepInserted();
+        return;
+    }
+
+    if (current == State::Importing && timersInserted > 0 && !SettingsPath.empty()) {
+        Settings::ScheduleSave(SettingsPath);
+    }
+
+    state = State::Done;
+
+    if (APIDefs) {
+        char logMsg[256];
+        if (current == State::Importing) {
+            sprintf_s(logMsg, "Imported %zu timers (%zu lines skipped)", timersInserted, linesSkipped.load());
+        }
+        else {
+            sprintf_s(logMsg, "Exported %zu timers", timersProcessed.load());
+        }
+        APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
+    }
+}
+
+float TimerPackTransfer::GetProgress() const {
+    if (state.load() == State::Done) return 1.0f;
+
+    uint64_t total = bytesTotal.load();
+    if (total == 0) return 0.0f;
+    return std::min(1.0f, static_cast<float>(bytesProcessed.load()) / static_cast<float>(total));
+}
+
+std::string TimerPackTransfer::GetStatusText() const {
+    char text[256];
+    switch (state.load()) {
+    case State::Importing:
+        sprintf_s(text, "Importing... %zu timers read", timersProcessed.load());
+        return text;
+    case State::Exporting:
+        sprintf_s(text, "Exporting... %zu timers written", timersProcessed.load());
+        return text;
+    case State::Done:
+        if (lastWasImport) {
+            sprintf_s(text, "Imported %zu timers (%zu lines skipped)", timersInserted, linesSkipped.load());
+        }
+        else {
+            sprintf_s(text, "Exported %zu timers", timersProcessed.load());
+        }
+        return text;
+    case State::Failed: {
+        std::lock_guard<std::mutex> lock(mutex);
+        return "Failed: " + statusMessage;
+    }
+    default:
+        return "";
+    }
+}
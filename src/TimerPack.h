@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <atomic>
+
+struct TimerData;
+
+// Streaming import/export of timer packs.
+//
+// A pack is newline-delimited JSON: an optional header line
+// {"format":"simple-timers-pack","version":1,"count":N} followed by one timer object
+// per line, in the same shape settings.json uses. Parsing and writing happen on a
+// worker thread; Update() moves parsed batches into Settings on the render thread
+// and registers keybinds a few per frame so a large pack never stalls a frame.
+class TimerPackTransfer {
+public:
+    enum class State {
+        Idle,
+        Importing,
+        Exporting,
+        Done,
+        Failed
+    };
+
+    TimerPackTransfer();
+    ~TimerPackTransfer();
+
+    bool StartImport(const std::string& path);
+    bool StartExport(const std::string& path);
+    void Cancel();
+
+    // Call once per frame from the render thread
+    void Update();
+
+    State GetState() const { return state.load(); }
+    bool IsBusy() const { State s = state.load(); return s == State::Importing || s == State::Exporting; }
+    float GetProgress() const;
+    std::string GetStatusText() const;
+
+private:
+    static const size_t BatchSize = 512;            // Timers per batch handed to the render thread
+    static const size_t KeybindsPerFrame = 64;      // Nexus keybind registrations per frame
+
+    void ImportWorker(std::string path);
+    void ExportWorker(std::string path, std::vector<TimerData> snapshot);
+    void Fail(const std::string& message);
+    void JoinWorker();
+    void KeepInserted();
+
+    std::thread worker;
+    std::atomic<State> state{ State::Idle };
+    std::atomic<bool> cancelRequested{ false };
+    std::atomic<bool> workerDone{ false };
+
+    // Progress, written by the worker and read by the UI
+    std::atomic<uint64_t> bytesTotal{ 0 };
+    std::atomic<uint64_t> bytesProcessed{ 0 };
+    std::atomic<size_t> timersProcessed{ 0 };
+    std::atomic<size_t> linesSkipped{ 0 };
+
+    // Render thread only
+    bool lastWasImport = false;
+    size_t timersInserted = 0;
+    std::deque<std::string> pendingRegistrations;    // Timer ids still waiting for a keybind
+
+    mutable std::mutex mutex;
+    std::deque<std::vector<TimerData>> readyBatches;
+    std::string statusMessage;
+};
+
+extern TimerPackTransfer* g_TimerPack;
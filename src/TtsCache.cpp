@@ -0,0 +1,114 @@
+#include "TtsCache.h"
+#include <algorithm>
+#include <cstdio>
+
+static const uint64_t FnvOffset = 14695981039346656037ull;
+static const uint64_t FnvPrime = 1099511628211ull;
+
+static uint64_t HashBytes(const void* data, size_t size, uint64_t hash = FnvOffset) {
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t i = 0; i < size; i++) {
+        hash = (hash ^ bytes[i]) * FnvPrime;
+    }
+    return hash;
+}
+
+uint64_t TtsPhraseKey(const std::wstring& voiceId, const std::string& text) {
+    // The separator keeps "ab"+"c" apart from "a"+"bc"; 0 is never a key
+    uint64_t hash = HashBytes(voiceId.data(), voiceId.size() * sizeof(wchar_t));
+    hash = HashBytes("\0", 1, hash);
+    hash = HashBytes(text.data(), text.size(), hash);
+    return hash != 0 ? hash : 1;
+}
+
+std::string TtsPhrasePath(uint64_t key) {
+    char path[32];
+    snprintf(path, sizeof(path), "tts-phrase:%016llx", static_cast<unsigned long long>(key));
+    return path;
+}
+
+std::shared_ptr<TtsClip> TtsClipCache::Find(uint64_t key) {
+    auto it = entries.find(key);
+    if (it == entries.end()) {
+        misses++;
+        return nullptr;
+    }
+    hits++;
+    it->second.lastUsed = ++tick;
+    return it->second.clip;
+}
+
+std::vector<uint64_t> TtsClipCache::Insert(uint64_t key, std::shared_ptr<TtsClip> clip, size_t bytes) {
+    Entry& entry = entries[key];
+    totalBytes -= entry.bytes;
+    entry.clip = std::move(clip);
+    entry.bytes = bytes;
+    entry.lastUsed = ++tick;
+    totalBytes += bytes;
+    return EvictExcept(key);
+}
+
+std::vector<uint64_t> TtsClipCache::SetPinned(std::unordered_set<uint64_t> keys) {
+    pinned.swap(keys);
+    return EvictExcept(0);
+}
+
+std::vector<uint64_t> TtsClipCache::EvictExcept(uint64_t keep) {
+    std::vector<uint64_t> evicted;
+    if (budget == 0 || totalBytes <= budget) return evicted;
+
+    std::vector<std::pair<uint64_t, uint64_t>> candidates;
+    for (const auto& [key, entry] : entries) {
+        if (key == keep || pinned.find(key) != pinned.end()) continue;
+        candidates.emplace_back(entry.lastUsed, key);
+    }
+    std::sort(candidates.begin(), candidates.end());
+
+    for (const auto& candidate : candidates) {
+        if (totalBytes <= budget) break;
+
+        auto it = entries.find(candidate.second);
+        totalBytes -= it->second.bytes;
+        entries.erase(it);
+        evicted.push_back(candidate.second);
+    }
+    evictions += evicted.size();
+    return evicted;
+}
+
+void TtsClipCache::RecordSynthesis(double milliseconds) {
+    synthesized++;
+    synthesisMs += milliseconds;
+    maxSynthesisMs = (std::max)(maxSynthesisMs, milliseconds);
+}
+
+TtsCacheStats TtsClipCache::GetStats() const {
+    TtsCacheStats stats;
+    stats.budgetBytes = budget;
+    stats.bytes = totalBytes;
+    stats.clips = entries.size();
+    for (const auto& key : pinned) {
+        stats.pinnedClips += entries.count(key);
+    }
+    stats.hits = hits;
+    stats.misses = misses;
+    stats.evictions = evictions;
+    stats.synthesized = synthesized;
+    stats.synthesisMs = synthesisMs;
+    stats.maxSynthesisMs = maxSynthesisMs;
+    return stats;
+}
+
+void TtsClipCache::ResetStats() {
+    hits = 0;
+    misses = 0;
+    evictions = 0;
+    synthesized = 0;
+    synthesisMs = 0.0;
+    maxSynthesisMs = 0.0;
+}
+
+void TtsClipCache::Clear() {
+    entries.clear();
+    totalBytes = 0;
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <memory>
+#include <unordered_map>
+#include <unordered_set>
+
+// A synthesized phrase, see TextToSpeech.h. The cache only holds them, so it builds
+// without the Windows headers the clip's format needs.
+struct TtsClip;
+
+// Phrases are identified by a hash of the voice's token ID and the text, so the same
+// words in another voice are another phrase. Spoken phrases play as engine sounds
+// under the path TtsPhrasePath gives for their key.
+uint64_t TtsPhraseKey(const std::wstring& voiceId, const std::string& text);
+std::string TtsPhrasePath(uint64_t key);
+
+// TTS clip cache usage, see TtsClipCache::GetStats
+struct TtsCacheStats {
+    size_t budgetBytes = 0;         // 0 when there is no limit
+    size_t bytes = 0;               // Clips and the engine's copies of spoken phrases
+    size_t clips = 0;
+    size_t pinnedClips = 0;         // Phrases a timer uses, never evicted
+    uint64_t hits = 0;              // Lookups served without synthesizing
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t synthesized = 0;
+    double synthesisMs = 0.0;       // Total worker time for those
+    double maxSynthesisMs = 0.0;
+
+    double HitRate() const { return hits + misses > 0 ? static_cast<double>(hits) / static_cast<double>(hits + misses) : 0.0; }
+};
+
+// Synthesized clips kept by phrase key under a byte budget, least recently used evicted
+// first. Render thread only.
+class TtsClipCache {
+public:
+    void SetBudget(size_t bytes) { budget = bytes; }
+
+    // The clip for a phrase, counted as a hit or a miss and marked used
+    std::shared_ptr<TtsClip> Find(uint64_t key);
+
+    // bytes is everything the phrase holds in memory. Returns the keys evicted to make room;
+    // the phrase just added is kept even when it alone is over the budget.
+    std::vector<uint64_t> Insert(uint64_t key, std::shared_ptr<TtsClip> clip, size_t bytes);
+
+    // Replaces the pinned set; returns the keys evicted now that fewer may be pinned
+    std::vector<uint64_t> SetPinned(std::unordered_set<uint64_t> keys);
+    const std::unordered_set<uint64_t>& GetPinned() const { return pinned; }
+
+    // Over budget after a change to it
+    std::vector<uint64_t> Evict() { return EvictExcept(0); }
+
+    void RecordSynthesis(double milliseconds);
+    TtsCacheStats GetStats() const;
+    void ResetStats();
+    void Clear();
+
+private:
+    struct Entry {
+        std::shared_ptr<TtsClip> clip;
+        size_t bytes = 0;
+        uint64_t lastUsed = 0;
+    };
+
+    std::vector<uint64_t> EvictExcept(uint64_t keep);
+
+    std::unordered_map<uint64_t, Entry> entries;
+    std::unordered_set<uint64_t> pinned;
+    size_t budget = 0;
+    size_t totalBytes = 0;
+    uint64_t tick = 0;
+
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    uint64_t evictions = 0;
+    uint64_t synthesized = 0;
+    double synthesisMs = 0.0;
+    double maxSynthesisMs = 0.0;
+};
@@ -0,0 +1,434 @@
+#include "XAudio2Backend.h"
+#include <mmdeviceapi.h>
+#include <Functiondiscoverykeys_devpkey.h>
+#include <vector>
+
+// Source voice plus the callback XAudio2 reports buffer events to
+class XAudio2Voice : public IAudioVoice, private IXAudio2VoiceCallback {
+public:
+    XAudio2Voice(XAudio2Backend* voiceOwner, const AudioFormat& voiceFormat) : owner(voiceOwner), format(voiceFormat) {
+        owner->voices.insert(this);
+    }
+
+    ~XAudio2Voice() override {
+        owner->voices.erase(this);
+        if (pSourceVoice) {
+            pSourceVoice->DestroyVoice();
+            pSourceVoice = nullptr;
+        }
+    }
+
+    bool Create(IXAudio2* pXAudio2) {
+        WAVEFORMATEX wfx = {};
+        wfx.wFormatTag = format.formatTag;
+        wfx.nChannels = format.channels;
+        wfx.nSamplesPerSec = format.sampleRate;
+        wfx.wBitsPerSample = format.bitsPerSample;
+        wfx.nBlockAlign = static_cast<WORD>(format.BlockAlign());
+        wfx.nAvgBytesPerSec = format.sampleRate * wfx.nBlockAlign;
+        wfx.cbSize = 0;
+
+        HRESULT hr = pXAudio2->CreateSourceVoice(&pSourceVoice, &wfx,
+            0, XAUDIO2_DEFAULT_FREQ_RATIO, this);
+        if (FAILED(hr)) {
+            pSourceVoice = nullptr;
+            return false;
+        }
+        return true;
+    }
+
+    const AudioFormat& GetFormat() const override { return format; }
+
+    bool Submit(const uint8_t* data, uint32_t bytes, bool endOfStream) override {
+        XAUDIO2_BUFFER buffer = { 0 };
+        buffer.pAudioData = data;
+        buffer.AudioBytes = bytes;
+        buffer.Flags = endOfStream ? XAUDIO2_END_OF_STREAM : 0;
+        return SUCCEEDED(pSourceVoice->SubmitSourceBuffer(&buffer));
+    }
+
+    void EndStream() override {
+        // OnStreamEnd fires once the buffers already queued have played
+        pSourceVoice->Discontinuity();
+    }
+
+    uint32_t GetQueuedBuffers() const override {
+        XAUDIO2_VOICE_STATE state;
+        pSourceVoice->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+        return state.BuffersQueued;
+    }
+
+    bool Start() override {
+        return SUCCEEDED(pSourceVoice->Start(0));
+    }
+
+    void Reset() override {
+        pSourceVoice->Stop(0);
+        pSourceVoice->FlushSourceBuffers();
+    }
+
+    void SetVolume(float volume) override {
+        pSourceVoice->SetVolume(volume);
+    }
+
+    void SetPan(float voicePan) override {
+        pan = voicePan;
+        hasPan = true;
+        float matrix[4];
+        ComputeStereoPanMatrix(format.channels, pan, matrix);
+        pSourceVoice->SetOutputMatrix(nullptr, format.channels, 2, matrix);
+    }
+
+    // Send to the mastering voice, or nowhere while it is being replaced. A voice that sends
+    // nowhere still plays, so its position and queued buffers survive the switch.
+    void Route(bool attached) {
+        if (!pSourceVoice) return;
+        if (attached) {
+            pSourceVoice->SetOutputVoices(nullptr);
+            // New sends start with the default matrix
+            if (hasPan) {
+                SetPan(pan);
+            }
+        }
+        else {
+            XAUDIO2_VOICE_SENDS none = { 0, nullptr };
+            pSourceVoice->SetOutputVoices(&none);
+        }
+    }
+
+private:
+    // Voice events we care about
+    void STDMETHODCALLTYPE OnStreamEnd() override { NotifyFinished(); }
+    void STDMETHODCALLTYPE OnBufferStart(void* pBufferContext) override { NotifyStarted(); }
+
+    // Required but unused callbacks
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 SamplesRequired) override {}
+    void STDMETHODCALLTYPE OnBufferEnd(void* pBufferContext) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void* pBufferContext) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void* pBufferContext, HRESULT Error) override {}
+
+    XAudio2Backend* owner;
+    AudioFormat format;
+    IXAudio2SourceVoice* pSourceVoice = nullptr;
+    float pan = 0.0f;
+    bool hasPan = false;
+};
+
+// Streaming source voice that renders its next buffer as soon as one finishes playing.
+// Three 10 ms blocks are kept queued, so the render callback runs on XAudio2's thread
+// about 20 ms ahead of what is heard.
+class XAudio2RenderStream : private IXAudio2VoiceCallback {
+public:
+    static const int BlockCount = 3;
+
+    XAudio2RenderStream(const AudioFormat& streamFormat, const AudioRenderCallback& renderCallback)
+        : format(streamFormat), render(renderCallback), blockFrames(streamFormat.sampleRate / 100) {}
+
+    ~XAudio2RenderStream() {
+        // Waits for a callback in progress, none run after this
+        if (pSourceVoice) {
+            pSourceVoice->DestroyVoice();
+            pSourceVoice = nullptr;
+        }
+    }
+
+    bool Start(IXAudio2* pXAudio2) {
+        WAVEFORMATEX wfx = {};
+        wfx.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+        wfx.nChannels = format.channels;
+        wfx.nSamplesPerSec = format.sampleRate;
+        wfx.wBitsPerSample = 32;
+        wfx.nBlockAlign = static_cast<WORD>(format.BlockAlign());
+        wfx.nAvgBytesPerSec = format.sampleRate * wfx.nBlockAlign;
+
+        if (FAILED(pXAudio2->CreateSourceVoice(&pSourceVoice, &wfx, 0, XAUDIO2_DEFAULT_FREQ_RATIO, this))) {
+            pSourceVoice = nullptr;
+            return false;
+        }
+
+        for (int i = 0; i < BlockCount; i++) {
+            blocks[i].resize(static_cast<size_t>(blockFrames) * format.channels);
+            SubmitBlock(i);
+        }
+        return SUCCEEDED(pSourceVoice->Start(0));
+    }
+
+    // Same as XAudio2Voice::Route
+    void Route(bool attached) {
+        if (!pSourceVoice) return;
+        XAUDIO2_VOICE_SENDS none = { 0, nullptr };
+        pSourceVoice->SetOutputVoices(attached ? nullptr : &none);
+    }
+
+private:
+    void SubmitBlock(int index) {
+        std::vector<float>& block = blocks[index];
+        render(block.data(), blockFrames);
+
+        XAUDIO2_BUFFER buffer = { 0 };
+        buffer.pAudioData = reinterpret_cast<const BYTE*>(block.data());
+        buffer.AudioBytes = static_cast<UINT32>(block.size() * sizeof(float));
+        buffer.pContext = reinterpret_cast<void*>(static_cast<intptr_t>(index));
+        pSourceVoice->SubmitSourceBuffer(&buffer);
+    }
+
+    void STDMETHODCALLTYPE OnBufferEnd(void* pBufferContext) override {
+        SubmitBlock(static_cast<int>(reinterpret_cast<intptr_t>(pBufferContext)));
+    }
+
+    // Required but unused callbacks
+    void STDMETHODCALLTYPE OnStreamEnd() override {}
+    void STDMETHODCALLTYPE OnBufferStart(void* pBufferContext) override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32 SamplesRequired) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void* pBufferContext) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void* pBufferContext, HRESULT Error) override {}
+
+    AudioFormat format;
+    AudioRenderCallback render;
+    uint32_t blockFrames;
+    std::vector<float> blocks[BlockCount];
+    IXAudio2SourceVoice* pSourceVoice = nullptr;
+};
+
+XAudio2Backend::~XAudio2Backend() {
+    Shutdown();
+}
+
+bool XAudio2Backend::Initialize(const std::wstring& deviceId) {
+    if (pXAudio2) return true;
+
+    // Initialize XAudio2
+    HRESULT hr = XAudio2Create(&pXAudio2, 0, XAUDIO2_DEFAULT_PROCESSOR);
+    if (FAILED(hr)) {
+        pXAudio2 = nullptr;
+        return false;
+    }
+    pXAudio2->RegisterForCallbacks(this);
+
+    if (!CreateMasteringVoice(deviceId)) {
+        ReleaseEngine();
+        return false;
+    }
+
+    outputLost = false;
+    return true;
+}
+
+void XAudio2Backend::Shutdown() {
+    StopRenderStream();
+    ReleaseEngine();
+}
+
+void XAudio2Backend::ReleaseEngine() {
+    if (pMasteringVoice) {
+        pMasteringVoice->DestroyVoice();
+        pMasteringVoice = nullptr;
+    }
+
+    if (pXAudio2) {
+        pXAudio2->UnregisterForCallbacks(this);
+        pXAudio2->Release();
+        pXAudio2 = nullptr;
+    }
+}
+
+bool XAudio2Backend::CreateMasteringVoice(const std::wstring& deviceId) {
+    HRESULT hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
+        XAUDIO2_DEFAULT_SAMPLERATE, 0, deviceId.empty() ? nullptr : deviceId.c_str(), nullptr);
+
+    // If the specific device fails, try the default
+    if (FAILED(hr) && !deviceId.empty()) {
+        hr = pXAudio2->CreateMasteringVoice(&pMasteringVoice, XAUDIO2_DEFAULT_CHANNELS,
+            XAUDIO2_DEFAULT_SAMPLERATE, 0, nullptr, nullptr);
+    }
+
+    if (FAILED(hr)) {
+        pMasteringVoice = nullptr;
+        return false;
+    }
+    return true;
+}
+
+bool XAudio2Backend::SetOutputDevice(const std::wstring& deviceId) {
+    // After a critical error the engine is unusable and is built again from scratch. The caller
+    // has deleted the voices that died with it; the render stream is recreated here.
+    if (outputLost) {
+        DestroyRenderStream();
+        ReleaseEngine();
+        if (!Initialize(deviceId)) {
+            return false;
+        }
+        if (renderCallback) {
+            CreateRenderStream();
+        }
+        return true;
+    }
+
+    if (!pXAudio2) return false;
+
+    // A mastering voice can't be destroyed while anything sends to it, so every source voice
+    // is detached, the mastering voice replaced, and the voices attached to the new one
+    for (XAudio2Voice* voice : voices) {
+        voice->Route(false);
+    }
+    if (pRenderStream) {
+        pRenderStream->Route(false);
+    }
+
+    if (pMasteringVoice) {
+        pMasteringVoice->DestroyVoice();
+        pMasteringVoice = nullptr;
+    }
+
+    // Not even the default device opened; treat it like a lost output so it's rebuilt later
+    if (!CreateMasteringVoice(deviceId)) {
+        outputLost = true;
+        return false;
+    }
+
+    for (XAudio2Voice* voice : voices) {
+        voice->Route(true);
+    }
+    if (pRenderStream) {
+        pRenderStream->Route(true);
+    }
+    return true;
+}
+
+bool XAudio2Backend::StartRenderStream(const AudioFormat& format, AudioRenderCallback render) {
+    if (!pXAudio2 || !pMasteringVoice || !render) return false;
+    if (format.formatTag != AudioFormat::Float || !format.IsValid()) return false;
+
+    StopRenderStream();
+    renderFormat = format;
+    renderCallback = std::move(render);
+    if (!CreateRenderStream()) {
+        renderCallback = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void XAudio2Backend::StopRenderStream() {
+    DestroyRenderStream();
+    renderCallback = nullptr;
+}
+
+bool XAudio2Backend::CreateRenderStream() {
+    pRenderStream = new XAudio2RenderStream(renderFormat, renderCallback);
+    if (!pRenderStream->Start(pXAudio2)) {
+        DestroyRenderStream();
+        return false;
+    }
+    return true;
+}
+
+void XAudio2Backend::DestroyRenderStream() {
+    delete pRenderStream;
+    pRenderStream = nullptr;
+}
+
+IAudioVoice* XAudio2Backend::CreateVoice(const AudioFormat& format) {
+    if (!pXAudio2 || !pMasteringVoice || !format.IsValid()) return nullptr;
+
+    XAudio2Voice* voice = new XAudio2Voice(this, format);
+    if (!voice->Create(pXAudio2)) {
+        delete voice;
+        return nullptr;
+    }
+    return voice;
+}
+
+bool XAudio2Backend::EnumerateDevices(std::vector<AudioDevice>& devices) {
+    devices.clear();
+
+    // Initialize COM if needed
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    bool needsUninitialize = SUCCEEDED(hr);
+
+    // Create device enumerator
+    IMMDeviceEnumerator* pEnumerator = nullptr;
+    hr = CoCreateInstance(__uuidof(MMDeviceEnumerator), nullptr, CLSCTX_ALL,
+        __uuidof(IMMDeviceEnumerator), (void**)&pEnumerator);
+
+    if (SUCCEEDED(hr)) {
+        // Get the default device ID
+        IMMDevice* pDefaultDevice = nullptr;
+        std::wstring defaultDeviceId;
+
+        hr = pEnumerator->GetDefaultAudioEndpoint(eRender, eConsole, &pDefaultDevice);
+        if (SUCCEEDED(hr)) {
+            LPWSTR deviceId = nullptr;
+            hr = pDefaultDevice->GetId(&deviceId);
+            if (SUCCEEDED(hr)) {
+                defaultDeviceId = deviceId;
+                CoTaskMemFree(deviceId);
+            }
+            pDefaultDevice->Release();
+        }
+
+        // Enumerate all devices
+        IMMDeviceCollection* pDevices = nullptr;
+        hr = pEnumerator->EnumAudioEndpoints(eRender, DEVICE_STATE_ACTIVE, &pDevices);
+
+        if (SUCCEEDED(hr)) {
+            UINT count;
+            hr = pDevices->GetCount(&count);
+
+            if (SUCCEEDED(hr)) {
+                for (UINT i = 0; i < count; i++) {
+                    IMMDevice* pDevice = nullptr;
+                    hr = pDevices->Item(i, &pDevice);
+
+                    if (SUCCEEDED(hr)) {
+                        // Get device ID
+                        LPWSTR deviceId = nullptr;
+                        hr = pDevice->GetId(&deviceId);
+
+                        if (SUCCEEDED(hr)) {
+                            // Get device properties
+                            IPropertyStore* pProps = nullptr;
+                            hr = pDevice->OpenPropertyStore(STGM_READ, &pProps);
+
+                            if (SUCCEEDED(hr)) {
+                                // Get friendly name
+                                PROPVARIANT varName;
+                                PropVariantInit(&varName);
+
+                                hr = pProps->GetValue(PKEY_Device_FriendlyName, &varName);
+                                if (SUCCEEDED(hr)) {
+                                    AudioDevice device;
+                                    device.id = deviceId;
+                                    device.name = varName.pwszVal;
+                                    device.isDefault = (defaultDeviceId == deviceId);
+                                    devices.push_back(device);
+
+                                    PropVariantClear(&varName);
+                                }
+
+                                pProps->Release();
+                            }
+
+                            CoTaskMemFree(deviceId);
+                        }
+
+                        pDevice->Release();
+                    }
+                }
+            }
+
+            pDevices->Release();
+        }
+
+        pEnumerator->Release();
+    }
+
+    // Uninitialize COM if we initialized it
+    if (needsUninitialize) {
+        CoUninitialize();
+    }
+
+    return !devices.empty();
+}
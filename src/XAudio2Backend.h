@@ -0,0 +1,56 @@
+#pragma once
+
+#include <Windows.h>
+#include <xaudio2.h>
+#include <set>
+#include <atomic>
+#include "AudioBackend.h"
+
+class XAudio2Voice;
+class XAudio2RenderStream;
+
+// IAudioBackend on XAudio2 with a mastering voice per output device.
+// Devices are listed through mmdeviceapi. Switching devices swaps the mastering voice
+// underneath the source voices, which carry on with their queued buffers.
+class XAudio2Backend : public IAudioBackend, private IXAudio2EngineCallback {
+private:
+    friend class XAudio2Voice;
+
+    IXAudio2* pXAudio2 = nullptr;                       // XAudio2 engine
+    IXAudio2MasteringVoice* pMasteringVoice = nullptr;  // Mastering voice
+    XAudio2RenderStream* pRenderStream = nullptr;       // Source voice fed from the render callback
+    std::set<XAudio2Voice*> voices;                     // Every live voice, rerouted on a device switch
+    std::atomic<bool> outputLost{ false };              // Set by OnCriticalError
+
+    // Kept so the render stream can be recreated on a new device
+    AudioFormat renderFormat;
+    AudioRenderCallback renderCallback;
+
+    bool CreateMasteringVoice(const std::wstring& deviceId);
+    bool CreateRenderStream();
+    void DestroyRenderStream();
+    void ReleaseEngine();
+
+    // Engine events; a critical error means the device is gone and the engine has to be recreated
+    void STDMETHODCALLTYPE OnCriticalError(HRESULT Error) override { outputLost = true; }
+    void STDMETHODCALLTYPE OnProcessingPassStart() override {}
+    void STDMETHODCALLTYPE OnProcessingPassEnd() override {}
+
+public:
+    XAudio2Backend() {}
+    ~XAudio2Backend() override;
+
+    const char* GetName() const override { return "XAudio2"; }
+
+    bool Initialize(const std::wstring& deviceId) override;
+    void Shutdown() override;
+
+    bool EnumerateDevices(std::vector<AudioDevice>& devices) override;
+    bool SetOutputDevice(const std::wstring& deviceId) override;
+    bool IsOutputLost() const override { return outputLost; }
+
+    IAudioVoice* CreateVoice(const AudioFormat& format) override;
+
+    bool StartRenderStream(const AudioFormat& format, AudioRenderCallback render) override;
+    void StopRenderStream() override;
+};
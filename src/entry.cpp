@@ -11,6 +11,8 @@
 #include "Sounds.h"  // Include the new Sound.h header
 #include "gui.h" 
 #include"wss.h"
+#include "SettingsWatcher.h"
+#include "TimerPack.h"
 
 /* proto */
 void AddonLoad(AddonAPI* aApi);
@@ -125,6 +127,11 @@ void AddonLoad(AddonAPI* aApi)
                         APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to load saved TTS sounds");
                     }
                 }
+
+                // Speech the timers use is synthesized first
+                for (const auto& timer : Settings::timers) {
+                    PrewarmTimerSpeech(timer);
+                }
             }
             else {
                 APIDefs->Log(ELogLevel_WARNING, ADDON_NAME, "Failed to initialize TTS engine");
@@ -200,6 +207,15 @@ void AddonLoad(AddonAPI* aApi)
     }
 
     initializeActiveTimers();
+
+    g_TimerPack = new TimerPackTransfer();
+
+    // Pick up external edits to settings.json without a game restart
+    g_SettingsWatcher = new SettingsWatcher();
+    if (!g_SettingsWatcher->Start(SettingsPath)) {
+        delete g_SettingsWatcher;
+        g_SettingsWatcher = nullptr;
+    }
 }
 ///----------------------------------------------------------------------------------------------------
 /// AddonUnload:
@@ -214,11 +230,30 @@ void AddonUnload() {
     APIDefs->Fonts.Release("SF FONT BIG", ReceiveFont);
     APIDefs->Fonts.Release("SF FONT GIANT", ReceiveFont);
 
+    if (g_TimerPack) {
+        g_TimerPack->Cancel();
+        delete g_TimerPack;
+        g_TimerPack = nullptr;
+    }
+
+    if (g_SettingsWatcher) {
+        g_SettingsWatcher->Stop();
+        delete g_SettingsWatcher;
+        g_SettingsWatcher = nullptr;
+    }
+
     // Unregister all keybinds
     for (const auto& timer : activeTimers) {
         UnregisterTimerKeybind(timer.id);
     }
 
+    // The TTS worker goes before the engine it hands sounds to
+    if (g_TextToSpeech) {
+        g_TextToSpeech->Shutdown();
+        delete g_TextToSpeech;
+        g_TextToSpeech = nullptr;
+    }
+
     if (g_SoundEngine) {
         g_SoundEngine->Shutdown();
         delete g_SoundEngine;
@@ -240,6 +275,18 @@ void AddonUnload() {
 
 void PreRender()
 {
+    if (g_SettingsWatcher) {
+        g_SettingsWatcher->ApplyPending();
+    }
+
+    if (g_TimerPack) {
+        g_TimerPack->Update();
+    }
+
+    if (g_TextToSpeech) {
+        g_TextToSpeech->Update();
+    }
+
     if (g_SoundEngine) {
         g_SoundEngine->Update();
     }
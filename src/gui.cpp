@@ -6,11 +6,15 @@
 #include "resource.h"
 #include "TextToSpeech.h"
 #include "wss.h"
+#include "TimerPack.h"
+#include "SoundPack.h"
 #include <vector>
 #include <string>
 #include <filesystem>
 #include <map>
 #include <algorithm>
+#include <future>
+#include <cmath>
 
 
 bool showCreateTimerWindow = false;
@@ -24,6 +28,103 @@ static bool g_connectionPending = false;
 static std::chrono::steady_clock::time_point g_nextConnectionAttempt;
 
 
+//-----------------------------------------------------------------
+// Helper: Import/export controls for timer packs (Timers tab).
+static void RenderTimerPackControls()
+{
+    if (!g_TimerPack)
+        return;
+
+    static char packPath[260] = "";
+    if (packPath[0] == '\0' && !AddonPath.empty()) {
+        strcpy_s(packPath, sizeof(packPath), (AddonPath + "/timers.ndjson").c_str());
+    }
+
+    ImGui::Spacing();
+    ImGui::Text("Timer Packs");
+    ImGui::Separator();
+
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.4f);
+    ImGui::InputText("##TimerPackPath", packPath, sizeof(packPath));
+    ImGui::PopItemWidth();
+
+    bool busy = g_TimerPack->IsBusy();
+    if (busy)
+        ImGui::PushStyleVar(ImGuiStyleVar_Alpha, 0.5f);
+    if (ImGui::Button("Import Pack") && !busy) {
+        g_TimerPack->StartImport(packPath);
+    }
+    ImGui::SameLine();
+    if (ImGui::Button("Export Pack") && !busy) {
+        g_TimerPack->StartExport(packPath);
+    }
+    if (busy)
+        ImGui::PopStyleVar();
+
+    if (busy) {
+        ImGui::SameLine();
+        if (ImGui::Button("Cancel##TimerPack")) {
+            g_TimerPack->Cancel();
+        }
+    }
+
+    TimerPackTransfer::State state = g_TimerPack->GetState();
+    if (state != TimerPackTransfer::State::Idle) {
+        ImGui::ProgressBar(g_TimerPack->GetProgress(), ImVec2(ImGui::GetContentRegionAvail().x * 0.4f, 0));
+        ImVec4 statusColor = state == TimerPackTransfer::State::Failed
+            ? ImVec4(1.0f, 0.4f, 0.4f, 1.0f)
+            : ImVec4(0.75f, 0.75f, 0.75f, 1.0f);
+        ImGui::TextColored(statusColor, "%s", g_TimerPack->GetStatusText().c_str());
+    }
+}
+
+//-----------------------------------------------------------------
+// Helper: Build a sound pack from a folder of sounds (Sounds tab).
+// Packing reads every file, so it runs off the render thread.
+static void RenderSoundPackControls(const char* sourceDir)
+{
+    static char packPath[260] = "";
+    static std::future<std::string> packJob;
+    static std::string packStatus;
+
+    if (packPath[0] == '\0' && !AddonPath.empty()) {
+        strcpy_s(packPath, sizeof(packPath), (AddonPath + "/callouts." + SoundPackExtension).c_str());
+    }
+
+    ImGui::Text("Sound Packs");
+    ImGui::PushItemWidth(ImGui::GetContentRegionAvail().x * 0.7f);
+    ImGui::InputText("##SoundPackPath", packPath, sizeof(packPath));
+    ImGui::PopItemWidth();
+
+    bool busy = packJob.valid() && packJob.wait_for(std::chrono::seconds(0)) != std::future_status::ready;
+    if (packJob.valid() && !busy) {
+        packStatus = packJob.get();
+    }
+
+    ImGui::SameLine();
+    if (busy)
+        ImGui::PushStyleVar(ImGuiStyleVar_Alpha, 0.5f);
+    if (ImGui::Button("Build Pack") && !busy && sourceDir[0] != '\0') {
+        std::string source = sourceDir;
+        std::string output = packPath;
+        packStatus = "Packing...";
+        packJob = std::async(std::launch::async, [source, output]() {
+            size_t count = 0;
+            std::string error;
+            if (!WriteSoundPack(source, output, count, error)) {
+                return "Failed: " + error;
+            }
+            return "Packed " + std::to_string(count) + " sounds into " + output;
+        });
+    }
+    if (busy)
+        ImGui::PopStyleVar();
+
+    if (!packStatus.empty()) {
+        ImGui::TextColored(ImVec4(0.75f, 0.75f, 0.75f, 1.0f), "%s", packStatus.c_str());
+    }
+}
+
 //-----------------------------------------------------------------
 // Helper: Render the header section with the title and add button.
 static void RenderTimersHeader()
@@ -78,6 +179,19 @@ static void RenderTimersHeader()
     ImGui::EndGroup();
 }
 
+//-----------------------------------------------------------------
+// Helper: Where a timer's sounds play from.
+static SoundEmitter TimerEmitter(const TimerData& timer)
+{
+    SoundEmitter emitter;
+    emitter.mode = static_cast<SpatialMode>(timer.spatialMode);
+    emitter.position[0] = timer.spatialX;
+    emitter.position[1] = timer.spatialY;
+    emitter.position[2] = timer.spatialZ;
+    emitter.mapId = static_cast<uint32_t>(timer.spatialMapId);
+    return emitter;
+}
+
 //-----------------------------------------------------------------
 // Helper: Render a single timer item.
 // Start a group for the timer row (containing timer and buttons)
@@ -321,19 +435,46 @@ static void RenderTimerItem(size_t index)
         SoundButton = APIDefs->Textures.GetOrCreateFromResource("SOUND_ICON", SOUND_ICON, hSelf);
     }
 
+    // A sound scheduled ahead is dropped if the timer was paused or reset before it started
+    if (activeTimer.scheduledWarning != 0 &&
+        (activeTimer.isPaused || activeTimer.remainingTime - settingsTimer->warningTime > ScheduledSoundLeadSeconds))
+    {
+        if (CancelSoundEffect(activeTimer.scheduledWarning) && activeTimer.isPaused)
+            activeTimer.warningPlayed = false;
+        activeTimer.scheduledWarning = 0;
+    }
+    if (activeTimer.endScheduled &&
+        (activeTimer.isPaused || activeTimer.remainingTime > ScheduledSoundLeadSeconds))
+    {
+        CancelSoundEffect(activeTimer.scheduledEnd);
+        activeTimer.scheduledEnd = 0;
+        activeTimer.endScheduled = false;
+    }
+
     // Update timer logic if not paused.
     if (!activeTimer.isPaused)
     {
         activeTimer.remainingTime -= ImGui::GetIO().DeltaTime;
+
+        // Sounds are scheduled a little ahead so they land on the exact moment, not on the
+        // first frame after it
         if (settingsTimer->useWarning && !activeTimer.warningPlayed &&
-            activeTimer.remainingTime <= settingsTimer->warningTime)
+            activeTimer.remainingTime - settingsTimer->warningTime <= ScheduledSoundLeadSeconds)
         {
-            PlaySoundEffect(settingsTimer->warningSound);
+            activeTimer.scheduledWarning = ScheduleSoundEffect(settingsTimer->warningSound,
+                activeTimer.remainingTime - settingsTimer->warningTime, AlertPriority::High, TimerEmitter(*settingsTimer));
             activeTimer.warningPlayed = true;
         }
+        if (!activeTimer.endScheduled && activeTimer.remainingTime <= ScheduledSoundLeadSeconds)
+        {
+            activeTimer.scheduledEnd = ScheduleSoundEffect(settingsTimer->endSound, activeTimer.remainingTime,
+                AlertPriority::Normal, TimerEmitter(*settingsTimer));
+            activeTimer.endScheduled = true;
+        }
         if (activeTimer.remainingTime <= 0.0f)
         {
-            PlaySoundEffect(settingsTimer->endSound);
+            activeTimer.scheduledEnd = 0;
+            activeTimer.endScheduled = false;
             activeTimer.remainingTime = settingsTimer->duration;
             activeTimer.isPaused = true;
             activeTimer.warningPlayed = false;
@@ -556,14 +697,17 @@ void RenderMainTimersWindow()
     }
     else
     {
-        std::string currentRoomId = Settings::GetCurrentRoom();
-        auto subscriptions = Settings::GetSubscriptionsForRoom(currentRoomId);
+        // Snapshot read, no settings lock or set copy on the frame path
+        auto roomState = Settings::GetRoomState();
+        auto subscriptionsIt = roomState->roomSubscriptions.find(roomState->currentRoomId);
+        const std::unordered_set<std::string>* subscriptions =
+            subscriptionsIt != roomState->roomSubscriptions.end() ? &subscriptionsIt->second : nullptr;
 
         for (size_t i = 0; i < activeTimers.size(); i++) {
             const auto& timer = activeTimers[i];
             // Only render local timers or subscribed room timers
             if (!timer.isRoomTimer() ||
-                (timer.isRoomTimer() && std::find(subscriptions.begin(), subscriptions.end(), timer.id) != subscriptions.end())) {
+                (subscriptions && subscriptions->count(timer.id) > 0)) {
                 RenderTimerItem(i);
             }
         }
@@ -725,7 +869,7 @@ void RenderCreateTimerWindow()
         if (ImGui::Button("Test"))
         {
             if (g_SoundEngine && selectedSoundIndex < static_cast<int>(soundIds.size()))
-                g_SoundEngine->PlaySound(soundIds[selectedSoundIndex]);
+                g_SoundEngine->PlaySound(soundIds[selectedSoundIndex], AlertPriority::Low);
         }
         ImGui::Spacing();
 
@@ -764,7 +908,7 @@ void RenderCreateTimerWindow()
             if (ImGui::Button("Test##warn"))
             {
                 if (g_SoundEngine && selectedWarningSoundIndex < static_cast<int>(soundIds.size()))
-                    g_SoundEngine->PlaySound(soundIds[selectedWarningSoundIndex]);
+                    g_SoundEngine->PlaySound(soundIds[selectedWarningSoundIndex], AlertPriority::Low);
             }
         }
         ImGui::Spacing();
@@ -819,6 +963,7 @@ void RenderCreateTimerWindow()
                         timer->warningTime = static_cast<float>(warningSeconds);
                         timer->warningSound = soundIds[selectedWarningSoundIndex];
                     }
+                    PrewarmTimerSpeech(*timer);
                     for (auto& activeTimer : activeTimers)
                     {
                         if (activeTimer.id == editTimerId)
@@ -872,6 +1017,7 @@ void RenderCreateTimerWindow()
                         newTimer.warningTime = static_cast<float>(warningSeconds);
                         newTimer.warningSound = soundIds[selectedWarningSoundIndex];
                     }
+                    PrewarmTimerSpeech(newTimer);
                     activeTimers.push_back(ActiveTimer(newTimer.id, newTimer.duration, true));
                     RegisterTimerKeybind(newTimer.id);
                 }
@@ -926,11 +1072,11 @@ void RenderRoomsTab() {
         int subscriptionCount = 0;
 
         {
-            std::lock_guard<std::mutex> lock(Settings::Mutex);
-            roomCount = Settings::websocket.roomSubscriptions.size();
+            auto roomState = Settings::GetRoomState();
+            roomCount = roomState->roomSubscriptions.size();
 
             // Count total subscriptions across all rooms
-            for (const auto& [roomId, timers] : Settings::websocket.roomSubscriptions) {
+            for (const auto& [roomId, timers] : roomState->roomSubscriptions) {
                 subscriptionCount += timers.size();
             }
         }
@@ -1012,9 +1158,9 @@ void RenderRoomsTab() {
 
             // Add badge for rooms with subscriptions
             {
-                std::lock_guard<std::mutex> lock(Settings::Mutex);
-                auto it = Settings::websocket.roomSubscriptions.find(room.id);
-                if (it != Settings::websocket.roomSubscriptions.end() && !it->second.empty()) {
+                auto roomState = Settings::GetRoomState();
+                auto it = roomState->roomSubscriptions.find(room.id);
+                if (it != roomState->roomSubscriptions.end() && !it->second.empty()) {
                     roomDisplay += " [" + std::to_string(it->second.size()) + " subscriptions]";
                 }
             }
@@ -1362,7 +1508,8 @@ void RenderRoomsTab() {
 
     if (ImGui::CollapsingHeader("Saved Room Subscriptions")) {
         // The map holding room subscriptions
-        const auto& roomSubscriptions = Settings::websocket.roomSubscriptions;
+        auto roomState = Settings::GetRoomState();
+        const auto& roomSubscriptions = roomState->roomSubscriptions;
 
         if (roomSubscriptions.empty()) {
             ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "No saved room subscriptions");
@@ -1879,6 +2026,9 @@ void RenderEditTimerWindow()
     static int editWarningSeconds = 30;
     static int editSelectedSoundIndex = 0;
     static int editSelectedWarningSoundIndex = 1;
+    static int editSpatialMode = 0;
+    static float editSpatial[3] = { 0.0f, 0.0f, 0.0f };
+    static int editSpatialMapId = 0;
     static bool editInitialized = false;
     static std::string lastEditTimerId = "";  // Add this to track which timer we're editing
 
@@ -1895,6 +2045,11 @@ void RenderEditTimerWindow()
             editSeconds = totalSeconds % 60;
             editUseWarning = timer->useWarning;
             editWarningSeconds = static_cast<int>(timer->warningTime);
+            editSpatialMode = timer->spatialMode;
+            editSpatial[0] = timer->spatialX;
+            editSpatial[1] = timer->spatialY;
+            editSpatial[2] = timer->spatialZ;
+            editSpatialMapId = timer->spatialMapId;
             if (g_SoundEngine)
             {
                 const auto& availableSounds = g_SoundEngine->GetAvailableSounds();
@@ -2027,7 +2182,7 @@ void RenderEditTimerWindow()
             if (ImGui::Button("Test##edit"))
             {
                 if (g_SoundEngine && editSelectedSoundIndex < static_cast<int>(soundIds.size()))
-                    g_SoundEngine->PlaySound(soundIds[editSelectedSoundIndex]);
+                    g_SoundEngine->PlaySound(soundIds[editSelectedSoundIndex], AlertPriority::Low);
             }
             ImGui::Spacing();
 
@@ -2063,8 +2218,57 @@ void RenderEditTimerWindow()
                 if (ImGui::Button("Test##edit_warn"))
                 {
                     if (g_SoundEngine && editSelectedWarningSoundIndex < static_cast<int>(soundIds.size()))
-                        g_SoundEngine->PlaySound(soundIds[editSelectedWarningSoundIndex]);
+                        g_SoundEngine->PlaySound(soundIds[editSelectedWarningSoundIndex], AlertPriority::Low);
+                }
+            }
+            ImGui::Spacing();
+
+            // Positional sound, captured from where the player stands or looks right now
+            const char* spatialModes[] = { "Off", "At a position", "From a direction" };
+            ImGui::Text("Positional Sound");
+            ImGui::PushItemWidth(240);
+            ImGui::Combo("##EditSpatialMode", &editSpatialMode, spatialModes, IM_ARRAYSIZE(spatialModes));
+            ImGui::PopItemWidth();
+            if (editSpatialMode != 0)
+            {
+                bool linked = MumbleLink && MumbleLink->UITick != 0;
+                if (!linked)
+                    ImGui::PushStyleVar(ImGuiStyleVar_Alpha, 0.5f);
+                if (editSpatialMode == 1)
+                {
+                    if (ImGui::Button("Use My Position##edit") && linked)
+                    {
+                        editSpatial[0] = MumbleLink->AvatarPosition.X;
+                        editSpatial[1] = MumbleLink->AvatarPosition.Y;
+                        editSpatial[2] = MumbleLink->AvatarPosition.Z;
+                        editSpatialMapId = static_cast<int>(MumbleLink->Context.MapID);
+                    }
+                }
+                else if (ImGui::Button("Use Camera Direction##edit") && linked)
+                {
+                    // Level, a compass direction
+                    float x = MumbleLink->CameraFront.X;
+                    float z = MumbleLink->CameraFront.Z;
+                    float length = std::sqrt(x * x + z * z);
+                    if (length > 0.001f)
+                    {
+                        editSpatial[0] = x / length;
+                        editSpatial[1] = 0.0f;
+                        editSpatial[2] = z / length;
+                    }
                 }
+                if (!linked)
+                    ImGui::PopStyleVar();
+                if (ImGui::IsItemHovered())
+                    ImGui::SetTooltip(linked ? "Sounds are panned and faded from where you are and where the camera faces."
+                        : "Needs the game's position data, enter a map first.");
+
+                if (editSpatialMode == 1)
+                    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "%.0f, %.0f, %.0f on map %d",
+                        editSpatial[0], editSpatial[1], editSpatial[2], editSpatialMapId);
+                else
+                    ImGui::TextColored(ImVec4(0.7f, 0.7f, 0.7f, 1.0f), "Heading %.0f degrees",
+                        std::atan2(editSpatial[0], editSpatial[2]) * 57.29578f);
             }
             ImGui::Separator();
 
@@ -2083,6 +2287,12 @@ void RenderEditTimerWindow()
                     timer->warningTime = static_cast<float>(editWarningSeconds);
                     timer->warningSound = soundIds[editSelectedWarningSoundIndex];
                 }
+                timer->spatialMode = editSpatialMode;
+                timer->spatialX = editSpatial[0];
+                timer->spatialY = editSpatial[1];
+                timer->spatialZ = editSpatial[2];
+                timer->spatialMapId = editSpatialMapId;
+                PrewarmTimerSpeech(*timer);
                 for (auto& activeTimer : activeTimers)
                 {
                     if (activeTimer.id == editTimerId)
@@ -2207,6 +2417,7 @@ void RenderOptions()
                     selectedSoundIndex = 0;
                     selectedWarningSoundIndex = 0;
                 }
+                RenderTimerPackControls();
                 ImGui::EndGroup();
 
                 ImGui::SameLine();
@@ -2316,7 +2527,7 @@ void RenderOptions()
                 ImGui::SameLine();
                 if (ImGui::Button("Test")) {
                     if (g_SoundEngine && selectedSoundIndex < soundIds.size())
-                        g_SoundEngine->PlaySound(soundIds[selectedSoundIndex]);
+                        g_SoundEngine->PlaySound(soundIds[selectedSoundIndex], AlertPriority::Low);
                 }
                 ImGui::Spacing();
 
@@ -2351,7 +2562,7 @@ void RenderOptions()
                     ImGui::SameLine();
                     if (ImGui::Button("Test##warn")) {
                         if (g_SoundEngine && selectedWarningSoundIndex < soundIds.size())
-                            g_SoundEngine->PlaySound(soundIds[selectedWarningSoundIndex]);
+                            g_SoundEngine->PlaySound(soundIds[selectedWarningSoundIndex], AlertPriority::Low);
                     }
                 }
                 ImGui::Spacing();
@@ -2398,6 +2609,7 @@ void RenderOptions()
                             newTimer.warningTime = static_cast<float>(warningSeconds);
                             newTimer.warningSound = soundIds[selectedWarningSoundIndex];
                         }
+                        PrewarmTimerSpeech(newTimer);
                         activeTimers.push_back(ActiveTimer(newTimer.id, newTimer.duration, true));
                         RegisterTimerKeybind(newTimer.id);
                         strcpy_s(timerName, sizeof(timerName), "New Timer");
@@ -2455,7 +2667,7 @@ void RenderOptions()
                 }
                 if (ImGui::Button("Test Sound")) {
                     try {
-                        PlaySoundEffect(SoundID(themes_chime_success));
+                        PlaySoundEffect(SoundID(themes_chime_success), AlertPriority::Low);
                     }
                     catch (...) {
                         if (APIDefs) {
@@ -2497,7 +2709,7 @@ void RenderOptions()
                                     if (ImGui::Selectable(devices[i].displayName().c_str(), isSelected)) {
                                         try {
                                             g_SoundEngine->SetAudioDevice(i);
-                                            PlaySoundEffect(SoundID(themes_chime_info));
+                                            PlaySoundEffect(SoundID(themes_chime_info), AlertPriority::Low);
                                             changed = true;
                                         }
                                         catch (...) {
@@ -2530,6 +2742,108 @@ void RenderOptions()
                         }
                     }
                 }
+                if (g_SoundEngine && ImGui::CollapsingHeader("Playback Latency")) {
+                    ImGui::Text("Audio backend: %s", g_SoundEngine->GetBackendName());
+                    bool usePool = g_SoundEngine->IsVoicePoolEnabled();
+                    if (ImGui::Checkbox("Use voice pool", &usePool)) {
+                        g_SoundEngine->SetVoicePoolEnabled(usePool);
+                    }
+                    bool useMixer = g_SoundEngine->IsMixerEnabled();
+                    if (ImGui::Checkbox("Mix alerts in software", &useMixer)) {
+                        g_SoundEngine->SetMixerEnabled(useMixer);
+                    }
+                    ImGui::SameLine();
+                    ImGui::TextDisabled("(%zu mixing)", g_SoundEngine->GetMixedClipCount());
+
+                    uint64_t count = 0;
+                    double averageMs = 0.0, maxMs = 0.0;
+                    g_SoundEngine->GetPlaybackLatency(true, count, averageMs, maxMs);
+                    ImGui::Text("Mixer and pooled voices: %llu plays, avg %.2f ms, max %.2f ms",
+                        static_cast<unsigned long long>(count), averageMs, maxMs);
+                    g_SoundEngine->GetPlaybackLatency(false, count, averageMs, maxMs);
+                    ImGui::Text("New voices: %llu plays, avg %.2f ms, max %.2f ms",
+                        static_cast<unsigned long long>(count), averageMs, maxMs);
+                    if (ImGui::Button("Reset Latency Stats")) {
+                        g_SoundEngine->ResetPlaybackLatency();
+                    }
+                }
+                if (g_SoundEngine && ImGui::CollapsingHeader("Sound Cache")) {
+                    int budgetMB = g_SoundEngine->GetCacheBudgetMB();
+                    if (ImGui::SliderInt("Memory budget (MB)", &budgetMB, 0, 512, budgetMB == 0 ? "No limit" : "%d MB")) {
+                        g_SoundEngine->SetCacheBudgetMB(budgetMB);
+                    }
+                    bool compressIdle = g_SoundEngine->IsIdleCompressionEnabled();
+                    if (ImGui::Checkbox("Compress sounds left unplayed for a minute", &compressIdle)) {
+                        g_SoundEngine->SetIdleCompressionEnabled(compressIdle);
+                    }
+                    if (ImGui::IsItemHovered()) {
+                        ImGui::SetTooltip("Long sounds take about an eighth of the memory at slightly lower quality.\nThey still play instantly through the mixer.");
+                    }
+
+                    SoundCacheStats stats = g_SoundEngine->GetCacheStats();
+                    ImGui::Text("Resident: %.1f MB in %zu sounds (%.1f MB pinned by timers)",
+                        stats.residentBytes / (1024.0 * 1024.0), stats.residentSounds, stats.pinnedBytes / (1024.0 * 1024.0));
+                    ImGui::Text("Hit rate: %.1f%% (%llu hits, %llu misses), %llu evictions",
+                        stats.HitRate() * 100.0, static_cast<unsigned long long>(stats.hits),
+                        static_cast<unsigned long long>(stats.misses), static_cast<unsigned long long>(stats.evictions));
+                    ImGui::Text("Disk cache: %llu loaded, %llu not cached, %llu written",
+                        static_cast<unsigned long long>(stats.diskHits), static_cast<unsigned long long>(stats.diskMisses),
+                        static_cast<unsigned long long>(stats.diskWrites));
+                    ImGui::Text("Compressed: %.1f MB in %zu sounds, %.1f MB saved, %llu expanded (avg %.2f ms)",
+                        stats.compressedBytes / (1024.0 * 1024.0), stats.compressedSounds, stats.compressionSavedBytes / (1024.0 * 1024.0),
+                        static_cast<unsigned long long>(stats.expansions), stats.expansions > 0 ? stats.expansionMs / stats.expansions : 0.0);
+                    if (g_TextToSpeech && g_TextToSpeech->IsInitialized()) {
+                        int ttsBudgetMB = g_TextToSpeech->GetCacheBudgetMB();
+                        if (ImGui::SliderInt("Speech budget (MB)", &ttsBudgetMB, 0, 128, ttsBudgetMB == 0 ? "No limit" : "%d MB")) {
+                            g_TextToSpeech->SetCacheBudgetMB(ttsBudgetMB);
+                        }
+                        if (ImGui::IsItemHovered()) {
+                            ImGui::SetTooltip("Spoken phrases kept ready to play again, least recently used dropped first.\nPhrases your timers use are always kept.");
+                        }
+
+                        TtsCacheStats tts = g_TextToSpeech->GetCacheStats();
+                        ImGui::Text("Speech: %.1f MB in %zu phrases (%zu pinned by timers), hit rate %.1f%%, %llu evictions",
+                            tts.bytes / (1024.0 * 1024.0), tts.clips, tts.pinnedClips, tts.HitRate() * 100.0,
+                            static_cast<unsigned long long>(tts.evictions));
+                        ImGui::Text("Synthesized: %llu phrases (avg %.0f ms, max %.0f ms)", static_cast<unsigned long long>(tts.synthesized),
+                            tts.synthesized > 0 ? tts.synthesisMs / tts.synthesized : 0.0, tts.maxSynthesisMs);
+                    }
+                    if (ImGui::Button("Reset Cache Stats")) {
+                        g_SoundEngine->ResetCacheStats();
+                        if (g_TextToSpeech) {
+                            g_TextToSpeech->ResetCacheStats();
+                        }
+                    }
+                }
+                if (g_SoundEngine && ImGui::CollapsingHeader("Alerts")) {
+                    int coalesceMs = g_SoundEngine->GetAlertCoalesceMs();
+                    if (ImGui::SliderInt("Merge repeats within (ms)", &coalesceMs, 0, 1000, coalesceMs == 0 ? "Off" : "%d ms")) {
+                        g_SoundEngine->SetAlertCoalesceMs(coalesceMs);
+                    }
+                    int maxSounds = g_SoundEngine->GetMaxConcurrentSounds();
+                    if (ImGui::SliderInt("Max simultaneous sounds", &maxSounds, 0, 32, maxSounds == 0 ? "No limit" : "%d")) {
+                        g_SoundEngine->SetMaxConcurrentSounds(maxSounds);
+                    }
+                    bool normalize = g_SoundEngine->IsLoudnessNormalized();
+                    if (ImGui::Checkbox("Even out custom sound loudness", &normalize)) {
+                        g_SoundEngine->SetLoudnessNormalized(normalize);
+                    }
+                    float duck = g_SoundEngine->GetAlertDuckVolume();
+                    if (ImGui::SliderFloat("Volume under warnings", &duck, 0.0f, 1.0f, "%.2f")) {
+                        g_SoundEngine->SetAlertDuckVolume(duck);
+                    }
+
+                    const AlertStats& alerts = g_SoundEngine->GetAlertStats();
+                    ImGui::Text("Alerts: %llu requested, %llu played, %llu merged",
+                        static_cast<unsigned long long>(alerts.requested), static_cast<unsigned long long>(alerts.played),
+                        static_cast<unsigned long long>(alerts.merged));
+                    ImGui::Text("Limit: %llu dropped, %llu stopped for priority, %llu ducked",
+                        static_cast<unsigned long long>(alerts.dropped), static_cast<unsigned long long>(alerts.stolen),
+                        static_cast<unsigned long long>(alerts.ducked));
+                    if (ImGui::Button("Reset Alert Stats")) {
+                        g_SoundEngine->ResetAlertStats();
+                    }
+                }
                 ImGui::Separator();
                 if (g_SoundEngine) {
                     const auto& allSounds = g_SoundEngine->GetAvailableSounds();
@@ -2547,7 +2861,7 @@ void RenderOptions()
                                 ImGui::Text("%s", sound.name.c_str());
                                 ImGui::SameLine(ImGui::GetWindowWidth() * 0.7f);
                                 if (ImGui::Button("Test"))
-                                    g_SoundEngine->PlaySound(sound.id);
+                                    g_SoundEngine->PlaySound(sound.id, AlertPriority::Low);
                                 if (ImGui::SliderFloat("Volume", &soundVolume, 0.0f, 1.0f, "%.2f")) {
                                     g_SoundEngine->SetSoundVolume(sound.id, soundVolume);
                                     changed = true;
@@ -2602,6 +2916,7 @@ void RenderOptions()
                                 g_SoundEngine->ScanSoundDirectory(customSoundsDir);
                             }
                         }
+                        RenderSoundPackControls(customSoundsDir);
                         ImGui::Separator();
                         auto it = categorizedSounds.find("Custom");
                         if (it != categorizedSounds.end() && !it->second.empty()) {
@@ -2613,7 +2928,7 @@ void RenderOptions()
                                 ImGui::Text("%s", sound.name.c_str());
                                 ImGui::SameLine(ImGui::GetWindowWidth() * 0.7f);
                                 if (ImGui::Button("Test"))
-                                    g_SoundEngine->PlaySound(sound.id);
+                                    g_SoundEngine->PlaySound(sound.id, AlertPriority::Low);
                                 if (ImGui::SliderFloat("Volume", &soundVolume, 0.0f, 1.0f, "%.2f")) {
                                     g_SoundEngine->SetSoundVolume(sound.id, soundVolume);
                                     changed = true;
@@ -2640,6 +2955,7 @@ void RenderOptions()
                             ImGui::Text("3. Enter the full path to this folder above");
                             ImGui::Text("4. Click 'Set' and then 'Refresh'");
                             ImGui::Text("5. Your custom sounds will appear here and in timer sound dropdowns");
+                            ImGui::Text("Sound packs (.soundpack) in the folder are loaded too; 'Build Pack' packs the folder and its subfolders into one");
                             ImGui::PopTextWrapPos();
                             ImGui::EndTooltip();
                         }
@@ -2762,7 +3078,7 @@ void RenderOptions()
                                     ImGui::Text("%s", sound.name.c_str());
                                     ImGui::SameLine(ImGui::GetWindowWidth() * 0.7f);
                                     if (ImGui::Button("Test##tts")) {
-                                        g_SoundEngine->PlaySound(sound.id);
+                                        g_SoundEngine->PlaySound(sound.id, AlertPriority::Low);
                                     }
 
                                     float soundVolume = g_SoundEngine->GetSoundVolume(sound.id);
@@ -1,2 +1,22 @@
+// Vorbis decoding needs stb_vorbis, which miniaudio doesn't bundle. Drop stb_vorbis.c
+// next to this file to enable .ogg sounds; without it the decoder handles WAV, MP3 and FLAC.
+#if __has_include("stb_vorbis.c")
+#define STB_VORBIS_HEADER_ONLY
+#include "stb_vorbis.c"
+#endif
+
 #define MINIAUDIO_IMPLEMENTATION
-#include "miniaudio.h"
\ No newline at end of file
+#include "miniaudio.h"
+
+#if __has_include("stb_vorbis.c")
+#undef STB_VORBIS_HEADER_ONLY
+#include "stb_vorbis.c"
+#endif
+
+bool IsVorbisDecodingAvailable() {
+#ifdef MA_HAS_VORBIS
+    return true;
+#else
+    return false;
+#endif
+}
@@ -6,6 +6,7 @@
 #include <sstream>
 #include <algorithm>
 #include <random>
+#include <set>
 #include <ctime>
 #include "shared.h"
 #include "Sounds.h"
@@ -53,14 +54,18 @@ bool Settings::showTitle = true;
 bool Settings::allowResize = true;
 WindowColors Settings::colors;
 std::vector<TimerData> Settings::timers;
-std::unordered_set<std::string> Settings::usedIds;
 SoundSettings Settings::sounds;
 std::mutex Settings::SaveMutex;
 bool Settings::saveScheduled = false;
 std::chrono::steady_clock::time_point Settings::lastSaveRequest = std::chrono::steady_clock::now();
 const std::chrono::milliseconds Settings::saveCooldown(500);
+std::atomic<size_t> Settings::lastSavedHash(0);
 WebSocketSettings Settings::websocket;
 bool Settings::isInitializing = false;
+SettingsDomain<SoundStateSnapshot> Settings::soundState;
+SettingsDomain<RoomStateSnapshot> Settings::roomState;
+std::atomic<uint64_t> Settings::timersVersion(0);
+std::unordered_map<std::string, size_t> Settings::timerIndex;
 
 // Implementation of TimerData methods
 TimerData::TimerData(const std::string& name, float duration)
@@ -72,100 +77,99 @@ TimerData::TimerData(const std::string& name, float duration)
     , useWarning(false)
     , isRoomTimer(false)
     , roomId("")
+    , spatialMode(0)
+    , spatialX(0.0f)
+    , spatialY(0.0f)
+    , spatialZ(0.0f)
+    , spatialMapId(0)
 {
     id = generateUniqueId("timer_");
 }
 
-std::string TimerData::generateUniqueId(const std::string& prefix) {
-    static std::mutex idMutex;
-    std::lock_guard<std::mutex> lock(idMutex);
+// Generator state: (milliseconds << 16) | sequence of the last id handed out
+static std::atomic<uint64_t> idState(0);
+static std::atomic<uint32_t> idSalt(0);
 
-    // Get current time with microsecond precision
-    auto now = std::chrono::system_clock::now();
-    auto micros = std::chrono::duration_cast<std::chrono::microseconds>(
-        now.time_since_epoch()
-        );
+static const char* const hexDigits = "0123456789abcdef";
 
-    // Convert to hex string
-    std::stringstream ss;
-    ss << prefix << std::hex << micros.count();
-    return ss.str();
+static void AppendHex(std::string& out, uint64_t value, int digits) {
+    for (int shift = (digits - 1) * 4; shift >= 0; shift -= 4) {
+        out.push_back(hexDigits[(value >> shift) & 0xF]);
+    }
 }
 
-json TimerData::toJson() const {
-    json j;
-    j["name"] = name;
-    j["id"] = id;
-    j["duration"] = duration;
-    j["endSound"] = endSound.ToString();
-    j["warningTime"] = warningTime;
-    j["warningSound"] = warningSound.ToString();
-    j["useWarning"] = useWarning;
-    j["isRoomTimer"] = isRoomTimer;
-    j["roomId"] = roomId;
-    return j;
+static bool ParseHex(const char* p, int digits, uint64_t& value) {
+    value = 0;
+    for (int i = 0; i < digits; i++) {
+        char c = p[i];
+        int nibble = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : -1;
+        if (nibble < 0) return false;
+        value = (value << 4) | static_cast<uint64_t>(nibble);
+    }
+    return true;
 }
 
-TimerData TimerData::fromJson(const json& j) {
-    TimerData timer;
-
-    // Using at() with default values to safely extract properties
-    timer.name = j.contains("name") ? j["name"].get<std::string>() : "";
-    timer.id = j.contains("id") ? j["id"].get<std::string>() : generateUniqueId("timer_");
-    timer.duration = j.contains("duration") ? j["duration"].get<float>() : 0.0f;
+std::string TimerData::generateUniqueId(const std::string& prefix) {
+    const uint64_t nowMs = static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count()) & 0xFFFFFFFFFFFull;
+
+    // Same millisecond (or clock went back): bump the sequence, carrying into the
+    // timestamp when it wraps. Either way the pair never repeats.
+    uint64_t previous = idState.load(std::memory_order_relaxed);
+    uint64_t next;
+    do {
+        uint64_t lastMs = previous >> 16;
+        next = nowMs > lastMs ? (nowMs << 16) : previous + 1;
+    } while (!idState.compare_exchange_weak(previous, next, std::memory_order_acq_rel, std::memory_order_relaxed));
+
+    std::string id;
+    id.reserve(prefix.size() + 21);
+    id += prefix;
+    AppendHex(id, next >> 16, 11);
+    AppendHex(id, next & 0xFFFF, 4);
+    AppendHex(id, idSalt.load(std::memory_order_relaxed), 6);
+    return id;
+}
 
-    // Deserialize endSound
-    std::string endSoundStr = j.contains("endSound") ? j["endSound"].get<std::string>() : "";
-    if (!endSoundStr.empty()) {
-        if (endSoundStr.find("res:") == 0 || endSoundStr.find("file:") == 0) {
-            timer.endSound = SoundID::FromString(endSoundStr);
-        }
-        else {
-            try {
-                int resId = std::stoi(endSoundStr);
-                timer.endSound = SoundID(resId);
-            }
-            catch (...) {
-                timer.endSound = SoundID(themes_chime_success);
-            }
-        }
-    }
-    else {
-        timer.endSound = SoundID(themes_chime_success);
+void TimerData::seedIdGenerator(const std::string& clientId) {
+    // FNV-1a, folded to 24 bits
+    uint32_t hash = 2166136261u;
+    for (unsigned char c : clientId) {
+        hash ^= c;
+        hash *= 16777619u;
     }
+    idSalt.store((hash >> 24) ^ (hash & 0xFFFFFF), std::memory_order_relaxed);
+}
 
-    // Deserialize warningSound and warningTime
-    timer.warningTime = j.contains("warningTime") ? j["warningTime"].get<float>() : 30.0f;
-    std::string warningSoundStr = j.contains("warningSound") ? j["warningSound"].get<std::string>() : "";
-    if (!warningSoundStr.empty()) {
-        if (warningSoundStr.find("res:") == 0 || warningSoundStr.find("file:") == 0) {
-            timer.warningSound = SoundID::FromString(warningSoundStr);
-        }
-        else {
-            try {
-                int resId = std::stoi(warningSoundStr);
-                timer.warningSound = SoundID(resId);
-            }
-            catch (...) {
-                timer.warningSound = SoundID(themes_chime_info);
-            }
-        }
-    }
-    else {
-        timer.warningSound = SoundID(themes_chime_info);
-    }
+void TimerData::observeId(const std::string& id) {
+    // Only ids in the current layout carrying our salt can collide with ours
+    if (id.size() < 21) return;
 
-    timer.useWarning = j.contains("useWarning") ? j["useWarning"].get<bool>() : false;
+    const char* tail = id.data() + id.size() - 21;
+    uint64_t ms, sequence, salt;
+    if (!ParseHex(tail, 11, ms) || !ParseHex(tail + 11, 4, sequence) || !ParseHex(tail + 15, 6, salt)) return;
+    if (salt != idSalt.load(std::memory_order_relaxed)) return;
+
+    // Keep new ids ahead of saved ones in case the clock moved back since they were made
+    uint64_t seen = (ms << 16) | sequence;
+    uint64_t current = idState.load(std::memory_order_relaxed);
+    while (current < seen && !idState.compare_exchange_weak(current, seen, std::memory_order_acq_rel, std::memory_order_relaxed)) {
+    }
+}
 
-    // Read the new fields
-    timer.isRoomTimer = j.contains("isRoomTimer") ? j["isRoomTimer"].get<bool>() : false;
-    timer.roomId = j.contains("roomId") ? j["roomId"].get<std::string>() : "";
+json TimerData::toJson() const {
+    return Schema::ToJson(*this);
+}
 
+TimerData TimerData::fromJson(const json& j) {
+    // A fresh timer already carries a generated id, kept when the document has none
+    TimerData timer;
+    Schema::FromJson(j, timer);
     return timer;
 }
 
 void Settings::Load(const std::string& path) {
-    std::lock_guard<std::mutex> lock(Mutex);
+    std::unique_lock<std::mutex> lock(Mutex);
 
     try {
         std::ifstream file(path);
@@ -178,7 +182,6 @@ void Settings::Load(const std::string& path) {
 
         // Clear existing state
         timers.clear();
-        usedIds.clear();
 
         // Load window settings
         if (SettingsData.contains("window")) {
@@ -204,9 +207,7 @@ void Settings::Load(const std::string& path) {
         // Load sound settings
         if (SettingsData.contains("sounds")) {
             const auto& soundsJson = SettingsData["sounds"];
-            sounds.masterVolume = soundsJson.contains("masterVolume") ? soundsJson["masterVolume"].get<float>() : 1.0f;
-            sounds.audioDeviceIndex = soundsJson.contains("audioDeviceIndex") ? soundsJson["audioDeviceIndex"].get<int>() : -1;
-            sounds.customSoundsDirectory = soundsJson.contains("customSoundsDirectory") ? soundsJson["customSoundsDirectory"].get<std::string>() : "";
+            Schema::FromJson(soundsJson, sounds);
 
             // Load sound volumes with new format
             if (soundsJson.contains("soundVolumes") && soundsJson["soundVolumes"].is_object()) {
@@ -285,11 +286,9 @@ void Settings::Load(const std::string& path) {
             if (soundsJson.contains("ttsSounds") && soundsJson["ttsSounds"].is_array()) {
                 for (const auto& ttsJson : soundsJson["ttsSounds"]) {
                     try {
-                        std::string id = ttsJson.contains("id") ? ttsJson["id"].get<std::string>() : "";
-                        std::string name = ttsJson.contains("name") ? ttsJson["name"].get<std::string>() : "";
-                        float volume = ttsJson.contains("volume") ? ttsJson["volume"].get<float>() : 1.0f;
-                        float pan = ttsJson.contains("pan") ? ttsJson["pan"].get<float>() : 0.0f;
-                        sounds.ttsSounds.emplace_back(id, name, volume, pan);
+                        SoundSettings::TtsSoundInfo info("", "");
+                        Schema::FromJson(ttsJson, info);
+                        sounds.ttsSounds.push_back(std::move(info));
                     }
                     catch (...) {
                         // Skip invalid entries
@@ -297,65 +296,20 @@ void Settings::Load(const std::string& path) {
                 }
             }
 
-            // Update the sound engine with the loaded settings
-            if (g_SoundEngine) {
-                g_SoundEngine->SetMasterVolume(sounds.masterVolume);
-
-                // Update individual sound volumes and pans
-                for (const auto& [soundIdStr, volume] : sounds.soundVolumes) {
-                    SoundID id = SoundID::FromString(soundIdStr);
-                    g_SoundEngine->SetSoundVolume(id, volume);
-                }
-
-                for (const auto& [soundIdStr, pan] : sounds.soundPans) {
-                    SoundID id = SoundID::FromString(soundIdStr);
-                    g_SoundEngine->SetSoundPan(id, pan);
-                }
-            }
         }
 
         // Load WebSockets
         if (SettingsData.contains("websocket")) {
             const auto& websocketJson = SettingsData["websocket"];
-            websocket.serverUrl = websocketJson.contains("serverUrl") ? websocketJson["serverUrl"].get<std::string>() : "wss://simple-timers-wss.onrender.com";
-            websocket.autoConnect = websocketJson.contains("autoConnect") ? websocketJson["autoConnect"].get<bool>() : false;
-            websocket.enabled = websocketJson.contains("enabled") ? websocketJson["enabled"].get<bool>() : false;
-            websocket.pingInterval = websocketJson.contains("pingInterval") ? websocketJson["pingInterval"].get<int>() : 30000;
-            websocket.autoReconnect = websocketJson.contains("autoReconnect") ? websocketJson["autoReconnect"].get<bool>() : true;
-            websocket.reconnectInterval = websocketJson.contains("reconnectInterval") ? websocketJson["reconnectInterval"].get<int>() : 5000;
-            websocket.maxReconnectAttempts = websocketJson.contains("maxReconnectAttempts") ? websocketJson["maxReconnectAttempts"].get<int>() : 5;
-            websocket.logMessages = websocketJson.contains("logMessages") ? websocketJson["logMessages"].get<bool>() : true;
-            websocket.maxLogEntries = websocketJson.contains("maxLogEntries") ? websocketJson["maxLogEntries"].get<int>() : 100;
-
-            // Load client ID if exists
-            if (websocketJson.contains("clientId")) {
-                websocket.clientId = websocketJson["clientId"].get<std::string>();
-            }
-            else {
-                // Generate a new client ID
-                websocket.ensureClientId();
-            }
+            Schema::FromJson(websocketJson, websocket);
 
-            // Load TLS settings if they exist
-            if (websocketJson.contains("tlsOptions")) {
-                const auto& tlsJson = websocketJson["tlsOptions"];
-                websocket.tlsOptions.verifyPeer = tlsJson.contains("verifyPeer") ? tlsJson["verifyPeer"].get<bool>() : true;
-                websocket.tlsOptions.verifyHost = tlsJson.contains("verifyHost") ? tlsJson["verifyHost"].get<bool>() : true;
-                websocket.tlsOptions.caFile = tlsJson.contains("caFile") ? tlsJson["caFile"].get<std::string>() : "";
-                websocket.tlsOptions.caPath = tlsJson.contains("caPath") ? tlsJson["caPath"].get<std::string>() : "";
-                websocket.tlsOptions.certFile = tlsJson.contains("certFile") ? tlsJson["certFile"].get<std::string>() : "";
-                websocket.tlsOptions.keyFile = tlsJson.contains("keyFile") ? tlsJson["keyFile"].get<std::string>() : "";
-                websocket.tlsOptions.enableServerCertAuth = tlsJson.contains("enableServerCertAuth") ? tlsJson["enableServerCertAuth"].get<bool>() : true;
-            }
+            // Older files have no client ID yet
+            websocket.ensureClientId();
         }
 
         if (SettingsData.contains("websocket")) {
             const auto& websocketJson = SettingsData["websocket"];
 
-            if (websocketJson.contains("currentRoomId")) {
-                websocket.currentRoomId = websocketJson["currentRoomId"].get<std::string>();
-            }
-
             // Load room subscriptions
             if (websocketJson.contains("roomSubscriptions") && websocketJson["roomSubscriptions"].is_object()) {
                 for (auto it = websocketJson["roomSubscriptions"].begin(); it != websocketJson["roomSubscriptions"].end(); ++it) {
@@ -375,23 +329,151 @@ void Settings::Load(const std::string& path) {
         }
 
         // Load timers
+        TimerData::seedIdGenerator(websocket.clientId);
         if (SettingsData.contains("timers") && SettingsData["timers"].is_array()) {
+            // Hand-edited files can repeat an id; only needed while loading
+            std::unordered_set<std::string> loadedIds;
+            loadedIds.reserve(SettingsData["timers"].size());
+
             for (const auto& timerJson : SettingsData["timers"]) {
                 TimerData timer = TimerData::fromJson(timerJson);
+                TimerData::observeId(timer.id);
 
-                // If ID already exists, generate a new one
-                while (usedIds.find(timer.id) != usedIds.end()) {
+                if (!loadedIds.insert(timer.id).second) {
                     timer.id = TimerData::generateUniqueId("timer_");
+                    loadedIds.insert(timer.id);
                 }
 
-                usedIds.insert(timer.id);
-                timers.push_back(timer);
+                timers.push_back(std::move(timer));
             }
         }
+        RebuildTimerIndex();
+
+        PublishSoundState();
+        PublishRoomState();
+        BumpTimersVersion();
     }
     catch (...) {
         InitializeDefaults();
     }
+
+    // The engine's setters write back through Settings, so update it after releasing the lock
+    lock.unlock();
+    if (g_SoundEngine) {
+        g_SoundEngine->SyncFromSettings();
+    }
+}
+
+SettingsReloadResult Settings::ApplyReload(const SettingsReload& reload) {
+    SettingsReloadResult result;
+    std::lock_guard<std::mutex> lock(Mutex);
+
+    // Timers, matched by id
+    std::unordered_map<std::string, const TimerData*> incoming;
+    for (const auto& timer : reload.timers) {
+        incoming.emplace(timer.id, &timer);
+    }
+
+    auto it = timers.begin();
+    while (it != timers.end()) {
+        if (it->isRoomTimer) {
+            ++it;
+            continue;
+        }
+
+        auto found = incoming.find(it->id);
+        if (found == incoming.end()) {
+            result.removedTimers.push_back(it->id);
+            it = timers.erase(it);
+            continue;
+        }
+
+        // Compare through the binary encoding so new schema fields are picked up automatically
+        std::string current, updated;
+        Schema::WriteBinary(current, *it);
+        Schema::WriteBinary(updated, *found->second);
+        if (current != updated) {
+            result.changedTimers.push_back({ it->id, it->duration, found->second->duration });
+            *it = *found->second;
+        }
+
+        incoming.erase(found);
+        ++it;
+    }
+
+    // Whatever is left is new, keep the file's order
+    for (const auto& timer : reload.timers) {
+        if (incoming.erase(timer.id) > 0) {
+            timers.push_back(timer);
+            result.addedTimers.push_back({ timer.id, 0.0f, timer.duration });
+        }
+    }
+
+    if (!result.addedTimers.empty() || !result.changedTimers.empty() || !result.removedTimers.empty()) {
+        RebuildTimerIndex();
+        BumpTimersVersion();
+    }
+
+    // Sounds
+    if (reload.hasSounds) {
+        const SoundSettings& next = reload.sounds;
+        result.soundsDirectoryChanged = next.customSoundsDirectory != sounds.customSoundsDirectory;
+        result.soundsChanged = result.soundsDirectoryChanged ||
+            next.masterVolume != sounds.masterVolume ||
+            next.soundCacheBudgetMB != sounds.soundCacheBudgetMB ||
+            next.alertCoalesceMs != sounds.alertCoalesceMs ||
+            next.maxConcurrentSounds != sounds.maxConcurrentSounds ||
+            next.alertDuckVolume != sounds.alertDuckVolume ||
+            next.normalizeLoudness != sounds.normalizeLoudness ||
+            next.compressIdleSounds != sounds.compressIdleSounds ||
+            next.ttsCacheBudgetMB != sounds.ttsCacheBudgetMB ||
+            next.soundVolumes != sounds.soundVolumes ||
+            next.soundPans != sounds.soundPans;
+
+        if (result.soundsChanged) {
+            sounds.masterVolume = next.masterVolume;
+            sounds.soundCacheBudgetMB = next.soundCacheBudgetMB;
+            sounds.alertCoalesceMs = next.alertCoalesceMs;
+            sounds.maxConcurrentSounds = next.maxConcurrentSounds;
+            sounds.alertDuckVolume = next.alertDuckVolume;
+            sounds.normalizeLoudness = next.normalizeLoudness;
+            sounds.compressIdleSounds = next.compressIdleSounds;
+            sounds.ttsCacheBudgetMB = next.ttsCacheBudgetMB;
+            sounds.soundVolumes = next.soundVolumes;
+            sounds.soundPans = next.soundPans;
+            sounds.customSoundsDirectory = next.customSoundsDirectory;
+            PublishSoundState();
+        }
+    }
+
+    return result;
+}
+
+// Both publishers expect Mutex to be held by the caller
+void Settings::PublishSoundState() {
+    SoundStateSnapshot next;
+    next.masterVolume = sounds.masterVolume;
+    next.audioDeviceIndex = sounds.audioDeviceIndex;
+    next.soundCacheBudgetMB = sounds.soundCacheBudgetMB;
+    next.alertCoalesceMs = sounds.alertCoalesceMs;
+    next.maxConcurrentSounds = sounds.maxConcurrentSounds;
+    next.alertDuckVolume = sounds.alertDuckVolume;
+    next.normalizeLoudness = sounds.normalizeLoudness;
+    next.compressIdleSounds = sounds.compressIdleSounds;
+    next.ttsCacheBudgetMB = sounds.ttsCacheBudgetMB;
+    next.customSoundsDirectory = sounds.customSoundsDirectory;
+    next.soundVolumes = sounds.soundVolumes;
+    next.soundPans = sounds.soundPans;
+    soundState.Publish(std::move(next));
+}
+
+void Settings::PublishRoomState() {
+    RoomStateSnapshot next;
+    next.connectionStatus = websocket.connectionStatus;
+    next.currentRoomId = websocket.currentRoomId;
+    next.availableRooms = websocket.availableRooms;
+    next.roomSubscriptions = websocket.roomSubscriptions;
+    roomState.Publish(std::move(next));
 }
 
 void Settings::ScheduleSave(const std::string& path) {
@@ -447,7 +529,7 @@ void Settings::InitializeDefaults() {
     allowResize = true;
     colors = WindowColors();
     timers.clear();
-    usedIds.clear();
+    timerIndex.clear();
 
     // Initialize sound settings
     sounds.masterVolume = 1.0f;
@@ -472,22 +554,32 @@ void Settings::InitializeDefaults() {
     websocket.logMessages = true;
     websocket.maxLogEntries = 100;
     websocket.ensureClientId();
+    TimerData::seedIdGenerator(websocket.clientId);
     websocket.tlsOptions.verifyPeer = false;
     websocket.tlsOptions.verifyHost = false;
     websocket.tlsOptions.enableServerCertAuth = false;
+
+    PublishSoundState();
+    PublishRoomState();
+    BumpTimersVersion();
 }
 
 TimerData& Settings::AddTimer(const std::string& name, float duration) {
     std::lock_guard<std::mutex> lock(Mutex);
     TimerData timer(name, duration);
+    timers.emplace_back(std::move(timer));
+    timerIndex.emplace(timers.back().id, timers.size() - 1);
+    BumpTimersVersion();
+    return timers.back();
+}
 
-    // Ensure unique ID
-    while (usedIds.find(timer.id) != usedIds.end()) {
-        timer.id = TimerData::generateUniqueId("timer_");
-    }
-
-    usedIds.insert(timer.id);
+TimerData& Settings::AddTimer(const std::string& name, float duration, const std::string& id) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    TimerData timer(name, duration);
+    timer.id = id;
     timers.emplace_back(std::move(timer));
+    timerIndex.emplace(timers.back().id, timers.size() - 1);
+    BumpTimersVersion();
     return timers.back();
 }
 
@@ -498,14 +590,56 @@ void Settings::RemoveTimer(const std::string& id) {
             [id](const TimerData& timer) { return timer.id == id; }),
         timers.end()
     );
-    usedIds.erase(id);
+    RebuildTimerIndex();
+    BumpTimersVersion();
+}
+
+std::vector<std::string> Settings::RemoveRoomTimers(const std::string& roomId, const std::unordered_set<std::string>& keepIds) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    std::vector<std::string> removed;
+    auto it = timers.begin();
+    while (it != timers.end()) {
+        if (it->isRoomTimer && it->roomId == roomId && keepIds.find(it->id) == keepIds.end()) {
+            removed.push_back(it->id);
+            it = timers.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+
+    if (!removed.empty()) {
+        RebuildTimerIndex();
+        BumpTimersVersion();
+    }
+    return removed;
+}
+
+void Settings::AddTimers(std::vector<TimerData>&& batch) {
+    if (batch.empty()) return;
+
+    std::lock_guard<std::mutex> lock(Mutex);
+    timers.reserve(timers.size() + batch.size());
+    for (auto& timer : batch) {
+        timers.push_back(std::move(timer));
+        timerIndex.emplace(timers.back().id, timers.size() - 1);
+    }
+    BumpTimersVersion();
+}
+
+// Expects Mutex to be held. Keeps the first timer for a repeated id, like a linear search would.
+void Settings::RebuildTimerIndex() {
+    timerIndex.clear();
+    timerIndex.reserve(timers.size());
+    for (size_t i = 0; i < timers.size(); i++) {
+        timerIndex.emplace(timers[i].id, i);
+    }
 }
 
 TimerData* Settings::FindTimer(const std::string& id) {
     std::lock_guard<std::mutex> lock(Mutex);
-    auto it = std::find_if(timers.begin(), timers.end(),
-        [id](const TimerData& timer) { return timer.id == id; });
-    return it != timers.end() ? &(*it) : nullptr;
+    auto it = timerIndex.find(id);
+    return it != timerIndex.end() ? &timers[it->second] : nullptr;
 }
 
 // Sound settings methods
@@ -513,6 +647,7 @@ void Settings::SetMasterVolume(float volume) {
     std::lock_guard<std::mutex> lock(Mutex);
     // Clamp to valid range
     sounds.masterVolume = std::max(0.0f, std::min(1.0f, volume));
+    PublishSoundState();
 
     if (APIDefs) {
         char logMsg[128];
@@ -530,8 +665,7 @@ void Settings::SetMasterVolume(float volume) {
 }
 
 float Settings::GetMasterVolume() {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return sounds.masterVolume;
+    return GetSoundState()->masterVolume;
 }
 
 void Settings::SetSoundVolume(int resourceId, float volume) {
@@ -542,6 +676,7 @@ void Settings::SetSoundVolume(int resourceId, float volume) {
     // Convert to new format
     SoundID id(resourceId);
     sounds.soundVolumes[id.ToString()] = clampedVolume;
+    PublishSoundState();
 
     // Update the sound engine for this sound
     if (g_SoundEngine) {
@@ -557,13 +692,13 @@ void Settings::SetSoundVolume(int resourceId, float volume) {
 }
 
 float Settings::GetSoundVolume(int resourceId) {
-    std::lock_guard<std::mutex> lock(Mutex);
+    auto state = GetSoundState();
     // Convert to new format
     SoundID id(resourceId);
     std::string idStr = id.ToString();
 
-    auto it = sounds.soundVolumes.find(idStr);
-    if (it != sounds.soundVolumes.end()) {
+    auto it = state->soundVolumes.find(idStr);
+    if (it != state->soundVolumes.end()) {
         return it->second;
     }
     // Default volume if not specified
@@ -578,6 +713,7 @@ void Settings::SetFileSoundVolume(const std::string& filePath, float volume) {
     // Convert to new format
     SoundID id(filePath);
     sounds.soundVolumes[id.ToString()] = clampedVolume;
+    PublishSoundState();
 
     // Update the sound engine for this sound
     if (g_SoundEngine) {
@@ -593,13 +729,13 @@ void Settings::SetFileSoundVolume(const std::string& filePath, float volume) {
 }
 
 float Settings::GetFileSoundVolume(const std::string& filePath) {
-    std::lock_guard<std::mutex> lock(Mutex);
+    auto state = GetSoundState();
     // Convert to new format
     SoundID id(filePath);
     std::string idStr = id.ToString();
 
-    auto it = sounds.soundVolumes.find(idStr);
-    if (it != sounds.soundVolumes.end()) {
+    auto it = state->soundVolumes.find(idStr);
+    if (it != state->soundVolumes.end()) {
         return it->second;
     }
     // Default volume if not specified
@@ -609,6 +745,7 @@ float Settings::GetFileSoundVolume(const std::string& filePath) {
 void Settings::SetAudioDeviceIndex(int index) {
     std::lock_guard<std::mutex> lock(Mutex);
     sounds.audioDeviceIndex = index;
+    PublishSoundState();
 
     if (APIDefs) {
         char logMsg[128];
@@ -626,8 +763,105 @@ void Settings::SetAudioDeviceIndex(int index) {
 }
 
 int Settings::GetAudioDeviceIndex() {
+    return GetSoundState()->audioDeviceIndex;
+}
+
+void Settings::SetSoundCacheBudgetMB(int megabytes) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.soundCacheBudgetMB = std::max(0, megabytes);
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+int Settings::GetSoundCacheBudgetMB() {
+    return GetSoundState()->soundCacheBudgetMB;
+}
+
+void Settings::SetAlertCoalesceMs(int milliseconds) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.alertCoalesceMs = std::max(0, std::min(2000, milliseconds));
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+int Settings::GetAlertCoalesceMs() {
+    return GetSoundState()->alertCoalesceMs;
+}
+
+void Settings::SetMaxConcurrentSounds(int count) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.maxConcurrentSounds = std::max(0, count);
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+int Settings::GetMaxConcurrentSounds() {
+    return GetSoundState()->maxConcurrentSounds;
+}
+
+void Settings::SetAlertDuckVolume(float volume) {
     std::lock_guard<std::mutex> lock(Mutex);
-    return sounds.audioDeviceIndex;
+    sounds.alertDuckVolume = std::max(0.0f, std::min(1.0f, volume));
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+float Settings::GetAlertDuckVolume() {
+    return GetSoundState()->alertDuckVolume;
+}
+
+void Settings::SetNormalizeLoudness(bool enabled) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.normalizeLoudness = enabled;
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+bool Settings::GetNormalizeLoudness() {
+    return GetSoundState()->normalizeLoudness;
+}
+
+void Settings::SetCompressIdleSounds(bool enabled) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.compressIdleSounds = enabled;
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+bool Settings::GetCompressIdleSounds() {
+    return GetSoundState()->compressIdleSounds;
+}
+
+void Settings::SetTtsCacheBudgetMB(int megabytes) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    sounds.ttsCacheBudgetMB = std::max(0, megabytes);
+    PublishSoundState();
+
+    if (!SettingsPath.empty()) {
+        ScheduleSave(SettingsPath);
+    }
+}
+
+int Settings::GetTtsCacheBudgetMB() {
+    return GetSoundState()->ttsCacheBudgetMB;
 }
 
 void Settings::SetSoundPan(int soundId, float pan) {
@@ -638,6 +872,7 @@ void Settings::SetSoundPan(int soundId, float pan) {
     // Convert to new format
     SoundID id(soundId);
     sounds.soundPans[id.ToString()] = clampedPan;
+    PublishSoundState();
 
     // Update the sound engine with the new panning
     if (g_SoundEngine) {
@@ -653,13 +888,13 @@ void Settings::SetSoundPan(int soundId, float pan) {
 }
 
 float Settings::GetSoundPan(int soundId) {
-    std::lock_guard<std::mutex> lock(Mutex);
+    auto state = GetSoundState();
     // Convert to new format
     SoundID id(soundId);
     std::string idStr = id.ToString();
 
-    auto it = sounds.soundPans.find(idStr);
-    if (it != sounds.soundPans.end()) {
+    auto it = state->soundPans.find(idStr);
+    if (it != state->soundPans.end()) {
         return it->second;
     }
     return 0.0f; // Default to center
@@ -673,6 +908,7 @@ void Settings::SetFileSoundPan(const std::string& filePath, float pan) {
     // Convert to new format
     SoundID id(filePath);
     sounds.soundPans[id.ToString()] = clampedPan;
+    PublishSoundState();
 
     // Update the sound engine with the new panning
     if (g_SoundEngine) {
@@ -688,13 +924,13 @@ void Settings::SetFileSoundPan(const std::string& filePath, float pan) {
 }
 
 float Settings::GetFileSoundPan(const std::string& filePath) {
-    std::lock_guard<std::mutex> lock(Mutex);
+    auto state = GetSoundState();
     // Convert to new format
     SoundID id(filePath);
     std::string idStr = id.ToString();
 
-    auto it = sounds.soundPans.find(idStr);
-    if (it != sounds.soundPans.end()) {
+    auto it = state->soundPans.find(idStr);
+    if (it != state->soundPans.end()) {
         return it->second;
     }
     return 0.0f; // Default to center
@@ -703,6 +939,7 @@ float Settings::GetFileSoundPan(const std::string& filePath) {
 void Settings::SetCustomSoundsDirectory(const std::string& directory) {
     std::lock_guard<std::mutex> lock(Mutex);
     sounds.customSoundsDirectory = directory;
+    PublishSoundState();
 
     // Call the global Save method to ensure everything is saved
     if (!SettingsPath.empty()) {
@@ -711,8 +948,7 @@ void Settings::SetCustomSoundsDirectory(const std::string& directory) {
 }
 
 std::string Settings::GetCustomSoundsDirectory() {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return sounds.customSoundsDirectory;
+    return GetSoundState()->customSoundsDirectory;
 }
 
 void Settings::AddRecentSound(const std::string& soundIdStr) {
@@ -725,6 +961,15 @@ void Settings::AddRecentSound(const std::string& soundIdStr) {
     }
 }
 
+bool Settings::AddRecentSounds(const std::vector<std::string>& soundIdStrs) {
+    std::lock_guard<std::mutex> lock(Mutex);
+    std::vector<std::string> before = sounds.recentSounds;
+    for (const auto& soundIdStr : soundIdStrs) {
+        sounds.addRecentSound(soundIdStr);
+    }
+    return sounds.recentSounds != before;
+}
+
 const std::vector<std::string>& Settings::GetRecentSounds() {
     std::lock_guard<std::mutex> lock(Mutex);
     return sounds.recentSounds;
@@ -787,6 +1032,11 @@ bool Settings::LoadSavedTtsSounds() {
 
     bool success = true;
 
+    // Timed so cold starts, which synthesize, can be compared with warm ones served from the PCM cache
+    auto loadStart = std::chrono::steady_clock::now();
+    uint64_t cachedBefore = g_SoundEngine->GetCacheStats().diskHits;
+    std::set<std::string> liveKeys;
+
     // Load each saved TTS sound
     for (const auto& ttsInfo : sounds.ttsSounds) {
         try {
@@ -812,6 +1062,7 @@ bool Settings::LoadSavedTtsSounds() {
             }
 
             // Let the TextToSpeech engine create the sound
+            liveKeys.insert(g_TextToSpeech->PcmKeyFor(voiceIndex, text));
             if (g_TextToSpeech->CreateTtsSound(text, ttsInfo.name, voiceIndex, ttsInfo.volume, ttsInfo.pan)) {
                 if (APIDefs) {
                     char logMsg[256];
@@ -844,6 +1095,17 @@ bool Settings::LoadSavedTtsSounds() {
         }
     }
 
+    if (APIDefs && !sounds.ttsSounds.empty()) {
+        double loadMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - loadStart).count();
+        char logMsg[128];
+        sprintf_s(logMsg, "Loaded %zu saved TTS sounds in %.1f ms, %llu from the cache, the rest synthesize in the background", sounds.ttsSounds.size(), loadMs,
+            static_cast<unsigned long long>(g_SoundEngine->GetCacheStats().diskHits - cachedBefore));
+        APIDefs->Log(ELogLevel_DEBUG, ADDON_NAME, logMsg);
+    }
+
+    // Speech cached for saved sounds that have since been deleted goes from the disk
+    g_SoundEngine->RetainCachedPcmKeys(std::move(liveKeys));
+
     // Clear initialization flag
     isInitializing = false;
     return success;
@@ -871,7 +1133,6 @@ void Settings::Save(const std::string& path)
         json windowJson = json::object();
         json colorsJson = json::object();
         json websocketJson = json::object();
-        json tlsOptionsJson = json::object();
         json soundsJson = json::object();
         json timersJson = json::array();
         json roomSubscriptionsJson = json::object();
@@ -899,31 +1160,10 @@ void Settings::Save(const std::string& path)
             localData["colors"] = colorsJson;
 
             // WebSocket settings
-            tlsOptionsJson["verifyPeer"] = websocket.tlsOptions.verifyPeer;
-            tlsOptionsJson["verifyHost"] = websocket.tlsOptions.verifyHost;
-            tlsOptionsJson["caFile"] = websocket.tlsOptions.caFile;
-            tlsOptionsJson["caPath"] = websocket.tlsOptions.caPath;
-            tlsOptionsJson["certFile"] = websocket.tlsOptions.certFile;
-            tlsOptionsJson["keyFile"] = websocket.tlsOptions.keyFile;
-            tlsOptionsJson["enableServerCertAuth"] = websocket.tlsOptions.enableServerCertAuth;
-
-            websocketJson["serverUrl"] = websocket.serverUrl;
-            websocketJson["autoConnect"] = websocket.autoConnect;
-            websocketJson["enabled"] = websocket.enabled;
-            websocketJson["pingInterval"] = websocket.pingInterval;
-            websocketJson["autoReconnect"] = websocket.autoReconnect;
-            websocketJson["reconnectInterval"] = websocket.reconnectInterval;
-            websocketJson["maxReconnectAttempts"] = websocket.maxReconnectAttempts;
-            websocketJson["logMessages"] = websocket.logMessages;
-            websocketJson["maxLogEntries"] = websocket.maxLogEntries;
-            websocketJson["clientId"] = websocket.clientId;
-            websocketJson["tlsOptions"] = tlsOptionsJson;
-            
+            websocketJson = Schema::ToJson(websocket);
 
             // Sound settings
-            soundsJson["masterVolume"] = sounds.masterVolume;
-            soundsJson["audioDeviceIndex"] = sounds.audioDeviceIndex;
-            soundsJson["customSoundsDirectory"] = sounds.customSoundsDirectory;
+            soundsJson = Schema::ToJson(sounds);
 
             // Sound volumes
             json soundVolumesJson = json::object();
@@ -960,12 +1200,7 @@ void Settings::Save(const std::string& path)
             json ttsSoundsJson = json::array();
             for (const auto& ttsSound : sounds.ttsSounds) {
                 try {
-                    json ttsSoundJson = json::object();
-                    ttsSoundJson["id"] = ttsSound.id;
-                    ttsSoundJson["name"] = ttsSound.name;
-                    ttsSoundJson["volume"] = ttsSound.volume;
-                    ttsSoundJson["pan"] = ttsSound.pan;
-                    ttsSoundsJson.push_back(ttsSoundJson);
+                    ttsSoundsJson.push_back(Schema::ToJson(ttsSound));
                 }
                 catch (...) {
                     if (APIDefs) {
@@ -984,7 +1219,6 @@ void Settings::Save(const std::string& path)
                 roomSubscriptionsJson[roomId] = timerIdsJson;
             }
             websocketJson["roomSubscriptions"] = roomSubscriptionsJson;
-            websocketJson["currentRoomId"] = websocket.currentRoomId;
             localData["websocket"] = websocketJson;
 
             // Timers
@@ -1011,7 +1245,9 @@ void Settings::Save(const std::string& path)
                 std::ofstream file(path);
                 if (file.is_open()) {
                     // Write the JSON with pretty formatting (indent=4)
-                    file << localData.dump(4);
+                    std::string content = localData.dump(4);
+                    file << content;
+                    lastSavedHash.store(std::hash<std::string>{}(content), std::memory_order_release);
                     file.flush();
                     file.close();
                     fileSaved = true;
@@ -1118,13 +1354,13 @@ bool Settings::GetWebSocketEnabled() {
 void Settings::SetWebSocketConnectionStatus(const std::string& status) {
     std::lock_guard<std::mutex> lock(Mutex);
     websocket.connectionStatus = status;
+    PublishRoomState();
 
     // Don't save this as it's transient
 }
 
 std::string Settings::GetWebSocketConnectionStatus() {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return websocket.connectionStatus;
+    return GetRoomState()->connectionStatus;
 }
 
 void Settings::AddWebSocketLogEntry(const std::string& direction, const std::string& message) {
@@ -1153,6 +1389,7 @@ std::string Settings::GetWebSocketClientId() {
 void Settings::SetCurrentRoom(const std::string& roomId) {
     std::lock_guard<std::mutex> lock(Mutex);
     websocket.currentRoomId = roomId;
+    PublishRoomState();
 
     // Save settings after updating
     if (!SettingsPath.empty()) {
@@ -1161,31 +1398,35 @@ void Settings::SetCurrentRoom(const std::string& roomId) {
 }
 
 std::string Settings::GetCurrentRoom() {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return websocket.currentRoomId;
+    return GetRoomState()->currentRoomId;
 }
 
 void Settings::SetAvailableRooms(const std::vector<RoomInfo>& rooms) {
     std::lock_guard<std::mutex> lock(Mutex);
     websocket.availableRooms = rooms;
+    PublishRoomState();
 
     // We don't save available rooms to disk as they're transient
     // and refreshed on connection
 }
 
 std::vector<RoomInfo> Settings::GetAvailableRooms() {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return websocket.availableRooms;
+    return GetRoomState()->availableRooms;
 }
 
 bool Settings::IsSubscribedToTimer(const std::string& timerId, const std::string& roomId) {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return websocket.isSubscribedToTimer(timerId, roomId.empty() ? websocket.currentRoomId : roomId);
+    auto state = GetRoomState();
+    const std::string& targetRoomId = roomId.empty() ? state->currentRoomId : roomId;
+    if (targetRoomId.empty()) return false;
+
+    auto roomIt = state->roomSubscriptions.find(targetRoomId);
+    return roomIt != state->roomSubscriptions.end() && roomIt->second.count(timerId) > 0;
 }
 
 void Settings::SubscribeToTimer(const std::string& timerId, const std::string& roomId) {
     std::lock_guard<std::mutex> lock(Mutex);
     websocket.subscribeToTimer(timerId, roomId.empty() ? websocket.currentRoomId : roomId);
+    PublishRoomState();
 
     // Save settings after updating subscriptions
     if (!SettingsPath.empty()) {
@@ -1196,6 +1437,7 @@ void Settings::SubscribeToTimer(const std::string& timerId, const std::string& r
 void Settings::UnsubscribeFromTimer(const std::string& timerId, const std::string& roomId) {
     std::lock_guard<std::mutex> lock(Mutex);
     websocket.unsubscribeFromTimer(timerId, roomId.empty() ? websocket.currentRoomId : roomId);
+    PublishRoomState();
 
     // Save settings after updating subscriptions
     if (!SettingsPath.empty()) {
@@ -1204,8 +1446,15 @@ void Settings::UnsubscribeFromTimer(const std::string& timerId, const std::strin
 }
 
 std::unordered_set<std::string> Settings::GetSubscriptionsForRoom(const std::string& roomId) {
-    std::lock_guard<std::mutex> lock(Mutex);
-    return websocket.getSubscriptionsForRoom(roomId.empty() ? websocket.currentRoomId : roomId);
+    auto state = GetRoomState();
+    const std::string& targetRoomId = roomId.empty() ? state->currentRoomId : roomId;
+    if (targetRoomId.empty()) return std::unordered_set<std::string>();
+
+    auto roomIt = state->roomSubscriptions.find(targetRoomId);
+    if (roomIt != state->roomSubscriptions.end()) {
+        return roomIt->second;
+    }
+    return std::unordered_set<std::string>();
 }
 
 void Settings::CleanupSubscriptions() {
@@ -1228,6 +1477,7 @@ void Settings::CleanupSubscriptions() {
             ++it;
         }
     }
+    PublishRoomState();
 
     // Save after cleanup
     if (!SettingsPath.empty()) {
@@ -6,12 +6,15 @@
 #include <unordered_set>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
+#include <memory>
 #include <chrono>
 #include <functional>
 #include "imgui/imgui.h"
 #include "nlohmann/json.hpp"
 #include "resource.h"
 #include "Sounds.h"
+#include "SettingsSchema.h"
 
 // For convenience
 using json = nlohmann::json;
@@ -55,6 +58,11 @@ struct TimerData {
     bool useWarning;
     bool isRoomTimer;     // New field: indicates if timer is from a room
     std::string roomId;   // New field: stores the room ID for room timers
+    int spatialMode;      // SpatialMode: its sounds play from a world position or direction, or as usual
+    float spatialX;       // World position in MumbleLink metres, or a unit direction
+    float spatialY;
+    float spatialZ;
+    int spatialMapId;     // Map the position was taken on
 
     TimerData()
         : name("")
@@ -65,13 +73,22 @@ struct TimerData {
         , useWarning(false)
         , isRoomTimer(false)
         , roomId("")
+        , spatialMode(0)
+        , spatialX(0.0f)
+        , spatialY(0.0f)
+        , spatialZ(0.0f)
+        , spatialMapId(0)
     {
         id = generateUniqueId("timer_");
     }
 
     TimerData(const std::string& name, float duration);
 
+    // Ids are prefix + 11 hex digits of milliseconds, 4 of sequence and 6 of client salt.
+    // Unique per client by construction, so no registry of used ids is needed.
     static std::string generateUniqueId(const std::string& prefix);
+    static void seedIdGenerator(const std::string& clientId);
+    static void observeId(const std::string& id);
     json toJson() const;
     static TimerData fromJson(const json& j);
 };
@@ -86,25 +103,8 @@ struct RoomInfo {
 
     RoomInfo() : id(""), name(""), createdAt(0), isPublic(true), clientCount(0) {}
 
-    json toJson() const {
-        json j;
-        j["id"] = id;
-        j["name"] = name;
-        j["createdAt"] = createdAt;
-        j["isPublic"] = isPublic;
-        j["clientCount"] = clientCount;
-        return j;
-    }
-
-    static RoomInfo fromJson(const json& j) {
-        RoomInfo room;
-        room.id = j.contains("id") ? j["id"].get<std::string>() : "";
-        room.name = j.contains("name") ? j["name"].get<std::string>() : "";
-        room.createdAt = j.contains("createdAt") ? j["createdAt"].get<std::time_t>() : 0;
-        room.isPublic = j.contains("isPublic") ? j["isPublic"].get<bool>() : true;
-        room.clientCount = j.contains("clientCount") ? j["clientCount"].get<int>() : 0;
-        return room;
-    }
+    json toJson() const;
+    static RoomInfo fromJson(const json& j);
 };
 
 // Sound settings structure
@@ -115,6 +115,13 @@ struct SoundSettings {
     std::vector<std::string> recentSounds; // SoundID strings
     std::string customSoundsDirectory;
     int audioDeviceIndex;
+    int soundCacheBudgetMB;     // Decoded PCM kept in memory, 0 for no limit
+    int alertCoalesceMs;        // Repeats of one sound inside this window play once
+    int maxConcurrentSounds;    // 0 for no limit
+    float alertDuckVolume;      // Other sounds' gain while a warning plays, 1 to disable
+    bool normalizeLoudness;     // Play custom files at a common measured loudness
+    bool compressIdleSounds;    // Keep long sounds unplayed for a while as ADPCM in memory
+    int ttsCacheBudgetMB;       // Synthesized speech kept in memory, 0 for no limit
 
     // TTS Sound Information
     struct TtsSoundInfo {
@@ -132,6 +139,13 @@ struct SoundSettings {
         : masterVolume(1.0f)
         , customSoundsDirectory("")
         , audioDeviceIndex(-1)
+        , soundCacheBudgetMB(64)
+        , alertCoalesceMs(150)
+        , maxConcurrentSounds(8)
+        , alertDuckVolume(0.4f)
+        , normalizeLoudness(true)
+        , compressIdleSounds(false)
+        , ttsCacheBudgetMB(16)
     {}
 
     void addRecentSound(const std::string& soundIdStr) {
@@ -366,6 +380,218 @@ struct WebSocketSettings {
     }
 };
 
+// Field tables. Keys, defaults and validation for each persisted struct live here;
+// Schema::FromJson/ToJson/WriteBinary/ReadBinary are generated from them.
+namespace Schema {
+
+    // Timer sounds are stored as "res:<id>" / "file:<path>", older files used a bare resource id
+    template <>
+    struct Codec<SoundID> {
+        static bool Read(const json& j, SoundID& out) {
+            if (!j.is_string()) return false;
+            const std::string& str = j.get_ref<const std::string&>();
+            if (str.empty()) return false;
+
+            if (str.compare(0, 4, "res:") == 0 || str.compare(0, 5, "file:") == 0) {
+                out = SoundID::FromString(str);
+                return true;
+            }
+
+            try {
+                out = SoundID(std::stoi(str));
+                return true;
+            }
+            catch (...) {
+                return false;
+            }
+        }
+        static void Write(json& j, const SoundID& value) { j = value.ToString(); }
+        static void WriteBinary(std::string& out, const SoundID& value) {
+            Codec<std::string>::WriteBinary(out, value.ToString());
+        }
+        static bool ReadBinary(const char*& p, const char* end, SoundID& value) {
+            std::string str;
+            if (!Codec<std::string>::ReadBinary(p, end, str)) return false;
+            value = SoundID::FromString(str);
+            return true;
+        }
+    };
+
+    template <>
+    struct Of<TimerData> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("id", &TimerData::id, KeepValue{}),
+            MakeField("name", &TimerData::name, ""),
+            MakeField("duration", &TimerData::duration, 0.0f, [](const float& v) { return v >= 0.0f; }),
+            MakeField("endSound", &TimerData::endSound, themes_chime_success),
+            MakeField("warningTime", &TimerData::warningTime, 30.0f, [](const float& v) { return v >= 0.0f; }),
+            MakeField("warningSound", &TimerData::warningSound, themes_chime_info),
+            MakeField("useWarning", &TimerData::useWarning, false),
+            MakeField("isRoomTimer", &TimerData::isRoomTimer, false),
+            MakeField("roomId", &TimerData::roomId, ""),
+            MakeField("spatialMode", &TimerData::spatialMode, 0, [](const int& v) { return v >= 0 && v <= 2; }),
+            MakeField("spatialX", &TimerData::spatialX, 0.0f),
+            MakeField("spatialY", &TimerData::spatialY, 0.0f),
+            MakeField("spatialZ", &TimerData::spatialZ, 0.0f),
+            MakeField("spatialMapId", &TimerData::spatialMapId, 0, [](const int& v) { return v >= 0; }));
+    };
+
+    template <>
+    struct Of<RoomInfo> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("id", &RoomInfo::id, ""),
+            MakeField("name", &RoomInfo::name, ""),
+            MakeField("createdAt", &RoomInfo::createdAt, 0),
+            MakeField("isPublic", &RoomInfo::isPublic, true),
+            MakeField("clientCount", &RoomInfo::clientCount, 0, [](const int& v) { return v >= 0; }));
+    };
+
+    // Scalar part of the "sounds" section; the volume/pan maps are read by hand
+    template <>
+    struct Of<SoundSettings> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("masterVolume", &SoundSettings::masterVolume, 1.0f, [](const float& v) { return v >= 0.0f && v <= 1.0f; }),
+            MakeField("audioDeviceIndex", &SoundSettings::audioDeviceIndex, -1),
+            MakeField("soundCacheBudgetMB", &SoundSettings::soundCacheBudgetMB, 64, [](const int& v) { return v >= 0; }),
+            MakeField("alertCoalesceMs", &SoundSettings::alertCoalesceMs, 150, [](const int& v) { return v >= 0 && v <= 2000; }),
+            MakeField("maxConcurrentSounds", &SoundSettings::maxConcurrentSounds, 8, [](const int& v) { return v >= 0; }),
+            MakeField("alertDuckVolume", &SoundSettings::alertDuckVolume, 0.4f, [](const float& v) { return v >= 0.0f && v <= 1.0f; }),
+            MakeField("normalizeLoudness", &SoundSettings::normalizeLoudness, true),
+            MakeField("compressIdleSounds", &SoundSettings::compressIdleSounds, false),
+            MakeField("ttsCacheBudgetMB", &SoundSettings::ttsCacheBudgetMB, 16, [](const int& v) { return v >= 0; }),
+            MakeField("customSoundsDirectory", &SoundSettings::customSoundsDirectory, ""));
+    };
+
+    template <>
+    struct Of<SoundSettings::TtsSoundInfo> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("id", &SoundSettings::TtsSoundInfo::id, ""),
+            MakeField("name", &SoundSettings::TtsSoundInfo::name, ""),
+            MakeField("volume", &SoundSettings::TtsSoundInfo::volume, 1.0f),
+            MakeField("pan", &SoundSettings::TtsSoundInfo::pan, 0.0f, [](const float& v) { return v >= -1.0f && v <= 1.0f; }));
+    };
+
+    template <>
+    struct Of<TlsOptions> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("verifyPeer", &TlsOptions::verifyPeer, true),
+            MakeField("verifyHost", &TlsOptions::verifyHost, true),
+            MakeField("caFile", &TlsOptions::caFile, ""),
+            MakeField("caPath", &TlsOptions::caPath, ""),
+            MakeField("certFile", &TlsOptions::certFile, ""),
+            MakeField("keyFile", &TlsOptions::keyFile, ""),
+            MakeField("enableServerCertAuth", &TlsOptions::enableServerCertAuth, true));
+    };
+
+    // Persisted part of the "websocket" section; roomSubscriptions is read by hand
+    template <>
+    struct Of<WebSocketSettings> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("serverUrl", &WebSocketSettings::serverUrl, "wss://simple-timers-wss.onrender.com"),
+            MakeField("autoConnect", &WebSocketSettings::autoConnect, false),
+            MakeField("enabled", &WebSocketSettings::enabled, false),
+            MakeField("pingInterval", &WebSocketSettings::pingInterval, 30000, [](const int& v) { return v > 0; }),
+            MakeField("autoReconnect", &WebSocketSettings::autoReconnect, true),
+            MakeField("reconnectInterval", &WebSocketSettings::reconnectInterval, 5000, [](const int& v) { return v > 0; }),
+            MakeField("maxReconnectAttempts", &WebSocketSettings::maxReconnectAttempts, 5, [](const int& v) { return v >= 0; }),
+            MakeField("logMessages", &WebSocketSettings::logMessages, true),
+            MakeField("maxLogEntries", &WebSocketSettings::maxLogEntries, 100, [](const int& v) { return v > 0; }),
+            MakeField("clientId", &WebSocketSettings::clientId, KeepValue{}),
+            MakeField("tlsOptions", &WebSocketSettings::tlsOptions, KeepValue{}),
+            MakeField("currentRoomId", &WebSocketSettings::currentRoomId, KeepValue{}));
+    };
+}
+
+inline json RoomInfo::toJson() const {
+    return Schema::ToJson(*this);
+}
+
+inline RoomInfo RoomInfo::fromJson(const json& j) {
+    RoomInfo room;
+    Schema::FromJson(j, room);
+    return room;
+}
+
+// Versioned, copy-on-write settings domain. Readers grab the current snapshot
+// without taking Settings::Mutex; writers build a fresh copy and publish it.
+template <typename T>
+class SettingsDomain {
+public:
+    SettingsDomain() : current(std::make_shared<const T>()), version(0) {}
+
+    std::shared_ptr<const T> Read() const {
+        return std::atomic_load_explicit(&current, std::memory_order_acquire);
+    }
+
+    uint64_t Version() const {
+        return version.load(std::memory_order_acquire);
+    }
+
+    void Publish(T next) {
+        next.version = version.load(std::memory_order_relaxed) + 1;
+        std::shared_ptr<const T> snapshot = std::make_shared<const T>(std::move(next));
+        std::atomic_store_explicit(&current, std::move(snapshot), std::memory_order_release);
+        version.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+private:
+    std::shared_ptr<const T> current;
+    std::atomic<uint64_t> version;
+};
+
+// Read-only view of the sound settings used by the audio path
+struct SoundStateSnapshot {
+    uint64_t version = 0;
+    float masterVolume = 1.0f;
+    int audioDeviceIndex = -1;
+    int soundCacheBudgetMB = 64;
+    int alertCoalesceMs = 150;
+    int maxConcurrentSounds = 8;
+    float alertDuckVolume = 0.4f;
+    bool normalizeLoudness = true;
+    bool compressIdleSounds = false;
+    int ttsCacheBudgetMB = 16;
+    std::string customSoundsDirectory;
+    std::unordered_map<std::string, float> soundVolumes;
+    std::unordered_map<std::string, float> soundPans;
+};
+
+// Read-only view of the room/connection state used by the render and network threads
+struct RoomStateSnapshot {
+    uint64_t version = 0;
+    std::string connectionStatus = "Disconnected";
+    std::string currentRoomId;
+    std::vector<RoomInfo> availableRooms;
+    std::unordered_map<std::string, std::unordered_set<std::string>> roomSubscriptions;
+};
+
+// Parsed contents of an externally edited settings file
+struct SettingsReload {
+    std::vector<TimerData> timers;      // Local timers only, room timers belong to the server
+    bool hasSounds = false;
+    SoundSettings sounds;               // Scalars plus the volume/pan maps
+    bool needsSave = false;             // Some timers had no id and got a generated one
+};
+
+// What Settings::ApplyReload changed, so callers can patch activeTimers and keybinds
+struct SettingsReloadResult {
+    struct TimerChange {
+        std::string id;
+        float oldDuration;
+        float newDuration;
+    };
+
+    std::vector<TimerChange> addedTimers;
+    std::vector<TimerChange> changedTimers;
+    std::vector<std::string> removedTimers;
+    bool soundsChanged = false;
+    bool soundsDirectoryChanged = false;
+
+    bool empty() const {
+        return addedTimers.empty() && changedTimers.empty() && removedTimers.empty() && !soundsChanged;
+    }
+};
+
 // Main settings class
 class Settings {
 public:
@@ -374,9 +600,17 @@ public:
     static void ScheduleSave(const std::string& path);
     static void InitializeDefaults();
 
+    // Hot reload: diff an externally edited file against the live state
+    static SettingsReloadResult ApplyReload(const SettingsReload& reload);
+    static size_t GetLastSavedHash() { return lastSavedHash.load(std::memory_order_acquire); }
+
     // Timer management
     static TimerData& AddTimer(const std::string& name, float duration);
+    static TimerData& AddTimer(const std::string& name, float duration, const std::string& id);    // Keeps a server's id
+    static void AddTimers(std::vector<TimerData>&& batch);     // One lock for a whole batch
     static void RemoveTimer(const std::string& id);
+    // Drops a room's timers the server no longer lists, returns their ids
+    static std::vector<std::string> RemoveRoomTimers(const std::string& roomId, const std::unordered_set<std::string>& keepIds);
     static TimerData* FindTimer(const std::string& id);
 
     // Sound settings
@@ -392,9 +626,24 @@ public:
     static float GetFileSoundPan(const std::string& filePath);
     static void SetAudioDeviceIndex(int index);
     static int GetAudioDeviceIndex();
+    static void SetSoundCacheBudgetMB(int megabytes);
+    static int GetSoundCacheBudgetMB();
+    static void SetAlertCoalesceMs(int milliseconds);
+    static int GetAlertCoalesceMs();
+    static void SetMaxConcurrentSounds(int count);
+    static int GetMaxConcurrentSounds();
+    static void SetAlertDuckVolume(float volume);
+    static float GetAlertDuckVolume();
+    static void SetNormalizeLoudness(bool enabled);
+    static bool GetNormalizeLoudness();
+    static void SetCompressIdleSounds(bool enabled);
+    static bool GetCompressIdleSounds();
+    static void SetTtsCacheBudgetMB(int megabytes);
+    static int GetTtsCacheBudgetMB();
     static void SetCustomSoundsDirectory(const std::string& directory);
     static std::string GetCustomSoundsDirectory();
     static void AddRecentSound(const std::string& soundIdStr);
+    static bool AddRecentSounds(const std::vector<std::string>& soundIdStrs);   // In play order, true if the list changed; doesn't save
     static const std::vector<std::string>& GetRecentSounds();
     static void AddTtsSound(const std::string& soundId, const std::string& name, float volume = 1.0f, float pan = 0.0f);
     static const std::vector<SoundSettings::TtsSoundInfo>& GetTtsSounds();
@@ -425,6 +674,11 @@ public:
     static std::unordered_set<std::string> GetSubscriptionsForRoom(const std::string& roomId = "");
     static void CleanupSubscriptions();
 
+    // Lock-free snapshots for per-frame readers
+    static std::shared_ptr<const SoundStateSnapshot> GetSoundState() { return soundState.Read(); }
+    static std::shared_ptr<const RoomStateSnapshot> GetRoomState() { return roomState.Read(); }
+    static uint64_t GetTimersVersion() { return timersVersion.load(std::memory_order_acquire); }
+
 public:
     // Public properties for window
     static ImVec2 windowPosition;
@@ -433,7 +687,6 @@ public:
     static bool allowResize;
     static WindowColors colors;
     static std::vector<TimerData> timers;
-    static std::unordered_set<std::string> usedIds;
     static SoundSettings sounds;
     static WebSocketSettings websocket;
 
@@ -449,6 +702,17 @@ private:
     static bool saveScheduled;
     static std::chrono::steady_clock::time_point lastSaveRequest;
     static const std::chrono::milliseconds saveCooldown;
+    static std::atomic<size_t> lastSavedHash;      // Hash of the last file we wrote, so the watcher skips our own saves
+
+    // Snapshot domains, republished by writers while holding Mutex
+    static SettingsDomain<SoundStateSnapshot> soundState;
+    static SettingsDomain<RoomStateSnapshot> roomState;
+    static std::atomic<uint64_t> timersVersion;
+    static std::unordered_map<std::string, size_t> timerIndex;     // id -> position in timers, kept by every writer
+    static void RebuildTimerIndex();
+    static void PublishSoundState();
+    static void PublishRoomState();
+    static void BumpTimersVersion() { timersVersion.fetch_add(1, std::memory_order_acq_rel); }
 };
 
 // Global settings file path
@@ -20,6 +20,11 @@ struct ActiveTimer {
     bool warningPlayed;
     std::string roomId; // Empty for local timers, room ID for online timers
 
+    // Sounds scheduled ahead of the warning and the end, cancelled if the timer is paused or reset first
+    uint64_t scheduledWarning = 0;
+    uint64_t scheduledEnd = 0;
+    bool endScheduled = false;
+
     // Default constructor - required for std::map
     ActiveTimer()
         : id(""), remainingTime(0.0f), isPaused(true), warningPlayed(false), roomId("") {}
@@ -75,7 +80,7 @@ void initializeActiveTimers();
 std::string FormatDuration(float seconds);
 
 bool LoadSoundResource(int resourceId);
-void PlaySoundEffect(const SoundID& soundId);
+void PlaySoundEffect(const SoundID& soundId, AlertPriority priority);
 
 // For backward compatibility
 inline void PlaySoundEffect(int resourceId) {
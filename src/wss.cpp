@@ -1682,22 +1682,11 @@ void WebSocketClient::handleRoomMessage(const json& data) {
                 }
 
                 // Clean up any timers in settings from this room that don't exist on the server
-                auto it = Settings::timers.begin();
-                while (it != Settings::timers.end()) {
-                    if (it->isRoomTimer && it->roomId == roomId &&
-                        validTimerIds.find(it->id) == validTimerIds.end()) {
-                        // This timer is from the current room but doesn't exist on the server
-                        std::string timerId = it->id; // Save ID before erasing
-                        it = Settings::timers.erase(it);
-
-                        if (APIDefs) {
-                            char logMsg[256];
-                            sprintf_s(logMsg, "Removed invalid room timer from settings: %s", timerId.c_str());
-                            APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
-                        }
-                    }
-                    else {
-                        ++it;
+                for (const auto& timerId : Settings::RemoveRoomTimers(roomId, validTimerIds)) {
+                    if (APIDefs) {
+                        char logMsg[256];
+                        sprintf_s(logMsg, "Removed invalid room timer from settings: %s", timerId.c_str());
+                        APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
                     }
                 }
 
@@ -1784,8 +1773,7 @@ void WebSocketClient::handleRoomMessage(const json& data) {
                     TimerData* settingsTimer = Settings::FindTimer(timerId);
                     if (!settingsTimer) {
                         // Create a new timer entry
-                        TimerData& newTimer = Settings::AddTimer(name, duration);
-                        newTimer.id = timerId;
+                        TimerData& newTimer = Settings::AddTimer(name, duration, timerId);
                         newTimer.isRoomTimer = true;
                         newTimer.roomId = roomId;
 
@@ -1947,9 +1935,7 @@ void WebSocketClient::handleTimerMessage(const json& data) {
                 // Create a local TimerData entry if it doesn't exist
                 TimerData* settingsTimer = Settings::FindTimer(timerId);
                 if (!settingsTimer) {
-                    TimerData& newTimer = Settings::AddTimer(name, duration);
-                    // Override the generated ID with the server's ID
-                    newTimer.id = timerId;
+                    TimerData& newTimer = Settings::AddTimer(name, duration, timerId);
                     // Mark as room timer
                     newTimer.isRoomTimer = true;
                     newTimer.roomId = roomId;
@@ -2046,9 +2032,7 @@ void WebSocketClient::handleTimerMessage(const json& data) {
                         // If we received a timer update but don't have a local entry, create one
                         float duration = data["timer"].value("duration", 0.0f);
                         if (duration > 0) {
-                            TimerData& newTimer = Settings::AddTimer(name, duration);
-                            // Replace the auto-generated ID with the server's timer ID
-                            newTimer.id = timerId;
+                            TimerData& newTimer = Settings::AddTimer(name, duration, timerId);
                             // Mark as room timer and set room ID
                             newTimer.isRoomTimer = true;
                             newTimer.roomId = roomId;
@@ -2172,8 +2156,7 @@ void WebSocketClient::handleTimerMessage(const json& data) {
                     TimerData* settingsTimer = Settings::FindTimer(timerId);
                     if (!settingsTimer) {
                         // Create a new timer entry
-                        TimerData& newTimer = Settings::AddTimer(name, duration);
-                        newTimer.id = timerId;
+                        TimerData& newTimer = Settings::AddTimer(name, duration, timerId);
                         newTimer.isRoomTimer = true;
                         newTimer.roomId = roomId;
                     }
@@ -2236,22 +2219,11 @@ void WebSocketClient::handleTimerMessage(const json& data) {
 
 void WebSocketClient::cleanupInvalidTimers(const std::unordered_set<std::string>& validTimerIds, const std::string& roomId) {
     // Remove any timers from settings that aren't in the validTimerIds set
-    auto it = Settings::timers.begin();
-    while (it != Settings::timers.end()) {
-        if (it->isRoomTimer && it->roomId == roomId &&
-            validTimerIds.find(it->id) == validTimerIds.end()) {
-            // This timer no longer exists on the server
-            std::string timerId = it->id; // Save before erasing
-            it = Settings::timers.erase(it);
-
-            if (APIDefs) {
-                char logMsg[256];
-                sprintf_s(logMsg, "Removed invalid room timer from settings: %s", timerId.c_str());
-                APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
-            }
-        }
-        else {
-            ++it;
+    for (const auto& timerId : Settings::RemoveRoomTimers(roomId, validTimerIds)) {
+        if (APIDefs) {
+            char logMsg[256];
+            sprintf_s(logMsg, "Removed invalid room timer from settings: %s", timerId.c_str());
+            APIDefs->Log(ELogLevel_INFO, ADDON_NAME, logMsg);
         }
     }
 
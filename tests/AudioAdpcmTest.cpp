@@ -0,0 +1,148 @@
+#include "TestCheck.h"
+#include "AudioAdpcm.h"
+#include "AudioMixer.h"
+#include <cstring>
+#include <thread>
+#include <vector>
+
+// IMA-ADPCM clips: size, quality on a tone, decoding in pieces, the background compressor,
+// and the mixer playing a compressed clip as it would the decoded PCM
+
+static std::vector<float> Tone(size_t frames) {
+    std::vector<float> samples(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        samples[i * 2] = 0.5f * std::sin(static_cast<float>(i) * 0.0576f);
+        samples[i * 2 + 1] = 0.3f * std::sin(static_cast<float>(i) * 0.1309f);
+    }
+    return samples;
+}
+
+static double SignalToNoiseDb(const std::vector<float>& original, const std::vector<float>& decoded) {
+    double signal = 0.0;
+    double noise = 0.0;
+    for (size_t i = 0; i < original.size(); i++) {
+        signal += static_cast<double>(original[i]) * original[i];
+        double error = static_cast<double>(decoded[i]) - original[i];
+        noise += error * error;
+    }
+    return noise > 0.0 ? 10.0 * std::log10(signal / noise) : 200.0;
+}
+
+static void TestRoundTrip() {
+    // Not a whole number of blocks, so the last one is short
+    const size_t frames = AdpcmBlockFrames * 10 + 123;
+    std::vector<float> tone = Tone(frames);
+    AdpcmClip clip;
+    CHECK(EncodeAdpcm(tone.data(), frames, clip));
+    CHECK(clip.frames == frames);
+    CHECK(clip.Bytes() == 11 * AdpcmBlockHeader + frames);
+    CHECK(clip.Bytes() * 7 < frames * 2 * sizeof(float));
+
+    std::vector<float> decoded;
+    DecodeAdpcm(clip, decoded);
+    CHECK(decoded.size() == tone.size());
+    CHECK(SignalToNoiseDb(tone, decoded) > 30.0);
+
+    // Read in odd pieces, it gives exactly the same samples
+    AdpcmReader reader(&clip);
+    std::vector<float> pieces(frames * 2);
+    size_t done = 0;
+    for (size_t piece = 1; done < frames; piece = piece * 3 % 1000 + 1) {
+        size_t read = reader.Read(pieces.data() + done * 2, (std::min)(piece, frames - done));
+        CHECK(read > 0);
+        if (read == 0) break;
+        done += read;
+    }
+    CHECK(reader.Read(pieces.data(), 1) == 0);
+    CHECK(memcmp(pieces.data(), decoded.data(), decoded.size() * sizeof(float)) == 0);
+}
+
+static void TestEdges() {
+    AdpcmClip clip;
+    CHECK(!EncodeAdpcm(nullptr, 10, clip));
+    std::vector<float> one = { 0.25f, -0.25f };
+    CHECK(!EncodeAdpcm(one.data(), 0, clip));
+
+    // Silence stays silent
+    std::vector<float> silence(AdpcmBlockFrames * 2 * 2, 0.0f);
+    CHECK(EncodeAdpcm(silence.data(), AdpcmBlockFrames * 2, clip));
+    std::vector<float> decoded;
+    DecodeAdpcm(clip, decoded);
+    float loudest = 0.0f;
+    for (float sample : decoded) {
+        loudest = (std::max)(loudest, std::fabs(sample));
+    }
+    CHECK(loudest < 0.001f);
+
+    // Past full scale saturates rather than wrapping
+    std::vector<float> loud(4096 * 2);
+    for (size_t i = 0; i < loud.size(); i++) {
+        loud[i] = (i / 2) % 200 < 100 ? 4.0f : -4.0f;
+    }
+    CHECK(EncodeAdpcm(loud.data(), 4096, clip));
+    DecodeAdpcm(clip, decoded);
+    for (size_t i = 0; i < decoded.size(); i++) {
+        CHECK(decoded[i] >= -1.0f && decoded[i] < 1.0f);
+    }
+    CHECK(decoded[150 * 2] < -0.9f && decoded[250 * 2] > 0.9f);
+}
+
+static void TestCompressor() {
+    const size_t frames = 48000;
+    auto tone = std::make_shared<std::vector<float>>(Tone(frames));
+    AdpcmClip expected;
+    CHECK(EncodeAdpcm(tone->data(), frames, expected));
+
+    AdpcmCompressor compressor;
+    compressor.Start();
+    compressor.Request(42, tone->data(), frames, tone);
+
+    std::vector<AdpcmCompressor::Result> results;
+    for (int attempt = 0; attempt < 500 && results.empty(); attempt++) {
+        results = compressor.TakeResults();
+        if (results.empty()) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+    }
+    compressor.Stop();
+
+    CHECK(results.size() == 1);
+    if (results.size() != 1) return;
+    CHECK(results[0].tag == 42);
+    CHECK(results[0].source == tone->data());
+    CHECK(results[0].clip && results[0].clip->data == expected.data && results[0].clip->frames == frames);
+    CHECK(tone.use_count() == 1);
+}
+
+static void TestMixerPlaysCompressed() {
+    // Longer than the mixer's scratch buffer, so it is decoded in several pieces per block
+    const size_t frames = 4800;
+    std::vector<float> tone = Tone(frames);
+    AdpcmClip clip;
+    CHECK(EncodeAdpcm(tone.data(), frames, clip));
+    std::vector<float> decoded;
+    DecodeAdpcm(clip, decoded);
+
+    AudioMixer mixer(48000);
+    mixer.Play(&clip, nullptr, 0.5f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    std::vector<float> out(frames * 2);
+    for (size_t block = 0; block < frames / 480; block++) {
+        mixer.Render(out.data() + block * 480 * 2, 480);
+    }
+
+    size_t mismatched = 0;
+    for (size_t i = 0; i < out.size(); i++) {
+        mismatched += out[i] != decoded[i] * 0.5f;
+    }
+    CHECK(mismatched == 0);
+    CHECK(mixer.GetPlayingCount() == 0);
+    CHECK(mixer.TakeFinished().size() == 1);
+}
+
+int main() {
+    TestRoundTrip();
+    TestEdges();
+    TestCompressor();
+    TestMixerPlaysCompressed();
+    return CheckResult("AudioAdpcmTest");
+}
@@ -0,0 +1,212 @@
+#include "TestCheck.h"
+#include "AudioConvert.h"
+#include <cstring>
+#include <random>
+#include <vector>
+
+// The SSE2 kernels against their scalar versions, bit for bit, plus known values for
+// every sample format and the WAV chunk reader
+
+static std::vector<float> RandomFloats(std::mt19937& random, size_t count) {
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> values(count);
+    for (auto& value : values) {
+        value = distribution(random);
+    }
+    return values;
+}
+
+static bool SameBits(const std::vector<float>& a, const std::vector<float>& b) {
+    return a.size() == b.size() && memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+
+static void TestKernelsMatchScalar() {
+    std::mt19937 random(37);
+
+    // Lengths around the vector widths, and an offset so loads are unaligned
+    for (size_t count : { 0, 1, 3, 4, 7, 8, 9, 15, 16, 17, 1000, 44101 }) {
+        std::vector<int16_t> pcm(count + 1);
+        for (auto& sample : pcm) {
+            sample = static_cast<int16_t>(random());
+        }
+        std::vector<float> simd(count), scalar(count);
+        ConvertS16ToFloat(pcm.data() + 1, simd.data(), count);
+        ConvertS16ToFloatScalar(pcm.data() + 1, scalar.data(), count);
+        CHECK(SameBits(simd, scalar));
+
+        std::vector<float> mono = RandomFloats(random, count + 1);
+        std::vector<float> stereoSimd(count * 2), stereoScalar(count * 2);
+        DuplicateMonoToStereo(mono.data() + 1, stereoSimd.data(), count);
+        DuplicateMonoToStereoScalar(mono.data() + 1, stereoScalar.data(), count);
+        CHECK(SameBits(stereoSimd, stereoScalar));
+
+        for (uint32_t rate : { 8000u, 11025u, 22050u, 44100u, 48000u, 96000u, 192000u }) {
+            std::vector<float> in = RandomFloats(random, count * 2);
+            size_t outFrames = ResampledFrameCount(count, rate, EngineSampleRate);
+            std::vector<float> outSimd(outFrames * 2), outScalar(outFrames * 2);
+            ResampleStereoLinear(in.data(), count, rate, outSimd.data(), outFrames, EngineSampleRate);
+            ResampleStereoLinearScalar(in.data(), count, rate, outScalar.data(), outFrames, EngineSampleRate);
+            CHECK(SameBits(outSimd, outScalar));
+        }
+    }
+}
+
+static void TestSampleFormats() {
+    // 16-bit: full scale is 32768
+    const int16_t s16[] = { -32768, -16384, 0, 1, 16384, 32767 };
+    float converted[6];
+    ConvertS16ToFloat(s16, converted, 6);
+    CHECK(converted[0] == -1.0f);
+    CHECK(converted[1] == -0.5f);
+    CHECK(converted[2] == 0.0f);
+    CHECK(converted[3] == 1.0f / 32768.0f);
+    CHECK(converted[4] == 0.5f);
+    CHECK(converted[5] == 32767.0f / 32768.0f);
+
+    AudioFormat format;
+    format.formatTag = AudioFormat::PCM;
+    format.channels = 2;
+    format.sampleRate = EngineSampleRate;
+    std::vector<float> out;
+
+    // 8-bit is unsigned around 128
+    format.bitsPerSample = 8;
+    const uint8_t u8[] = { 0, 128, 192, 255 };
+    CHECK(ConvertToEngineFormat(format, u8, sizeof(u8), out));
+    CHECK(out.size() == 4 && out[0] == -1.0f && out[1] == 0.0f && out[2] == 0.5f && out[3] == 127.0f / 128.0f);
+
+    // 24-bit little-endian, sign extended
+    format.bitsPerSample = 24;
+    const uint8_t s24[] = { 0x00, 0x00, 0x80, 0x00, 0x00, 0x40, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f };
+    CHECK(ConvertToEngineFormat(format, s24, sizeof(s24), out));
+    CHECK(out.size() == 4 && out[0] == -1.0f && out[1] == 0.5f && out[2] == -1.0f / 8388608.0f && out[3] == 8388607.0f / 8388608.0f);
+
+    // 32-bit integer
+    format.bitsPerSample = 32;
+    const int32_t s32[] = { INT32_MIN, 1 << 30 };
+    CHECK(ConvertToEngineFormat(format, s32, sizeof(s32), out));
+    CHECK(out.size() == 2 && out[0] == -1.0f && out[1] == 0.5f);
+
+    // Float is copied as it is
+    format.formatTag = AudioFormat::Float;
+    const float f32[] = { 0.25f, -0.75f };
+    CHECK(ConvertToEngineFormat(format, f32, sizeof(f32), out));
+    CHECK(out.size() == 2 && out[0] == 0.25f && out[1] == -0.75f);
+
+    // Mono goes to both sides; more than two channels keep the front pair
+    format.formatTag = AudioFormat::PCM;
+    format.bitsPerSample = 16;
+    format.channels = 1;
+    const int16_t mono[] = { 16384, -16384 };
+    CHECK(ConvertToEngineFormat(format, mono, sizeof(mono), out));
+    CHECK(out.size() == 4 && out[0] == 0.5f && out[1] == 0.5f && out[2] == -0.5f && out[3] == -0.5f);
+
+    format.channels = 6;
+    const int16_t surround[] = { 16384, -16384, 1000, 2000, 3000, 4000 };
+    CHECK(ConvertToEngineFormat(format, surround, sizeof(surround), out));
+    CHECK(out.size() == 2 && out[0] == 0.5f && out[1] == -0.5f);
+
+    // Unsupported layouts are refused
+    format.channels = 2;
+    format.bitsPerSample = 12;
+    CHECK(!ConvertToEngineFormat(format, s16, sizeof(s16), out));
+}
+
+static void TestResampler() {
+    CHECK(ResampledFrameCount(0, 44100, 48000) == 0);
+    CHECK(ResampledFrameCount(44100, 44100, 48000) == 48000);
+    CHECK(ResampledFrameCount(1, 192000, 48000) == 1);
+
+    // Doubling the rate of a ramp puts the new frames exactly halfway
+    std::vector<float> ramp(200);
+    for (size_t i = 0; i < 100; i++) {
+        ramp[i * 2] = static_cast<float>(i);
+        ramp[i * 2 + 1] = -static_cast<float>(i);
+    }
+    size_t doubled = ResampledFrameCount(100, 24000, 48000);
+    CHECK(doubled == 200);
+    std::vector<float> out(doubled * 2);
+    ResampleStereoLinear(ramp.data(), 100, 24000, out.data(), doubled, 48000);
+    for (size_t j = 0; j < 198; j++) {
+        CHECK(out[j * 2] == static_cast<float>(j) * 0.5f);
+        CHECK(out[j * 2 + 1] == -static_cast<float>(j) * 0.5f);
+    }
+    // Past the last source frame it holds
+    CHECK(out[199 * 2] == 99.0f);
+
+    // Positions are exact ratios, so ten seconds of 44.1 kHz end where they should
+    const size_t longFrames = 441000;
+    std::vector<float> longRamp(longFrames * 2);
+    for (size_t i = 0; i < longFrames; i++) {
+        longRamp[i * 2] = static_cast<float>(i);
+        longRamp[i * 2 + 1] = static_cast<float>(i);
+    }
+    size_t outFrames = ResampledFrameCount(longFrames, 44100, 48000);
+    CHECK(outFrames == 480000);
+    std::vector<float> resampled(outFrames * 2);
+    ResampleStereoLinear(longRamp.data(), longFrames, 44100, resampled.data(), outFrames, 48000);
+    double worst = 0.0;
+    for (size_t j = 0; j + 1 < outFrames; j++) {
+        double expected = static_cast<double>(j) * 44100.0 / 48000.0;
+        worst = (std::max)(worst, std::fabs(resampled[j * 2] - expected));
+    }
+    CHECK_NEAR(worst, 0.0, 0.05);
+}
+
+static void PutChunk(std::vector<uint8_t>& image, const char* id, const void* body, uint32_t size) {
+    image.insert(image.end(), id, id + 4);
+    const uint8_t* sizeBytes = reinterpret_cast<const uint8_t*>(&size);
+    image.insert(image.end(), sizeBytes, sizeBytes + 4);
+    const uint8_t* bodyBytes = static_cast<const uint8_t*>(body);
+    image.insert(image.end(), bodyBytes, bodyBytes + size);
+    if (size & 1) {
+        image.push_back(0);
+    }
+}
+
+static void TestWavChunks() {
+    // WAVE_FORMAT_EXTENSIBLE 24-bit stereo, an odd-sized chunk before data, and a data
+    // chunk that claims more than the file holds
+    uint8_t fmt[40] = {};
+    uint16_t tag = 0xFFFE, channels = 2, bits = 24;
+    uint32_t rate = 44100;
+    memcpy(fmt, &tag, 2);
+    memcpy(fmt + 2, &channels, 2);
+    memcpy(fmt + 4, &rate, 4);
+    memcpy(fmt + 14, &bits, 2);
+
+    std::vector<uint8_t> image = { 'R', 'I', 'F', 'F', 0, 0, 0, 0, 'W', 'A', 'V', 'E' };
+    PutChunk(image, "fmt ", fmt, sizeof(fmt));
+    PutChunk(image, "LIST", "odd", 3);
+    uint8_t samples[12] = { 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12 };
+    PutChunk(image, "data", samples, sizeof(samples));
+    uint32_t claimed = 1000;
+    memcpy(image.data() + image.size() - sizeof(samples) - 4, &claimed, 4);
+
+    const uint8_t* fmtChunk = nullptr;
+    const uint8_t* pcm = nullptr;
+    uint32_t fmtSize = 0;
+    uint32_t pcmSize = 0;
+    CHECK(FindWavChunks(image.data(), image.size(), fmtChunk, fmtSize, pcm, pcmSize));
+    CHECK(fmtSize == sizeof(fmt));
+    CHECK(pcmSize == sizeof(samples));
+    CHECK(pcm && memcmp(pcm, samples, sizeof(samples)) == 0);
+
+    AudioFormat format = ParseWavFormat(fmtChunk, fmtSize);
+    CHECK(format.formatTag == AudioFormat::PCM);
+    CHECK(format.channels == 2 && format.sampleRate == 44100 && format.bitsPerSample == 24);
+
+    // No data chunk at all
+    std::vector<uint8_t> noData(image.begin(), image.begin() + 12);
+    PutChunk(noData, "fmt ", fmt, sizeof(fmt));
+    CHECK(!FindWavChunks(noData.data(), noData.size(), fmtChunk, fmtSize, pcm, pcmSize));
+    CHECK(!FindWavChunks(image.data(), 8, fmtChunk, fmtSize, pcm, pcmSize));
+}
+
+int main() {
+    TestKernelsMatchScalar();
+    TestSampleFormats();
+    TestResampler();
+    TestWavChunks();
+    return CheckResult("AudioConvertTest");
+}
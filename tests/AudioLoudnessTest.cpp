@@ -0,0 +1,152 @@
+#include "TestCheck.h"
+#include "AudioLoudness.h"
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Loudness against the reference points of ITU-R BS.1770: a 1 kHz sine at the same level
+// on both channels reads its RMS level in LUFS plus 3 dB, and a full-scale one 0 LUFS
+
+static std::vector<float> Sine(size_t frames, float frequency, float amplitude, float phase = 0.0f) {
+    const double pi = 3.14159265358979323846;
+    std::vector<float> samples(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        float value = amplitude * static_cast<float>(std::sin(2.0 * pi * frequency * i / 48000.0 + phase));
+        samples[i * 2] = value;
+        samples[i * 2 + 1] = value;
+    }
+    return samples;
+}
+
+static void TestSineLoudness() {
+    LoudnessInfo info;
+    std::vector<float> tone = Sine(48000 * 3, 1000.0f, 0.1f);
+    CHECK(MeasureLoudness(tone.data(), 48000 * 3, 48000, info));
+    CHECK_NEAR(info.integratedLufs, -20.0, 0.2);
+    CHECK_NEAR(info.truePeakDb, -20.0, 0.1);
+
+    // Silence after the tone is gated out rather than averaged in, which would read 3 dB
+    // lower; only the blocks straddling the end of the tone pull it down a little
+    std::vector<float> withSilence = tone;
+    withSilence.resize(tone.size() * 2, 0.0f);
+    LoudnessInfo gated;
+    CHECK(MeasureLoudness(withSilence.data(), 48000 * 6, 48000, gated));
+    CHECK_NEAR(gated.integratedLufs, info.integratedLufs, 0.3);
+
+    // Shorter than one 400 ms block, measured as one
+    LoudnessInfo chime;
+    CHECK(MeasureLoudness(tone.data(), 4800, 48000, chime));
+    CHECK_NEAR(chime.integratedLufs, -20.0, 0.5);
+}
+
+static void TestTruePeak() {
+    // A quarter of the sample rate at 45 degrees: every sample is 3 dB below the peak
+    // between them, which only the oversampled measurement sees
+    const float quarterPi = 0.78539816f;
+    std::vector<float> tone = Sine(48000, 12000.0f, 0.5f, quarterPi);
+    float samplePeak = 0.0f;
+    for (float sample : tone) {
+        samplePeak = (std::max)(samplePeak, std::fabs(sample));
+    }
+    CHECK_NEAR(20.0 * std::log10(samplePeak), -9.03, 0.05);
+
+    LoudnessInfo info;
+    CHECK(MeasureLoudness(tone.data(), 48000, 48000, info));
+    CHECK_NEAR(info.truePeakDb, -6.02, 0.5);
+}
+
+static void TestSilence() {
+    std::vector<float> silence(48000 * 2, 0.0f);
+    LoudnessInfo info;
+    CHECK(MeasureLoudness(silence.data(), 48000, 48000, info));
+    CHECK(info.integratedLufs == -100.0f);
+    CHECK(info.truePeakDb == -100.0f);
+    CHECK(info.NormalizationGain() == 1.0f);
+
+    CHECK(!MeasureLoudness(nullptr, 48000, 48000, info));
+    CHECK(!MeasureLoudness(silence.data(), 0, 48000, info));
+}
+
+static void TestNormalizationGain() {
+    auto gainDb = [](float lufs, float peak) {
+        LoudnessInfo info;
+        info.integratedLufs = lufs;
+        info.truePeakDb = peak;
+        return 20.0 * std::log10(info.NormalizationGain());
+    };
+
+    CHECK_NEAR(gainDb(LoudnessTargetLufs, -10.0f), 0.0, 1e-4);
+    CHECK_NEAR(gainDb(-10.0f, -2.0f), -8.0, 1e-4);
+    // Limited to +-12 dB
+    CHECK_NEAR(gainDb(-40.0f, -30.0f), 12.0, 1e-4);
+    CHECK_NEAR(gainDb(0.0f, 0.0f), -12.0, 1e-4);
+    // Never pushes the true peak past -1 dBTP
+    CHECK_NEAR(gainDb(-25.0f, -3.0f), 2.0, 1e-4);
+    // Below the absolute gate counts as silence
+    CHECK_NEAR(gainDb(-80.0f, -60.0f), 0.0, 1e-4);
+}
+
+static bool WaitForResult(LoudnessAnalyzer& analyzer, LoudnessAnalyzer::Result& result) {
+    for (int attempt = 0; attempt < 500; attempt++) {
+        std::vector<LoudnessAnalyzer::Result> results = analyzer.TakeResults();
+        if (!results.empty()) {
+            result = results.front();
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    return false;
+}
+
+static void TestAnalyzerCache() {
+    std::filesystem::path directory = MakeTestDirectory("AudioLoudnessTest");
+    std::string soundPath = (directory / "alert.wav").string();
+    std::string cachePath = (directory / "loudness.json").string();
+    {
+        std::ofstream file(soundPath, std::ios::binary);
+        file << "stands in for the sound file";
+    }
+
+    auto tone = std::make_shared<std::vector<float>>(Sine(48000, 1000.0f, 0.1f));
+    LoudnessInfo measured;
+    {
+        LoudnessAnalyzer analyzer;
+        analyzer.Start(cachePath);
+
+        LoudnessInfo info;
+        CHECK(!analyzer.Lookup(soundPath, info));
+        analyzer.Request(soundPath, tone->data(), 48000, 48000, tone);
+
+        LoudnessAnalyzer::Result result;
+        CHECK(WaitForResult(analyzer, result));
+        CHECK(result.ok && result.path == soundPath);
+        CHECK_NEAR(result.info.integratedLufs, -20.0, 0.2);
+        CHECK(analyzer.Lookup(soundPath, measured));
+        CHECK(measured.integratedLufs == result.info.integratedLufs);
+        analyzer.Stop();
+    }
+    CHECK(tone.use_count() == 1);
+
+    // A later run reads it from the cache file, until the file changes
+    LoudnessAnalyzer analyzer;
+    analyzer.Start(cachePath);
+    LoudnessInfo cached;
+    CHECK(analyzer.Lookup(soundPath, cached));
+    CHECK(cached.integratedLufs == measured.integratedLufs);
+    CHECK(cached.truePeakDb == measured.truePeakDb);
+    {
+        std::ofstream file(soundPath, std::ios::binary | std::ios::app);
+        file << ", now longer";
+    }
+    CHECK(!analyzer.Lookup(soundPath, cached));
+    analyzer.Stop();
+}
+
+int main() {
+    TestSineLoudness();
+    TestTruePeak();
+    TestSilence();
+    TestNormalizationGain();
+    TestAnalyzerCache();
+    return CheckResult("AudioLoudnessTest");
+}
@@ -0,0 +1,73 @@
+#include "Benchmark.h"
+#include "AudioMixer.h"
+#include <random>
+#include <vector>
+
+// 64 clips mixed at once, the worst case of many timers going off together, in 10 ms
+// blocks at 48 kHz with a gain change every few blocks so the ramps are exercised.
+// Compressed clips add their decoding on the render thread.
+
+static const uint32_t Block = 480;
+static const size_t Clips = 64;
+
+static double RenderMicroseconds(AudioMixer& mixer, int blocks) {
+    std::vector<float> out(Block * 2);
+    mixer.Render(out.data(), Block);
+    auto start = std::chrono::steady_clock::now();
+    for (int block = 0; block < blocks; block++) {
+        if (block % 7 == 0) {
+            mixer.SetMasterGain(block % 2 ? 1.0f : 0.5f);
+        }
+        mixer.Render(out.data(), Block);
+    }
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count() / blocks;
+}
+
+int main() {
+    const int blocks = 800;
+    const size_t frames = 48000 * 10;
+    std::mt19937 random(38);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> samples(frames * 2);
+    for (auto& sample : samples) {
+        sample = distribution(random);
+    }
+
+    AudioMixer pcmMixer(48000);
+    for (size_t i = 0; i < Clips; i++) {
+        pcmMixer.Play(samples.data() + i * 2, frames - Clips, nullptr, 0.5f + i * 0.005f, (static_cast<int>(i % 9) - 4) / 4.0f,
+            std::chrono::steady_clock::now(), nullptr);
+    }
+    double pcmUs = RenderMicroseconds(pcmMixer, blocks);
+    printf("%zu PCM clips: %.2f us per 10 ms block (%.3f%% of real time), %zu playing\n",
+        Clips, pcmUs, pcmUs / 100.0, pcmMixer.GetPlayingCount());
+
+    AdpcmClip adpcm;
+    EncodeAdpcm(samples.data(), frames, adpcm);
+    AudioMixer adpcmMixer(48000);
+    for (size_t i = 0; i < Clips; i++) {
+        adpcmMixer.Play(&adpcm, nullptr, 0.5f + i * 0.005f, (static_cast<int>(i % 9) - 4) / 4.0f,
+            std::chrono::steady_clock::now(), nullptr);
+    }
+    double adpcmUs = RenderMicroseconds(adpcmMixer, blocks);
+    printf("%zu ADPCM clips: %.2f us per 10 ms block (%.3f%% of real time), %zu playing\n",
+        Clips, adpcmUs, adpcmUs / 100.0, adpcmMixer.GetPlayingCount());
+
+    // The kernel alone, a block of every clip
+    const float from[4] = { 1.0f, 0.0f, 0.0f, 1.0f };
+    const float to[4] = { 0.5f, 0.1f, 0.1f, 0.5f };
+    std::vector<float> out(Block * 2);
+    double simdMs = BestMilliseconds(20, [&]() {
+        for (size_t i = 0; i < Clips; i++) {
+            MixStereoRamp(samples.data() + i * Block * 2, out.data(), Block, from, to);
+        }
+    });
+    double scalarMs = BestMilliseconds(20, [&]() {
+        for (size_t i = 0; i < Clips; i++) {
+            MixStereoRampScalar(samples.data() + i * Block * 2, out.data(), Block, from, to);
+        }
+    });
+    printf("MixStereoRamp, %zu x %u frames: %.2f us, scalar %.2f us (%.2fx)\n",
+        Clips, Block, simdMs * 1000.0, scalarMs * 1000.0, scalarMs / simdMs);
+    return 0;
+}
@@ -0,0 +1,230 @@
+#include "TestCheck.h"
+#include "AudioMixer.h"
+#include <cstring>
+#include <random>
+#include <set>
+#include <vector>
+
+// The software mixer: kernel against its scalar version, gains and pans ramped across a
+// block, scheduling, and clips coming back through TakeFinished even when they pile up
+
+static const uint32_t Block = 480;
+
+static std::vector<float> TestClip(size_t frames, unsigned seed) {
+    std::mt19937 random(seed);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    std::vector<float> samples(frames * 2);
+    for (auto& sample : samples) {
+        sample = distribution(random);
+    }
+    return samples;
+}
+
+static void TestKernelMatchesScalar() {
+    const float from[4] = { 1.0f, 0.2f, 0.1f, 0.5f };
+    const float to[4] = { 0.3f, 0.0f, 0.7f, 1.2f };
+    for (size_t frames : { 0, 1, 2, 3, 17, 480, 481, 4800 }) {
+        std::vector<float> in = TestClip(frames, static_cast<unsigned>(frames));
+        std::vector<float> simd(frames * 2, 0.25f), scalar(frames * 2, 0.25f);
+        MixStereoRamp(in.data(), simd.data(), frames, from, to);
+        MixStereoRampScalar(in.data(), scalar.data(), frames, from, to);
+        CHECK(memcmp(simd.data(), scalar.data(), simd.size() * sizeof(float)) == 0);
+    }
+}
+
+static void TestGainRamp() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(48000, 1);
+    std::vector<float> out(Block * 2);
+
+    // Starts at its gain, centred stereo passes straight through
+    uint64_t id = mixer.Play(clip.data(), 48000, nullptr, 0.5f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    mixer.Render(out.data(), Block);
+    size_t mismatched = 0;
+    for (size_t i = 0; i < out.size(); i++) {
+        mismatched += out[i] != clip[i] * 0.5f;
+    }
+    CHECK(mismatched == 0);
+    CHECK(mixer.GetPlayingCount() == 1);
+
+    // A gain change ramps across the next block instead of stepping
+    mixer.SetClipGain(id, 1.0f);
+    mixer.Render(out.data(), Block);
+    const float* source = clip.data() + Block * 2;
+    CHECK(out[0] == source[0] * 0.5f);
+    CHECK_NEAR(out[(Block - 1) * 2], source[(Block - 1) * 2] * (0.5f + 0.5f * (Block - 1) / Block), 1e-6);
+    mixer.Render(out.data(), Block);
+    CHECK(out[0] == clip[Block * 4]);
+
+    // Master gain ramps the same way, on top of the clip's own
+    mixer.SetMasterGain(0.25f);
+    mixer.Render(out.data(), Block);
+    mixer.Render(out.data(), Block);
+    CHECK_NEAR(out[10], clip[Block * 8 + 10] * 0.25f, 1e-7);
+}
+
+static void TestPan() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(4800, 2);
+    std::vector<float> out(Block * 2);
+
+    // A clip's pan is fixed from its first block, through the same matrix the backends use
+    mixer.Play(clip.data(), 4800, nullptr, 1.0f, 0.6f, std::chrono::steady_clock::now(), nullptr);
+    mixer.Render(out.data(), Block);
+    float matrix[4];
+    ComputeStereoPanMatrix(2, 0.6f, matrix);
+    float worst = 0.0f;
+    for (size_t k = 0; k < Block; k++) {
+        float left = clip[k * 2];
+        float right = clip[k * 2 + 1];
+        worst = (std::max)(worst, std::fabs(out[k * 2] - (left * matrix[0] + right * matrix[1])));
+        worst = (std::max)(worst, std::fabs(out[k * 2 + 1] - (left * matrix[2] + right * matrix[3])));
+    }
+    CHECK_NEAR(worst, 0.0, 1e-6);
+}
+
+static void TestClipsSum() {
+    AudioMixer mixer(48000);
+    std::vector<float> first = TestClip(Block, 3);
+    std::vector<float> second = TestClip(Block / 2, 4);
+    std::vector<float> out(Block * 2);
+
+    mixer.Play(first.data(), Block, nullptr, 0.5f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    mixer.Play(second.data(), Block / 2, nullptr, 0.25f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    mixer.Render(out.data(), Block);
+    float worst = 0.0f;
+    for (size_t i = 0; i < out.size(); i++) {
+        float expected = first[i] * 0.5f + (i < second.size() ? second[i] * 0.25f : 0.0f);
+        worst = (std::max)(worst, std::fabs(out[i] - expected));
+    }
+    CHECK_NEAR(worst, 0.0, 1e-6);
+
+    // Both ended inside the block
+    CHECK(mixer.GetPlayingCount() == 0);
+    CHECK(mixer.TakeFinished().size() == 2);
+}
+
+static void TestStopReleasesClip() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(48000, 5);
+    std::vector<float> out(Block * 2);
+    auto keepAlive = std::make_shared<int>(0);
+
+    uint64_t id = mixer.Play(clip.data(), 48000, keepAlive, 1.0f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    mixer.Render(out.data(), Block);
+    CHECK(keepAlive.use_count() == 2);
+
+    mixer.Stop(id);
+    mixer.Render(out.data(), Block);
+    CHECK(mixer.GetPlayingCount() == 0);
+    for (float sample : out) {
+        CHECK(sample == 0.0f);
+    }
+
+    // Held by the finished clip until the game thread lets go of it
+    std::vector<AudioMixer::FinishedClip> finished = mixer.TakeFinished();
+    CHECK(finished.size() == 1 && finished[0].id == id);
+    CHECK(keepAlive.use_count() == 2);
+    finished.clear();
+    CHECK(keepAlive.use_count() == 1);
+}
+
+static void TestScheduledStart() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(4800, 6);
+    std::vector<float> out(Block * 2);
+    mixer.Render(out.data(), Block);
+
+    // A second from now is tens of blocks away
+    auto now = std::chrono::steady_clock::now();
+    uint64_t later = mixer.PlayAt(clip.data(), 4800, nullptr, 1.0f, 0.0f, now + std::chrono::seconds(1));
+    for (int block = 0; block < 5; block++) {
+        mixer.Render(out.data(), Block);
+        for (float sample : out) {
+            CHECK(sample == 0.0f);
+        }
+    }
+    CHECK(mixer.GetPlayingCount() == 1);
+
+    // Stopped before it started, it comes back without playing
+    mixer.Stop(later);
+    mixer.Render(out.data(), Block);
+    std::vector<AudioMixer::FinishedClip> finished = mixer.TakeFinished();
+    CHECK(finished.size() == 1 && finished[0].id == later);
+
+    // A start time already past plays from the top of the next block
+    mixer.PlayAt(clip.data(), 4800, nullptr, 1.0f, 0.0f, now - std::chrono::seconds(1));
+    mixer.Render(out.data(), Block);
+    CHECK(memcmp(out.data(), clip.data(), out.size() * sizeof(float)) == 0);
+}
+
+static void TestFinishedOverflow() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(1, 7);
+    std::vector<float> out(Block * 2);
+    auto keepAlive = std::make_shared<int>(0);
+
+    // More one-frame clips end than the finished ring holds before anyone takes them
+    std::set<uint64_t> ids;
+    const size_t rounds = AudioMixer::FinishedCapacity / AudioMixer::MaxClips + 1;
+    for (size_t round = 0; round < rounds; round++) {
+        for (size_t i = 0; i < AudioMixer::MaxClips; i++) {
+            ids.insert(mixer.Play(clip.data(), 1, keepAlive, 1.0f, 0.0f, std::chrono::steady_clock::now(), nullptr));
+        }
+        mixer.Render(out.data(), Block);
+    }
+    CHECK(mixer.GetPlayingCount() == AudioMixer::MaxClips);
+
+    // The ones that didn't fit wait, silent, and follow once there is room
+    std::vector<AudioMixer::FinishedClip> finished = mixer.TakeFinished();
+    CHECK(finished.size() == AudioMixer::FinishedCapacity);
+    mixer.Render(out.data(), Block);
+    for (float sample : out) {
+        CHECK(sample == 0.0f);
+    }
+    std::vector<AudioMixer::FinishedClip> rest = mixer.TakeFinished();
+    CHECK(finished.size() + rest.size() == ids.size());
+    CHECK(mixer.GetPlayingCount() == 0);
+
+    for (const auto& clipDone : finished) {
+        ids.erase(clipDone.id);
+    }
+    for (const auto& clipDone : rest) {
+        ids.erase(clipDone.id);
+    }
+    CHECK(ids.empty());
+    finished.clear();
+    rest.clear();
+    CHECK(keepAlive.use_count() == 1);
+}
+
+static void TestTooManyClips() {
+    AudioMixer mixer(48000);
+    std::vector<float> clip = TestClip(48000, 8);
+    std::vector<float> out(Block * 2);
+
+    // Past MaxClips, plays are handed back unplayed
+    for (size_t i = 0; i < AudioMixer::MaxClips + 10; i++) {
+        mixer.Play(clip.data(), 48000, nullptr, 0.01f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    }
+    mixer.Render(out.data(), Block);
+    CHECK(mixer.GetPlayingCount() == AudioMixer::MaxClips);
+    CHECK(mixer.TakeFinished().size() == 10);
+
+    mixer.StopAll();
+    mixer.Render(out.data(), Block);
+    CHECK(mixer.GetPlayingCount() == 0);
+    CHECK(mixer.TakeFinished().size() == AudioMixer::MaxClips);
+}
+
+int main() {
+    TestKernelMatchesScalar();
+    TestGainRamp();
+    TestPan();
+    TestClipsSum();
+    TestStopReleasesClip();
+    TestScheduledStart();
+    TestFinishedOverflow();
+    TestTooManyClips();
+    return CheckResult("AudioMixerTest");
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+
+// Timing for the benchmark executables: the best of several runs, which is the least
+// disturbed by whatever else the machine is doing
+template <typename Function>
+double BestMilliseconds(int runs, Function&& function) {
+    double best = 0.0;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        double elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        if (run == 0 || elapsed < best) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
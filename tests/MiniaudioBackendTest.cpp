@@ -0,0 +1,162 @@
+#include "TestCheck.h"
+#include "MiniaudioBackend.h"
+#include "AudioDecoder.h"
+#include "AudioMixer.h"
+#include <cstring>
+#include <vector>
+
+// The WAV file output renders voices and the render stream deterministically; reading the
+// file back has to give exactly what was mixed.
+
+static std::vector<float> TestSignal(size_t frames) {
+    std::vector<float> samples(frames * 2);
+    for (size_t i = 0; i < frames; i++) {
+        samples[i * 2] = std::sin(static_cast<float>(i) * 0.031f) * 0.5f;
+        samples[i * 2 + 1] = std::sin(static_cast<float>(i) * 0.017f) * 0.25f;
+    }
+    return samples;
+}
+
+static bool ReadOutput(const std::string& path, std::vector<float>& samples) {
+    DecodedSound sound;
+    std::string error;
+    if (!DecodeAudioFile(path, sound, error)) {
+        printf("Decoding %s failed: %s\n", path.c_str(), error.c_str());
+        return false;
+    }
+    samples.resize(sound.pcm.size() / sizeof(float));
+    memcpy(samples.data(), sound.pcm.data(), samples.size() * sizeof(float));
+    return true;
+}
+
+static void TestVoiceToWavFile(const std::filesystem::path& directory) {
+    std::string path = (directory / "voice.wav").string();
+    const size_t frames = 4800;
+    std::vector<float> signal = TestSignal(frames);
+
+    MiniaudioBackend backend(MiniaudioBackend::Output::WavFile, path);
+    CHECK(backend.Initialize(L""));
+
+    AudioFormat format;
+    format.formatTag = AudioFormat::Float;
+    format.channels = 2;
+    format.sampleRate = 48000;
+    format.bitsPerSample = 32;
+
+    // Centred stereo passes straight through; the second half of the render is silence
+    IAudioVoice* voice = backend.CreateVoice(format);
+    CHECK(voice != nullptr);
+    if (!voice) return;
+    CHECK(voice->Submit(reinterpret_cast<const uint8_t*>(signal.data()), static_cast<uint32_t>(signal.size() * sizeof(float))));
+    CHECK(voice->Start());
+    for (int block = 0; block < 20; block++) {
+        CHECK(backend.Render(480));
+    }
+    CHECK(voice->IsFinished());
+    CHECK(backend.GetFramesRendered() == 9600);
+    delete voice;
+    backend.Shutdown();
+
+    std::vector<float> output;
+    CHECK(ReadOutput(path, output));
+    CHECK(output.size() == 9600 * 2);
+    if (output.size() != 9600 * 2) return;
+
+    size_t mismatched = 0;
+    for (size_t i = 0; i < output.size(); i++) {
+        float expected = i < signal.size() ? signal[i] : 0.0f;
+        mismatched += output[i] != expected;
+    }
+    CHECK(mismatched == 0);
+}
+
+static void TestVoiceVolumeAndPan(const std::filesystem::path& directory) {
+    std::string path = (directory / "pan.wav").string();
+    const size_t frames = 960;
+    std::vector<float> signal = TestSignal(frames);
+
+    MiniaudioBackend backend(MiniaudioBackend::Output::WavFile, path);
+    CHECK(backend.Initialize(L""));
+
+    AudioFormat format;
+    format.formatTag = AudioFormat::Float;
+    format.channels = 2;
+    format.sampleRate = 48000;
+    format.bitsPerSample = 32;
+
+    // Gain and pan go through the same matrix as on the XAudio2 backend
+    IAudioVoice* voice = backend.CreateVoice(format);
+    CHECK(voice != nullptr);
+    if (!voice) return;
+    voice->SetVolume(0.5f);
+    voice->SetPan(-0.5f);
+    CHECK(voice->Submit(reinterpret_cast<const uint8_t*>(signal.data()), static_cast<uint32_t>(signal.size() * sizeof(float))));
+    CHECK(voice->Start());
+    CHECK(backend.Render(static_cast<uint32_t>(frames)));
+    delete voice;
+    backend.Shutdown();
+
+    std::vector<float> output;
+    CHECK(ReadOutput(path, output));
+    CHECK(output.size() == frames * 2);
+    if (output.size() != frames * 2) return;
+
+    float matrix[4];
+    ComputeStereoPanMatrix(2, -0.5f, matrix);
+    double worst = 0.0;
+    for (size_t i = 0; i < frames; i++) {
+        float left = signal[i * 2];
+        float right = signal[i * 2 + 1];
+        worst = (std::max)(worst, std::fabs(output[i * 2] - (matrix[0] * left + matrix[1] * right) * 0.5));
+        worst = (std::max)(worst, std::fabs(output[i * 2 + 1] - (matrix[2] * left + matrix[3] * right) * 0.5));
+    }
+    CHECK_NEAR(worst, 0.0, 1e-6);
+}
+
+static void TestMixerRenderStream(const std::filesystem::path& directory) {
+    std::string path = (directory / "mixer.wav").string();
+    const size_t frames = 2400;
+    std::vector<float> signal = TestSignal(frames);
+
+    MiniaudioBackend backend(MiniaudioBackend::Output::WavFile, path);
+    CHECK(backend.Initialize(L""));
+
+    AudioMixer mixer(48000);
+    AudioFormat format;
+    format.formatTag = AudioFormat::Float;
+    format.channels = 2;
+    format.sampleRate = 48000;
+    format.bitsPerSample = 32;
+    CHECK(backend.StartRenderStream(format, [&mixer](float* out, uint32_t frameCount) { mixer.Render(out, frameCount); }));
+
+    uint64_t clipId = mixer.Play(signal.data(), frames, nullptr, 0.5f, 0.0f, std::chrono::steady_clock::now(), nullptr);
+    CHECK(clipId != 0);
+    for (int block = 0; block < 10; block++) {
+        CHECK(backend.Render(480));
+    }
+    backend.StopRenderStream();
+    backend.Shutdown();
+
+    std::vector<AudioMixer::FinishedClip> finished = mixer.TakeFinished();
+    CHECK(finished.size() == 1 && finished[0].id == clipId);
+
+    std::vector<float> output;
+    CHECK(ReadOutput(path, output));
+    CHECK(output.size() == 4800 * 2);
+    if (output.size() != 4800 * 2) return;
+
+    double worst = 0.0;
+    for (size_t i = 0; i < output.size(); i++) {
+        float expected = i < signal.size() ? signal[i] * 0.5f : 0.0f;
+        worst = (std::max)(worst, std::fabs(static_cast<double>(output[i]) - expected));
+    }
+    CHECK_NEAR(worst, 0.0, 1e-6);
+}
+
+int main() {
+    std::filesystem::path directory = MakeTestDirectory("MiniaudioBackendTest");
+    TestVoiceToWavFile(directory);
+    TestVoiceVolumeAndPan(directory);
+    TestMixerRenderStream(directory);
+    return CheckResult("MiniaudioBackendTest");
+}
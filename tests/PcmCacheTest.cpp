@@ -0,0 +1,91 @@
+#include "TestCheck.h"
+#include "PcmCache.h"
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <fstream>
+#include <thread>
+#include <vector>
+
+// Stored PCM has to come back from a restarted cache, and the orphan sweeps have to drop
+// the blobs of deleted source files and of keys that are no longer live, and nothing else
+
+static bool WaitFor(const std::function<bool()>& condition) {
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition()) {
+        if (std::chrono::steady_clock::now() > deadline) return false;
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    return true;
+}
+
+static size_t CountBlobs(const std::filesystem::path& directory) {
+    size_t count = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.path().extension() == ".pcm") {
+            count++;
+        }
+    }
+    return count;
+}
+
+static bool Holds(PcmCache& cache, const std::string& key, const std::vector<float>& samples) {
+    PcmCache::Blob blob;
+    return cache.LookupKey(key, blob) && blob.frames * 2 == samples.size() &&
+        std::equal(samples.begin(), samples.end(), blob.samples);
+}
+
+static void TestOrphanSweeps(const std::filesystem::path& directory) {
+    std::string cacheDirectory = (directory / "cache").string();
+    std::filesystem::path source = directory / "callout.wav";
+    { std::ofstream(source) << "not really a wav, only its bytes are hashed"; }
+
+    auto kept = std::make_shared<std::vector<float>>(960, 0.25f);
+    auto deleted = std::make_shared<std::vector<float>>(480, -0.5f);
+    auto file = std::make_shared<std::vector<float>>(240, 0.125f);
+    {
+        PcmCache cache;
+        CHECK(cache.Start(cacheDirectory));
+        cache.StoreKey("tts:voice:stack", kept->data(), kept->size() / 2, kept);
+        cache.StoreKey("tts:voice:spread", deleted->data(), deleted->size() / 2, deleted);
+        cache.StoreFile(source.string(), file->data(), file->size() / 2, file);
+        CHECK(WaitFor([&]() { return cache.GetStats().writes == 3; }));
+        cache.Stop();
+    }
+    CHECK(CountBlobs(cacheDirectory) == 3);
+
+    // Only "stack" is still a saved sound; "spread" goes once the cache is told so
+    {
+        PcmCache cache;
+        CHECK(cache.Start(cacheDirectory));
+        CHECK(Holds(cache, "tts:voice:stack", *kept));
+        CHECK(Holds(cache, "tts:voice:spread", *deleted));
+
+        std::set<std::string> liveKeys = { "tts:voice:stack" };
+        cache.RetainKeys(liveKeys);
+        PcmCache::Blob blob;
+        CHECK(WaitFor([&]() { return !cache.LookupKey("tts:voice:spread", blob); }));
+        CHECK(Holds(cache, "tts:voice:stack", *kept));
+        CHECK(cache.LookupFile(source.string(), blob));
+        cache.Stop();
+    }
+    CHECK(CountBlobs(cacheDirectory) == 2);
+
+    // A deleted source file loses its blob on the next start, the key stays
+    std::filesystem::remove(source);
+    {
+        PcmCache cache;
+        CHECK(cache.Start(cacheDirectory));
+        CHECK(WaitFor([&]() { return CountBlobs(cacheDirectory) == 1; }));
+        CHECK(Holds(cache, "tts:voice:stack", *kept));
+        CHECK(!Holds(cache, "tts:voice:spread", *deleted));
+        cache.Stop();
+    }
+}
+
+int main() {
+    std::filesystem::path directory = MakeTestDirectory("pcm-cache");
+    TestOrphanSweeps(directory);
+    std::filesystem::remove_all(directory);
+    return CheckResult("PcmCacheTest");
+}
@@ -0,0 +1,101 @@
+#include "Benchmark.h"
+#include "TestWav.h"
+#include "AudioDecoder.h"
+#include <cstdlib>
+#include <filesystem>
+#include <thread>
+
+// Startup cost of a custom sound folder with many files, split the way ScanSoundDirectory
+// splits it: listing the folder, which is all the game's thread waits for, and decoding
+// every file on the decode pool. Decoding them one after another on a single thread, as
+// the scan used to, is timed for comparison.
+//
+//   ScanBenchmark [file count, default 1000]
+
+static size_t ListSoundFiles(const std::filesystem::path& directory) {
+    size_t found = 0;
+    for (const auto& entry : std::filesystem::directory_iterator(directory)) {
+        if (entry.is_regular_file() && entry.path().extension() == ".wav") {
+            found++;
+        }
+    }
+    return found;
+}
+
+static double DecodeOnPool(const std::vector<std::string>& paths, size_t threadCount, size_t& failed) {
+    auto start = std::chrono::steady_clock::now();
+    AudioDecodeWorker worker;
+    worker.Start(threadCount);
+    for (const auto& path : paths) {
+        worker.RequestDecode(path);
+    }
+
+    size_t done = 0;
+    failed = 0;
+    while (done < paths.size()) {
+        std::vector<AudioDecodeWorker::Result> results = worker.TakeResults();
+        if (results.empty()) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+            continue;
+        }
+        for (const auto& result : results) {
+            failed += !result.ok;
+        }
+        done += results.size();
+    }
+    worker.Stop();
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char** argv) {
+    size_t fileCount = argc > 1 ? static_cast<size_t>(strtoul(argv[1], nullptr, 10)) : 1000;
+    if (fileCount == 0) fileCount = 1000;
+
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "simple-timers-ScanBenchmark";
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory);
+
+    // Half a second of 44.1 kHz mono each, so every file is resampled and widened on load
+    AudioFormat format;
+    format.formatTag = AudioFormat::PCM;
+    format.channels = 1;
+    format.sampleRate = 44100;
+    format.bitsPerSample = 16;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < fileCount; i++) {
+        std::vector<int16_t> tone = MakeTestTone(22050, 1, 220.0f + static_cast<float>(i % 50) * 10.0f, 44100);
+        char name[64];
+        snprintf(name, sizeof(name), "callout-%04zu.wav", i);
+        std::string path = (directory / name).string();
+        if (!WriteTestWav(path, format, tone.data(), static_cast<uint32_t>(tone.size() * sizeof(int16_t)))) {
+            printf("Writing %s failed\n", path.c_str());
+            return 1;
+        }
+        paths.push_back(path);
+    }
+
+    size_t listed = 0;
+    double listMs = BestMilliseconds(5, [&]() { listed = ListSoundFiles(directory); });
+    printf("%zu files listed in %.2f ms\n", listed, listMs);
+
+    auto serialStart = std::chrono::steady_clock::now();
+    size_t serialFailed = 0;
+    for (const auto& path : paths) {
+        DecodedSound sound;
+        std::string decodeError;
+        serialFailed += !DecodeAudioFile(path, sound, decodeError);
+    }
+    double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - serialStart).count();
+    printf("Decoded one after another on one thread: %.1f ms, %zu failed\n", serialMs, serialFailed);
+
+    printf("%u cores\n", std::thread::hardware_concurrency());
+    for (size_t threads = 1; threads <= AudioDecodeWorker::MaxThreads; threads *= 2) {
+        size_t failed = 0;
+        double poolMs = DecodeOnPool(paths, threads, failed);
+        printf("Decoded on a pool of %zu: %.1f ms, %zu failed\n", threads, poolMs, failed);
+    }
+
+    std::filesystem::remove_all(directory, error);
+    return 0;
+}
@@ -0,0 +1,337 @@
+#include "Benchmark.h"
+#include "SettingsSchema.h"
+#include <string>
+#include <vector>
+
+// Settings serialization through the Schema field tables against the hand-written
+// contains()/operator[] code they replaced, on a settings file of a heavy user: 150 timers,
+// 20 saved TTS sounds and the "sounds" section. settings.h pulls in the addon's Windows
+// headers, so the persisted structs are mirrored here with the fields both versions handle.
+
+using json = nlohmann::json;
+
+namespace {
+    const int ChimeSuccess = 101;
+    const int ChimeInfo = 102;
+
+    // The parts of SoundID the timer codec touches
+    struct SoundRef {
+        bool isResource = true;
+        int resourceId = 0;
+        std::string filePath;
+
+        SoundRef() = default;
+        explicit SoundRef(int resId) : resourceId(resId) {}
+
+        std::string ToString() const {
+            return isResource ? "res:" + std::to_string(resourceId) : "file:" + filePath;
+        }
+
+        static SoundRef FromString(const std::string& str) {
+            SoundRef sound;
+            if (str.compare(0, 4, "res:") == 0) {
+                try {
+                    sound.resourceId = std::stoi(str.substr(4));
+                }
+                catch (...) {
+                }
+            }
+            else if (str.compare(0, 5, "file:") == 0) {
+                sound.isResource = false;
+                sound.filePath = str.substr(5);
+            }
+            return sound;
+        }
+    };
+
+    struct Timer {
+        std::string id;
+        std::string name;
+        float duration = 0.0f;
+        SoundRef endSound = SoundRef(ChimeSuccess);
+        float warningTime = 30.0f;
+        SoundRef warningSound = SoundRef(ChimeInfo);
+        bool useWarning = false;
+        bool isRoomTimer = false;
+        std::string roomId;
+    };
+
+    struct TtsSound {
+        std::string id;
+        std::string name;
+        float volume = 1.0f;
+        float pan = 0.0f;
+    };
+
+    struct Sounds {
+        float masterVolume = 1.0f;
+        int audioDeviceIndex = -1;
+        std::string customSoundsDirectory;
+        std::vector<TtsSound> ttsSounds;
+    };
+}
+
+namespace Schema {
+    template <>
+    struct Codec<SoundRef> {
+        static bool Read(const json& j, SoundRef& out) {
+            if (!j.is_string()) return false;
+            const std::string& str = j.get_ref<const std::string&>();
+            if (str.empty()) return false;
+
+            if (str.compare(0, 4, "res:") == 0 || str.compare(0, 5, "file:") == 0) {
+                out = SoundRef::FromString(str);
+                return true;
+            }
+
+            try {
+                out = SoundRef(std::stoi(str));
+                return true;
+            }
+            catch (...) {
+                return false;
+            }
+        }
+        static void Write(json& j, const SoundRef& value) { j = value.ToString(); }
+        static void WriteBinary(std::string& out, const SoundRef& value) { Codec<std::string>::WriteBinary(out, value.ToString()); }
+        static bool ReadBinary(const char*& p, const char* end, SoundRef& value) {
+            std::string str;
+            if (!Codec<std::string>::ReadBinary(p, end, str)) return false;
+            value = SoundRef::FromString(str);
+            return true;
+        }
+    };
+
+    template <>
+    struct Of<Timer> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("id", &Timer::id, KeepValue{}),
+            MakeField("name", &Timer::name, ""),
+            MakeField("duration", &Timer::duration, 0.0f, [](const float& v) { return v >= 0.0f; }),
+            MakeField("endSound", &Timer::endSound, ChimeSuccess),
+            MakeField("warningTime", &Timer::warningTime, 30.0f, [](const float& v) { return v >= 0.0f; }),
+            MakeField("warningSound", &Timer::warningSound, ChimeInfo),
+            MakeField("useWarning", &Timer::useWarning, false),
+            MakeField("isRoomTimer", &Timer::isRoomTimer, false),
+            MakeField("roomId", &Timer::roomId, ""));
+    };
+
+    template <>
+    struct Of<TtsSound> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("id", &TtsSound::id, ""),
+            MakeField("name", &TtsSound::name, ""),
+            MakeField("volume", &TtsSound::volume, 1.0f),
+            MakeField("pan", &TtsSound::pan, 0.0f, [](const float& v) { return v >= -1.0f && v <= 1.0f; }));
+    };
+
+    template <>
+    struct Of<Sounds> {
+        static constexpr auto fields = std::make_tuple(
+            MakeField("masterVolume", &Sounds::masterVolume, 1.0f, [](const float& v) { return v >= 0.0f && v <= 1.0f; }),
+            MakeField("audioDeviceIndex", &Sounds::audioDeviceIndex, -1),
+            MakeField("customSoundsDirectory", &Sounds::customSoundsDirectory, ""));
+    };
+}
+
+// The serialization as it was before the tables
+namespace Legacy {
+    static SoundRef ReadSound(const json& j, const char* key, int fallback) {
+        std::string str = j.contains(key) ? j[key].get<std::string>() : "";
+        if (str.empty()) {
+            return SoundRef(fallback);
+        }
+        if (str.find("res:") == 0 || str.find("file:") == 0) {
+            return SoundRef::FromString(str);
+        }
+        try {
+            return SoundRef(std::stoi(str));
+        }
+        catch (...) {
+            return SoundRef(fallback);
+        }
+    }
+
+    static Timer TimerFromJson(const json& j) {
+        Timer timer;
+        timer.name = j.contains("name") ? j["name"].get<std::string>() : "";
+        timer.id = j.contains("id") ? j["id"].get<std::string>() : "timer_generated";
+        timer.duration = j.contains("duration") ? j["duration"].get<float>() : 0.0f;
+        timer.endSound = ReadSound(j, "endSound", ChimeSuccess);
+        timer.warningTime = j.contains("warningTime") ? j["warningTime"].get<float>() : 30.0f;
+        timer.warningSound = ReadSound(j, "warningSound", ChimeInfo);
+        timer.useWarning = j.contains("useWarning") ? j["useWarning"].get<bool>() : false;
+        timer.isRoomTimer = j.contains("isRoomTimer") ? j["isRoomTimer"].get<bool>() : false;
+        timer.roomId = j.contains("roomId") ? j["roomId"].get<std::string>() : "";
+        return timer;
+    }
+
+    static json TimerToJson(const Timer& timer) {
+        json j;
+        j["name"] = timer.name;
+        j["id"] = timer.id;
+        j["duration"] = timer.duration;
+        j["endSound"] = timer.endSound.ToString();
+        j["warningTime"] = timer.warningTime;
+        j["warningSound"] = timer.warningSound.ToString();
+        j["useWarning"] = timer.useWarning;
+        j["isRoomTimer"] = timer.isRoomTimer;
+        j["roomId"] = timer.roomId;
+        return j;
+    }
+
+    static Sounds SoundsFromJson(const json& soundsJson) {
+        Sounds sounds;
+        sounds.masterVolume = soundsJson.contains("masterVolume") ? soundsJson["masterVolume"].get<float>() : 1.0f;
+        sounds.audioDeviceIndex = soundsJson.contains("audioDeviceIndex") ? soundsJson["audioDeviceIndex"].get<int>() : -1;
+        sounds.customSoundsDirectory = soundsJson.contains("customSoundsDirectory") ? soundsJson["customSoundsDirectory"].get<std::string>() : "";
+        for (const auto& ttsJson : soundsJson["ttsSounds"]) {
+            TtsSound info;
+            info.id = ttsJson.contains("id") ? ttsJson["id"].get<std::string>() : "";
+            info.name = ttsJson.contains("name") ? ttsJson["name"].get<std::string>() : "";
+            info.volume = ttsJson.contains("volume") ? ttsJson["volume"].get<float>() : 1.0f;
+            info.pan = ttsJson.contains("pan") ? ttsJson["pan"].get<float>() : 0.0f;
+            sounds.ttsSounds.push_back(info);
+        }
+        return sounds;
+    }
+
+    static json SoundsToJson(const Sounds& sounds) {
+        json soundsJson = json::object();
+        soundsJson["masterVolume"] = sounds.masterVolume;
+        soundsJson["audioDeviceIndex"] = sounds.audioDeviceIndex;
+        soundsJson["customSoundsDirectory"] = sounds.customSoundsDirectory;
+        json ttsSoundsJson = json::array();
+        for (const auto& ttsSound : sounds.ttsSounds) {
+            json ttsSoundJson = json::object();
+            ttsSoundJson["id"] = ttsSound.id;
+            ttsSoundJson["name"] = ttsSound.name;
+            ttsSoundJson["volume"] = ttsSound.volume;
+            ttsSoundJson["pan"] = ttsSound.pan;
+            ttsSoundsJson.push_back(ttsSoundJson);
+        }
+        soundsJson["ttsSounds"] = ttsSoundsJson;
+        return soundsJson;
+    }
+}
+
+static Sounds SchemaSoundsFromJson(const json& soundsJson) {
+    Sounds sounds;
+    Schema::FromJson(soundsJson, sounds);
+    for (const auto& ttsJson : soundsJson["ttsSounds"]) {
+        TtsSound info;
+        Schema::FromJson(ttsJson, info);
+        sounds.ttsSounds.push_back(std::move(info));
+    }
+    return sounds;
+}
+
+static json SchemaSoundsToJson(const Sounds& sounds) {
+    json soundsJson = Schema::ToJson(sounds);
+    json ttsSoundsJson = json::array();
+    for (const auto& ttsSound : sounds.ttsSounds) {
+        ttsSoundsJson.push_back(Schema::ToJson(ttsSound));
+    }
+    soundsJson["ttsSounds"] = ttsSoundsJson;
+    return soundsJson;
+}
+
+static std::string MakeSettingsFile(size_t timerCount, size_t ttsCount) {
+    std::vector<Timer> timers(timerCount);
+    for (size_t i = 0; i < timerCount; i++) {
+        Timer& timer = timers[i];
+        timer.id = "timer_" + std::to_string(0x18f2a3b4c5dull + i) + "0001a1b2c3";
+        timer.name = "Boss phase " + std::to_string(i) + " - next mechanic";
+        timer.duration = 15.0f + static_cast<float>(i % 240);
+        timer.warningTime = 5.0f;
+        timer.useWarning = i % 3 == 0;
+        if (i % 4 == 0) {
+            timer.endSound.isResource = false;
+            timer.endSound.filePath = "C:/Users/player/Documents/Guild Wars 2/addons/SimpleTimers/sounds/callout-" + std::to_string(i) + ".wav";
+        }
+        if (i % 5 == 0) {
+            timer.isRoomTimer = true;
+            timer.roomId = "room_" + std::to_string(i / 20);
+        }
+    }
+
+    Sounds sounds;
+    sounds.masterVolume = 0.8f;
+    sounds.customSoundsDirectory = "C:/Users/player/Documents/Guild Wars 2/addons/SimpleTimers/sounds";
+    for (size_t i = 0; i < ttsCount; i++) {
+        TtsSound info;
+        info.id = "tts_" + std::to_string(1000 + i);
+        info.name = "Stack on the tag for phase " + std::to_string(i);
+        info.volume = 0.9f;
+        sounds.ttsSounds.push_back(info);
+    }
+
+    json document = json::object();
+    document["sounds"] = Legacy::SoundsToJson(sounds);
+    json timersJson = json::array();
+    for (const auto& timer : timers) {
+        timersJson.push_back(Legacy::TimerToJson(timer));
+    }
+    document["timers"] = timersJson;
+    return document.dump(4);
+}
+
+static void Report(const char* name, double schemaMs, double legacyMs) {
+    printf("%-10s schema %8.3f ms   hand-written %8.3f ms   %.2fx\n", name, schemaMs, legacyMs, legacyMs / schemaMs);
+}
+
+int main() {
+    const int runs = 50;
+    const std::string text = MakeSettingsFile(150, 20);
+    const json document = json::parse(text);
+    printf("Settings file: %zu bytes, 150 timers, 20 TTS sounds\n", text.size());
+
+    std::vector<Timer> timers;
+    Sounds sounds;
+    double schemaReadMs = BestMilliseconds(runs, [&]() {
+        timers.clear();
+        for (const auto& timerJson : document["timers"]) {
+            Timer timer;
+            timer.id = "timer_generated";
+            Schema::FromJson(timerJson, timer);
+            timers.push_back(std::move(timer));
+        }
+        sounds = SchemaSoundsFromJson(document["sounds"]);
+        });
+    double legacyReadMs = BestMilliseconds(runs, [&]() {
+        timers.clear();
+        for (const auto& timerJson : document["timers"]) {
+            timers.push_back(Legacy::TimerFromJson(timerJson));
+        }
+        sounds = Legacy::SoundsFromJson(document["sounds"]);
+        });
+    Report("FromJson", schemaReadMs, legacyReadMs);
+
+    json written;
+    double schemaWriteMs = BestMilliseconds(runs, [&]() {
+        written = json::object();
+        written["sounds"] = SchemaSoundsToJson(sounds);
+        json timersJson = json::array();
+        for (const auto& timer : timers) {
+            timersJson.push_back(Schema::ToJson(timer));
+        }
+        written["timers"] = std::move(timersJson);
+        });
+    double legacyWriteMs = BestMilliseconds(runs, [&]() {
+        written = json::object();
+        written["sounds"] = Legacy::SoundsToJson(sounds);
+        json timersJson = json::array();
+        for (const auto& timer : timers) {
+            timersJson.push_back(Legacy::TimerToJson(timer));
+        }
+        written["timers"] = std::move(timersJson);
+        });
+    Report("ToJson", schemaWriteMs, legacyWriteMs);
+
+    // Both sides share the text parse and dump, which bound what either can save on a load or save
+    json parsed;
+    double parseMs = BestMilliseconds(runs, [&]() { parsed = json::parse(text); });
+    double dumpMs = BestMilliseconds(runs, [&]() { written.dump(4); });
+    printf("For scale: json::parse %.3f ms, dump %.3f ms\n", parseMs, dumpMs);
+    return written == document ? 0 : 1;
+}
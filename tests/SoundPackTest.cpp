@@ -0,0 +1,192 @@
+#include "TestCheck.h"
+#include "TestWav.h"
+#include "SoundPack.h"
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+// Packs a folder of loose files and reads the pack back: names, categories, formats and
+// every byte of data have to survive, and damaged packs have to be refused
+
+static std::vector<uint8_t> ReadFile(const std::filesystem::path& path) {
+    std::ifstream file(path, std::ios::binary);
+    return std::vector<uint8_t>(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+}
+
+static void WriteFile(const std::filesystem::path& path, const std::vector<uint8_t>& bytes) {
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file.write(reinterpret_cast<const char*>(bytes.data()), static_cast<std::streamsize>(bytes.size()));
+}
+
+struct SourceSound {
+    std::string name;
+    std::string category;
+    AudioFormat format;
+    std::vector<uint8_t> data;
+};
+
+static bool SamePcm(const SoundPack::Sound* sound, const SourceSound& source) {
+    return sound && !sound->encoded && sound->format == source.format && sound->size == source.data.size() &&
+        memcmp(sound->data, source.data.data(), source.data.size()) == 0;
+}
+
+static void TestRoundTrip(const std::filesystem::path& directory) {
+    std::filesystem::path folder = directory / "callouts";
+    std::filesystem::create_directories(folder / "bosses" / "raids");
+    std::filesystem::create_directories(folder / "empty");
+
+    // A 16-bit stereo top-level sound, an 8-bit mono one two folders down, and float
+    SourceSound chime;
+    chime.name = "chime";
+    chime.format.formatTag = AudioFormat::PCM;
+    chime.format.channels = 2;
+    chime.format.sampleRate = 44100;
+    chime.format.bitsPerSample = 16;
+    std::vector<int16_t> tone = MakeTestTone(4410, 2, 880.0f, 44100);
+    chime.data.assign(reinterpret_cast<const uint8_t*>(tone.data()), reinterpret_cast<const uint8_t*>(tone.data() + tone.size()));
+
+    SourceSound breakbar;
+    breakbar.name = "bosses/raids/breakbar";
+    breakbar.category = "bosses/raids";
+    breakbar.format.formatTag = AudioFormat::PCM;
+    breakbar.format.channels = 1;
+    breakbar.format.sampleRate = 22050;
+    breakbar.format.bitsPerSample = 8;
+    for (size_t i = 0; i < 2205; i++) {
+        breakbar.data.push_back(static_cast<uint8_t>(128 + 100 * std::sin(i * 0.05)));
+    }
+
+    SourceSound wipe;
+    wipe.name = "bosses/wipe";
+    wipe.category = "bosses";
+    wipe.format.formatTag = AudioFormat::Float;
+    wipe.format.channels = 2;
+    wipe.format.sampleRate = 48000;
+    wipe.format.bitsPerSample = 32;
+    std::vector<float> floats(960 * 2);
+    for (size_t i = 0; i < floats.size(); i++) {
+        floats[i] = static_cast<float>(i % 97) / 97.0f - 0.5f;
+    }
+    wipe.data.assign(reinterpret_cast<const uint8_t*>(floats.data()), reinterpret_cast<const uint8_t*>(floats.data() + floats.size()));
+
+    for (const SourceSound* source : { &chime, &breakbar, &wipe }) {
+        std::filesystem::path path = folder / (source->name + ".wav");
+        CHECK(WriteTestWav(path.string(), source->format, source->data.data(), static_cast<uint32_t>(source->data.size())));
+    }
+
+    // Anything that isn't a readable WAV is kept as its file image; other files and empty
+    // ones are left out
+    std::vector<uint8_t> encoded = { 'I', 'D', '3', 4, 0, 0, 1, 2, 3, 4, 5, 6, 7 };
+    WriteFile(folder / "bosses" / "enrage.mp3", encoded);
+    std::vector<uint8_t> notRiff = { 'n', 'o', 't', ' ', 'a', ' ', 'w', 'a', 'v', 'e' };
+    WriteFile(folder / "odd.WAV", notRiff);
+    WriteFile(folder / "readme.txt", { 'h', 'i' });
+    WriteFile(folder / "empty" / "silent.wav", {});
+
+    std::string packPath = (directory / "callouts.soundpack").string();
+    size_t soundCount = 0;
+    std::string error;
+    CHECK(WriteSoundPack(folder.string(), packPath, soundCount, error));
+    CHECK(error.empty());
+    CHECK(soundCount == 5);
+    CHECK(!std::filesystem::exists(packPath + ".tmp"));
+
+    std::shared_ptr<SoundPack> pack = SoundPack::Open(packPath, error);
+    CHECK(pack != nullptr);
+    if (!pack) {
+        printf("%s\n", error.c_str());
+        return;
+    }
+    CHECK(pack->GetPath() == packPath);
+    CHECK(pack->GetSounds().size() == 5);
+
+    CHECK(SamePcm(pack->Find("chime"), chime));
+    CHECK(SamePcm(pack->Find("bosses/raids/breakbar"), breakbar));
+    CHECK(SamePcm(pack->Find("bosses/wipe"), wipe));
+    CHECK(pack->Find("chime")->category.empty());
+    CHECK(pack->Find("bosses/raids/breakbar")->category == "bosses/raids");
+
+    const SoundPack::Sound* enrage = pack->Find("bosses/enrage");
+    CHECK(enrage && enrage->encoded && enrage->category == "bosses");
+    CHECK(enrage && enrage->size == encoded.size() && memcmp(enrage->data, encoded.data(), encoded.size()) == 0);
+    const SoundPack::Sound* odd = pack->Find("odd");
+    CHECK(odd && odd->encoded && odd->size == notRiff.size() && memcmp(odd->data, notRiff.data(), notRiff.size()) == 0);
+    CHECK(pack->Find("readme") == nullptr);
+    CHECK(pack->Find("empty/silent") == nullptr);
+
+    // Data is aligned for the mixer, in a mapping that starts on a page
+    for (const auto& sound : pack->GetSounds()) {
+        CHECK(reinterpret_cast<uintptr_t>(sound.data) % 64 == 0);
+    }
+
+    // The same folder always packs to the same bytes
+    std::string againPath = (directory / "again.soundpack").string();
+    CHECK(WriteSoundPack(folder.string(), againPath, soundCount, error));
+    CHECK(ReadFile(packPath) == ReadFile(againPath));
+}
+
+static void TestDamagedPacks(const std::filesystem::path& directory) {
+    std::string packPath = (directory / "callouts.soundpack").string();
+    std::vector<uint8_t> image = ReadFile(packPath);
+    CHECK(image.size() > 200);
+    std::string error;
+
+    auto openDamaged = [&](const std::vector<uint8_t>& bytes) {
+        std::filesystem::path path = directory / "damaged.soundpack";
+        WriteFile(path, bytes);
+        error.clear();
+        std::shared_ptr<SoundPack> pack = SoundPack::Open(path.string(), error);
+        return pack == nullptr && !error.empty();
+    };
+
+    // Cut off inside the header, inside the index, and inside the data
+    CHECK(openDamaged(std::vector<uint8_t>(image.begin(), image.begin() + 16)));
+    CHECK(openDamaged(std::vector<uint8_t>(image.begin(), image.begin() + 64)));
+    CHECK(openDamaged(std::vector<uint8_t>(image.begin(), image.end() - 1)));
+
+    std::vector<uint8_t> badMagic = image;
+    badMagic[0] = 'X';
+    CHECK(openDamaged(badMagic));
+
+    std::vector<uint8_t> newerVersion = image;
+    newerVersion[4] = 2;
+    CHECK(openDamaged(newerVersion));
+
+    // The first entry's data pointing past the end of the file
+    std::vector<uint8_t> badOffset = image;
+    uint64_t farAway = image.size() + 1;
+    memcpy(badOffset.data() + 32 + 32, &farAway, sizeof(farAway));
+    CHECK(openDamaged(badOffset));
+
+    CHECK(!SoundPack::Open((directory / "missing.soundpack").string(), error));
+
+    // Nothing to pack
+    size_t soundCount = 0;
+    std::filesystem::create_directories(directory / "nothing");
+    CHECK(!WriteSoundPack((directory / "nothing").string(), (directory / "nothing.soundpack").string(), soundCount, error));
+    CHECK(soundCount == 0);
+    CHECK(!std::filesystem::exists(directory / "nothing.soundpack"));
+}
+
+static void TestSoundPaths() {
+    std::string soundPath = MakeSoundPackPath("/packs/raid.soundpack", "bosses/wipe");
+    std::string packPath;
+    std::string name;
+    CHECK(SplitSoundPackPath(soundPath, packPath, name));
+    CHECK(packPath == "/packs/raid.soundpack" && name == "bosses/wipe");
+    CHECK(!SplitSoundPackPath("/sounds/wipe.wav", packPath, name));
+    CHECK(!SplitSoundPackPath("|wipe", packPath, name));
+
+    CHECK(IsSoundPackFile("raid.soundpack"));
+    CHECK(IsSoundPackFile("RAID.SoundPack"));
+    CHECK(!IsSoundPackFile("raid.soundpack.tmp"));
+    CHECK(!IsSoundPackFile("raid.wav"));
+}
+
+int main() {
+    std::filesystem::path directory = MakeTestDirectory("SoundPackTest");
+    TestRoundTrip(directory);
+    TestDamagedPacks(directory);
+    TestSoundPaths();
+    return CheckResult("SoundPackTest");
+}
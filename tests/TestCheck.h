@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <filesystem>
+
+// Minimal checks for the test executables. A failed check is printed and counted, and
+// main returns the count, so ctest reports the test as failed without stopping at the first.
+static int checkFailures = 0;
+
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance) \
+    do { \
+        double checkActual = (actual); \
+        double checkExpected = (expected); \
+        if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) { \
+            printf("%s:%d: CHECK_NEAR(%s, %s) failed: %g, expected %g\n", \
+                __FILE__, __LINE__, #actual, #expected, checkActual, checkExpected); \
+            checkFailures++; \
+        } \
+    } while (0)
+
+inline int CheckResult(const char* testName) {
+    if (checkFailures == 0) {
+        printf("%s: passed\n", testName);
+    }
+    else {
+        printf("%s: %d checks failed\n", testName, checkFailures);
+    }
+    return checkFailures;
+}
+
+// Empty directory under the system temp directory, for files a test writes
+inline std::filesystem::path MakeTestDirectory(const std::string& name) {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / ("simple-timers-" + name);
+    std::error_code error;
+    std::filesystem::remove_all(directory, error);
+    std::filesystem::create_directories(directory);
+    return directory;
+}
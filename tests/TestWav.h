@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "AudioBackend.h"
+
+// Writes a canonical RIFF/WAVE file: a 16 byte fmt chunk and one data chunk
+inline bool WriteTestWav(const std::string& path, const AudioFormat& format, const void* data, uint32_t bytes) {
+    FILE* file = fopen(path.c_str(), "wb");
+    if (!file) return false;
+
+    auto put32 = [file](uint32_t value) { fwrite(&value, 4, 1, file); };
+    auto put16 = [file](uint16_t value) { fwrite(&value, 2, 1, file); };
+
+    fwrite("RIFF", 1, 4, file);
+    put32(36 + bytes);
+    fwrite("WAVEfmt ", 1, 8, file);
+    put32(16);
+    put16(format.formatTag);
+    put16(format.channels);
+    put32(format.sampleRate);
+    put32(format.sampleRate * format.BlockAlign());
+    put16(static_cast<uint16_t>(format.BlockAlign()));
+    put16(format.bitsPerSample);
+    fwrite("data", 1, 4, file);
+    put32(bytes);
+    bool written = fwrite(data, 1, bytes, file) == bytes;
+    return fclose(file) == 0 && written;
+}
+
+// A tone as 16-bit PCM, the usual shape of a custom sound
+inline std::vector<int16_t> MakeTestTone(size_t frames, uint16_t channels, float frequency, uint32_t sampleRate) {
+    std::vector<int16_t> samples(frames * channels);
+    for (size_t i = 0; i < frames; i++) {
+        float value = std::sin(6.2831853f * frequency * static_cast<float>(i) / static_cast<float>(sampleRate));
+        for (uint16_t channel = 0; channel < channels; channel++) {
+            samples[i * channels + channel] = static_cast<int16_t>(value * (channel == 0 ? 12000.0f : 6000.0f));
+        }
+    }
+    return samples;
+}
@@ -0,0 +1,145 @@
+#include "TestCheck.h"
+#include "TtsCache.h"
+#include <algorithm>
+#include <cstring>
+
+// Stands in for the SAPI clip of TextToSpeech.h, which the cache never looks inside
+struct TtsClip {
+    int id = 0;
+};
+
+static std::shared_ptr<TtsClip> Clip(int id) {
+    auto clip = std::make_shared<TtsClip>();
+    clip->id = id;
+    return clip;
+}
+
+static bool Contains(const std::vector<uint64_t>& keys, uint64_t key) {
+    return std::find(keys.begin(), keys.end(), key) != keys.end();
+}
+
+static void TestPhraseKeys() {
+    uint64_t key = TtsPhraseKey(L"voice-a", "Boss in 37 seconds");
+    CHECK(key != 0);
+    CHECK(key == TtsPhraseKey(L"voice-a", "Boss in 37 seconds"));
+    CHECK(key != TtsPhraseKey(L"voice-b", "Boss in 37 seconds"));
+    CHECK(key != TtsPhraseKey(L"voice-a", "Boss in 36 seconds"));
+    CHECK(TtsPhraseKey(L"ab", "c") != TtsPhraseKey(L"a", "bc"));
+    CHECK(TtsPhraseKey(L"", "") != 0);
+
+    std::string path = TtsPhrasePath(0x1234abcdull);
+    CHECK(path == "tts-phrase:000000001234abcd");
+    CHECK(TtsPhrasePath(key).size() == strlen("tts-phrase:") + 16);
+}
+
+static void TestLeastRecentlyUsed() {
+    TtsClipCache cache;
+    cache.SetBudget(1000);
+
+    CHECK(cache.Insert(1, Clip(1), 400).empty());
+    CHECK(cache.Insert(2, Clip(2), 400).empty());
+
+    // Using 1 makes 2 the oldest
+    std::shared_ptr<TtsClip> found = cache.Find(1);
+    CHECK(found && found->id == 1);
+    std::vector<uint64_t> evicted = cache.Insert(3, Clip(3), 400);
+    CHECK(evicted.size() == 1 && evicted[0] == 2);
+    CHECK(cache.Find(2) == nullptr);
+    CHECK(cache.Find(3) != nullptr);
+
+    // Replacing a phrase counts its new size, not both
+    CHECK(cache.Insert(3, Clip(33), 200).empty());
+    CHECK(cache.Find(3)->id == 33);
+    CHECK(cache.GetStats().bytes == 600);
+
+    // One phrase over the whole budget is still kept, everything else goes
+    evicted = cache.Insert(4, Clip(4), 5000);
+    CHECK(evicted.size() == 2 && Contains(evicted, 1) && Contains(evicted, 3));
+    CHECK(cache.Find(4) != nullptr);
+    CHECK(cache.GetStats().clips == 1);
+}
+
+static void TestPinned() {
+    TtsClipCache cache;
+    cache.SetBudget(1000);
+    cache.Insert(1, Clip(1), 400);
+    cache.Insert(2, Clip(2), 400);
+
+    std::unordered_set<uint64_t> pinned = { 1, 7 };
+    CHECK(cache.SetPinned(pinned).empty());
+    CHECK(cache.GetPinned().size() == 2);
+
+    // The pinned phrase is the oldest but stays
+    std::vector<uint64_t> evicted = cache.Insert(3, Clip(3), 400);
+    CHECK(evicted.size() == 1 && evicted[0] == 2);
+    CHECK(cache.Find(1) != nullptr);
+
+    // Only phrases actually held count as pinned clips
+    CHECK(cache.GetStats().pinnedClips == 1);
+
+    // Pinned phrases may take the cache over budget; unpinning lets it catch up, oldest first
+    CHECK(cache.SetPinned({ 1, 3 }).empty());
+    CHECK(cache.Insert(4, Clip(4), 400).empty());
+    CHECK(cache.GetStats().bytes == 1200);
+    evicted = cache.SetPinned({});
+    CHECK(evicted.size() == 1 && evicted[0] == 3);
+    CHECK(cache.GetStats().bytes == 800);
+}
+
+static void TestBudget() {
+    // No budget is no limit
+    TtsClipCache cache;
+    for (uint64_t key = 1; key <= 100; key++) {
+        CHECK(cache.Insert(key, Clip(static_cast<int>(key)), 1000000).empty());
+    }
+    CHECK(cache.GetStats().clips == 100);
+
+    // Lowering it evicts on the next Evict, oldest first
+    cache.SetBudget(10 * 1000000);
+    std::vector<uint64_t> evicted = cache.Evict();
+    CHECK(evicted.size() == 90);
+    CHECK(Contains(evicted, 1) && !Contains(evicted, 100));
+    CHECK(cache.GetStats().budgetBytes == 10 * 1000000);
+    CHECK(cache.GetStats().bytes == 10 * 1000000);
+
+    cache.Clear();
+    CHECK(cache.GetStats().clips == 0 && cache.GetStats().bytes == 0);
+}
+
+static void TestStats() {
+    TtsClipCache cache;
+    cache.SetBudget(1000);
+    cache.Insert(1, Clip(1), 600);
+    cache.Find(1);
+    cache.Find(1);
+    cache.Find(1);
+    cache.Find(2);
+    cache.Insert(2, Clip(2), 600);
+    cache.RecordSynthesis(120.0);
+    cache.RecordSynthesis(80.0);
+
+    TtsCacheStats stats = cache.GetStats();
+    CHECK(stats.hits == 3);
+    CHECK(stats.misses == 1);
+    CHECK_NEAR(stats.HitRate(), 0.75, 1e-9);
+    CHECK(stats.evictions == 1);
+    CHECK(stats.synthesized == 2);
+    CHECK_NEAR(stats.synthesisMs, 200.0, 1e-9);
+    CHECK_NEAR(stats.maxSynthesisMs, 120.0, 1e-9);
+
+    // Resetting the counters keeps the clips
+    cache.ResetStats();
+    stats = cache.GetStats();
+    CHECK(stats.hits == 0 && stats.misses == 0 && stats.evictions == 0 && stats.synthesized == 0);
+    CHECK(stats.HitRate() == 0.0);
+    CHECK(stats.clips == 1 && stats.bytes == 600);
+}
+
+int main() {
+    TestPhraseKeys();
+    TestLeastRecentlyUsed();
+    TestPinned();
+    TestBudget();
+    TestStats();
+    return CheckResult("TtsCacheTest");
+}
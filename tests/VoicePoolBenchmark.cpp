@@ -0,0 +1,183 @@
+#include "Benchmark.h"
+#include "TestCheck.h"
+#include "MiniaudioBackend.h"
+#include <map>
+#include <vector>
+
+// Voice acquisition for alert playback, pooled against creating a voice for every play.
+// The pool is SoundEngine's (Sounds.cpp needs Windows, so AcquireVoice/RecycleVoice are
+// mirrored here) and plays come in bursts of timers ending together. Two backends: a mock
+// that counts the voices it creates, and miniaudio, whose voices are mixed to completion.
+
+static const size_t MaxIdleVoicesPerFormat = 8;
+static const int BurstSize = 6;
+static const int Bursts = 2000;
+
+class MockVoice : public IAudioVoice {
+public:
+    explicit MockVoice(const AudioFormat& voiceFormat) : format(voiceFormat) {}
+
+    const AudioFormat& GetFormat() const override { return format; }
+    bool Submit(const uint8_t* data, uint32_t bytes, bool endOfStream) override {
+        queued = data && bytes > 0 ? 1 : 0;
+        return queued != 0;
+    }
+    void EndStream() override {}
+    uint32_t GetQueuedBuffers() const override { return queued; }
+
+    // Plays instantly: the clip starts and ends on Start
+    bool Start() override {
+        NotifyStarted();
+        queued = 0;
+        NotifyFinished();
+        return true;
+    }
+    void Reset() override { queued = 0; }
+    void SetVolume(float) override {}
+    void SetPan(float) override {}
+
+private:
+    AudioFormat format;
+    uint32_t queued = 0;
+};
+
+class MockBackend : public IAudioBackend {
+public:
+    size_t created = 0;
+
+    const char* GetName() const override { return "mock"; }
+    bool Initialize(const std::wstring&) override { return true; }
+    void Shutdown() override {}
+    bool EnumerateDevices(std::vector<AudioDevice>& devices) override {
+        devices.clear();
+        return false;
+    }
+    bool SetOutputDevice(const std::wstring&) override { return true; }
+    IAudioVoice* CreateVoice(const AudioFormat& format) override {
+        created++;
+        return new MockVoice(format);
+    }
+    bool StartRenderStream(const AudioFormat&, AudioRenderCallback) override { return false; }
+    void StopRenderStream() override {}
+};
+
+// SoundEngine's AcquireVoice/RecycleVoice/ReleaseVoicePool
+class VoiceSource {
+public:
+    VoiceSource(IAudioBackend& audioBackend, bool pooled) : backend(audioBackend), poolEnabled(pooled) {}
+    ~VoiceSource() {
+        for (auto& [format, idle] : pool) {
+            for (IAudioVoice* voice : idle) {
+                delete voice;
+            }
+        }
+    }
+
+    IAudioVoice* Acquire(const AudioFormat& format, bool& fromPool) {
+        auto poolIt = pool.find(format);
+        if (poolEnabled && poolIt != pool.end() && !poolIt->second.empty()) {
+            IAudioVoice* voice = poolIt->second.back();
+            poolIt->second.pop_back();
+            fromPool = true;
+            return voice;
+        }
+
+        fromPool = false;
+        return backend.CreateVoice(format);
+    }
+
+    void Recycle(IAudioVoice* voice) {
+        std::vector<IAudioVoice*>& idle = pool[voice->GetFormat()];
+        if (poolEnabled && idle.size() < MaxIdleVoicesPerFormat) {
+            voice->Reset();
+            idle.push_back(voice);
+        }
+        else {
+            delete voice;
+        }
+    }
+
+private:
+    IAudioBackend& backend;
+    bool poolEnabled;
+    std::map<AudioFormat, std::vector<IAudioVoice*>> pool;
+};
+
+struct RunResult {
+    double milliseconds = 0.0;
+    uint64_t pooledPlays = 0;
+    uint64_t createdPlays = 0;
+};
+
+// Bursts of plays of one clip: acquire, set up and start every voice, let them finish
+// (finish is called with the started voices), then hand them back
+template <typename Finish>
+static RunResult RunBursts(IAudioBackend& backend, bool pooled, const std::vector<float>& clip, Finish&& finish) {
+    AudioFormat format;
+    format.formatTag = AudioFormat::Float;
+    format.channels = 2;
+    format.sampleRate = 48000;
+    format.bitsPerSample = 32;
+
+    PlaybackLatencyStats latency;
+    RunResult result;
+    result.milliseconds = BestMilliseconds(5, [&]() {
+        latency.Reset();
+        VoiceSource source(backend, pooled);
+        std::vector<IAudioVoice*> playing;
+        for (int burst = 0; burst < Bursts; burst++) {
+            for (int play = 0; play < BurstSize; play++) {
+                bool fromPool = false;
+                IAudioVoice* voice = source.Acquire(format, fromPool);
+                voice->Arm(std::chrono::steady_clock::now(), fromPool, &latency);
+                voice->SetVolume(0.8f);
+                voice->SetPan(0.0f);
+                voice->Submit(reinterpret_cast<const uint8_t*>(clip.data()), static_cast<uint32_t>(clip.size() * sizeof(float)));
+                voice->Start();
+                playing.push_back(voice);
+            }
+            finish(playing);
+            for (IAudioVoice* voice : playing) {
+                source.Recycle(voice);
+            }
+            playing.clear();
+        }
+        });
+    result.pooledPlays = latency.pooledCount;
+    result.createdPlays = latency.createdCount;
+    return result;
+}
+
+static void Report(const char* name, const RunResult& pooled, const RunResult& created) {
+    const double plays = static_cast<double>(BurstSize) * Bursts;
+    printf("%-10s pooled %7.3f ms (%6.0f ns/play, %llu of %llu from the pool)   per play %7.3f ms (%6.0f ns/play)   %.2fx\n", name,
+        pooled.milliseconds, pooled.milliseconds * 1e6 / plays,
+        static_cast<unsigned long long>(pooled.pooledPlays), static_cast<unsigned long long>(pooled.pooledPlays + pooled.createdPlays),
+        created.milliseconds, created.milliseconds * 1e6 / plays, created.milliseconds / pooled.milliseconds);
+}
+
+int main() {
+    // A 20 ms chime
+    std::vector<float> clip(960 * 2, 0.25f);
+
+    MockBackend mock;
+    RunResult mockPooled = RunBursts(mock, true, clip, [](std::vector<IAudioVoice*>&) {});
+    size_t pooledCreated = mock.created;
+    mock.created = 0;
+    RunResult mockCreated = RunBursts(mock, false, clip, [](std::vector<IAudioVoice*>&) {});
+    Report("mock", mockPooled, mockCreated);
+    printf("           voices created over 5 runs: pooled %zu, per play %zu\n", pooledCreated, mock.created);
+
+    std::filesystem::path directory = MakeTestDirectory("voice-pool");
+    MiniaudioBackend miniaudio(MiniaudioBackend::Output::WavFile, (directory / "out.wav").string());
+    if (!miniaudio.Initialize(L"")) {
+        printf("miniaudio backend failed to initialize\n");
+        return 1;
+    }
+    std::vector<float> mixBuffer(960 * 2);
+    auto mixOut = [&](std::vector<IAudioVoice*>&) { miniaudio.Mix(mixBuffer.data(), 960); };
+    Report("miniaudio", RunBursts(miniaudio, true, clip, mixOut), RunBursts(miniaudio, false, clip, mixOut));
+    miniaudio.Shutdown();
+    std::filesystem::remove_all(directory);
+    return 0;
+}